@@ -4,6 +4,7 @@
 #include <gimslib/d3d/DX12Util.hpp>
 #include <gimslib/d3d/UploadHelper.hpp>
 #include <gimslib/dbg/HrException.hpp>
+#include <gimslib/mesh/MeshOptimizer.hpp>
 #include <gimslib/sys/Event.hpp>
 #include <imgui.h>
 #include <iostream>
@@ -91,7 +92,14 @@ MeshViewer::MeshViewer(const DX12AppConfig config)
   // Test print some stats
   cbm.printAttributes(std::cout);
   cbm.printConstant(std::cout);
-  std::cout << cbm.getNumTriangles();
+  std::cout << cbm.getNumTriangles() << std::endl;
+
+  // Reorder triangles for the post-transform vertex cache and overdraw, and vertices for vertex fetch locality. The
+  // overdraw is measured on the CPU from 16 directions.
+  MeshOptimizationSettings meshOptimizationSettings;
+  meshOptimizationSettings.numOverdrawViews = 16;
+  std::cout << "Mesh optimization: ";
+  optimizeMesh(cbm, meshOptimizationSettings).print(std::cout);
 
   initializeVertexBuffer(&cbm);
   uploadVertexBufferToGPU();
@@ -24,6 +24,13 @@ public:
   /// <param name="nPositions">Number of positions.</param>
   AABB(f32v3 const* const positions, ui32 nPositions);
 
+  /// <summary>
+  /// Creates a bounding box from its two corners.
+  /// </summary>
+  /// <param name="lowerLeftBottom">Component-wise minimum.</param>
+  /// <param name="upperRightTop">Component-wise maximum.</param>
+  AABB(const f32v3& lowerLeftBottom, const f32v3& upperRightTop);
+
   /// <summary>
   /// Returns the affine matrix, that maps the bounding box to [-0.5...0.5]^3.
   /// </summary>
@@ -0,0 +1,248 @@
+#pragma once
+#include "CpuScene.hpp"
+#include "TileScheduler.hpp"
+#include "ViewerSettings.hpp"
+#include <functional>
+#include <gimslib/rt/RaySorter.hpp>
+#include <gimslib/rt/TopLevelAS.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+/// <summary>
+/// Reference renderer on the CPU. Evaluates the lighting of the pixel shader of the viewer (PS_main) with shadow rays
+/// against the CPU acceleration structure: every point light contributes a Blinn-Phong term, attenuated by one over
+/// the distance, unless the shadow ray towards it is occluded. The image is split into square tiles, which are
+/// distributed over the threads by a TileScheduler.
+/// </summary>
+class CpuRenderer
+{
+public:
+  /// <summary>
+  /// Camera of the viewer.
+  /// </summary>
+  struct Camera
+  {
+    f32m4 viewMatrix;       //! World space to view space, i.e., the camera matrix times the scene normalization.
+    f32m4 projectionMatrix; //! View space to clip space, see getProjectionMatrix().
+  };
+
+  /// <summary>
+  /// What render() computes per pixel.
+  /// </summary>
+  enum class RenderMode
+  {
+    Lighting,             //! Point lights with shadows. The baked ambient occlusion, if any, scales the ambient term.
+    AmbientOcclusion,     //! Ambient occlusion, traced per pixel with numAmbientOcclusionRays per pass.
+    BakedAmbientOcclusion //! Ambient occlusion interpolated from the vertices, see bakeAmbientOcclusion().
+  };
+
+  /// <summary>
+  /// Parameters of render().
+  /// </summary>
+  struct Settings
+  {
+    ui32       width    = 1280;                 //! Image width in pixels.
+    ui32       height   = 720;                  //! Image height in pixels.
+    ui32       tileSize = 16;                   //! Edge length of the tiles in pixels, e.g., 16 or 32.
+    RenderMode mode     = RenderMode::Lighting; //! What the pixels show.
+
+    f32v3 backgroundColor = f32v3(0.25f, 0.25f, 0.25f); //! Color of pixels without hit, as in the viewer.
+    f32   shadowBias      = 0.0001f;                    //! Offset of secondary ray origins along the normal.
+
+    f32  lightRadius           = 0.0f; //! Radius of the spherical area lights, 0 for hard shadows.
+    ui32 numShadowRaysPerLight = 1;    //! Shadow rays per light, pixel and pass.
+
+    ui32 numAmbientOcclusionRays  = 4;     //! Occlusion rays per pixel and pass.
+    f32  ambientOcclusionDistance = 0.05f; //! Length of the occlusion rays relative to the scene diagonal.
+
+    bool sortSecondaryRays = false; //! Sorts the shadow and occlusion rays of a tile with a RaySorter before tracing.
+    bool countTraversal    = false; //! Counts visited nodes and tested triangles per tile, see createHeatmap().
+  };
+
+  /// <summary>
+  /// What a heatmap of createHeatmap() shows.
+  /// </summary>
+  enum class HeatmapMetric
+  {
+    NodesVisited,   //! TraversalCounters::numNodesVisited per pixel.
+    TrianglesTested //! TraversalCounters::numTrianglesTested per pixel.
+  };
+
+  /// <summary>
+  /// Radiance of the passes that were rendered so far with the same camera and image size. Soft shadows converge over
+  /// the passes, since every pass continues the low-discrepancy sequence of the light samples.
+  /// </summary>
+  struct Accumulation
+  {
+    std::vector<f32v3>  radianceSums;  //! Per pixel, sum over all passes.
+    std::vector<RayHit> primaryHits;   //! Per pixel, traced in the first pass and reused by the following ones.
+    Camera              camera;        //! Camera of the passes.
+    ui32                width     = 0; //! Image width of the passes.
+    ui32                height    = 0; //! Image height of the passes.
+    ui32                numPasses = 0; //! Number of passes in radianceSums.
+
+    /// <summary>
+    /// Discards the passes, e.g., after the lights changed. render() calls it when the camera or image size changes.
+    /// </summary>
+    void reset();
+  };
+
+  /// <summary>
+  /// Ray counts and timing of a render() call.
+  /// </summary>
+  struct Statistics
+  {
+    ui64                      numPrimaryRays          = 0; //! One per pixel in the first pass of an accumulation.
+    ui64                      numShadowRays           = 0; //! Per light and lit surface point.
+    ui64                      numAmbientOcclusionRays = 0; //! Per surface point or vertex in ambient occlusion.
+    f64                       seconds                 = 0; //! Wall clock time without acceleration structure build.
+    f64                       raySortingSeconds       = 0; //! Time spent sorting secondary rays, summed over threads.
+    TileScheduler::Statistics tiles;                       //! Load balance and cost of the tiles.
+    TraversalCounters         traversal;                   //! Work of all rays, if Settings::countTraversal is set.
+
+    //! Work per tile in the order of TileScheduler::getTiles(), if Settings::countTraversal is set.
+    std::vector<TraversalCounters> tileTraversal;
+
+    /// <summary>
+    /// Rays of all kinds per second in millions.
+    /// </summary>
+    f64 getMegaRaysPerSecond() const;
+  };
+
+  /// <summary>
+  /// Builds the acceleration structure of the scene, see CpuScene::createAccelerationStructure(). The scene must
+  /// outlive the renderer.
+  /// </summary>
+  /// <param name="scene">The scene.</param>
+  /// <param name="bottomLevelSettings">Build settings of the BLAS.</param>
+  /// <param name="bvhCache">If not null, the BLAS are loaded from this cache, missing ones are built.</param>
+  explicit CpuRenderer(const CpuScene& scene, const BvhBuildSettings& bottomLevelSettings = {},
+                       BvhCache* bvhCache = nullptr);
+
+  /// <summary>
+  /// Renders an image with a single pass.
+  /// </summary>
+  /// <param name="camera">The camera.</param>
+  /// <param name="pointLights">The lights in world space.</param>
+  /// <param name="settings">Image size and shading parameters.</param>
+  /// <param name="threadPool">The tiles are distributed over the threads of this pool.</param>
+  /// <param name="image">Receives width * height pixels, row by row, starting with the top row.</param>
+  /// <returns>Ray counts and render time.</returns>
+  Statistics render(const Camera& camera, const std::vector<PointLight>& pointLights, const Settings& settings,
+                    ThreadPool& threadPool, std::vector<ui8v4>& image) const;
+
+  /// <summary>
+  /// Renders one more pass into an accumulation and writes the average of all its passes into the image. The
+  /// accumulation is reset first, if the camera or the image size differ from its previous passes.
+  /// </summary>
+  /// <param name="accumulation">The passes rendered so far.</param>
+  /// <returns>Ray counts and render time of this pass.</returns>
+  Statistics render(const Camera& camera, const std::vector<PointLight>& pointLights, const Settings& settings,
+                    ThreadPool& threadPool, Accumulation& accumulation, std::vector<ui8v4>& image) const;
+
+  /// <summary>
+  /// Computes the ambient occlusion at the vertices of every instance, which RenderMode::BakedAmbientOcclusion
+  /// interpolates instead of tracing rays per pixel and frame. The scene is static, so the result stays valid for the
+  /// lifetime of the renderer. Vertices shared by instances get separate values, since their surroundings differ.
+  /// </summary>
+  /// <param name="settings">numAmbientOcclusionRays, ambientOcclusionDistance and shadowBias are used.</param>
+  /// <param name="threadPool">The vertices are distributed over the threads of this pool.</param>
+  /// <returns>Ray count and bake time.</returns>
+  Statistics bakeAmbientOcclusion(const Settings& settings, ThreadPool& threadPool);
+
+  /// <summary>
+  /// Visualizes the traversal work of the tiles of a render() call with Settings::countTraversal: every pixel of a
+  /// tile shows the work per pixel of the tile, from blue for no work to red for the most expensive tile.
+  /// </summary>
+  /// <param name="settings">The settings of the render() call.</param>
+  /// <param name="statistics">The statistics of the render() call.</param>
+  /// <param name="metric">The counter that is shown.</param>
+  /// <returns>width * height pixels, like the image of render().</returns>
+  static std::vector<ui8v4> createHeatmap(const Settings& settings, const Statistics& statistics,
+                                          HeatmapMetric metric);
+
+  /// <summary>
+  /// Returns true, if bakeAmbientOcclusion() was called.
+  /// </summary>
+  bool hasBakedAmbientOcclusion() const;
+
+  /// <summary>
+  /// Returns the acceleration structure.
+  /// </summary>
+  const TopLevelAS& getAccelerationStructure() const;
+
+private:
+  /// <summary>
+  /// Mesh and normal transformation of an instance of the acceleration structure.
+  /// </summary>
+  struct InstanceData
+  {
+    ui32             meshIdx;                //! Index of the mesh in the scene.
+    f32m3            normalMatrix;           //! Inverse transpose of the object to world transformation.
+    std::vector<f32> vertexAmbientOcclusion; //! Baked ambient occlusion per vertex of the mesh, empty if not baked.
+  };
+
+  /// <summary>
+  /// Attributes of a hit in world space.
+  /// </summary>
+  struct SurfacePoint
+  {
+    f32v3 position;                     //! Position.
+    f32v3 normal;                       //! Unit normal.
+    f32v2 textureCoordinate;            //! Texture coordinate.
+    ui32  materialIndex;                //! Index of the material in the scene.
+    f32   bakedAmbientOcclusion = 1.0f; //! Interpolated baked ambient occlusion, 1 if not baked.
+  };
+
+  /// <summary>
+  /// Traces a shadow or occlusion ray and returns true, if it reaches its end. group is the index of the light of a
+  /// shadow ray and 0 for occlusion rays; rays of the same group are likely blocked by the same occluder.
+  /// </summary>
+  using VisibilityFunction = std::function<bool(const Ray& ray, ui32 group)>;
+
+  /// <summary>
+  /// Traces the primary rays of a tile as one batch, or takes their hits from the accumulation after the first pass,
+  /// and adds the shaded radiance to the accumulation. If Settings::sortSecondaryRays is set, the secondary rays of
+  /// the tile are collected and traced in the order of the ray sorter before the pixels are shaded. If
+  /// Settings::countTraversal is set, the primary rays are traced one by one, since batches do not count their work.
+  /// </summary>
+  void renderTile(const f32m4& clipToWorld, const std::vector<PointLight>& pointLights, const Settings& settings,
+                  f32 ambientOcclusionDistance, const RaySorter& raySorter, ThreadPool& threadPool,
+                  const TileScheduler::Tile& tile, Accumulation& accumulation, std::vector<ui8v4>& image,
+                  Statistics& statistics) const;
+
+  /// <summary>
+  /// Returns the length of the occlusion rays in world space, see Settings::ambientOcclusionDistance.
+  /// </summary>
+  f32 getAmbientOcclusionDistance(const Settings& settings) const;
+
+  /// <summary>
+  /// Interpolates the vertex attributes at a hit.
+  /// </summary>
+  SurfacePoint getSurfacePoint(const Ray& ray, const RayHit& hit) const;
+
+  /// <summary>
+  /// Evaluates the lighting at a surface point, with isVisible tracing the shadow rays. The light samples of the pass
+  /// start at sampleIdx of the Sobol sequence, rotated by the offsets of the pixel. The shadow rays do not depend on
+  /// the results of previous ones.
+  /// </summary>
+  f32v3 shade(const Ray& ray, const SurfacePoint& surface, const std::vector<PointLight>& pointLights,
+              const Settings& settings, ui32 pixelX, ui32 pixelY, ui32 sampleIdx,
+              const VisibilityFunction& isVisible) const;
+
+  /// <summary>
+  /// Returns the fraction of cosine-distributed occlusion rays of length maxDistance that are not blocked. The
+  /// directions start at sampleIdx of the Sobol sequence, rotated by the offsets of (x, y), i.e., of a pixel or of a
+  /// vertex and instance. isVisible traces the rays.
+  /// </summary>
+  f32 traceAmbientOcclusion(const f32v3& position, const f32v3& normal, const Settings& settings, f32 maxDistance,
+                            ui32 x, ui32 y, ui32 sampleIdx, const VisibilityFunction& isVisible) const;
+
+  const CpuScene&           m_scene;     //! The scene.
+  TopLevelAS                m_tlas;      //! Acceleration structure of the scene.
+  std::vector<InstanceData> m_instances; //! Per instance of m_tlas.
+};
+} // namespace gims
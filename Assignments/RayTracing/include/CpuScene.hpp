@@ -0,0 +1,131 @@
+#pragma once
+#include "AABB.hpp"
+#include "Vertex.hpp"
+#include <gimslib/rt/BvhCache.hpp>
+#include <gimslib/rt/TopLevelAS.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+class CpuSceneFactory;
+
+/// <summary>
+/// Scene graph without any GPU resources, for rendering on the CPU. Nodes, meshes and materials have the same indices
+/// and the same coordinate system as in the Scene created by the SceneGraphFactory from the same file.
+/// </summary>
+class CpuScene
+{
+public:
+  /// <summary>
+  /// Node of the scene graph.
+  /// </summary>
+  struct Node
+  {
+    f32m4             transformation;           //! Transformation to parent node.
+    f32m4             worldSpaceTransformation; //! Transformation into world space
+    std::vector<ui32> meshIndices;              //! Index in the array of meshes, i.e., CpuScene::m_meshes[].
+    std::vector<ui32> childIndices;             //! Index in the array of nodes, i.e., CpuScene::m_nodes[].
+  };
+
+  /// <summary>
+  /// Triangle mesh in main memory.
+  /// </summary>
+  struct Mesh
+  {
+    std::vector<Vertex> vertices;      //! Vertices.
+    std::vector<ui32>   indices;       //! Three indices per triangle.
+    ui32                materialIndex; //! Index in the array of materials, i.e., CpuScene::m_materials[].
+    AABB                aabb;          //! Bounds of the positions.
+  };
+
+  /// <summary>
+  /// RGBA8 texture in main memory.
+  /// </summary>
+  struct Texture
+  {
+    ui32               width  = 0; //! Width in texels.
+    ui32               height = 0; //! Height in texels.
+    std::vector<ui8v4> texels;     //! Row by row, starting with the top row.
+
+    /// <summary>
+    /// Returns the nearest texel with wrapped texture coordinates, like the point sampler of the viewer.
+    /// </summary>
+    f32v4 sample(f32v2 textureCoordinate) const;
+  };
+
+  /// <summary>
+  /// Material information. The colors are the values of the material constant buffer of the viewer.
+  /// </summary>
+  struct Material
+  {
+    f32v4 ambientColor             = f32v4(0); //! Ambient Color.
+    f32v4 diffuseColor             = f32v4(0); //! Diffuse Color.
+    f32v4 specularColorAndExponent = f32v4(0); //! xyz: Specular Color, w: Specular Exponent.
+    ui32  diffuseTextureIndex      = 0;        //! Index in the array of textures, i.e., CpuScene::m_textures[].
+  };
+
+  /// <summary>
+  /// Default constructor.
+  /// </summary>
+  CpuScene() = default;
+
+  /// <summary>
+  /// Returns the axis aligned bounding box of the scene.
+  /// </summary>
+  const AABB& getAABB() const;
+
+  /// <summary>
+  /// Nodes are stored in a flat 1D array. This functions returns the Node at the respective index.
+  /// </summary>
+  const Node& getNode(ui32 nodeIdx) const;
+
+  /// <summary>
+  /// Returns the number of nodes.
+  /// </summary>
+  ui32 getNumberOfNodes() const;
+
+  /// <summary>
+  /// Returns the mesh at the respective index.
+  /// </summary>
+  const Mesh& getMesh(ui32 meshIdx) const;
+
+  /// <summary>
+  /// Returns the number of meshes.
+  /// </summary>
+  ui32 getNumberOfMeshes() const;
+
+  /// <summary>
+  /// Returns the material at the respective index.
+  /// </summary>
+  const Material& getMaterial(ui32 materialIdx) const;
+
+  /// <summary>
+  /// Returns the texture at the respective index. Index 0 is a white texture, which materials without diffuse texture
+  /// refer to.
+  /// </summary>
+  const Texture& getTexture(ui32 textureIdx) const;
+
+  /// <summary>
+  /// Builds the acceleration structure like RayTracingUtils::createCpuAccelerationStructure(): one instance per (node,
+  /// mesh) pair with the world space transformation of the node, so RayHit::instanceIdx is the same as in the viewer.
+  /// Every mesh has a single BLAS that all its instances share, and Instance::instanceID is the mesh index. The BLAS
+  /// are built in parallel; build time and SAH cost are printed.
+  /// </summary>
+  /// <param name="bottomLevelSettings">Build settings of the BLAS. Its thread pool, if any, also distributes the
+  /// meshes, so benchmarks can build with a given number of threads.</param>
+  /// <param name="bvhCache">If not null, the BLAS are loaded from this cache, missing ones are built.</param>
+  /// <returns>The top level acceleration structure, which owns the bottom level acceleration structures.</returns>
+  TopLevelAS createAccelerationStructure(const BvhBuildSettings& bottomLevelSettings,
+                                         BvhCache*               bvhCache = nullptr) const;
+
+private:
+  friend class CpuSceneFactory;
+
+  std::vector<Node>     m_nodes;     //! The nodes of the scene.
+  std::vector<Mesh>     m_meshes;    //! Array meshes of the scene.
+  std::vector<Material> m_materials; //! Material information for each mesh.
+  std::vector<Texture>  m_textures;  //! Array of textures.
+  AABB                  m_aabb;      //! The axis-aligned bounding box of the scene.
+};
+} // namespace gims
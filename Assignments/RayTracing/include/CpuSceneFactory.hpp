@@ -0,0 +1,42 @@
+#pragma once
+#include "CpuScene.hpp"
+#include <filesystem>
+#include <gimslib/io/GltfFile.hpp>
+
+namespace gims
+{
+/// <summary>
+/// CPU path of the SceneGraphFactory: creates a CpuScene, which needs neither a device nor Assimp, so it also runs
+/// headless and on other platforms.
+/// </summary>
+class CpuSceneFactory
+{
+public:
+  /// <summary>
+  /// Creates the scene from a glTF 2.0 file. The conversion to a left-handed coordinate system, the node hierarchy,
+  /// the materials and the default material are the same as in SceneGraphFactory::createFromGltf(), so the scene
+  /// matches the one of the viewer. Meshes and textures are loaded in parallel.
+  /// </summary>
+  /// <param name="pathToScene">Path to the .gltf file.</param>
+  static CpuScene createFromGltf(const std::filesystem::path& pathToScene);
+
+private:
+  /// <summary>
+  /// Converts every triangle primitive into a mesh. Returns for each glTF mesh the indices of its primitives in
+  /// CpuScene::m_meshes.
+  /// </summary>
+  static std::vector<std::vector<ui32>> createMeshes(const GltfFile& inputScene, CpuScene& outputScene);
+
+  static ui32 createNodes(const GltfFile& inputScene, const std::vector<std::vector<ui32>>& sceneMeshIndices,
+                          CpuScene& outputScene, ui32 nodeIdx, f32m4 worldSpaceTransformation);
+
+  static void computeSceneAABB(CpuScene& scene, AABB& aabb, ui32 nodeIdx, f32m4 transformation);
+
+  /// <summary>
+  /// Creates the materials and loads their diffuse textures. The other textures have no effect on the shading of the
+  /// CPU renderer.
+  /// </summary>
+  static void createMaterials(const GltfFile& inputScene, const std::filesystem::path& parentPath,
+                              CpuScene& outputScene);
+};
+} // namespace gims
@@ -0,0 +1,45 @@
+#pragma once
+#include "AABB.hpp"
+#include "Vertex.hpp"
+#include <gimslib/io/GltfFile.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+/// <summary>
+/// Applies what aiProcess_MakeLeftHanded does to node transformations: the matrix is mirrored at the xy-plane from
+/// both sides, i.e., S * M * S with S = diag(1, 1, -1, 1).
+/// </summary>
+f32m4 toLeftHanded(f32m4 m);
+
+/// <summary>
+/// Converts a glTF primitive into interleaved vertices and a flat index buffer. Each attribute is read in place from
+/// the mapped buffer and written exactly once into its final location. Positions, normals and tangents are mirrored at
+/// the xy-plane, texture coordinates are flipped vertically, and the winding order is reversed, which is what
+/// aiProcess_ConvertToLeftHanded does.
+/// </summary>
+void convertGltfPrimitive(const GltfFile& inputScene, const GltfFile::Primitive& primitive,
+                          std::vector<Vertex>& vertices, std::vector<ui32>& indices);
+
+/// <summary>
+/// Only triangle primitives with positions are converted into meshes.
+/// </summary>
+bool isTrianglePrimitive(const GltfFile::Primitive& primitive);
+
+/// <summary>
+/// Primitives without material use the default material, which is appended after the materials of the file.
+/// </summary>
+ui32 getMaterialIndex(const GltfFile& inputScene, const GltfFile::Primitive& primitive);
+
+/// <summary>
+/// Returns the bounding box of a primitive in the left-handed coordinate system. The accessor bounds are used if they
+/// are present, which they have to be for positions according to the glTF specification.
+/// </summary>
+AABB getPrimitiveAABB(const GltfFile& inputScene, const GltfFile::Primitive& primitive);
+
+/// <summary>
+/// Returns true, if a primitive references no material and, thus, requires the default material.
+/// </summary>
+bool gltfNeedsDefaultMaterial(const GltfFile& inputScene);
+} // namespace gims
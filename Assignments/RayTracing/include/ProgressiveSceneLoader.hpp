@@ -0,0 +1,125 @@
+#pragma once
+#include "Scene.hpp"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <gimslib/io/GltfFile.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gims
+{
+/// <summary>
+/// Loads a glTF scene asynchronously.
+///
+/// The constructor only parses the glTF file and creates the node hierarchy, the bounding boxes (from the accessor
+/// bounds) and the materials, so the first frame can be drawn after a few milliseconds. Meshes are placeholders at
+/// this point, see TriangleMeshD3D12::isLoaded(). A worker thread then creates the meshes, the ones that appear largest
+/// on screen first, and finally the textures: a downsampled version of every texture first, then the full resolution.
+///
+/// The worker never touches the scene. Finished resources are handed over by update(), which has to be called by the
+/// render thread at a frame boundary while the GPU is idle.
+/// </summary>
+class ProgressiveSceneLoader
+{
+public:
+  /// <summary>
+  /// Creates the scene hierarchy and starts loading the meshes and textures in the background.
+  /// </summary>
+  /// <param name="pathToScene">Path to the .gltf file.</param>
+  /// <param name="device">Device on which the GPU resources are created.</param>
+  /// <param name="outputScene">Receives the scene hierarchy, the materials and the mesh placeholders.</param>
+  /// <param name="keepCpuCopy">If true, the meshes keep their positions and indices in CPU memory, e.g., for
+  /// RayTracingUtils::createCpuAccelerationStructure().</param>
+  ProgressiveSceneLoader(const std::filesystem::path pathToScene, const ComPtr<ID3D12Device>& device,
+                         Scene& outputScene, bool keepCpuCopy = false);
+
+  /// <summary>
+  /// Stops the worker thread. Resources that are not handed over yet are released.
+  /// </summary>
+  ~ProgressiveSceneLoader();
+
+  ProgressiveSceneLoader(const ProgressiveSceneLoader& other)            = delete;
+  ProgressiveSceneLoader& operator=(const ProgressiveSceneLoader& other) = delete;
+
+  /// <summary>
+  /// Sets the model view matrix that is used to decide which mesh is loaded next. Can be called every frame.
+  /// </summary>
+  /// <param name="modelView">The model view matrix the scene is drawn with.</param>
+  void setModelView(const f32m4& modelView);
+
+  /// <summary>
+  /// Returns true, if update() should be called. Loaded resources are collected for a short while, because every
+  /// handoff requires an idle GPU.
+  /// </summary>
+  bool hasUpdates() const;
+
+  /// <summary>
+  /// Moves the loaded meshes and textures into the scene and updates the texture descriptors of the materials. The GPU
+  /// must not use the scene while this function is running. Rethrows exceptions of the worker thread.
+  /// </summary>
+  /// <param name="scene">The scene that was passed to the constructor.</param>
+  /// <returns>True, if meshes were added, i.e., the acceleration structures have to be rebuilt.</returns>
+  bool update(Scene& scene);
+
+  /// <summary>
+  /// Returns true, if all resources have been handed over to the scene.
+  /// </summary>
+  bool isFinished() const;
+
+  /// <summary>
+  /// Returns the number of resources that have been handed over to the scene.
+  /// </summary>
+  ui32 getNumLoadedResources() const;
+
+  /// <summary>
+  /// Returns the total number of resources. Each texture counts twice, once for each resolution.
+  /// </summary>
+  ui32 getNumResources() const;
+
+private:
+  /// <summary>
+  /// Descriptor of a material that refers to a texture.
+  /// </summary>
+  struct TextureUsage
+  {
+    ui32 materialIdx;   //! Index in Scene::m_materials.
+    ui32 descriptorIdx; //! Index in the descriptor heap of the material.
+  };
+
+  /// <summary>
+  /// Entry point of the worker thread.
+  /// </summary>
+  void loadResources();
+
+  /// <summary>
+  /// Sorts the meshes by their size on screen, such that the largest one is at the back.
+  /// </summary>
+  void sortBySizeOnScreen(std::vector<ui32>& meshIndices, const f32m4& modelView) const;
+
+  GltfFile                                m_inputScene;         //! Parsed glTF file with mapped buffers.
+  std::filesystem::path                   m_parentPath;         //! Directory of the glTF file.
+  ComPtr<ID3D12Device>                    m_device;             //! Device for the GPU resources.
+  ComPtr<ID3D12CommandQueue>              m_commandQueue;       //! Own queue for the uploads of the worker.
+  std::vector<GltfFile::Primitive const*> m_scenePrimitives;    //! glTF primitive of each mesh of the scene.
+  std::vector<std::vector<f32v4>>         m_boundingSpheres;    //! Per mesh: world space spheres of all instances.
+  std::vector<std::filesystem::path>      m_textureFileNames;   //! Texture i is stored at Scene::m_textures[3 + i].
+  std::vector<std::vector<TextureUsage>>  m_textureUsages;      //! Per texture: descriptors that refer to it.
+  std::chrono::steady_clock::time_point   m_lastUpdate;         //! Time of the last handoff.
+  ui32                                    m_numLoadedResources; //! Number of resources handed over so far.
+  bool                                    m_keepCpuCopy;        //! Meshes keep positions and indices on the CPU.
+
+  mutable std::mutex                              m_mutex;            //! Guards the members below.
+  f32m4                                           m_modelView;        //! Latest model view matrix.
+  ui32                                            m_modelViewVersion; //! Incremented whenever m_modelView changes.
+  std::vector<std::pair<ui32, TriangleMeshD3D12>> m_loadedMeshes;     //! Loaded meshes and their index in the scene.
+  std::vector<std::pair<ui32, Texture2DD3D12>>    m_loadedTextures;   //! Loaded textures and their texture index.
+  std::exception_ptr                              m_exception;        //! Exception thrown by the worker.
+  bool                                            m_finished;         //! True, when the worker is done.
+
+  std::atomic<bool> m_stop;   //! Asks the worker to stop.
+  std::thread       m_worker; //! Runs loadResources().
+};
+} // namespace gims
@@ -6,6 +6,9 @@
 #include <gimslib/d3d/DX12Util.hpp>
 #include <gimslib/d3d/UploadHelper.hpp>
 #include <gimslib/dbg/HrException.hpp>
+#include <gimslib/rt/BvhCache.hpp>
+#include <gimslib/rt/TopLevelAS.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
 #include <gimslib/types.hpp>
 #include <iostream>
 #include <string>
@@ -30,9 +33,13 @@ public:
 
   // Acceleration structure
   ComPtr<ID3D12Resource>              m_topLevelAS;
-  std::vector<ComPtr<ID3D12Resource>> m_bottomLevelAS;
+  std::vector<ComPtr<ID3D12Resource>> m_bottomLevelAS; // Per mesh; null until the mesh is loaded.
 
   bool isRayTracingSupported(ComPtr<ID3D12Device5> device);
+
+  /// <summary>
+  /// Builds the BLAS of all loaded meshes that do not have one yet and rebuilds the TLAS over all loaded meshes.
+  /// </summary>
   void createAccelerationStructures(ComPtr<ID3D12Device5> device, Scene& scene,
                                     ComPtr<ID3D12GraphicsCommandList4> commandList,
                                     ComPtr<ID3D12CommandAllocator>     commandAllocator,
@@ -40,6 +47,24 @@ public:
 
   void buildGeometryDescriptionsForBLAS(std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>& geometryDescriptions,
                                         Scene&                                       scene);
+
+  /// <summary>
+  /// CPU counterpart of createAccelerationStructures(), e.g., for machines without ray tracing support. The mapping
+  /// from the scene is the same: one BLAS per mesh, instanced once per node that references it with the world space
+  /// transformation of the node, and meshes that are still loading are left out. Hence, RayHit::instanceIdx equals
+  /// InstanceIndex() of the GPU version and RayHit::instanceID, the mesh index, equals InstanceID(). The userData of
+  /// an instance is the index of its node. The BLAS are built in parallel; build time and SAH cost are printed.
+  /// </summary>
+  /// <param name="scene">The scene. Its meshes must have been created with keepCpuCopy, see
+  /// TriangleMeshD3D12::getPositions().</param>
+  /// <param name="bottomLevelSettings">Build settings of the BLAS. The default binned SAH builder corresponds to
+  /// PREFER_FAST_TRACE, BvhBuilder::Linear to PREFER_FAST_BUILD.</param>
+  /// <param name="bvhCache">If not null, the BLAS are loaded from this cache and only built if they are missing, so
+  /// static scenes are built only on the first start.</param>
+  /// <returns>The top level acceleration structure, which owns the bottom level acceleration structures.</returns>
+  static gims::TopLevelAS createCpuAccelerationStructure(const Scene&                  scene,
+                                                         const gims::BvhBuildSettings& bottomLevelSettings = {},
+                                                         gims::BvhCache*               bvhCache = nullptr);
 };
 
 RayTracingUtils::~RayTracingUtils()
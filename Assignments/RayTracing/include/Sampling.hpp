@@ -0,0 +1,97 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <gimslib/types.hpp>
+
+namespace gims
+{
+/// <summary>
+/// Returns the index-th point of the two-dimensional Sobol sequence in [0, 1)^2. The first dimension is the van der
+/// Corput sequence, the second one the second Sobol dimension, so every power-of-two prefix is stratified in both
+/// dimensions and consecutive passes keep filling the gaps of the previous ones.
+/// </summary>
+inline f32v2 getSobolSample(ui32 index)
+{
+  ui32 x = 0;
+  ui32 y = 0;
+  for (ui32 v = 1u << 31, bits = index; bits != 0; bits >>= 1, v ^= v >> 1)
+  {
+    if (bits & 1)
+    {
+      y ^= v;
+    }
+  }
+  for (ui32 bit = 0; bit < 32; bit++)
+  {
+    x |= ((index >> bit) & 1u) << (31 - bit);
+  }
+  // 24 bits are exactly representable in [0, 1).
+  return f32v2(static_cast<f32>(x >> 8), static_cast<f32>(y >> 8)) * (1.0f / 16777216.0f);
+}
+
+/// <summary>
+/// Per-pixel offset for a Cranley-Patterson rotation of a sample sequence. The R2 dither distributes the offsets of
+/// neighboring pixels evenly, so the remaining noise is of high frequency like blue noise, without a noise texture.
+/// dimension decorrelates independent sample sequences of the same pixel, e.g., of different lights.
+/// </summary>
+inline f32v2 getPixelSampleOffset(ui32 x, ui32 y, ui32 dimension)
+{
+  const f64 fx = static_cast<f64>(x) + 0.6180339887 * dimension;
+  const f64 fy = static_cast<f64>(y) + 0.4142135624 * dimension;
+  const f64 u  = 0.7548776662 * fx + 0.5698402910 * fy;
+  const f64 v  = 0.5698402910 * fx + 0.7548776662 * fy;
+  return f32v2(static_cast<f32>(u - std::floor(u)), static_cast<f32>(v - std::floor(v)));
+}
+
+/// <summary>
+/// Applies a Cranley-Patterson rotation, i.e., adds the offset modulo 1.
+/// </summary>
+inline f32v2 rotateSample(f32v2 sample, f32v2 offset)
+{
+  sample += offset;
+  return sample - glm::floor(sample);
+}
+
+/// <summary>
+/// Maps [0, 1)^2 to the unit disk with Shirley's concentric mapping, which keeps the stratification of the samples.
+/// </summary>
+inline f32v2 sampleConcentricDisk(f32v2 u)
+{
+  const f32v2 p = 2.0f * u - 1.0f;
+  if (p.x == 0.0f && p.y == 0.0f)
+  {
+    return f32v2(0.0f);
+  }
+  const f32 quarterPi = 0.78539816f;
+  if (std::abs(p.x) > std::abs(p.y))
+  {
+    const f32 phi = quarterPi * (p.y / p.x);
+    return p.x * f32v2(std::cos(phi), std::sin(phi));
+  }
+  const f32 phi = 2.0f * quarterPi - quarterPi * (p.x / p.y);
+  return p.y * f32v2(std::cos(phi), std::sin(phi));
+}
+
+/// <summary>
+/// Maps [0, 1)^2 to directions of the hemisphere around +z, distributed proportional to the cosine of their angle to
+/// +z, by projecting concentric disk samples up to the hemisphere (Malley's method).
+/// </summary>
+inline f32v3 sampleCosineHemisphere(f32v2 u)
+{
+  const f32v2 d = sampleConcentricDisk(u);
+  return f32v3(d, std::sqrt(std::max(0.0f, 1.0f - glm::dot(d, d))));
+}
+
+/// <summary>
+/// Returns two unit vectors that form an orthonormal basis with the unit vector n.
+/// </summary>
+inline void getOrthonormalBasis(const f32v3& n, f32v3& tangent, f32v3& bitangent)
+{
+  // Duff et al., Building an Orthonormal Basis, Revisited.
+  const f32 sign = std::copysign(1.0f, n.z);
+  const f32 a    = -1.0f / (sign + n.z);
+  const f32 b    = n.x * n.y * a;
+  tangent        = f32v3(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+  bitangent      = f32v3(b, sign + n.y * n.y * a, -n.y);
+}
+} // namespace gims
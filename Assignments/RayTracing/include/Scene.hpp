@@ -4,8 +4,11 @@
 #include <Texture2DD3D12.hpp>
 #include <assimp/scene.h>
 #include <d3d12.h>
+#include <gimslib/rt/Ray.hpp>
+#include <gimslib/rt/TopLevelAS.hpp>
 #include <gimslib/types.hpp>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 namespace gims
@@ -17,6 +20,7 @@ static inline glm::mat4 aiMatrix4x4ToGlm(const aiMatrix4x4& from)
 }
 
 class SceneGraphFactory;
+class ProgressiveSceneLoader;
 
 /// <summary>
 /// Class that represents a scene graph for D3D12 rendering.
@@ -54,6 +58,26 @@ public:
     ComPtr<ID3D12DescriptorHeap> srvDescriptorHeap;      //! Descriptor Heap for the textures.
   };
 
+  /// <summary>
+  /// Result of pick(). Without a hit, all indices are RayHit::INVALID.
+  /// </summary>
+  struct PickResult
+  {
+    ui32  nodeIdx      = RayHit::INVALID;                      //! Node that references the hit mesh.
+    ui32  meshIdx      = RayHit::INVALID;                      //! Index of the hit mesh.
+    ui32  triangleIdx  = RayHit::INVALID;                      //! Index of the hit triangle within the mesh.
+    f32v2 barycentrics = f32v2(0.0f);                          //! Weights of the second and the third vertex.
+    f32   distance     = std::numeric_limits<f32>::infinity(); //! World space distance from the ray origin.
+
+    /// <summary>
+    /// Returns true, if a triangle was hit.
+    /// </summary>
+    bool isHit() const
+    {
+      return triangleIdx != RayHit::INVALID;
+    }
+  };
+
   /// <summary>
   /// Default constructor.
   /// </summary>
@@ -117,14 +141,45 @@ public:
                         ui32 modelViewRootParameterIdx, ui32 materialConstantsRootParameterIdx,
                         ui32 srvRootParameterIdx);
 
+  /// <summary>
+  /// Replaces the CPU acceleration structure that pick() queries and frees the CPU copies of the meshes, which are not
+  /// needed anymore. Building the structure with RayTracingUtils::createCpuAccelerationStructure() only reads the
+  /// scene, so it can run on another thread while frames are drawn; the handover has to happen on the render thread.
+  /// </summary>
+  /// <param name="pickingAS">Acceleration structure over the loaded meshes. Meshes that were still loading cannot be
+  /// picked.</param>
+  void setPickingAccelerationStructure(TopLevelAS pickingAS);
+
+  /// <summary>
+  /// Finds the closest triangle along a ray. A single closest-hit query on the CPU acceleration structure takes a few
+  /// microseconds, so picking can run on every mouse move.
+  /// </summary>
+  /// <param name="ray">The ray in world space, i.e., without the normalization of getAABB().</param>
+  /// <returns>The node, mesh and triangle that were hit, if any.</returns>
+  PickResult pick(const Ray& ray) const;
+
+  /// <summary>
+  /// Finds the closest triangle under the cursor. The ray starts at the near plane and ends at the far plane.
+  /// </summary>
+  /// <param name="normalizedCoordinates">Cursor position in normalized device coordinates, e.g.,
+  /// DX12App::getNormalizedMouseCoordinates().</param>
+  /// <param name="worldToClip">Projection times view matrix, including the normalization of getAABB().</param>
+  /// <returns>The node, mesh and triangle that were hit, if any. The distance is measured from the near
+  /// plane.</returns>
+  PickResult pick(const f32v2& normalizedCoordinates, const f32m4& worldToClip) const;
+
   // Allow the class SceneGraphFactor access to the private members.
   friend class SceneGraphFactory;
 
+  // Hands loaded meshes and textures over into the scene.
+  friend class ProgressiveSceneLoader;
+
 private:
   std::vector<Node>              m_nodes;     //! The nodes of the scene.
   std::vector<TriangleMeshD3D12> m_meshes;    //! Array meshes of the scene.
   AABB                           m_aabb;      //! The axis-aligned bounding box of the scene.
   std::vector<Material>          m_materials; //! Material information for each mesh.
   std::vector<Texture2DD3D12>    m_textures;  //! Array of textures.
+  TopLevelAS                     m_pickingAS; //! CPU acceleration structure over the loaded meshes for pick().
 };
 } // namespace gims
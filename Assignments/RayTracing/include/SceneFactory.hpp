@@ -1,6 +1,8 @@
 #pragma once
 #include "Scene.hpp"
 #include <filesystem>
+#include <gimslib/io/GltfFile.hpp>
+#include <gimslib/mesh/MeshOptimizer.hpp>
 #include <unordered_map>
 
 struct aiScene;
@@ -11,11 +13,25 @@ class SceneGraphFactory
 {
 public:
   static Scene createFromAssImpScene(const std::filesystem::path pathToScene, const ComPtr<ID3D12Device>& device,
-                                     const ComPtr<ID3D12CommandQueue>& commandQueue);
+                                     const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy = false);
+
+  /// <summary>
+  /// Creates the scene directly from a glTF 2.0 file without going through Assimp. The binary buffers are memory
+  /// mapped and the vertex attributes are read in place. The resulting scene has the same node, mesh and material
+  /// structure as the one created by createFromAssImpScene, including the conversion to a left-handed coordinate
+  /// system.
+  /// </summary>
+  /// <param name="pathToScene">Path to the .gltf file.</param>
+  /// <param name="device">Device on which the GPU resources are created.</param>
+  /// <param name="commandQueue">Command queue used for uploading the data.</param>
+  /// <param name="keepCpuCopy">If true, the meshes keep their positions and indices in CPU memory, e.g., for
+  /// RayTracingUtils::createCpuAccelerationStructure().</param>
+  static Scene createFromGltf(const std::filesystem::path pathToScene, const ComPtr<ID3D12Device>& device,
+                              const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy = false);
 
 private:
   static void createMeshes(aiScene const* const inputScene, const ComPtr<ID3D12Device>& device,
-                           const ComPtr<ID3D12CommandQueue>& commandQueue, Scene& outputScene);
+                           const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy, Scene& outputScene);
 
   static ui32 createNodes(aiScene const* const inputScene, Scene& outputScene, aiNode const* const startNode,
                           f32m4 worldSpaceTransformation);
@@ -29,5 +45,51 @@ private:
   static void createMaterials(aiScene const* const                            inputScene,
                               std::unordered_map<std::filesystem::path, ui32> textureFileNameToTextureIndex,
                               const ComPtr<ID3D12Device>& device, Scene& outputScene);
+
+  /// <summary>
+  /// Creates one TriangleMeshD3D12 per triangle primitive. Returns for each glTF mesh the indices of its primitives
+  /// in Scene::m_meshes.
+  /// </summary>
+  static std::vector<std::vector<ui32>> createMeshes(const GltfFile& inputScene, const ComPtr<ID3D12Device>& device,
+                                                     const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy,
+                                                     Scene& outputScene);
+
+  /// <summary>
+  /// Like createMeshes, but creates placeholders without GPU buffers. Their bounding boxes are taken from the accessor
+  /// bounds, so the binary buffers are usually not touched. scenePrimitives receives the primitive of each placeholder.
+  /// </summary>
+  static std::vector<std::vector<ui32>> createMeshPlaceholders(
+      const GltfFile& inputScene, Scene& outputScene, std::vector<GltfFile::Primitive const*>& scenePrimitives);
+
+  /// <summary>
+  /// Converts a triangle primitive, optimizes it for the vertex cache and overdraw and uploads it to the GPU.
+  /// </summary>
+  /// <param name="keepCpuCopy">If true, the mesh keeps its positions and indices in CPU memory.</param>
+  /// <param name="statistics">Receives the vertex cache statistics of the mesh, which are added to the given
+  /// ones.</param>
+  static TriangleMeshD3D12 createMesh(const GltfFile& inputScene, const GltfFile::Primitive& primitive,
+                                      const ComPtr<ID3D12Device>&       device,
+                                      const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy,
+                                      MeshOptimizationStatistics&       statistics);
+
+  /// <summary>
+  /// Creates the node hierarchy starting at the root nodes of the glTF scene.
+  /// </summary>
+  static void createNodes(const GltfFile& inputScene, const std::vector<std::vector<ui32>>& sceneMeshIndices,
+                          Scene& outputScene);
+
+  static ui32 createNodes(const GltfFile& inputScene, const std::vector<std::vector<ui32>>& sceneMeshIndices,
+                          Scene& outputScene, ui32 nodeIdx, f32m4 worldSpaceTransformation);
+
+  /// <summary>
+  /// Creates the materials. Textures that are not contained in textureFileNameToTextureIndex are replaced by the
+  /// default texture of the respective slot.
+  /// </summary>
+  static void createMaterials(const GltfFile&                                        inputScene,
+                              const std::unordered_map<std::filesystem::path, ui32>& textureFileNameToTextureIndex,
+                              const ComPtr<ID3D12Device>& device, Scene& outputScene);
+
+  // The progressive loader builds the glTF scene from the same parts.
+  friend class ProgressiveSceneLoader;
 };
 } // namespace gims
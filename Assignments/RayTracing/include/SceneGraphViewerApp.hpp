@@ -1,20 +1,16 @@
 #pragma once
+#include "ProgressiveSceneLoader.hpp"
 #include "RayTracingUtils.hpp"
 #include "Scene.hpp"
 #include "StepTimer.h"
+#include "ViewerSettings.hpp"
+#include <chrono>
+#include <future>
 #include <gimslib/d3d/DX12App.hpp>
 #include <gimslib/types.hpp>
 #include <gimslib/ui/ExaminerController.hpp>
 using namespace gims;
 
-struct PointLight
-{
-  f32 position[3];
-  f32 padding1; // 4 bytes to align to 16 bytes
-  f32v3 color;
-  f32   intensity;
-};
-
 /// <summary>
 /// An app for viewing an Asset Importer Scene Graph.
 /// </summary>
@@ -50,6 +46,24 @@ private:
   /// </summary>
   void createPipeline();
 
+  /// <summary>
+  /// Hands the meshes and textures loaded in the background over to the scene and rebuilds the acceleration structures
+  /// if necessary. Called at the beginning of a frame.
+  /// </summary>
+  void updateScene();
+
+  /// <summary>
+  /// Starts building the CPU acceleration structure for picking on another thread. updateScene() hands it over to the
+  /// scene once it is done, so the frames are not stalled by the build.
+  /// </summary>
+  void startPickingAccelerationStructureBuild();
+
+  /// <summary>
+  /// Picks the triangle under the cursor with a single ray on the CPU acceleration structure of the scene. Called
+  /// every frame, i.e., on every mouse move.
+  /// </summary>
+  void updatePickResult();
+
   /// <summary>
   /// Draws the scene.
   /// </summary>
@@ -70,13 +84,18 @@ private:
     f32   m_shadowBias = 0.0001f;
   };
 
-  ComPtr<ID3D12PipelineState>      m_pipelineState;
-  ComPtr<ID3D12RootSignature>      m_graphicsRootSignature;
-  std::vector<ConstantBufferD3D12> m_sceneConstantBuffers;
-  std::vector<ConstantBufferD3D12> m_lightConstantBuffers;
-  std::vector<PointLight>          m_pointLights;
-  gims::ExaminerController         m_examinerController;
-  Scene                            m_scene;
-  UiData                           m_uiData;
-  RayTracingUtils                  m_rayTracingUtils;
+  ComPtr<ID3D12PipelineState>             m_pipelineState;
+  ComPtr<ID3D12RootSignature>             m_graphicsRootSignature;
+  std::vector<ConstantBufferD3D12>        m_sceneConstantBuffers;
+  std::vector<ConstantBufferD3D12>        m_lightConstantBuffers;
+  std::vector<PointLight>                 m_pointLights;
+  gims::ExaminerController                m_examinerController;
+  Scene                                   m_scene;
+  std::unique_ptr<ProgressiveSceneLoader> m_sceneLoader; //! Loads glTF scenes in the background, null when done.
+  UiData                                  m_uiData;
+  RayTracingUtils                         m_rayTracingUtils;
+  ComPtr<ID3D12CommandAllocator>          m_loadingCommandAllocator; //! Rebuilds of the acceleration structures.
+  ComPtr<ID3D12GraphicsCommandList4>      m_loadingCommandList;      //! Rebuilds of the acceleration structures.
+  Scene::PickResult                       m_pickResult;              //! Triangle under the cursor.
+  std::future<TopLevelAS>                 m_pickingASBuild;          //! Picking structure under construction.
 };
@@ -0,0 +1,89 @@
+#pragma once
+#include <functional>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <gimslib/types.hpp>
+#include <iostream>
+#include <vector>
+
+namespace gims
+{
+/// <summary>
+/// Distributes the square tiles of an image over the threads of a pool with work-stealing. The tiles are emitted in
+/// Morton order and every thread starts with its own contiguous range of this order in a deque, so neighboring tiles,
+/// which touch the same nodes of the acceleration structure and the same textures, tend to run on the same core.
+/// Threads take tiles from the front of their own deque and, when it runs empty, steal from the back of the deques of
+/// the other threads, so expensive regions of the image are shared by all threads instead of a static split.
+/// </summary>
+class TileScheduler
+{
+public:
+  /// <summary>
+  /// Pixel range [x0, x1) x [y0, y1) of a tile.
+  /// </summary>
+  struct Tile
+  {
+    ui32 x0; //! First column.
+    ui32 y0; //! First row.
+    ui32 x1; //! Column after the last one.
+    ui32 y1; //! Row after the last one.
+  };
+
+  /// <summary>
+  /// Cost distribution of the tiles of a run(), in logarithmic bins.
+  /// </summary>
+  struct CostHistogram
+  {
+    f64               firstBinSeconds = 0; //! Upper bound of the first bin. Every further bin doubles the bound.
+    std::vector<ui32> numTiles;            //! Number of tiles per bin.
+
+    /// <summary>
+    /// Prints one line per bin.
+    /// </summary>
+    void print(std::ostream& stream = std::cout) const;
+  };
+
+  /// <summary>
+  /// Load balance and tile costs of a run().
+  /// </summary>
+  struct Statistics
+  {
+    ui32              numSteals = 0;  //! Tiles executed by another thread than the one they were assigned to.
+    std::vector<f32>  tileSeconds;    //! Per tile, in the order of getTiles().
+    std::vector<f64>  threadSeconds;  //! Time every thread spent in tiles.
+    std::vector<ui32> threadNumTiles; //! Number of tiles executed by every thread.
+
+    /// <summary>
+    /// Returns the ratio of the busiest thread's time to the mean time of all threads. 1 means perfect balance.
+    /// </summary>
+    f64 getImbalance() const;
+
+    /// <summary>
+    /// Bins the tile costs into numBins bins whose bounds double, starting with the cheapest tile.
+    /// </summary>
+    CostHistogram getCostHistogram(ui32 numBins = 12) const;
+  };
+
+  /// <summary>
+  /// Splits an image into tiles.
+  /// </summary>
+  /// <param name="width">Image width in pixels.</param>
+  /// <param name="height">Image height in pixels.</param>
+  /// <param name="tileSize">Edge length of the tiles, e.g., 16 or 32. Tiles at the right and bottom border are
+  /// clipped.</param>
+  TileScheduler(ui32 width, ui32 height, ui32 tileSize);
+
+  /// <summary>
+  /// Returns the tiles in Morton order.
+  /// </summary>
+  const std::vector<Tile>& getTiles() const;
+
+  /// <summary>
+  /// Calls function(tile, tileIdx) for every tile on the threads of the pool and returns when all tiles are done.
+  /// tileIdx is the index in getTiles(). Exceptions of function are rethrown.
+  /// </summary>
+  Statistics run(ThreadPool& threadPool, const std::function<void(const Tile&, ui32)>& function) const;
+
+private:
+  std::vector<Tile> m_tiles; //! Tiles in Morton order.
+};
+} // namespace gims
@@ -1,20 +1,76 @@
 #pragma once
 #include "AABB.hpp"
+#include "Vertex.hpp"
 #include <d3d12.h>
 #include <gimslib/types.hpp>
+#include <memory>
 #include <vector>
 #include <wrl.h>
 using Microsoft::WRL::ComPtr;
 
 namespace gims
 {
+class UploadHelper;
 
-struct Vertex
+/// <summary>
+/// Staging memory for the vertex and index buffer of one TriangleMeshD3D12. The data is written directly into mapped
+/// upload heap memory, so every vertex and index is written exactly once on the CPU. The object is move-only and is
+/// consumed by the TriangleMeshD3D12 constructor, which copies the data to the GPU.
+///
+/// The upload heap is write-combined memory: fill it sequentially and never read from it. On request, positions and
+/// indices are additionally kept in CPU memory for the CPU acceleration structures.
+/// </summary>
+class TriangleMeshStagingD3D12
 {
-  gims::f32v3 position;
-  gims::f32v3 normal;
-  gims::f32v2 textureCoordinate;
-  gims::f32v3 tangents;
+public:
+  /// <summary>
+  /// Allocates and maps the upload buffers.
+  /// </summary>
+  /// <param name="nVertices">Number of vertices.</param>
+  /// <param name="nIndices">Number of indices (NOT the number triangles!)</param>
+  /// <param name="device">Device on which the upload buffers are created.</param>
+  /// <param name="keepCpuCopy">If true, positions and indices are also written to CPU memory, see
+  /// TriangleMeshD3D12::getPositions().</param>
+  TriangleMeshStagingD3D12(ui32 nVertices, ui32 nIndices, const ComPtr<ID3D12Device>& device,
+                           bool keepCpuCopy = false);
+
+  ~TriangleMeshStagingD3D12();
+
+  TriangleMeshStagingD3D12(const TriangleMeshStagingD3D12& other)            = delete;
+  TriangleMeshStagingD3D12& operator=(const TriangleMeshStagingD3D12& other) = delete;
+  TriangleMeshStagingD3D12(TriangleMeshStagingD3D12&& other) noexcept;
+  TriangleMeshStagingD3D12& operator=(TriangleMeshStagingD3D12&& other) noexcept;
+
+  /// <summary>
+  /// Writes a vertex, keeps a CPU copy of its position if requested and extends the bounding box by it.
+  /// </summary>
+  /// <param name="vertexIdx">Index of the vertex, must be smaller than the number of vertices.</param>
+  /// <param name="vertex">The vertex.</param>
+  void setVertex(ui32 vertexIdx, const Vertex& vertex);
+
+  /// <summary>
+  /// Writes the three indices of a triangle.
+  /// </summary>
+  /// <param name="triangleIdx">Index of the triangle, must be smaller than the number of indices divided by 3.</param>
+  /// <param name="triangle">The vertex indices of the triangle.</param>
+  void setTriangle(ui32 triangleIdx, const ui32v3& triangle);
+
+  ui32 getNumVertices() const;
+  ui32 getNumIndices() const;
+
+private:
+  friend class TriangleMeshD3D12;
+
+  ui32                          m_nVertices;          //! Number of vertices.
+  ui32                          m_nIndices;           //! Number of indices.
+  std::unique_ptr<UploadHelper> m_vertexUploadHelper; //! Owns the upload buffer for the vertices.
+  std::unique_ptr<UploadHelper> m_indexUploadHelper;  //! Owns the upload buffer for the indices.
+  Vertex*                       m_vertices;           //! Mapped vertex upload buffer.
+  ui32*                         m_indices;            //! Mapped index upload buffer.
+  f32v3                         m_lowerLeftBottom;    //! Bounding box of the vertices written so far.
+  f32v3                         m_upperRightTop;      //! Bounding box of the vertices written so far.
+  std::vector<f32v3>            m_positionsCPU;       //! CPU copy of the vertex positions, empty if not requested.
+  std::vector<ui32>             m_indicesCPU;         //! CPU copy of the indices, empty if not requested.
 };
 
 /// <summary>
@@ -36,11 +92,52 @@ public:
   /// <param name="materialIndex">Material index.</param>
   /// <param name="device">Device on which the GPU buffers should be created.</param>
   /// <param name="commandQueue">Command queue used to copy the data from the GPU to the GPU.</param>
+  /// <param name="keepCpuCopy">If true, positions and indices are kept in CPU memory, see getPositions().</param>
   TriangleMeshD3D12(f32v3 const* const positions, f32v3 const* const normals, f32v3 const* const textureCoordinates,
                     ui32 nVertices, ui32v3 const* const indexBuffer, ui32 nIndices, f32v3 const* const tangents,
                     ui32 materialIndex, const ComPtr<ID3D12Device>& device,
+                    const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy = false);
+
+  /// <summary>
+  /// Constructor that creates a D3D12 GPU Triangle mesh from vertices that are already interleaved and a flat index
+  /// buffer. The data is uploaded as is, without intermediate copies.
+  /// </summary>
+  /// <param name="vertices">Array of interleaved vertices. There must be nVertices elements in this array.</param>
+  /// <param name="nVertices">Number of vertices.</param>
+  /// <param name="indexBuffer">Index buffer for triangle list. Triples of integer indices form a triangle.</param>
+  /// <param name="nIndices">Number of indices (NOT the number triangles!)</param>
+  /// <param name="materialIndex">Material index.</param>
+  /// <param name="device">Device on which the GPU buffers should be created.</param>
+  /// <param name="commandQueue">Command queue used to copy the data from the GPU to the GPU.</param>
+  /// <param name="keepCpuCopy">If true, positions and indices are kept in CPU memory, see getPositions().</param>
+  TriangleMeshD3D12(Vertex const* const vertices, ui32 nVertices, ui32 const* const indexBuffer, ui32 nIndices,
+                    ui32 materialIndex, const ComPtr<ID3D12Device>& device,
+                    const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy = false);
+
+  /// <summary>
+  /// Constructor that creates a D3D12 GPU Triangle mesh from data that has already been written into staging memory.
+  /// The staging memory is consumed: it is copied to the GPU and released when the constructor returns.
+  /// </summary>
+  /// <param name="staging">Filled staging memory.</param>
+  /// <param name="materialIndex">Material index.</param>
+  /// <param name="device">Device on which the GPU buffers should be created.</param>
+  /// <param name="commandQueue">Command queue used to copy the data from the GPU to the GPU.</param>
+  TriangleMeshD3D12(TriangleMeshStagingD3D12 staging, ui32 materialIndex, const ComPtr<ID3D12Device>& device,
                     const ComPtr<ID3D12CommandQueue>& commandQueue);
 
+  /// <summary>
+  /// Creates a placeholder for a mesh whose data is still loading. It has a bounding box and a material, but no GPU
+  /// buffers, see isLoaded().
+  /// </summary>
+  /// <param name="aabb">Axis-aligned bounding box of the mesh that will replace the placeholder.</param>
+  /// <param name="materialIndex">Material index.</param>
+  TriangleMeshD3D12(const AABB& aabb, ui32 materialIndex);
+
+  /// <summary>
+  /// Returns false for placeholders, which must neither be drawn nor be added to acceleration structures.
+  /// </summary>
+  bool isLoaded() const;
+
   /// <summary>
   /// Adds the commands necessary for rendering this triangle mesh to the provided commandList.
   /// </summary>
@@ -62,6 +159,23 @@ public:
   const ComPtr<ID3D12Resource>& getVertexBuffer() const;
   const ComPtr<ID3D12Resource>& getIndexBuffer() const;
 
+  /// <summary>
+  /// Returns a CPU copy of the vertex positions, e.g., for building CPU acceleration structures. Empty for
+  /// placeholders and unless the mesh was created with keepCpuCopy.
+  /// </summary>
+  const std::vector<f32v3>& getPositions() const;
+
+  /// <summary>
+  /// Returns a CPU copy of the triangle list index buffer. Empty for placeholders and unless the mesh was created with
+  /// keepCpuCopy.
+  /// </summary>
+  const std::vector<ui32>& getIndices() const;
+
+  /// <summary>
+  /// Frees the CPU copy of positions and indices, e.g., once the CPU acceleration structures have been built.
+  /// </summary>
+  void releaseCpuCopy();
+
   /// <summary>
   /// Returns the input element descriptors required for the pipeline.
   /// </summary>
@@ -75,6 +189,17 @@ public:
   TriangleMeshD3D12& operator=(TriangleMeshD3D12&& other) noexcept = default;
 
 private:
+  /// <summary>
+  /// Creates the GPU buffers and their views.
+  /// </summary>
+  void createBuffers(const ComPtr<ID3D12Device>& device);
+
+  /// <summary>
+  /// Creates the GPU buffers and uploads the vertex and index data.
+  /// </summary>
+  void createBuffers(void const* const vertexData, void const* const indexData, const ComPtr<ID3D12Device>& device,
+                     const ComPtr<ID3D12CommandQueue>& commandQueue);
+
   ui32                     m_nIndices;         //! Number of indices in the index buffer.
   ui32                     m_vertexBufferSize; //! Vertex buffer size in bytes.
   ui32                     m_indexBufferSize;  //! Index buffer size in bytes.
@@ -84,6 +209,8 @@ private:
   ComPtr<ID3D12Resource>   m_indexBuffer;      //! The index buffer on the GPU.
   D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
   D3D12_INDEX_BUFFER_VIEW  m_indexBufferView;
+  std::vector<f32v3>       m_positionsCPU; //! CPU copy of the vertex positions.
+  std::vector<ui32>        m_indicesCPU;   //! CPU copy of the index buffer.
 
   //! Input element descriptor defining the vertex format.
   static const std::vector<D3D12_INPUT_ELEMENT_DESC> m_inputElementDescs;
@@ -0,0 +1,16 @@
+#pragma once
+#include <gimslib/types.hpp>
+
+namespace gims
+{
+/// <summary>
+/// Vertex of the meshes. The GPU vertex buffers use this layout, the CPU scene keeps the vertices as they are.
+/// </summary>
+struct Vertex
+{
+  gims::f32v3 position;
+  gims::f32v3 normal;
+  gims::f32v2 textureCoordinate;
+  gims::f32v3 tangents;
+};
+} // namespace gims
@@ -0,0 +1,52 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+/// <summary>
+/// Point light as laid out in the light constant buffer of the shader.
+/// </summary>
+struct PointLight
+{
+  f32 position[3];
+  f32 padding1; // 4 bytes to align to 16 bytes
+  f32v3 color;
+  f32   intensity;
+};
+
+/// <summary>
+/// Initial translation of the examiner controller. The viewer and the headless renderer start with the same camera.
+/// </summary>
+inline const f32v3 DEFAULT_CAMERA_TRANSLATION = f32v3(0, -0.25f, 1.5);
+
+/// <summary>
+/// Projection matrix of the viewer: 45 degrees vertical field of view, near plane 0.01, far plane 1000.
+/// </summary>
+inline f32m4 getProjectionMatrix(ui32 width, ui32 height)
+{
+  return glm::perspectiveFovLH_ZO<f32>(glm::radians(45.0f), (f32)width, (f32)height, 0.01f, 1000.0f);
+}
+
+/// <summary>
+/// The lights the viewer starts with.
+/// </summary>
+inline std::vector<PointLight> getDefaultPointLights()
+{
+  PointLight p1;
+  p1.position[0] = -20.0f;
+  p1.position[1] = 55.5f;
+  p1.position[2] = -30.0f;
+  p1.color       = f32v3(1.0f, 0.5f, 0.5f);
+  p1.intensity   = 50.0f;
+
+  PointLight p2;
+  p2.position[0] = 22.0f;
+  p2.position[1] = 11.0f;
+  p2.position[2] = -21.0f;
+  p2.color       = f32v3(1.0f, 1.0f, 1.0f);
+  p2.intensity   = 50.0f;
+
+  return {p1, p2};
+}
+} // namespace gims
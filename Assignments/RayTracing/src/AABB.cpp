@@ -18,6 +18,11 @@ AABB::AABB(f32v3 const* const positions, ui32 nPositions)
     m_upperRightTop   = glm::max(m_upperRightTop, p);
   }
 }
+AABB::AABB(const f32v3& lowerLeftBottom, const f32v3& upperRightTop)
+    : m_lowerLeftBottom(lowerLeftBottom)
+    , m_upperRightTop(upperRightTop)
+{
+}
 f32m4 AABB::getNormalizationTransformation() const
 {
   // Scale to [-0.5,...,0.5]^3
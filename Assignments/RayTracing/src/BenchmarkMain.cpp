@@ -0,0 +1,492 @@
+#include "CpuRenderer.hpp"
+#include "CpuSceneFactory.hpp"
+#include "ViewerSettings.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <gimslib/types.hpp>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+using namespace gims;
+
+namespace
+{
+/// <summary>
+/// Command line of the benchmark.
+/// </summary>
+struct Options
+{
+  std::filesystem::path    dataDirectory = "../../../data";       //! Every subdirectory with a glTF file is a scene.
+  std::filesystem::path    outputPath    = "RayTracingBenchmark"; //! Results go to .json and .csv files of this name.
+  std::filesystem::path    baselinePath;                          //! CSV file of an earlier run, empty for none.
+  std::vector<std::string> sceneNames;                            //! Scenes to measure, empty for all.
+  std::vector<ui32>        threadCounts;                          //! Empty: 1, 2, 4, ... and the hardware threads.
+  ui32                     width       = 640;                     //! Image width.
+  ui32                     height      = 360;                     //! Image height.
+  ui32                     repetitions = 3;                       //! Measurements per value, the median is reported.
+  f64                      tolerance   = 0.1;                     //! Relative change that counts as regression.
+};
+
+/// <summary>
+/// Fixed camera pose relative to the normalized scene, applied like the ExaminerController of the viewer: the
+/// scene is rotated around its center, then translated.
+/// </summary>
+struct CameraPose
+{
+  const char* name;         //! Name in the results.
+  f32         yawDegrees;   //! Rotation around the y axis.
+  f32         pitchDegrees; //! Rotation around the x axis, positive values look down onto the scene.
+  f32v3       translation;  //! Translation after the rotation.
+};
+
+/// <summary>
+/// The camera poses of every scene: the start view of the viewer, two views from other sides, and one from the scene
+/// center, which is inside of closed scenes such as sponza and makes most rays hit.
+/// </summary>
+const CameraPose CAMERA_POSES[] = {{"front", 0.0f, 0.0f, DEFAULT_CAMERA_TRANSLATION},
+                                   {"side", 90.0f, 15.0f, DEFAULT_CAMERA_TRANSLATION},
+                                   {"above", 30.0f, 60.0f, DEFAULT_CAMERA_TRANSLATION},
+                                   {"center", 180.0f, 0.0f, f32v3(0.0f)}};
+
+/// <summary>
+/// One measured value.
+/// </summary>
+struct Result
+{
+  std::string scene;      //! Name of the scene directory.
+  std::string camera;     //! Name of the camera pose, "-" for values that do not depend on it.
+  ui32        numThreads; //! Threads of the pool.
+  std::string metric;     //! What was measured, see isHigherBetter().
+  f64         value;      //! Median over the repetitions.
+};
+
+/// <summary>
+/// Identifies a value across runs.
+/// </summary>
+using ResultKey = std::tuple<std::string, std::string, ui32, std::string>;
+
+/// <summary>
+/// Prints the command line syntax.
+/// </summary>
+void printUsage()
+{
+  std::cout << "Usage: RayTracingBenchmark [options]\n"
+               "  --data <directory>                  Directory whose subdirectories contain the glTF scenes.\n"
+               "  --scenes <name,name,...>            Scenes to measure, all by default.\n"
+               "  --threads <n,n,...>                 Thread counts, by default 1, 2, 4, ... up to the hardware.\n"
+               "  --width <pixels> --height <pixels>  Image size.\n"
+               "  --repetitions <n>                   Measurements per value, the median is reported.\n"
+               "  --output <path>                     Writes <path>.json and <path>.csv.\n"
+               "  --baseline <file.csv>               Compares with an earlier run of the same size and repetitions.\n"
+               "  --tolerance <fraction>              Relative change that counts as regression, e.g., 0.1.\n"
+               "Returns 2 if a value regressed compared to the baseline."
+            << std::endl;
+}
+
+/// <summary>
+/// Splits a comma separated list.
+/// </summary>
+std::vector<std::string> splitList(const std::string& list)
+{
+  std::vector<std::string> items;
+  std::stringstream        stream(list);
+  std::string              item;
+  while (std::getline(stream, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+/// <summary>
+/// Parses the command line. Throws, if it is invalid.
+/// </summary>
+Options parseOptions(int argc, char** argv)
+{
+  Options options;
+
+  const auto toUi32 = [](const std::string& value) { return static_cast<ui32>(std::stoul(value)); };
+  const std::unordered_map<std::string, std::function<void(const std::string&)>> handlers = {
+      {"--data", [&](const std::string& v) { options.dataDirectory = v; }},
+      {"--scenes", [&](const std::string& v) { options.sceneNames = splitList(v); }},
+      {"--threads", [&](const std::string& v)
+       {
+         for (const auto& item : splitList(v))
+         {
+           options.threadCounts.push_back(std::max(toUi32(item), 1u));
+         }
+       }},
+      {"--width", [&](const std::string& v) { options.width = toUi32(v); }},
+      {"--height", [&](const std::string& v) { options.height = toUi32(v); }},
+      {"--repetitions", [&](const std::string& v) { options.repetitions = std::max(toUi32(v), 1u); }},
+      {"--output", [&](const std::string& v) { options.outputPath = v; }},
+      {"--baseline", [&](const std::string& v) { options.baselinePath = v; }},
+      {"--tolerance", [&](const std::string& v) { options.tolerance = std::stod(v); }}};
+
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    const auto        handler  = handlers.find(argument);
+    if (handler == handlers.end() || i + 1 == argc)
+    {
+      throw std::runtime_error("Invalid option " + argument + ".");
+    }
+    handler->second(argv[++i]);
+  }
+
+  if (options.threadCounts.empty())
+  {
+    const ui32 numHardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (ui32 numThreads = 1; numThreads < numHardwareThreads; numThreads *= 2)
+    {
+      options.threadCounts.push_back(numThreads);
+    }
+    options.threadCounts.push_back(numHardwareThreads);
+  }
+  return options;
+}
+
+/// <summary>
+/// Returns the glTF file of every scene directory by name, e.g., desk/scene.gltf or sponza/glTF/Sponza.gltf.
+/// </summary>
+std::map<std::string, std::filesystem::path> findScenes(const Options& options)
+{
+  std::map<std::string, std::filesystem::path> scenes;
+  for (const auto& directory : std::filesystem::directory_iterator(options.dataDirectory))
+  {
+    if (!directory.is_directory())
+    {
+      continue;
+    }
+    const std::string name = directory.path().filename().string();
+    if (!options.sceneNames.empty() &&
+        std::find(options.sceneNames.begin(), options.sceneNames.end(), name) == options.sceneNames.end())
+    {
+      continue;
+    }
+    for (const auto& file : std::filesystem::recursive_directory_iterator(directory.path()))
+    {
+      if (file.is_regular_file() && file.path().extension() == ".gltf")
+      {
+        scenes[name] = file.path();
+        break;
+      }
+    }
+  }
+  return scenes;
+}
+
+/// <summary>
+/// Returns true for throughputs, false for times.
+/// </summary>
+bool isHigherBetter(const std::string& metric)
+{
+  return metric.find("seconds") == std::string::npos || metric.find("per_second") != std::string::npos;
+}
+
+/// <summary>
+/// Returns the median of the measurements.
+/// </summary>
+f64 getMedian(std::vector<f64> values)
+{
+  std::sort(values.begin(), values.end());
+  const size_t middle = values.size() / 2;
+  return values.size() % 2 == 1 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+/// <summary>
+/// Returns rays per second in millions, 0 if no ray was traced.
+/// </summary>
+f64 getMegaRaysPerSecond(ui64 numRays, f64 seconds)
+{
+  return seconds > 0.0 ? static_cast<f64>(numRays) / seconds / 1e6 : 0.0;
+}
+
+/// <summary>
+/// Returns the camera of a pose, see CameraPose.
+/// </summary>
+CpuRenderer::Camera getCamera(const CameraPose& pose, const CpuScene& scene, const Options& options)
+{
+  f32m4 rotation = glm::rotate(f32m4(1.0f), -glm::radians(pose.pitchDegrees), f32v3(1.0f, 0.0f, 0.0f));
+  rotation       = glm::rotate(rotation, glm::radians(pose.yawDegrees), f32v3(0.0f, 1.0f, 0.0f));
+
+  CpuRenderer::Camera camera;
+  camera.viewMatrix       = glm::translate(f32m4(1.0f), pose.translation) * rotation *
+                            scene.getAABB().getNormalizationTransformation();
+  camera.projectionMatrix = getProjectionMatrix(options.width, options.height);
+  return camera;
+}
+
+/// <summary>
+/// Measures the BVH build and the ray throughput of one scene with one thread count.
+/// </summary>
+/// <remarks>
+/// Every pose renders five passes into one accumulation. The first pass has no lights, so it only traces the
+/// primary rays. The following passes reuse the primary hits and only trace shadow rays towards the default lights
+/// or ambient occlusion rays, first in pixel order and then sorted by CpuRenderer::Settings::sortSecondaryRays.
+/// Shading and sorting are included in the times, like in the viewer.
+/// </remarks>
+void measureScene(const std::string& name, const CpuScene& scene, ui32 numThreads, const Options& options,
+                  std::vector<Result>& results)
+{
+  ThreadPool       threadPool(numThreads);
+  BvhBuildSettings bottomLevelSettings;
+  bottomLevelSettings.threadPool = &threadPool;
+
+  std::vector<f64> buildSeconds;
+  for (ui32 i = 0; i < options.repetitions; i++)
+  {
+    const auto        start = std::chrono::steady_clock::now();
+    const CpuRenderer renderer(scene, bottomLevelSettings);
+    buildSeconds.push_back(std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count());
+  }
+  results.push_back({name, "-", numThreads, "bvh_build_seconds", getMedian(buildSeconds)});
+
+  const CpuRenderer     renderer(scene, bottomLevelSettings);
+  CpuRenderer::Settings settings;
+  settings.width  = options.width;
+  settings.height = options.height;
+  CpuRenderer::Settings ambientOcclusionSettings = settings;
+  ambientOcclusionSettings.mode                  = CpuRenderer::RenderMode::AmbientOcclusion;
+
+  CpuRenderer::Settings sortedSettings                 = settings;
+  sortedSettings.sortSecondaryRays                     = true;
+  CpuRenderer::Settings sortedAmbientOcclusionSettings = ambientOcclusionSettings;
+  sortedAmbientOcclusionSettings.sortSecondaryRays     = true;
+
+  std::vector<ui8v4> image;
+  for (const CameraPose& pose : CAMERA_POSES)
+  {
+    const CpuRenderer::Camera camera = getCamera(pose, scene, options);
+    std::vector<f64>          primary, shadow, ambientOcclusion, sortedShadow, sortedAmbientOcclusion;
+    for (ui32 i = 0; i < options.repetitions; i++)
+    {
+      CpuRenderer::Accumulation accumulation;
+      const auto primaryPass = renderer.render(camera, {}, settings, threadPool, accumulation, image);
+      const auto shadowPass =
+          renderer.render(camera, getDefaultPointLights(), settings, threadPool, accumulation, image);
+      const auto ambientOcclusionPass =
+          renderer.render(camera, {}, ambientOcclusionSettings, threadPool, accumulation, image);
+      const auto sortedShadowPass =
+          renderer.render(camera, getDefaultPointLights(), sortedSettings, threadPool, accumulation, image);
+      const auto sortedAmbientOcclusionPass =
+          renderer.render(camera, {}, sortedAmbientOcclusionSettings, threadPool, accumulation, image);
+      primary.push_back(getMegaRaysPerSecond(primaryPass.numPrimaryRays, primaryPass.seconds));
+      shadow.push_back(getMegaRaysPerSecond(shadowPass.numShadowRays, shadowPass.seconds));
+      ambientOcclusion.push_back(
+          getMegaRaysPerSecond(ambientOcclusionPass.numAmbientOcclusionRays, ambientOcclusionPass.seconds));
+      sortedShadow.push_back(getMegaRaysPerSecond(sortedShadowPass.numShadowRays, sortedShadowPass.seconds));
+      sortedAmbientOcclusion.push_back(getMegaRaysPerSecond(sortedAmbientOcclusionPass.numAmbientOcclusionRays,
+                                                            sortedAmbientOcclusionPass.seconds));
+    }
+    results.push_back({name, pose.name, numThreads, "primary_mrays_per_second", getMedian(primary)});
+    results.push_back({name, pose.name, numThreads, "shadow_mrays_per_second", getMedian(shadow)});
+    results.push_back({name, pose.name, numThreads, "ao_mrays_per_second", getMedian(ambientOcclusion)});
+    results.push_back({name, pose.name, numThreads, "shadow_sorted_mrays_per_second", getMedian(sortedShadow)});
+    results.push_back({name, pose.name, numThreads, "ao_sorted_mrays_per_second", getMedian(sortedAmbientOcclusion)});
+  }
+}
+
+/// <summary>
+/// Returns the settings of a run that its values depend on, e.g., "width=640,height=360,repetitions=3". Runs are only
+/// compared if these match.
+/// </summary>
+std::string getRunSettings(const Options& options)
+{
+  return "width=" + std::to_string(options.width) + ",height=" + std::to_string(options.height) +
+         ",repetitions=" + std::to_string(options.repetitions);
+}
+
+/// <summary>
+/// Writes the results as CSV: a comment line with the run settings, see getRunSettings(), a header line and one value
+/// per line.
+/// </summary>
+void writeCsv(const std::filesystem::path& path, const Options& options, const std::vector<Result>& results)
+{
+  std::ofstream file(path);
+  file << "# " << getRunSettings(options) << "\n";
+  file << "scene,camera,threads,metric,value\n" << std::setprecision(6);
+  for (const auto& result : results)
+  {
+    file << result.scene << ',' << result.camera << ',' << result.numThreads << ',' << result.metric << ','
+         << result.value << '\n';
+  }
+  if (!file)
+  {
+    throw std::runtime_error("Could not write " + path.string() + ".");
+  }
+}
+
+/// <summary>
+/// Writes the settings of the run and the results as JSON.
+/// </summary>
+void writeJson(const std::filesystem::path& path, const Options& options, const std::vector<Result>& results)
+{
+  std::ofstream file(path);
+  file << "{\n  \"width\": " << options.width << ",\n  \"height\": " << options.height
+       << ",\n  \"repetitions\": " << options.repetitions << ",\n  \"results\": [\n"
+       << std::setprecision(6);
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const Result& result = results[i];
+    file << "    {\"scene\": \"" << result.scene << "\", \"camera\": \"" << result.camera
+         << "\", \"threads\": " << result.numThreads << ", \"metric\": \"" << result.metric
+         << "\", \"value\": " << result.value << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  file << "  ]\n}\n";
+  if (!file)
+  {
+    throw std::runtime_error("Could not write " + path.string() + ".");
+  }
+}
+
+/// <summary>
+/// Reads the values of a CSV file written by writeCsv(). Throws, if its run settings differ from the current ones,
+/// since values of different image sizes or repetitions are not comparable.
+/// </summary>
+std::map<ResultKey, f64> readCsv(const std::filesystem::path& path, const Options& options)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    throw std::runtime_error("Could not read " + path.string() + ".");
+  }
+  std::string line;
+  std::getline(file, line);
+  const std::string runSettings = getRunSettings(options);
+  if (line.rfind("# ", 0) != 0)
+  {
+    throw std::runtime_error(path.string() + " does not contain the run settings, expected \"# " + runSettings +
+                             "\" in the first line.");
+  }
+  if (line.substr(2) != runSettings)
+  {
+    throw std::runtime_error("The baseline " + path.string() + " was measured with " + line.substr(2) +
+                             ", this run uses " + runSettings + ". Rerun with the settings of the baseline.");
+  }
+  std::map<ResultKey, f64> values;
+  std::getline(file, line);
+  while (std::getline(file, line))
+  {
+    const std::vector<std::string> fields = splitList(line);
+    if (fields.size() != 5)
+    {
+      throw std::runtime_error("Invalid line in " + path.string() + ": " + line);
+    }
+    values[{fields[0], fields[1], static_cast<ui32>(std::stoul(fields[2])), fields[3]}] = std::stod(fields[4]);
+  }
+  return values;
+}
+
+/// <summary>
+/// Prints the relative change of every value that the baseline contains and returns the number of regressions,
+/// i.e., changes in the worse direction by more than the tolerance.
+/// </summary>
+ui32 compareWithBaseline(const std::vector<Result>& results, const std::map<ResultKey, f64>& baseline,
+                         const Options& options)
+{
+  ui32 numRegressions = 0;
+  ui32 numCompared    = 0;
+  std::cout << "Comparison with " << options.baselinePath.string() << ":" << std::endl;
+  for (const auto& result : results)
+  {
+    const auto base = baseline.find({result.scene, result.camera, result.numThreads, result.metric});
+    if (base == baseline.end() || base->second == 0.0)
+    {
+      continue;
+    }
+    numCompared++;
+    const f64  change    = (result.value - base->second) / base->second;
+    const bool regressed = isHigherBetter(result.metric) ? change < -options.tolerance : change > options.tolerance;
+    numRegressions += regressed ? 1 : 0;
+    std::cout << (regressed ? "REGRESSION " : "           ") << result.scene << " " << result.camera << " "
+              << result.numThreads << " threads " << result.metric << ": " << base->second << " -> " << result.value
+              << " (" << std::showpos << std::fixed << std::setprecision(1) << 100.0 * change << "%)"
+              << std::noshowpos << std::defaultfloat << std::setprecision(6) << std::endl;
+  }
+  std::cout << numCompared << " values compared, " << numRegressions << " regressions beyond "
+            << 100.0 * options.tolerance << "%" << std::endl;
+  return numRegressions;
+}
+} // namespace
+
+/// <summary>
+/// Measures BVH build times and primary, shadow and ambient occlusion ray throughput of the CPU renderer for every
+/// scene in the data directory, fixed camera poses and several thread counts. Writes the results as JSON and CSV and
+/// optionally compares them with the CSV file of an earlier run to catch regressions.
+/// </summary>
+int main(int argc, char** argv)
+{
+  try
+  {
+    const Options options = parseOptions(argc, argv);
+    const auto    scenes  = findScenes(options);
+    if (scenes.empty())
+    {
+      throw std::runtime_error("No scenes found in " + options.dataDirectory.string() + ".");
+    }
+    // Read before measuring, so that a baseline with other settings fails right away.
+    const auto baseline =
+        options.baselinePath.empty() ? std::map<ResultKey, f64>() : readCsv(options.baselinePath, options);
+
+    std::vector<Result> results;
+    for (const auto& [name, path] : scenes)
+    {
+      std::cout << "Scene " << name << ": " << path.string() << std::endl;
+      CpuScene scene;
+      try
+      {
+        scene = CpuSceneFactory::createFromGltf(path);
+      }
+      catch (const std::exception& e)
+      {
+        // Incomplete checkouts lack some scene files. Their values are missing from the results and the comparison.
+        std::cerr << "Skipping " << name << ": " << e.what() << "\n";
+        continue;
+      }
+      for (const ui32 numThreads : options.threadCounts)
+      {
+        const size_t firstResult = results.size();
+        measureScene(name, scene, numThreads, options, results);
+        for (size_t i = firstResult; i < results.size(); i++)
+        {
+          std::cout << "  " << numThreads << " threads, " << results[i].camera << ", " << results[i].metric << ": "
+                    << std::setprecision(4) << results[i].value << std::endl;
+        }
+      }
+    }
+
+    std::filesystem::path jsonPath = options.outputPath;
+    std::filesystem::path csvPath  = options.outputPath;
+    writeJson(jsonPath.replace_extension(".json"), options, results);
+    writeCsv(csvPath.replace_extension(".csv"), options, results);
+    std::cout << "Written to " << jsonPath.string() << " and " << csvPath.string() << std::endl;
+
+    if (!options.baselinePath.empty() && compareWithBaseline(results, baseline, options) > 0)
+    {
+      return 2;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << "\n";
+    printUsage();
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,516 @@
+#include "CpuRenderer.hpp"
+#include "Sampling.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+using namespace gims;
+
+namespace
+{
+/// <summary>
+/// Start of the shadow rays, as in PS_main. The origin is additionally offset by the shadow bias.
+/// </summary>
+constexpr f32 SHADOW_RAY_T_MIN = 0.0001f;
+
+/// <summary>
+/// Decorrelates the ambient occlusion samples of a pixel from its light samples, which use the light index.
+/// </summary>
+constexpr ui32 AMBIENT_OCCLUSION_SAMPLE_DIMENSION = 1024;
+
+/// <summary>
+/// Number of vertices that a thread bakes at once.
+/// </summary>
+constexpr ui32 BAKE_GRAIN_SIZE = 256;
+
+/// <summary>
+/// Transforms a point from clip space into world space.
+/// </summary>
+f32v3 unproject(const f32m4& clipToWorld, f32v2 ndc, f32 depth)
+{
+  const f32v4 p = clipToWorld * f32v4(ndc.x, ndc.y, depth, 1.0f);
+  return f32v3(p) / p.w;
+}
+
+/// <summary>
+/// Maps x in [0, 1] to a color ramp from blue over cyan, green and yellow to red.
+/// </summary>
+ui8v4 getHeatmapColor(f32 x)
+{
+  static const f32v3 ramp[] = {f32v3(0.0f, 0.0f, 1.0f), f32v3(0.0f, 1.0f, 1.0f), f32v3(0.0f, 1.0f, 0.0f),
+                               f32v3(1.0f, 1.0f, 0.0f), f32v3(1.0f, 0.0f, 0.0f)};
+  const f32   position = std::clamp(x, 0.0f, 1.0f) * 4.0f;
+  const ui32  i        = std::min(static_cast<ui32>(position), 3u);
+  const f32v3 color    = glm::mix(ramp[i], ramp[i + 1], position - static_cast<f32>(i));
+  return ui8v4(ui8v3(glm::round(color * 255.0f)), 255);
+}
+} // namespace
+
+namespace gims
+{
+f64 CpuRenderer::Statistics::getMegaRaysPerSecond() const
+{
+  const ui64 numRays = numPrimaryRays + numShadowRays + numAmbientOcclusionRays;
+  return seconds > 0.0 ? static_cast<f64>(numRays) / seconds / 1e6 : 0.0;
+}
+
+CpuRenderer::CpuRenderer(const CpuScene& scene, const BvhBuildSettings& bottomLevelSettings, BvhCache* bvhCache)
+    : m_scene(scene)
+{
+  m_tlas = scene.createAccelerationStructure(bottomLevelSettings, bvhCache);
+  for (const auto& instance : m_tlas.getInstances())
+  {
+    const f32m3 objectToWorld = f32m3(instance.transformation);
+    m_instances.push_back({instance.instanceID, glm::transpose(glm::inverse(objectToWorld)), {}});
+  }
+}
+
+void CpuRenderer::Accumulation::reset()
+{
+  numPasses = 0;
+}
+
+CpuRenderer::Statistics CpuRenderer::render(const Camera& camera, const std::vector<PointLight>& pointLights,
+                                            const Settings& settings, ThreadPool& threadPool,
+                                            std::vector<ui8v4>& image) const
+{
+  Accumulation accumulation;
+  return render(camera, pointLights, settings, threadPool, accumulation, image);
+}
+
+CpuRenderer::Statistics CpuRenderer::render(const Camera& camera, const std::vector<PointLight>& pointLights,
+                                            const Settings& settings, ThreadPool& threadPool,
+                                            Accumulation& accumulation, std::vector<ui8v4>& image) const
+{
+  if (settings.mode == RenderMode::BakedAmbientOcclusion && !hasBakedAmbientOcclusion())
+  {
+    throw std::runtime_error("The ambient occlusion must be baked before it can be rendered.");
+  }
+  const auto start = std::chrono::steady_clock::now();
+
+  const size_t numPixels = static_cast<size_t>(settings.width) * settings.height;
+  if (accumulation.width != settings.width || accumulation.height != settings.height ||
+      accumulation.camera.viewMatrix != camera.viewMatrix ||
+      accumulation.camera.projectionMatrix != camera.projectionMatrix)
+  {
+    accumulation.reset();
+  }
+  if (accumulation.numPasses == 0)
+  {
+    accumulation.radianceSums.assign(numPixels, f32v3(0.0f));
+    accumulation.primaryHits.resize(numPixels);
+    accumulation.camera = camera;
+    accumulation.width  = settings.width;
+    accumulation.height = settings.height;
+  }
+
+  image.resize(numPixels);
+  const f32m4         clipToWorld              = glm::inverse(camera.projectionMatrix * camera.viewMatrix);
+  const f32           ambientOcclusionDistance = getAmbientOcclusionDistance(settings);
+  const RaySorter     raySorter(m_tlas.getBounds());
+  const TileScheduler tileScheduler(settings.width, settings.height, settings.tileSize);
+
+  // Tiles write disjoint pixels and their own statistics, which are summed up afterwards.
+  std::vector<Statistics> tileStatistics(tileScheduler.getTiles().size());
+  Statistics              statistics;
+  statistics.tiles = tileScheduler.run(threadPool,
+                                       [&](const TileScheduler::Tile& tile, ui32 tileIdx)
+                                       {
+                                         renderTile(clipToWorld, pointLights, settings, ambientOcclusionDistance,
+                                                    raySorter, threadPool, tile, accumulation, image,
+                                                    tileStatistics[tileIdx]);
+                                       });
+  accumulation.numPasses++;
+
+  for (const auto& tile : tileStatistics)
+  {
+    statistics.numPrimaryRays += tile.numPrimaryRays;
+    statistics.numShadowRays += tile.numShadowRays;
+    statistics.numAmbientOcclusionRays += tile.numAmbientOcclusionRays;
+    statistics.raySortingSeconds += tile.raySortingSeconds;
+    statistics.traversal += tile.traversal;
+    if (settings.countTraversal)
+    {
+      statistics.tileTraversal.push_back(tile.traversal);
+    }
+  }
+  statistics.seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+  return statistics;
+}
+
+CpuRenderer::Statistics CpuRenderer::bakeAmbientOcclusion(const Settings& settings, ThreadPool& threadPool)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const f32  maxDistance = getAmbientOcclusionDistance(settings);
+  Statistics statistics;
+  for (ui32 instanceIdx = 0; instanceIdx < static_cast<ui32>(m_instances.size()); instanceIdx++)
+  {
+    InstanceData&         instance      = m_instances[instanceIdx];
+    const CpuScene::Mesh& mesh          = m_scene.getMesh(instance.meshIdx);
+    const f32m4&          objectToWorld = m_tlas.getInstances()[instanceIdx].transformation;
+    const ui32            numVertices   = static_cast<ui32>(mesh.vertices.size());
+    instance.vertexAmbientOcclusion.resize(numVertices);
+
+    // Chunks count their rays separately, which are summed up afterwards.
+    std::vector<ui64> chunkNumRays((numVertices + BAKE_GRAIN_SIZE - 1) / BAKE_GRAIN_SIZE, 0);
+    threadPool.parallelFor(0, numVertices, BAKE_GRAIN_SIZE,
+                           [&](ui32 begin, ui32 end)
+                           {
+                             Occluder                 occluder;
+                             ui64                     numRays   = 0;
+                             const VisibilityFunction isVisible = [&](const Ray& ray, ui32)
+                             {
+                               numRays++;
+                               return !m_tlas.occluded(ray, occluder);
+                             };
+                             for (ui32 vertexIdx = begin; vertexIdx < end; vertexIdx++)
+                             {
+                               const Vertex& vertex   = mesh.vertices[vertexIdx];
+                               const f32v3   position = f32v3(objectToWorld * f32v4(vertex.position, 1.0f));
+                               const f32v3   normal   = instance.normalMatrix * vertex.normal;
+                               instance.vertexAmbientOcclusion[vertexIdx] =
+                                   glm::dot(normal, normal) > 0.0f
+                                       ? traceAmbientOcclusion(position, glm::normalize(normal), settings, maxDistance,
+                                                               vertexIdx, instanceIdx, 0, isVisible)
+                                       : 1.0f;
+                             }
+                             chunkNumRays[begin / BAKE_GRAIN_SIZE] = numRays;
+                           });
+    for (const ui64 numRays : chunkNumRays)
+    {
+      statistics.numAmbientOcclusionRays += numRays;
+    }
+  }
+
+  statistics.seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+  return statistics;
+}
+
+std::vector<ui8v4> CpuRenderer::createHeatmap(const Settings& settings, const Statistics& statistics,
+                                              HeatmapMetric metric)
+{
+  const TileScheduler tileScheduler(settings.width, settings.height, settings.tileSize);
+  const auto&         tiles = tileScheduler.getTiles();
+  if (statistics.tileTraversal.size() != tiles.size())
+  {
+    throw std::runtime_error("The statistics do not contain the traversal counters of the tiles.");
+  }
+
+  std::vector<f32> workPerPixel(tiles.size());
+  f32              maxWorkPerPixel = 0.0f;
+  for (size_t i = 0; i < tiles.size(); i++)
+  {
+    const TraversalCounters& counters = statistics.tileTraversal[i];
+    const ui64 work = metric == HeatmapMetric::NodesVisited ? counters.numNodesVisited : counters.numTrianglesTested;
+    const ui32 numPixels = (tiles[i].x1 - tiles[i].x0) * (tiles[i].y1 - tiles[i].y0);
+    workPerPixel[i]      = static_cast<f32>(work) / static_cast<f32>(numPixels);
+    maxWorkPerPixel      = std::max(maxWorkPerPixel, workPerPixel[i]);
+  }
+
+  std::vector<ui8v4> heatmap(static_cast<size_t>(settings.width) * settings.height);
+  for (size_t i = 0; i < tiles.size(); i++)
+  {
+    const ui8v4 color = getHeatmapColor(maxWorkPerPixel > 0.0f ? workPerPixel[i] / maxWorkPerPixel : 0.0f);
+    for (ui32 y = tiles[i].y0; y < tiles[i].y1; y++)
+    {
+      std::fill_n(heatmap.begin() + static_cast<size_t>(y) * settings.width + tiles[i].x0, tiles[i].x1 - tiles[i].x0,
+                  color);
+    }
+  }
+  return heatmap;
+}
+
+bool CpuRenderer::hasBakedAmbientOcclusion() const
+{
+  return !m_instances.empty() && !m_instances[0].vertexAmbientOcclusion.empty();
+}
+
+const TopLevelAS& CpuRenderer::getAccelerationStructure() const
+{
+  return m_tlas;
+}
+
+f32 CpuRenderer::getAmbientOcclusionDistance(const Settings& settings) const
+{
+  const BoundingBox bounds = m_tlas.getBounds();
+  return settings.ambientOcclusionDistance * glm::length(bounds.upperRightTop - bounds.lowerLeftBottom);
+}
+
+void CpuRenderer::renderTile(const f32m4& clipToWorld, const std::vector<PointLight>& pointLights,
+                             const Settings& settings, f32 ambientOcclusionDistance, const RaySorter& raySorter,
+                             ThreadPool& threadPool, const TileScheduler::Tile& tile, Accumulation& accumulation,
+                             std::vector<ui8v4>& image, Statistics& statistics) const
+{
+  // Primary rays start at the near plane and end at the far plane, like the rasterized fragments of the viewer.
+  RayBatch batch;
+  batch.rays.reserve(static_cast<size_t>(tile.x1 - tile.x0) * (tile.y1 - tile.y0));
+  for (ui32 y = tile.y0; y < tile.y1; y++)
+  {
+    for (ui32 x = tile.x0; x < tile.x1; x++)
+    {
+      const f32v2 ndc(2.0f * (static_cast<f32>(x) + 0.5f) / static_cast<f32>(settings.width) - 1.0f,
+                      1.0f - 2.0f * (static_cast<f32>(y) + 0.5f) / static_cast<f32>(settings.height));
+      const f32v3 nearPoint = unproject(clipToWorld, ndc, 0.0f);
+      const f32v3 direction = unproject(clipToWorld, ndc, 1.0f) - nearPoint;
+      const f32   length    = glm::length(direction);
+
+      Ray ray;
+      ray.origin    = nearPoint;
+      ray.direction = direction / length;
+      ray.tMax      = length;
+      batch.rays.push_back(ray);
+    }
+  }
+
+  // The primary hits do not change while the camera stands still, so only the first pass traces them.
+  const ui32 tileWidth = tile.x1 - tile.x0;
+  const auto pixelIdx  = [&](ui32 i)
+  { return static_cast<size_t>(tile.y0 + i / tileWidth) * settings.width + tile.x0 + i % tileWidth; };
+  TraversalCounters* counters = settings.countTraversal ? &statistics.traversal : nullptr;
+  if (accumulation.numPasses == 0)
+  {
+    if (counters)
+    {
+      batch.hits.assign(batch.rays.size(), RayHit());
+      for (ui32 i = 0; i < static_cast<ui32>(batch.rays.size()); i++)
+      {
+        m_tlas.intersect(batch.rays[i], batch.hits[i], TopLevelAS::ALL_INSTANCES, counters);
+      }
+    }
+    else
+    {
+      m_tlas.intersect(batch);
+    }
+    statistics.numPrimaryRays += batch.rays.size();
+    for (ui32 i = 0; i < static_cast<ui32>(batch.rays.size()); i++)
+    {
+      accumulation.primaryHits[pixelIdx(i)] = batch.hits[i];
+    }
+  }
+  else
+  {
+    batch.hits.resize(batch.rays.size());
+    for (ui32 i = 0; i < static_cast<ui32>(batch.rays.size()); i++)
+    {
+      batch.hits[i] = accumulation.primaryHits[pixelIdx(i)];
+    }
+  }
+
+  std::vector<SurfacePoint> surfaces(batch.rays.size());
+  for (ui32 i = 0; i < static_cast<ui32>(batch.rays.size()); i++)
+  {
+    if (batch.hits[i].isHit())
+    {
+      surfaces[i] = getSurfacePoint(batch.rays[i], batch.hits[i]);
+    }
+  }
+  const auto getColor = [&](ui32 i, const VisibilityFunction& isVisible)
+  {
+    if (!batch.hits[i].isHit())
+    {
+      return settings.backgroundColor;
+    }
+    const ui32 x = tile.x0 + i % tileWidth;
+    const ui32 y = tile.y0 + i / tileWidth;
+    switch (settings.mode)
+    {
+    case RenderMode::Lighting:
+      return shade(batch.rays[i], surfaces[i], pointLights, settings, x, y,
+                   accumulation.numPasses * settings.numShadowRaysPerLight, isVisible);
+    case RenderMode::AmbientOcclusion:
+      return f32v3(traceAmbientOcclusion(surfaces[i].position, surfaces[i].normal, settings, ambientOcclusionDistance,
+                                         x, y, accumulation.numPasses * settings.numAmbientOcclusionRays, isVisible));
+    case RenderMode::BakedAmbientOcclusion:
+      return f32v3(surfaces[i].bakedAmbientOcclusion);
+    }
+    return settings.backgroundColor;
+  };
+
+  // The shadow rays of a tile towards the same light are coherent, so the last occluder is remembered per light.
+  std::vector<Occluder> occluders(std::max<size_t>(pointLights.size(), 1));
+  ui64&                 numSecondaryRays =
+      settings.mode == RenderMode::Lighting ? statistics.numShadowRays : statistics.numAmbientOcclusionRays;
+  VisibilityFunction isVisible = [&](const Ray& ray, ui32 group)
+  {
+    numSecondaryRays++;
+    return !m_tlas.occluded(ray, occluders[group], TopLevelAS::ALL_INSTANCES, counters);
+  };
+
+  // Sorted tracing collects the secondary rays of all pixels first. Shading replays the same rays in the same order
+  // and takes their results, which were traced in the order of the ray sorter with one shared occluder.
+  std::vector<ui8> visibility;
+  ui32             nextVisibilityIdx = 0;
+  if (settings.sortSecondaryRays)
+  {
+    std::vector<Ray>         secondaryRays;
+    const VisibilityFunction collect = [&](const Ray& ray, ui32)
+    {
+      secondaryRays.push_back(ray);
+      return true;
+    };
+    for (ui32 i = 0; i < static_cast<ui32>(batch.rays.size()); i++)
+    {
+      getColor(i, collect);
+    }
+
+    const auto        sortStart = std::chrono::steady_clock::now();
+    std::vector<ui32> order;
+    raySorter.sort(secondaryRays, order, threadPool);
+    statistics.raySortingSeconds +=
+        std::chrono::duration<f64>(std::chrono::steady_clock::now() - sortStart).count();
+
+    visibility.resize(secondaryRays.size());
+    Occluder occluder;
+    for (const ui32 rayIdx : order)
+    {
+      const bool occluded = m_tlas.occluded(secondaryRays[rayIdx], occluder, TopLevelAS::ALL_INSTANCES, counters);
+      visibility[rayIdx]  = occluded ? 0 : 1;
+    }
+    numSecondaryRays += secondaryRays.size();
+    isVisible = [&](const Ray&, ui32) { return visibility[nextVisibilityIdx++] != 0; };
+  }
+
+  const f32 weight = 1.0f / static_cast<f32>(accumulation.numPasses + 1);
+  for (ui32 i = 0; i < static_cast<ui32>(batch.rays.size()); i++)
+  {
+    f32v3& radianceSum = accumulation.radianceSums[pixelIdx(i)];
+    radianceSum += getColor(i, isVisible);
+    image[pixelIdx(i)] = ui8v4(ui8v3(glm::round(glm::clamp(radianceSum * weight, 0.0f, 1.0f) * 255.0f)), 255);
+  }
+}
+
+CpuRenderer::SurfacePoint CpuRenderer::getSurfacePoint(const Ray& ray, const RayHit& hit) const
+{
+  const InstanceData&   instance = m_instances[hit.instanceIdx];
+  const CpuScene::Mesh& mesh     = m_scene.getMesh(instance.meshIdx);
+  const ui32            i0       = mesh.indices[3 * hit.triangleIdx + 0];
+  const ui32            i1       = mesh.indices[3 * hit.triangleIdx + 1];
+  const ui32            i2       = mesh.indices[3 * hit.triangleIdx + 2];
+  const Vertex&         v0       = mesh.vertices[i0];
+  const Vertex&         v1       = mesh.vertices[i1];
+  const Vertex&         v2       = mesh.vertices[i2];
+  const f32             b1       = hit.barycentrics.x;
+  const f32             b2       = hit.barycentrics.y;
+  const f32             b0       = 1.0f - b1 - b2;
+
+  SurfacePoint surface;
+  surface.position          = ray.origin + hit.t * ray.direction;
+  surface.textureCoordinate = b0 * v0.textureCoordinate + b1 * v1.textureCoordinate + b2 * v2.textureCoordinate;
+  surface.materialIndex     = mesh.materialIndex;
+
+  // Meshes without normals get the face normal.
+  f32v3 normal = b0 * v0.normal + b1 * v1.normal + b2 * v2.normal;
+  if (glm::dot(normal, normal) == 0.0f)
+  {
+    normal = glm::cross(v1.position - v0.position, v2.position - v0.position);
+  }
+  surface.normal = glm::normalize(instance.normalMatrix * normal);
+
+  if (!instance.vertexAmbientOcclusion.empty())
+  {
+    surface.bakedAmbientOcclusion = b0 * instance.vertexAmbientOcclusion[i0] +
+                                    b1 * instance.vertexAmbientOcclusion[i1] +
+                                    b2 * instance.vertexAmbientOcclusion[i2];
+  }
+  return surface;
+}
+
+f32v3 CpuRenderer::shade(const Ray& ray, const SurfacePoint& surface, const std::vector<PointLight>& pointLights,
+                         const Settings& settings, ui32 pixelX, ui32 pixelY, ui32 sampleIdx,
+                         const VisibilityFunction& isVisible) const
+{
+  const CpuScene::Material& material         = m_scene.getMaterial(surface.materialIndex);
+  const CpuScene::Texture&  texture          = m_scene.getTexture(material.diffuseTextureIndex);
+  const f32v3               texel            = f32v3(texture.sample(surface.textureCoordinate));
+  const f32v3               diffuse          = texel * f32v3(material.diffuseColor);
+  const f32v3               specular         = f32v3(material.specularColorAndExponent);
+  const f32                 specularExponent = material.specularColorAndExponent.w;
+  const f32v3&              position         = surface.position;
+  const f32v3&              normal           = surface.normal;
+  const f32v3               toViewer         = -ray.direction;
+  const f32v3               shadowRayOrigin  = position + settings.shadowBias * normal;
+
+  // Point lights need a single shadow ray.
+  const ui32 numShadowRaysPerLight = settings.lightRadius > 0.0f ? std::max(settings.numShadowRaysPerLight, 1u) : 1;
+
+  f32v3 color = f32v3(material.ambientColor) * surface.bakedAmbientOcclusion;
+  for (ui32 i = 0; i < static_cast<ui32>(pointLights.size()); i++)
+  {
+    const PointLight& light       = pointLights[i];
+    const f32v3       lightCenter = f32v3(light.position[0], light.position[1], light.position[2]);
+    const f32v3       toLight     = lightCenter - position;
+    const f32         distance    = glm::length(toLight);
+    const f32v3       lightDir    = toLight / distance;
+    const f32         nDotL       = std::max(0.0f, glm::dot(normal, lightDir));
+    if (nDotL == 0.0f)
+    {
+      continue;
+    }
+
+    // The shadow rays aim at points on the disk of the light that faces the surface point. Every light of every pixel
+    // gets its own rotation of the Sobol sequence.
+    f32v3 tangent, bitangent;
+    getOrthonormalBasis(lightDir, tangent, bitangent);
+    const f32v2 sampleOffset = getPixelSampleOffset(pixelX, pixelY, i);
+    ui32        numVisible   = 0;
+    for (ui32 j = 0; j < numShadowRaysPerLight; j++)
+    {
+      const f32v2 diskSample = sampleConcentricDisk(rotateSample(getSobolSample(sampleIdx + j), sampleOffset));
+      const f32v3 lightSample =
+          lightCenter + settings.lightRadius * (diskSample.x * tangent + diskSample.y * bitangent);
+      const f32v3 toSample       = lightSample - shadowRayOrigin;
+      const f32   sampleDistance = glm::length(toSample);
+
+      Ray shadowRay;
+      shadowRay.origin    = shadowRayOrigin;
+      shadowRay.direction = toSample / sampleDistance;
+      shadowRay.tMin      = SHADOW_RAY_T_MIN;
+      shadowRay.tMax      = sampleDistance;
+      if (isVisible(shadowRay, i))
+      {
+        numVisible++;
+      }
+    }
+    if (numVisible == 0)
+    {
+      continue;
+    }
+
+    const f32v3 halfVector = glm::normalize(lightDir + toViewer);
+    const f32   nDotH      = std::max(0.0f, glm::dot(normal, halfVector));
+    const f32   visibility = static_cast<f32>(numVisible) / static_cast<f32>(numShadowRaysPerLight);
+    const f32v3 radiance   = light.color * (light.intensity * visibility / distance);
+    color += (diffuse * nDotL + specular * std::pow(nDotH, specularExponent)) * radiance;
+  }
+  return color;
+}
+
+f32 CpuRenderer::traceAmbientOcclusion(const f32v3& position, const f32v3& normal, const Settings& settings,
+                                       f32 maxDistance, ui32 x, ui32 y, ui32 sampleIdx,
+                                       const VisibilityFunction& isVisible) const
+{
+  f32v3 tangent, bitangent;
+  getOrthonormalBasis(normal, tangent, bitangent);
+  const f32v2 sampleOffset = getPixelSampleOffset(x, y, AMBIENT_OCCLUSION_SAMPLE_DIMENSION);
+  const ui32  numSamples   = std::max(settings.numAmbientOcclusionRays, 1u);
+
+  // Only the existence of a hit within maxDistance matters, so the occlusion rays take the any-hit path.
+  ui32 numVisible = 0;
+  for (ui32 j = 0; j < numSamples; j++)
+  {
+    const f32v3 direction = sampleCosineHemisphere(rotateSample(getSobolSample(sampleIdx + j), sampleOffset));
+
+    Ray ray;
+    ray.origin    = position + settings.shadowBias * normal;
+    ray.direction = glm::normalize(direction.x * tangent + direction.y * bitangent + direction.z * normal);
+    ray.tMin      = SHADOW_RAY_T_MIN;
+    ray.tMax      = maxDistance;
+    if (isVisible(ray, 0))
+    {
+      numVisible++;
+    }
+  }
+  return static_cast<f32>(numVisible) / static_cast<f32>(numSamples);
+}
+} // namespace gims
@@ -0,0 +1,104 @@
+#include "CpuScene.hpp"
+#include <algorithm>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <iostream>
+using namespace gims;
+
+namespace gims
+{
+f32v4 CpuScene::Texture::sample(f32v2 textureCoordinate) const
+{
+  const f32v2 wrapped = textureCoordinate - glm::floor(textureCoordinate);
+  const ui32  x       = std::min(static_cast<ui32>(wrapped.x * static_cast<f32>(width)), width - 1);
+  const ui32  y       = std::min(static_cast<ui32>(wrapped.y * static_cast<f32>(height)), height - 1);
+  return f32v4(texels[static_cast<size_t>(y) * width + x]) / 255.0f;
+}
+
+const AABB& CpuScene::getAABB() const
+{
+  return m_aabb;
+}
+
+const CpuScene::Node& CpuScene::getNode(ui32 nodeIdx) const
+{
+  return m_nodes[nodeIdx];
+}
+
+ui32 CpuScene::getNumberOfNodes() const
+{
+  return static_cast<ui32>(m_nodes.size());
+}
+
+const CpuScene::Mesh& CpuScene::getMesh(ui32 meshIdx) const
+{
+  return m_meshes[meshIdx];
+}
+
+ui32 CpuScene::getNumberOfMeshes() const
+{
+  return static_cast<ui32>(m_meshes.size());
+}
+
+const CpuScene::Material& CpuScene::getMaterial(ui32 materialIdx) const
+{
+  return m_materials[materialIdx];
+}
+
+const CpuScene::Texture& CpuScene::getTexture(ui32 textureIdx) const
+{
+  return m_textures[textureIdx];
+}
+
+TopLevelAS CpuScene::createAccelerationStructure(const BvhBuildSettings& bottomLevelSettings,
+                                                 BvhCache*               bvhCache) const
+{
+  // Every mesh gets one BLAS, which all nodes that reference the mesh share.
+  std::vector<TopLevelAS::Instance> instances;
+  std::vector<ui32>                 meshBottomLevelASIndices(m_meshes.size(), RayHit::INVALID);
+  std::vector<ui32>                 bottomLevelASMeshIndices;
+  for (const auto& currentNode : m_nodes)
+  {
+    for (const auto meshIdx : currentNode.meshIndices)
+    {
+      if (meshBottomLevelASIndices[meshIdx] == RayHit::INVALID)
+      {
+        meshBottomLevelASIndices[meshIdx] = static_cast<ui32>(bottomLevelASMeshIndices.size());
+        bottomLevelASMeshIndices.push_back(meshIdx);
+      }
+      TopLevelAS::Instance instance = {currentNode.worldSpaceTransformation, meshBottomLevelASIndices[meshIdx]};
+      instance.instanceID           = meshIdx;
+      instances.push_back(instance);
+    }
+  }
+
+  ThreadPool& threadPool = bottomLevelSettings.threadPool ? *bottomLevelSettings.threadPool : ThreadPool::getGlobal();
+
+  std::vector<BottomLevelAS> bottomLevelAS(bottomLevelASMeshIndices.size());
+  threadPool.parallelFor(0, static_cast<ui32>(bottomLevelASMeshIndices.size()), 1,
+                         [&](ui32 begin, ui32 end)
+                         {
+                           for (ui32 i = begin; i < end; i++)
+                           {
+                             const auto&        mesh = m_meshes[bottomLevelASMeshIndices[i]];
+                             std::vector<f32v3> positions(mesh.vertices.size());
+                             for (size_t v = 0; v < positions.size(); v++)
+                             {
+                               positions[v] = mesh.vertices[v].position;
+                             }
+                             bottomLevelAS[i] =
+                                 bvhCache != nullptr
+                                     ? bvhCache->getBottomLevelAS(positions, mesh.indices, bottomLevelSettings)
+                                     : BottomLevelAS(positions, mesh.indices, bottomLevelSettings);
+                           }
+                         });
+
+  BvhBuildStatistics statistics;
+  for (const auto& blas : bottomLevelAS)
+  {
+    statistics += blas.getBvh().getBuildStatistics();
+  }
+  std::cout << "CPU BLAS build: ";
+  statistics.print(std::cout);
+  return TopLevelAS(std::move(bottomLevelAS), std::move(instances));
+}
+} // namespace gims
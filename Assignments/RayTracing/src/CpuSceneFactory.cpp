@@ -0,0 +1,206 @@
+#include "CpuSceneFactory.hpp"
+#include "GltfConversion.hpp"
+#include <cstring>
+#include <gimslib/contrib/stb/stb_image.h>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+using namespace gims;
+
+namespace
+{
+/// <summary>
+/// Loads an image file as RGBA8, like Texture2DD3D12 does.
+/// </summary>
+CpuScene::Texture loadTexture(const std::filesystem::path& path)
+{
+  const auto fileName = path.generic_string();
+  i32        textureWidth, textureHeight, textureComp;
+
+  std::unique_ptr<ui8, void (*)(void*)> image(
+      stbi_load(fileName.c_str(), &textureWidth, &textureHeight, &textureComp, 4), &stbi_image_free);
+  if (image.get() == nullptr)
+  {
+    throw std::runtime_error(fileName + std::string(" can't be loaded."));
+  }
+
+  CpuScene::Texture texture;
+  texture.width  = static_cast<ui32>(textureWidth);
+  texture.height = static_cast<ui32>(textureHeight);
+  texture.texels.resize(static_cast<size_t>(texture.width) * texture.height);
+  ::memcpy(texture.texels.data(), image.get(), texture.texels.size() * sizeof(ui8v4));
+  return texture;
+}
+} // namespace
+
+namespace gims
+{
+CpuScene CpuSceneFactory::createFromGltf(const std::filesystem::path& pathToScene)
+{
+  CpuScene outputScene;
+
+  const auto absolutePath = std::filesystem::weakly_canonical(pathToScene);
+  if (!std::filesystem::exists(absolutePath))
+  {
+    throw std::runtime_error(absolutePath.string() + std::string(" does not exist."));
+  }
+
+  const GltfFile inputScene(absolutePath);
+
+  const auto sceneMeshIndices = createMeshes(inputScene, outputScene);
+
+  // Like Assimp, introduce an additional root node only if the glTF scene has more than one root.
+  const f32m4 identity  = glm::identity<f32m4>();
+  const auto& rootNodes = inputScene.getRootNodes();
+  if (rootNodes.size() == 1)
+  {
+    createNodes(inputScene, sceneMeshIndices, outputScene, rootNodes[0], identity);
+  }
+  else
+  {
+    outputScene.m_nodes.emplace_back();
+    outputScene.m_nodes.back().transformation           = identity;
+    outputScene.m_nodes.back().worldSpaceTransformation = identity;
+    for (const auto rootNodeIdx : rootNodes)
+    {
+      const ui32 childNodeIndex = createNodes(inputScene, sceneMeshIndices, outputScene, rootNodeIdx, identity);
+      outputScene.m_nodes.at(0).childIndices.emplace_back(childNodeIndex);
+    }
+  }
+
+  computeSceneAABB(outputScene, outputScene.m_aabb, 0, identity);
+  createMaterials(inputScene, absolutePath.parent_path(), outputScene);
+
+  return outputScene;
+}
+
+std::vector<std::vector<ui32>> CpuSceneFactory::createMeshes(const GltfFile& inputScene, CpuScene& outputScene)
+{
+  std::vector<std::vector<ui32>>          sceneMeshIndices;
+  std::vector<GltfFile::Primitive const*> scenePrimitives;
+  for (const auto& mesh : inputScene.getMeshes())
+  {
+    sceneMeshIndices.emplace_back();
+    for (const auto& primitive : mesh.primitives)
+    {
+      if (!isTrianglePrimitive(primitive))
+      {
+        std::cout << "Skipping non-triangle primitive of mesh " << mesh.name << std::endl;
+        continue;
+      }
+      scenePrimitives.push_back(&primitive);
+      sceneMeshIndices.back().push_back(static_cast<ui32>(scenePrimitives.size() - 1));
+    }
+  }
+
+  outputScene.m_meshes.resize(scenePrimitives.size());
+  ThreadPool::getGlobal().parallelFor(0, static_cast<ui32>(scenePrimitives.size()), 1,
+                                      [&](ui32 begin, ui32 end)
+                                      {
+                                        for (ui32 i = begin; i < end; i++)
+                                        {
+                                          CpuScene::Mesh& mesh = outputScene.m_meshes[i];
+                                          convertGltfPrimitive(inputScene, *scenePrimitives[i], mesh.vertices,
+                                                               mesh.indices);
+                                          mesh.materialIndex = getMaterialIndex(inputScene, *scenePrimitives[i]);
+                                          mesh.aabb          = getPrimitiveAABB(inputScene, *scenePrimitives[i]);
+                                        }
+                                      });
+  return sceneMeshIndices;
+}
+
+ui32 CpuSceneFactory::createNodes(const GltfFile& inputScene, const std::vector<std::vector<ui32>>& sceneMeshIndices,
+                                  CpuScene& outputScene, ui32 nodeIdx, f32m4 worldSpaceTransformation)
+{
+  const auto& inputNode = inputScene.getNodes().at(nodeIdx);
+
+  outputScene.m_nodes.emplace_back();
+  const auto      currentNodeIndex = static_cast<ui32>(outputScene.m_nodes.size() - 1);
+  CpuScene::Node& currentNode      = outputScene.m_nodes.back();
+
+  currentNode.transformation           = toLeftHanded(inputNode.transformation);
+  worldSpaceTransformation             = worldSpaceTransformation * currentNode.transformation;
+  currentNode.worldSpaceTransformation = worldSpaceTransformation;
+
+  if (inputNode.mesh >= 0)
+  {
+    currentNode.meshIndices = sceneMeshIndices.at(inputNode.mesh);
+  }
+
+  for (const auto childIdx : inputNode.childIndices)
+  {
+    const ui32 childNodeIndex =
+        createNodes(inputScene, sceneMeshIndices, outputScene, childIdx, worldSpaceTransformation);
+    outputScene.m_nodes.at(currentNodeIndex).childIndices.emplace_back(childNodeIndex);
+  }
+
+  return currentNodeIndex;
+}
+
+void CpuSceneFactory::computeSceneAABB(CpuScene& scene, AABB& accuAABB, ui32 nodeIdx, f32m4 accuTransformation)
+{
+  const auto& currentNode = scene.m_nodes[nodeIdx];
+
+  accuTransformation = accuTransformation * currentNode.transformation;
+
+  for (const auto& meshIndex : currentNode.meshIndices)
+  {
+    const auto transformedMeshAABB = scene.m_meshes[meshIndex].aabb.getTransformed(accuTransformation);
+    accuAABB                       = accuAABB.getUnion(transformedMeshAABB);
+  }
+  for (const auto childIdx : currentNode.childIndices)
+  {
+    computeSceneAABB(scene, accuAABB, childIdx, accuTransformation);
+  }
+}
+
+void CpuSceneFactory::createMaterials(const GltfFile& inputScene, const std::filesystem::path& parentPath,
+                                      CpuScene& outputScene)
+{
+  // Texture 0 is white, like the default diffuse texture of the viewer.
+  std::vector<std::filesystem::path>              textureFileNames;
+  std::unordered_map<std::filesystem::path, ui32> textureFileNameToTextureIndex;
+  outputScene.m_textures.push_back({1, 1, {ui8v4(255, 255, 255, 255)}});
+
+  std::vector<GltfFile::Material> materials = inputScene.getMaterials();
+  if (gltfNeedsDefaultMaterial(inputScene))
+  {
+    materials.emplace_back();
+  }
+
+  for (const auto& currentMaterial : materials)
+  {
+    // glTF has no ambient color. As in the GPU path, the emissive color is used as ambient color.
+    CpuScene::Material material;
+    material.ambientColor             = f32v4(currentMaterial.emissiveFactor, 0.0f);
+    material.diffuseColor             = f32v4(f32v3(currentMaterial.diffuseFactor), 0.0f);
+    material.specularColorAndExponent = f32v4(currentMaterial.specularFactor, currentMaterial.shininess);
+    if (currentMaterial.diffuseTexture >= 0)
+    {
+      const auto& textureFileName = inputScene.getTextureFileName(static_cast<ui32>(currentMaterial.diffuseTexture));
+      const auto  textureIdx      = static_cast<ui32>(outputScene.m_textures.size() + textureFileNames.size());
+      const auto  textureIter     = textureFileNameToTextureIndex.emplace(textureFileName, textureIdx).first;
+      if (textureIter->second == textureIdx)
+      {
+        textureFileNames.push_back(textureFileName);
+      }
+      material.diffuseTextureIndex = textureIter->second;
+    }
+    outputScene.m_materials.push_back(material);
+  }
+
+  const size_t firstTexture = outputScene.m_textures.size();
+  outputScene.m_textures.resize(firstTexture + textureFileNames.size());
+  ThreadPool::getGlobal().parallelFor(0, static_cast<ui32>(textureFileNames.size()), 1,
+                                      [&](ui32 begin, ui32 end)
+                                      {
+                                        for (ui32 i = begin; i < end; i++)
+                                        {
+                                          outputScene.m_textures[firstTexture + i] =
+                                              loadTexture(parentPath / textureFileNames[i]);
+                                        }
+                                      });
+}
+} // namespace gims
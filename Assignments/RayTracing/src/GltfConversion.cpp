@@ -0,0 +1,211 @@
+#include "GltfConversion.hpp"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+using namespace gims;
+
+namespace
+{
+/// <summary>
+/// Reads the first three components of an element. Float data is read in place without conversion.
+/// </summary>
+f32v3 readFloat3(const GltfFile::Accessor& accessor, ui32 idx)
+{
+  if (accessor.componentType == GltfFile::FLOAT && accessor.numComponents >= 3)
+  {
+    f32v3 result;
+    ::memcpy(&result, accessor.data + static_cast<size_t>(idx) * accessor.byteStride, sizeof(result));
+    return result;
+  }
+  return f32v3(accessor.getFloat(idx));
+}
+
+/// <summary>
+/// Reads the first two components of an element. Float data is read in place without conversion.
+/// </summary>
+f32v2 readFloat2(const GltfFile::Accessor& accessor, ui32 idx)
+{
+  if (accessor.componentType == GltfFile::FLOAT && accessor.numComponents >= 2)
+  {
+    f32v2 result;
+    ::memcpy(&result, accessor.data + static_cast<size_t>(idx) * accessor.byteStride, sizeof(result));
+    return result;
+  }
+  return f32v2(accessor.getFloat(idx));
+}
+
+/// <summary>
+/// Computes area weighted vertex normals, like aiProcess_GenSmoothNormals does for meshes without normals.
+/// </summary>
+void computeSmoothNormals(std::vector<Vertex>& vertices, const std::vector<ui32>& indices)
+{
+  for (size_t i = 0; i + 2 < indices.size(); i += 3)
+  {
+    const f32v3 p0         = vertices[indices[i + 0]].position;
+    const f32v3 faceNormal = glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0);
+    vertices[indices[i + 0]].normal += faceNormal;
+    vertices[indices[i + 1]].normal += faceNormal;
+    vertices[indices[i + 2]].normal += faceNormal;
+  }
+  for (auto& v : vertices)
+  {
+    const f32 length = glm::length(v.normal);
+    v.normal         = length > 0.0f ? v.normal / length : f32v3(0.0f);
+  }
+}
+} // namespace
+
+namespace gims
+{
+f32m4 toLeftHanded(f32m4 m)
+{
+  m[2][0] = -m[2][0];
+  m[2][1] = -m[2][1];
+  m[2][3] = -m[2][3];
+  m[0][2] = -m[0][2];
+  m[1][2] = -m[1][2];
+  m[3][2] = -m[3][2];
+  return m;
+}
+
+void convertGltfPrimitive(const GltfFile& inputScene, const GltfFile::Primitive& primitive,
+                          std::vector<Vertex>& vertices, std::vector<ui32>& indices)
+{
+  const auto& positions = inputScene.getAccessor(static_cast<ui32>(primitive.positions));
+  const ui32  nVertices = positions.count;
+
+  const auto attribute = [&](i32 accessorIdx) -> GltfFile::Accessor const* {
+    if (accessorIdx < 0)
+    {
+      return nullptr;
+    }
+    const auto& accessor = inputScene.getAccessor(static_cast<ui32>(accessorIdx));
+    if (accessor.count < nVertices)
+    {
+      throw std::runtime_error("glTF vertex attribute has less elements than POSITION.");
+    }
+    return &accessor;
+  };
+  const auto normals            = attribute(primitive.normals);
+  const auto textureCoordinates = attribute(primitive.textureCoordinates);
+  const auto tangents           = attribute(primitive.tangents);
+
+  vertices.resize(nVertices);
+  for (ui32 i = 0; i < nVertices; i++)
+  {
+    Vertex& v  = vertices[i];
+    v.position = readFloat3(positions, i);
+    v.position.z *= -1.0f;
+    if (normals)
+    {
+      v.normal = readFloat3(*normals, i);
+      v.normal.z *= -1.0f;
+    }
+    else
+    {
+      v.normal = f32v3(0.0f);
+    }
+    if (textureCoordinates)
+    {
+      const f32v2 uv      = readFloat2(*textureCoordinates, i);
+      v.textureCoordinate = f32v2(uv.x, 1.0f - uv.y);
+    }
+    else
+    {
+      v.textureCoordinate = f32v2(0.0f);
+    }
+    if (tangents)
+    {
+      v.tangents = readFloat3(*tangents, i);
+      v.tangents.z *= -1.0f;
+    }
+    else
+    {
+      v.tangents = f32v3(0.0f);
+    }
+  }
+
+  if (primitive.indices >= 0)
+  {
+    const auto& indexAccessor = inputScene.getAccessor(static_cast<ui32>(primitive.indices));
+    indices.resize(indexAccessor.count - indexAccessor.count % 3);
+    for (ui32 i = 0; i < static_cast<ui32>(indices.size()); i += 3)
+    {
+      indices[i + 0] = indexAccessor.getIndex(i + 2);
+      indices[i + 1] = indexAccessor.getIndex(i + 1);
+      indices[i + 2] = indexAccessor.getIndex(i + 0);
+    }
+    for (const auto index : indices)
+    {
+      if (index >= nVertices)
+      {
+        throw std::runtime_error("glTF index out of range.");
+      }
+    }
+  }
+  else
+  {
+    indices.resize(nVertices - nVertices % 3);
+    for (ui32 i = 0; i < static_cast<ui32>(indices.size()); i += 3)
+    {
+      indices[i + 0] = i + 2;
+      indices[i + 1] = i + 1;
+      indices[i + 2] = i + 0;
+    }
+  }
+
+  if (!normals)
+  {
+    computeSmoothNormals(vertices, indices);
+  }
+}
+
+bool isTrianglePrimitive(const GltfFile::Primitive& primitive)
+{
+  return primitive.mode == GltfFile::TRIANGLES && primitive.positions >= 0;
+}
+
+ui32 getMaterialIndex(const GltfFile& inputScene, const GltfFile::Primitive& primitive)
+{
+  return primitive.material >= 0 ? static_cast<ui32>(primitive.material)
+                                 : static_cast<ui32>(inputScene.getMaterials().size());
+}
+
+AABB getPrimitiveAABB(const GltfFile& inputScene, const GltfFile::Primitive& primitive)
+{
+  const auto& positions = inputScene.getAccessor(static_cast<ui32>(primitive.positions));
+  f32v3       lowerLeftBottom(std::numeric_limits<f32>::max());
+  f32v3       upperRightTop(-std::numeric_limits<f32>::max());
+  if (positions.hasBounds)
+  {
+    lowerLeftBottom = positions.min;
+    upperRightTop   = positions.max;
+  }
+  else
+  {
+    for (ui32 i = 0; i < positions.count; i++)
+    {
+      lowerLeftBottom = glm::min(lowerLeftBottom, readFloat3(positions, i));
+      upperRightTop   = glm::max(upperRightTop, readFloat3(positions, i));
+    }
+  }
+  // mirror at the xy-plane, see convertGltfPrimitive
+  return AABB(f32v3(lowerLeftBottom.x, lowerLeftBottom.y, -upperRightTop.z),
+              f32v3(upperRightTop.x, upperRightTop.y, -lowerLeftBottom.z));
+}
+
+bool gltfNeedsDefaultMaterial(const GltfFile& inputScene)
+{
+  for (const auto& mesh : inputScene.getMeshes())
+  {
+    for (const auto& primitive : mesh.primitives)
+    {
+      if (primitive.material < 0)
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+} // namespace gims
@@ -0,0 +1,257 @@
+#include "CpuRenderer.hpp"
+#include "CpuSceneFactory.hpp"
+#include "ViewerSettings.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <gimslib/io/PngFile.hpp>
+#include <gimslib/rt/BvhCache.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <gimslib/types.hpp>
+#include <gimslib/ui/ExaminerController.hpp>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+using namespace gims;
+
+namespace
+{
+/// <summary>
+/// Command line of the headless renderer.
+/// </summary>
+struct Options
+{
+  std::filesystem::path scenePath  = "../../../data/desk/scene.gltf"; //! glTF file to render.
+  std::filesystem::path outputPath = "RayTracingHeadless.png";        //! PNG file to write.
+  ui32                  numThreads = 0;                               //! 0 uses one thread per hardware thread.
+  ui32                  numPasses  = 1;                               //! Passes that are accumulated progressively.
+  CpuRenderer::Settings settings;                                     //! Image size and shading parameters.
+  BvhBuildSettings      bottomLevelSettings;                          //! BVH and leaf layout of the BLAS.
+
+  //! Cache of the BLAS, empty to always build them.
+  std::filesystem::path bvhCacheDirectory = std::filesystem::temp_directory_path() / "gims_bvh_cache";
+
+  bool                  printBvhStatistics = false; //! Prints the quality of the BVHs after the build.
+  std::filesystem::path heatmapPath;                //! Traversal heatmaps of the first pass, empty for none.
+};
+
+/// <summary>
+/// Prints the command line syntax.
+/// </summary>
+void printUsage()
+{
+  std::cout << "Usage: RayTracingHeadless [scene.gltf] [image.png] [options]\n"
+               "  --width <pixels> --height <pixels>  Image size.\n"
+               "  --threads <n>                       Render threads, 0: one per hardware thread.\n"
+               "  --tile-size <pixels>                Edge length of the tiles, e.g., 16 or 32.\n"
+               "  --passes <n>                        Passes that are accumulated progressively.\n"
+               "  --mode lighting|ao|baked-ao         Lighting, traced or baked ambient occlusion.\n"
+               "  --shadow-rays <n>                   Shadow rays per light, pixel and pass.\n"
+               "  --light-radius <radius>             Radius of the lights, 0 for hard shadows.\n"
+               "  --ao-rays <n>                       Ambient occlusion rays per pixel and pass or per vertex.\n"
+               "  --ao-distance <fraction>            Ambient occlusion ray length relative to the scene diagonal.\n"
+               "  --sort-rays 0|1                     Sort the secondary rays of every tile before tracing.\n"
+               "  --leaf-bits 0|16                    Store BLAS leaf triangles as floats or on a 16 bit grid.\n"
+               "  --bvh-cache <directory>|none        Directory of BVHs built before, none to always build them.\n"
+               "  --bvh-stats 0|1                     Print SAH cost, overlap, histograms and memory of the BVHs.\n"
+               "  --heatmap <image.png>               Count the traversal work per tile and write heatmaps of the\n"
+               "                                      visited nodes and tested triangles, e.g., image_nodes.png."
+            << std::endl;
+}
+
+/// <summary>
+/// Parses the command line. Throws, if it is invalid.
+/// </summary>
+Options parseOptions(int argc, char** argv)
+{
+  Options                options;
+  CpuRenderer::Settings& s = options.settings;
+
+  const auto toUi32 = [](const std::string& value) { return static_cast<ui32>(std::stoul(value)); };
+  const std::unordered_map<std::string, CpuRenderer::RenderMode> modes = {
+      {"lighting", CpuRenderer::RenderMode::Lighting},
+      {"ao", CpuRenderer::RenderMode::AmbientOcclusion},
+      {"baked-ao", CpuRenderer::RenderMode::BakedAmbientOcclusion}};
+  const std::unordered_map<std::string, std::function<void(const std::string&)>> handlers = {
+      {"--width", [&](const std::string& v) { s.width = toUi32(v); }},
+      {"--height", [&](const std::string& v) { s.height = toUi32(v); }},
+      {"--threads", [&](const std::string& v) { options.numThreads = toUi32(v); }},
+      {"--tile-size", [&](const std::string& v) { s.tileSize = toUi32(v); }},
+      {"--passes", [&](const std::string& v) { options.numPasses = std::max(toUi32(v), 1u); }},
+      {"--mode", [&](const std::string& v) { s.mode = modes.at(v); }},
+      {"--shadow-rays", [&](const std::string& v) { s.numShadowRaysPerLight = toUi32(v); }},
+      {"--light-radius", [&](const std::string& v) { s.lightRadius = std::stof(v); }},
+      {"--ao-rays", [&](const std::string& v) { s.numAmbientOcclusionRays = toUi32(v); }},
+      {"--ao-distance", [&](const std::string& v) { s.ambientOcclusionDistance = std::stof(v); }},
+      {"--sort-rays", [&](const std::string& v) { s.sortSecondaryRays = toUi32(v) != 0; }},
+      {"--leaf-bits", [&](const std::string& v) { options.bottomLevelSettings.leafPositionBits = toUi32(v); }},
+      {"--bvh-cache", [&](const std::string& v)
+       { options.bvhCacheDirectory = v == "none" ? std::filesystem::path() : std::filesystem::path(v); }},
+      {"--bvh-stats", [&](const std::string& v) { options.printBvhStatistics = toUi32(v) != 0; }},
+      {"--heatmap", [&](const std::string& v)
+       {
+         options.heatmapPath = v;
+         s.countTraversal    = true;
+       }}};
+
+  ui32 numPositionalArguments = 0;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (argument.rfind("--", 0) != 0)
+    {
+      (numPositionalArguments++ == 0 ? options.scenePath : options.outputPath) = argument;
+      continue;
+    }
+    const auto handler = handlers.find(argument);
+    if (handler == handlers.end() || i + 1 == argc)
+    {
+      throw std::runtime_error("Invalid option " + argument + ".");
+    }
+    handler->second(argv[++i]);
+  }
+  return options;
+}
+
+/// <summary>
+/// Prints the ray counts and the speed of a render or bake call.
+/// </summary>
+void printStatistics(const std::string& name, const CpuRenderer::Statistics& statistics)
+{
+  std::cout << name << ": " << statistics.seconds << " s, " << statistics.numPrimaryRays << " primary rays, "
+            << statistics.numShadowRays << " shadow rays, " << statistics.numAmbientOcclusionRays
+            << " ambient occlusion rays, " << statistics.getMegaRaysPerSecond() << " Mrays/s";
+  if (statistics.raySortingSeconds > 0.0)
+  {
+    std::cout << ", " << statistics.raySortingSeconds << " s sorting rays";
+  }
+  std::cout << std::endl;
+}
+
+/// <summary>
+/// Prints the quality of the BLAS, summed over all of them, and of the TLAS, and the memory of both levels.
+/// </summary>
+void printBvhStatistics(const TopLevelAS& tlas)
+{
+  BvhQualityStatistics bottomLevel;
+  for (ui32 i = 0; i < tlas.getNumBottomLevelAS(); i++)
+  {
+    bottomLevel += tlas.getBottomLevelAS(i).getBvh().computeQualityStatistics();
+  }
+  std::cout << "BLAS BVHs: ";
+  bottomLevel.print(std::cout);
+  std::cout << "TLAS BVH: ";
+  tlas.getBvh().computeQualityStatistics().print(std::cout);
+  std::cout << "Acceleration structure memory: " << static_cast<f64>(tlas.getMemorySize()) / (1024.0 * 1024.0)
+            << " MiB" << std::endl;
+}
+
+/// <summary>
+/// Prints the traversal work per ray and writes the heatmaps next to path, e.g., image_nodes.png for image.png.
+/// </summary>
+void writeHeatmaps(const std::filesystem::path& path, const CpuRenderer::Settings& settings,
+                   const CpuRenderer::Statistics& statistics)
+{
+  const ui64 numRays = statistics.numPrimaryRays + statistics.numShadowRays + statistics.numAmbientOcclusionRays;
+  const f64  perRay  = numRays > 0 ? 1.0 / static_cast<f64>(numRays) : 0.0;
+  std::cout << "Traversal: " << static_cast<f64>(statistics.traversal.numNodesVisited) * perRay
+            << " nodes visited and " << static_cast<f64>(statistics.traversal.numTrianglesTested) * perRay
+            << " triangles tested per ray" << std::endl;
+
+  const std::pair<const char*, CpuRenderer::HeatmapMetric> heatmaps[] = {
+      {"_nodes", CpuRenderer::HeatmapMetric::NodesVisited},
+      {"_triangles", CpuRenderer::HeatmapMetric::TrianglesTested}};
+  for (const auto& [suffix, metric] : heatmaps)
+  {
+    std::filesystem::path heatmapPath = path;
+    heatmapPath.replace_filename(path.stem().string() + suffix + path.extension().string());
+    const auto heatmap = CpuRenderer::createHeatmap(settings, statistics, metric);
+    writePngFile(heatmapPath, settings.width, settings.height, heatmap.data());
+    std::cout << "Heatmap written to " << heatmapPath.string() << std::endl;
+  }
+}
+} // namespace
+
+/// <summary>
+/// Renders the initial view of the RayTracing viewer on the CPU and writes it as PNG, without window or GPU.
+/// </summary>
+int main(int argc, char** argv)
+{
+  try
+  {
+    const Options                options  = parseOptions(argc, argv);
+    const CpuRenderer::Settings& settings = options.settings;
+
+    using Clock      = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto scene = CpuSceneFactory::createFromGltf(options.scenePath);
+    const auto built = Clock::now();
+    std::cout << "Scene loading: " << std::chrono::duration<f64>(built - start).count() << " s" << std::endl;
+
+    std::unique_ptr<BvhCache> bvhCache;
+    if (!options.bvhCacheDirectory.empty())
+    {
+      bvhCache = std::make_unique<BvhCache>(options.bvhCacheDirectory);
+    }
+    CpuRenderer renderer(scene, options.bottomLevelSettings, bvhCache.get());
+    std::cout << "Acceleration structure: " << std::chrono::duration<f64>(Clock::now() - built).count() << " s";
+    if (bvhCache)
+    {
+      std::cout << ", " << bvhCache->getNumHits() << " BLAS loaded from and " << bvhCache->getNumMisses()
+                << " added to " << options.bvhCacheDirectory.string();
+    }
+    std::cout << std::endl;
+    if (options.printBvhStatistics)
+    {
+      printBvhStatistics(renderer.getAccelerationStructure());
+    }
+
+    ThreadPool threadPool(options.numThreads);
+    std::cout << "Threads: " << threadPool.getNumThreads() << std::endl;
+    if (settings.mode == CpuRenderer::RenderMode::BakedAmbientOcclusion)
+    {
+      printStatistics("Ambient occlusion bake", renderer.bakeAmbientOcclusion(settings, threadPool));
+    }
+
+    // Same camera as the viewer right after start.
+    ExaminerController examinerController(true);
+    examinerController.setTranslationVector(DEFAULT_CAMERA_TRANSLATION);
+    CpuRenderer::Camera camera;
+    camera.viewMatrix =
+        examinerController.getTransformationMatrix() * scene.getAABB().getNormalizationTransformation();
+    camera.projectionMatrix = getProjectionMatrix(settings.width, settings.height);
+
+    CpuRenderer::Accumulation accumulation;
+    std::vector<ui8v4>        image;
+    for (ui32 pass = 0; pass < options.numPasses; pass++)
+    {
+      const auto statistics =
+          renderer.render(camera, getDefaultPointLights(), settings, threadPool, accumulation, image);
+      printStatistics("Pass " + std::to_string(pass), statistics);
+      if (pass == 0)
+      {
+        std::cout << "Tiles: " << statistics.tiles.tileSeconds.size() << ", " << statistics.tiles.numSteals
+                  << " stolen, imbalance " << statistics.tiles.getImbalance() << ", cost per tile:" << std::endl;
+        statistics.tiles.getCostHistogram().print();
+        if (!options.heatmapPath.empty())
+        {
+          writeHeatmaps(options.heatmapPath, settings, statistics);
+        }
+      }
+    }
+
+    writePngFile(options.outputPath, settings.width, settings.height, image.data());
+    std::cout << "Written to " << options.outputPath.string() << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << "\n";
+    printUsage();
+    return 1;
+  }
+  return 0;
+}
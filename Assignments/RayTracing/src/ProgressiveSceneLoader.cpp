@@ -0,0 +1,339 @@
+#include "ProgressiveSceneLoader.hpp"
+#include "SceneFactory.hpp"
+#include <algorithm>
+#include <gimslib/contrib/stb/stb_image.h>
+#include <gimslib/dbg/HrException.hpp>
+#include <iostream>
+#include <numeric>
+#include <unordered_map>
+
+using namespace gims;
+
+namespace
+{
+/// <summary>
+/// Loaded resources are handed over at most every this many milliseconds.
+/// </summary>
+constexpr std::chrono::milliseconds HANDOFF_INTERVAL(100);
+
+/// <summary>
+/// The mesh order is updated at most every this many milliseconds while the camera moves.
+/// </summary>
+constexpr std::chrono::milliseconds RESORT_INTERVAL(100);
+
+/// <summary>
+/// Maximum width and height of the downsampled textures that are loaded first.
+/// </summary>
+constexpr i32 LOW_RESOLUTION_TEXTURE_SIZE = 64;
+
+/// <summary>
+/// Loads an image and halves its resolution until it fits into LOW_RESOLUTION_TEXTURE_SIZE, averaging 2x2 texels.
+/// </summary>
+Texture2DD3D12 createLowResolutionTexture(const std::filesystem::path& path, const ComPtr<ID3D12Device>& device,
+                                          const ComPtr<ID3D12CommandQueue>& commandQueue)
+{
+  const auto fileName = path.generic_string();
+  i32        textureWidth, textureHeight, textureComp;
+
+  std::unique_ptr<ui8, void (*)(void*)> image(
+      stbi_load(fileName.c_str(), &textureWidth, &textureHeight, &textureComp, 4), &stbi_image_free);
+  if (image.get() == nullptr)
+  {
+    throw std::exception("Error loading texture.");
+  }
+
+  const ui8v4* const texels = reinterpret_cast<const ui8v4*>(image.get());
+  std::vector<ui8v4> result(texels, texels + static_cast<size_t>(textureWidth) * textureHeight);
+  while (textureWidth > LOW_RESOLUTION_TEXTURE_SIZE || textureHeight > LOW_RESOLUTION_TEXTURE_SIZE)
+  {
+    const i32 halfWidth  = std::max(textureWidth / 2, 1);
+    const i32 halfHeight = std::max(textureHeight / 2, 1);
+    for (i32 y = 0; y < halfHeight; y++)
+    {
+      const i32 y0 = std::min(2 * y, textureHeight - 1);
+      const i32 y1 = std::min(2 * y + 1, textureHeight - 1);
+      for (i32 x = 0; x < halfWidth; x++)
+      {
+        const i32    x0  = std::min(2 * x, textureWidth - 1);
+        const i32    x1  = std::min(2 * x + 1, textureWidth - 1);
+        const ui32v4 sum = ui32v4(result[y0 * textureWidth + x0]) + ui32v4(result[y0 * textureWidth + x1]) +
+                           ui32v4(result[y1 * textureWidth + x0]) + ui32v4(result[y1 * textureWidth + x1]);
+        // Written in place: the target texel precedes all source texels that are still needed.
+        result[y * halfWidth + x] = ui8v4((sum + 2u) / 4u);
+      }
+    }
+    textureWidth  = halfWidth;
+    textureHeight = halfHeight;
+  }
+
+  return Texture2DD3D12(result.data(), textureWidth, textureHeight, device, commandQueue);
+}
+
+/// <summary>
+/// Approximates the size of a mesh on screen by the largest ratio of bounding sphere radius and distance to the camera
+/// over all its instances. Instances behind the camera count much less.
+/// </summary>
+f32 getSizeOnScreen(const std::vector<f32v4>& boundingSpheres, const f32m4& modelView)
+{
+  const f32 scale = glm::max(glm::length(f32v3(modelView[0])),
+                             glm::max(glm::length(f32v3(modelView[1])), glm::length(f32v3(modelView[2]))));
+
+  f32 result = 0.0f;
+  for (const auto& sphere : boundingSpheres)
+  {
+    const f32v3 center   = f32v3(modelView * f32v4(f32v3(sphere), 1.0f));
+    const f32   radius   = sphere.w * scale;
+    const f32   distance = glm::length(center);
+    if (distance <= radius)
+    {
+      return std::numeric_limits<f32>::max();
+    }
+    // left-handed view space, the camera looks along +z
+    const f32 behindCamera = center.z < -radius ? 0.01f : 1.0f;
+    result                 = glm::max(result, behindCamera * radius / distance);
+  }
+  return result;
+}
+} // namespace
+
+namespace gims
+{
+ProgressiveSceneLoader::ProgressiveSceneLoader(const std::filesystem::path pathToScene,
+                                               const ComPtr<ID3D12Device>& device, Scene& outputScene,
+                                               bool keepCpuCopy)
+    : m_inputScene(pathToScene)
+    , m_parentPath(std::filesystem::weakly_canonical(pathToScene).parent_path())
+    , m_device(device)
+    , m_lastUpdate(std::chrono::steady_clock::now())
+    , m_numLoadedResources(0)
+    , m_keepCpuCopy(keepCpuCopy)
+    , m_modelView(glm::identity<f32m4>())
+    , m_modelViewVersion(0)
+    , m_finished(false)
+    , m_stop(false)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+  queueDesc.Type                     = D3D12_COMMAND_LIST_TYPE_DIRECT;
+  throwIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+
+  // Hierarchy, bounding boxes and materials. Textures are replaced by the defaults until they are loaded.
+  const auto sceneMeshIndices =
+      SceneGraphFactory::createMeshPlaceholders(m_inputScene, outputScene, m_scenePrimitives);
+  SceneGraphFactory::createNodes(m_inputScene, sceneMeshIndices, outputScene);
+  SceneGraphFactory::computeSceneAABB(outputScene, outputScene.m_aabb, 0, glm::identity<f32m4>());
+  SceneGraphFactory::createTextures({}, m_parentPath, m_device, m_commandQueue, outputScene);
+  SceneGraphFactory::createMaterials(m_inputScene, {}, m_device, outputScene);
+
+  // World space bounding spheres of all mesh instances, used for the loading order.
+  m_boundingSpheres.resize(m_scenePrimitives.size());
+  for (ui32 i = 0; i < outputScene.getNumberOfNodes(); i++)
+  {
+    const auto& currentNode = outputScene.getNode(i);
+    for (const auto meshIdx : currentNode.meshIndices)
+    {
+      f32m4 worldSpaceTransformation = currentNode.worldSpaceTransformation;
+      AABB  worldSpaceAABB           = outputScene.getMesh(meshIdx).getAABB();
+      worldSpaceAABB                 = worldSpaceAABB.getTransformed(worldSpaceTransformation);
+
+      const auto lowerLeftBottom = worldSpaceAABB.getLowerLeftBottom();
+      const auto upperRightTop   = worldSpaceAABB.getUpperRightTop();
+      m_boundingSpheres[meshIdx].emplace_back(0.5f * (lowerLeftBottom + upperRightTop),
+                                              0.5f * glm::length(upperRightTop - lowerLeftBottom));
+    }
+  }
+
+  // Same descriptor order as in SceneGraphFactory::createMaterials: ambient, diffuse, specular, emissive, normal.
+  std::unordered_map<std::filesystem::path, ui32> textureFileNameToTextureIndex;
+  const auto&                                     materials = m_inputScene.getMaterials();
+  for (ui32 materialIdx = 0; materialIdx < static_cast<ui32>(materials.size()); materialIdx++)
+  {
+    const auto& material           = materials[materialIdx];
+    const i32   materialTextures[] = {material.diffuseTexture, material.specularTexture, material.emissiveTexture,
+                                      material.normalTexture};
+    for (ui32 slot = 0; slot < 4; slot++)
+    {
+      if (materialTextures[slot] < 0)
+      {
+        continue;
+      }
+      const auto& textureFileName = m_inputScene.getTextureFileName(static_cast<ui32>(materialTextures[slot]));
+      const auto  textureIter =
+          textureFileNameToTextureIndex.emplace(textureFileName, static_cast<ui32>(m_textureFileNames.size())).first;
+      if (textureIter->second == m_textureFileNames.size())
+      {
+        m_textureFileNames.push_back(textureFileName);
+        m_textureUsages.emplace_back();
+      }
+      m_textureUsages[textureIter->second].push_back({materialIdx, slot + 1});
+    }
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  std::cout << "Scene hierarchy created in " << std::chrono::duration<f64, std::milli>(end - start).count() << " ms, "
+            << "loading " << m_scenePrimitives.size() << " meshes and " << m_textureFileNames.size() << " textures"
+            << std::endl;
+
+  m_worker = std::thread(&ProgressiveSceneLoader::loadResources, this);
+}
+
+ProgressiveSceneLoader::~ProgressiveSceneLoader()
+{
+  m_stop = true;
+  if (m_worker.joinable())
+  {
+    m_worker.join();
+  }
+}
+
+void ProgressiveSceneLoader::setModelView(const f32m4& modelView)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (modelView != m_modelView)
+  {
+    m_modelView = modelView;
+    m_modelViewVersion++;
+  }
+}
+
+bool ProgressiveSceneLoader::hasUpdates() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_exception)
+  {
+    return true;
+  }
+  const bool hasLoadedResources = !m_loadedMeshes.empty() || !m_loadedTextures.empty();
+  return hasLoadedResources && (m_finished || std::chrono::steady_clock::now() - m_lastUpdate >= HANDOFF_INTERVAL);
+}
+
+bool ProgressiveSceneLoader::update(Scene& scene)
+{
+  std::vector<std::pair<ui32, TriangleMeshD3D12>> loadedMeshes;
+  std::vector<std::pair<ui32, Texture2DD3D12>>    loadedTextures;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_exception)
+    {
+      std::rethrow_exception(m_exception);
+    }
+    std::swap(loadedMeshes, m_loadedMeshes);
+    std::swap(loadedTextures, m_loadedTextures);
+  }
+  m_lastUpdate = std::chrono::steady_clock::now();
+
+  for (auto& loadedMesh : loadedMeshes)
+  {
+    scene.m_meshes.at(loadedMesh.first) = std::move(loadedMesh.second);
+  }
+
+  scene.m_textures.resize(std::max(scene.m_textures.size(), 3 + m_textureFileNames.size()));
+  for (auto& loadedTexture : loadedTextures)
+  {
+    auto& texture = scene.m_textures.at(3 + loadedTexture.first);
+    texture       = std::move(loadedTexture.second);
+    for (const auto& usage : m_textureUsages[loadedTexture.first])
+    {
+      texture.addToDescriptorHeap(m_device, scene.m_materials.at(usage.materialIdx).srvDescriptorHeap,
+                                  usage.descriptorIdx);
+    }
+  }
+
+  m_numLoadedResources += static_cast<ui32>(loadedMeshes.size() + loadedTextures.size());
+  return !loadedMeshes.empty();
+}
+
+bool ProgressiveSceneLoader::isFinished() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_finished && !m_exception && m_loadedMeshes.empty() && m_loadedTextures.empty();
+}
+
+ui32 ProgressiveSceneLoader::getNumLoadedResources() const
+{
+  return m_numLoadedResources;
+}
+
+ui32 ProgressiveSceneLoader::getNumResources() const
+{
+  return static_cast<ui32>(m_scenePrimitives.size() + 2 * m_textureFileNames.size());
+}
+
+void ProgressiveSceneLoader::loadResources()
+{
+  try
+  {
+    // Meshes, the largest on screen first. The order is updated when the camera moves.
+    std::vector<ui32> pendingMeshes(m_scenePrimitives.size());
+    std::iota(pendingMeshes.begin(), pendingMeshes.end(), 0);
+    ui32 sortedModelViewVersion = static_cast<ui32>(-1);
+    auto lastSort               = std::chrono::steady_clock::time_point();
+
+    MeshOptimizationStatistics statistics;
+    while (!pendingMeshes.empty() && !m_stop)
+    {
+      f32m4 modelView;
+      ui32  modelViewVersion;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        modelView        = m_modelView;
+        modelViewVersion = m_modelViewVersion;
+      }
+      const auto now = std::chrono::steady_clock::now();
+      if (modelViewVersion != sortedModelViewVersion && now - lastSort >= RESORT_INTERVAL)
+      {
+        sortBySizeOnScreen(pendingMeshes, modelView);
+        sortedModelViewVersion = modelViewVersion;
+        lastSort               = now;
+      }
+
+      const ui32 meshIdx = pendingMeshes.back();
+      pendingMeshes.pop_back();
+      auto mesh = SceneGraphFactory::createMesh(m_inputScene, *m_scenePrimitives[meshIdx], m_device, m_commandQueue,
+                                                m_keepCpuCopy, statistics);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_loadedMeshes.emplace_back(meshIdx, std::move(mesh));
+    }
+    if (!m_stop)
+    {
+      std::cout << "Mesh optimization: ";
+      statistics.print(std::cout);
+    }
+
+    // Textures: first all of them in low resolution, then in full resolution.
+    for (const bool lowResolution : {true, false})
+    {
+      for (ui32 i = 0; i < static_cast<ui32>(m_textureFileNames.size()) && !m_stop; i++)
+      {
+        const auto path    = m_parentPath / m_textureFileNames[i];
+        auto       texture = lowResolution ? createLowResolutionTexture(path, m_device, m_commandQueue)
+                                           : Texture2DD3D12(path, m_device, m_commandQueue);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loadedTextures.emplace_back(i, std::move(texture));
+      }
+    }
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_exception = std::current_exception();
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_finished = true;
+}
+
+void ProgressiveSceneLoader::sortBySizeOnScreen(std::vector<ui32>& meshIndices, const f32m4& modelView) const
+{
+  std::vector<f32> sizeOnScreen(m_boundingSpheres.size(), 0.0f);
+  for (const auto meshIdx : meshIndices)
+  {
+    sizeOnScreen[meshIdx] = getSizeOnScreen(m_boundingSpheres[meshIdx], modelView);
+  }
+  std::sort(meshIndices.begin(), meshIndices.end(),
+            [&](ui32 a, ui32 b) { return sizeOnScreen[a] < sizeOnScreen[b]; });
+}
+} // namespace gims
@@ -47,6 +47,30 @@ inline void allocateUAVBuffer(ComPtr<ID3D12Device5> device, ui64 bufferSize, ID3
   (*ppResource)->SetName(resourceName);
 }
 
+/// <summary>
+/// Instance of a BLAS with the world space transformation of a node. InstanceID() is the mesh index, which DXR limits
+/// to 24 bits.
+/// </summary>
+inline D3D12_RAYTRACING_INSTANCE_DESC createInstanceDesc(const f32m4& worldSpaceTransformation, ui32 meshIdx,
+                                                         ID3D12Resource* bottomLevelAS)
+{
+  // transpose to match the row-major order of DirectX
+  const auto transposed = glm::transpose(worldSpaceTransformation);
+
+  D3D12_RAYTRACING_INSTANCE_DESC instanceDesc = {};
+  for (ui32 row = 0; row < 3; row++)
+  {
+    for (ui32 column = 0; column < 4; column++)
+    {
+      instanceDesc.Transform[row][column] = transposed[row][column];
+    }
+  }
+  instanceDesc.InstanceID            = meshIdx & 0xFFFFFF;
+  instanceDesc.InstanceMask          = 1;
+  instanceDesc.AccelerationStructure = bottomLevelAS->GetGPUVirtualAddress();
+  return instanceDesc;
+}
+
 #pragma endregion
 
 } // namespace
@@ -128,100 +152,94 @@ void RayTracingUtils::createAccelerationStructures(ComPtr<ID3D12Device5> device,
                                                    ComPtr<ID3D12CommandAllocator>     commandAllocator,
                                                    ComPtr<ID3D12CommandQueue> commandQueue, SceneGraphViewerApp& app)
 {
+  const ui32 numMeshes = scene.getNumberOfMeshes();
+  const ui32 numNodes  = scene.getNumberOfNodes();
+
+  // Meshes that are still loading are left out. As long as none is loaded, there is nothing to build.
+  bool hasLoadedMeshes = false;
+  for (ui32 i = 0; i < numNodes; i++)
+  {
+    for (const auto meshIdx : scene.getNode(i).meshIndices)
+    {
+      hasLoadedMeshes = hasLoadedMeshes || scene.getMesh(meshIdx).isLoaded();
+    }
+  }
+  if (!hasLoadedMeshes)
+  {
+    return;
+  }
 
   // Reset the command list for the acceleration structure construction.
   commandList->Reset(commandAllocator.Get(), nullptr);
-  const ui32 numMeshes = scene.getNumberOfMeshes();
-  const ui32 numNodes  = scene.getNumberOfNodes();
 
-  // Build all BLAS for scene
+  // One BLAS per mesh, which all nodes that reference the mesh share. BLAS of earlier calls are kept, since loaded
+  // meshes do not change, so only the meshes loaded in the meantime are built. The TLAS is always rebuilt.
   std::vector<D3D12_RAYTRACING_INSTANCE_DESC> instanceDescs;
   std::vector<ComPtr<ID3D12Resource>>         scratchResources; // Keep scratch resources alive
-  instanceDescs.reserve(numMeshes);
+  m_bottomLevelAS.resize(numMeshes);
 
-  for (ui16 i = 0; i < numNodes; i++)
+  for (ui32 i = 0; i < numNodes; i++)
   {
     const auto& currentNode = scene.getNode(i);
-    if (currentNode.meshIndices.empty())
+    for (const auto meshIdx : currentNode.meshIndices)
     {
-      continue;
-    }
-
-    for (ui8 m = 0; m < currentNode.meshIndices.size(); m++)
-    {
-      const auto& currentMesh = scene.getMesh(currentNode.meshIndices.at(m));
-
-      //  Create geometry description for each mesh
-      D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
-      geometryDesc.Type                           = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
-      geometryDesc.Triangles.IndexBuffer          = currentMesh.getIndexBuffer()->GetGPUVirtualAddress();
-      geometryDesc.Triangles.IndexCount =
-          static_cast<ui32>(currentMesh.getIndexBuffer()->GetDesc().Width) / sizeof(ui32);
-      geometryDesc.Triangles.IndexFormat  = DXGI_FORMAT_R32_UINT;
-      geometryDesc.Triangles.Transform3x4 = 0;
-      geometryDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
-      geometryDesc.Triangles.VertexCount =
-          static_cast<ui32>(currentMesh.getVertexBuffer()->GetDesc().Width) / sizeof(Vertex);
-      geometryDesc.Triangles.VertexBuffer.StartAddress  = currentMesh.getVertexBuffer()->GetGPUVirtualAddress();
-      geometryDesc.Triangles.VertexBuffer.StrideInBytes = sizeof(Vertex);
-      geometryDesc.Flags                                = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
-
-      // Create BLAS for each mesh
-      D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS bottomLevelInputs = {};
-      bottomLevelInputs.Type           = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
-      bottomLevelInputs.DescsLayout    = D3D12_ELEMENTS_LAYOUT_ARRAY;
-      bottomLevelInputs.Flags          = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-      bottomLevelInputs.NumDescs       = 1;
-      bottomLevelInputs.pGeometryDescs = &geometryDesc;
-
-      D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO bottomLevelPrebuildInfo = {};
-      device->GetRaytracingAccelerationStructurePrebuildInfo(&bottomLevelInputs, &bottomLevelPrebuildInfo);
-      throwIfZero(bottomLevelPrebuildInfo.ResultDataMaxSizeInBytes > 0);
-
-      // Create scratch buffer
-      ComPtr<ID3D12Resource> scratchResource;
-      allocateUAVBuffer(device, bottomLevelPrebuildInfo.ScratchDataSizeInBytes, &scratchResource,
-                        D3D12_RESOURCE_STATE_COMMON, L"BLAS_ScratchResource");
-      scratchResources.push_back(scratchResource);
-
-      ComPtr<ID3D12Resource> blasResource;
-      allocateUAVBuffer(device, bottomLevelPrebuildInfo.ResultDataMaxSizeInBytes, &blasResource,
-                        D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, L"BottomLevelAccelerationStructure");
-      m_bottomLevelAS.push_back(blasResource);
-      const ui8 index = static_cast<ui8>(m_bottomLevelAS.size() - 1);
-
-      // Bottom Level Acceleration Structure desc
-      D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC bottomLevelBuildDesc = {};
-      bottomLevelBuildDesc.Inputs                                             = bottomLevelInputs;
-      bottomLevelBuildDesc.ScratchAccelerationStructureData                   = scratchResource->GetGPUVirtualAddress();
-      bottomLevelBuildDesc.DestAccelerationStructureData = m_bottomLevelAS.at(index)->GetGPUVirtualAddress();
-
-      commandList->BuildRaytracingAccelerationStructure(&bottomLevelBuildDesc, 0, nullptr);
-      auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(m_bottomLevelAS.at(index).Get());
-      commandList->ResourceBarrier(1, &uavBarrier);
-
-      // transpose to match the row-major order of DirectX
-      const auto worldSpaceTransformation = glm::transpose(currentNode.worldSpaceTransformation);
-
-      // create instance description for each BLAS
-      D3D12_RAYTRACING_INSTANCE_DESC instanceDesc = {};
-      instanceDesc.Transform[0][0]                = worldSpaceTransformation[0][0];
-      instanceDesc.Transform[0][1]                = worldSpaceTransformation[0][1];
-      instanceDesc.Transform[0][2]                = worldSpaceTransformation[0][2];
-      instanceDesc.Transform[0][3]                = worldSpaceTransformation[0][3];
-
-      instanceDesc.Transform[1][0] = worldSpaceTransformation[1][0];
-      instanceDesc.Transform[1][1] = worldSpaceTransformation[1][1];
-      instanceDesc.Transform[1][2] = worldSpaceTransformation[1][2];
-      instanceDesc.Transform[1][3] = worldSpaceTransformation[1][3];
-
-      instanceDesc.Transform[2][0]       = worldSpaceTransformation[2][0];
-      instanceDesc.Transform[2][1]       = worldSpaceTransformation[2][1];
-      instanceDesc.Transform[2][2]       = worldSpaceTransformation[2][2];
-      instanceDesc.Transform[2][3]       = worldSpaceTransformation[2][3];
-      instanceDesc.InstanceMask          = 1;
-      instanceDesc.AccelerationStructure = m_bottomLevelAS.at(index)->GetGPUVirtualAddress();
-      instanceDescs.push_back(instanceDesc);
+      const auto& currentMesh = scene.getMesh(meshIdx);
+      if (!currentMesh.isLoaded())
+      {
+        continue;
+      }
+      if (!m_bottomLevelAS[meshIdx])
+      {
+        //  Create geometry description for each mesh
+        D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
+        geometryDesc.Type                           = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+        geometryDesc.Triangles.IndexBuffer          = currentMesh.getIndexBuffer()->GetGPUVirtualAddress();
+        geometryDesc.Triangles.IndexCount =
+            static_cast<ui32>(currentMesh.getIndexBuffer()->GetDesc().Width) / sizeof(ui32);
+        geometryDesc.Triangles.IndexFormat  = DXGI_FORMAT_R32_UINT;
+        geometryDesc.Triangles.Transform3x4 = 0;
+        geometryDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+        geometryDesc.Triangles.VertexCount =
+            static_cast<ui32>(currentMesh.getVertexBuffer()->GetDesc().Width) / sizeof(Vertex);
+        geometryDesc.Triangles.VertexBuffer.StartAddress  = currentMesh.getVertexBuffer()->GetGPUVirtualAddress();
+        geometryDesc.Triangles.VertexBuffer.StrideInBytes = sizeof(Vertex);
+        geometryDesc.Flags                                = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+
+        // Create BLAS for each mesh
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS bottomLevelInputs = {};
+        bottomLevelInputs.Type           = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+        bottomLevelInputs.DescsLayout    = D3D12_ELEMENTS_LAYOUT_ARRAY;
+        bottomLevelInputs.Flags          = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        bottomLevelInputs.NumDescs       = 1;
+        bottomLevelInputs.pGeometryDescs = &geometryDesc;
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO bottomLevelPrebuildInfo = {};
+        device->GetRaytracingAccelerationStructurePrebuildInfo(&bottomLevelInputs, &bottomLevelPrebuildInfo);
+        throwIfZero(bottomLevelPrebuildInfo.ResultDataMaxSizeInBytes > 0);
+
+        // Create scratch buffer
+        ComPtr<ID3D12Resource> scratchResource;
+        allocateUAVBuffer(device, bottomLevelPrebuildInfo.ScratchDataSizeInBytes, &scratchResource,
+                          D3D12_RESOURCE_STATE_COMMON, L"BLAS_ScratchResource");
+        scratchResources.push_back(scratchResource);
+
+        ComPtr<ID3D12Resource> blasResource;
+        allocateUAVBuffer(device, bottomLevelPrebuildInfo.ResultDataMaxSizeInBytes, &blasResource,
+                          D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, L"BottomLevelAccelerationStructure");
+        m_bottomLevelAS[meshIdx] = blasResource;
+
+        // Bottom Level Acceleration Structure desc
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC bottomLevelBuildDesc = {};
+        bottomLevelBuildDesc.Inputs                             = bottomLevelInputs;
+        bottomLevelBuildDesc.ScratchAccelerationStructureData   = scratchResource->GetGPUVirtualAddress();
+        bottomLevelBuildDesc.DestAccelerationStructureData      = m_bottomLevelAS[meshIdx]->GetGPUVirtualAddress();
+
+        commandList->BuildRaytracingAccelerationStructure(&bottomLevelBuildDesc, 0, nullptr);
+        auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(m_bottomLevelAS[meshIdx].Get());
+        commandList->ResourceBarrier(1, &uavBarrier);
+      }
+      instanceDescs.push_back(
+          createInstanceDesc(currentNode.worldSpaceTransformation, meshIdx, m_bottomLevelAS[meshIdx].Get()));
     }
   }
 
@@ -269,4 +287,60 @@ void RayTracingUtils::createAccelerationStructures(ComPtr<ID3D12Device5> device,
   app.waitForGPU();
 }
 
-#pragma endregion
\ No newline at end of file
+TopLevelAS RayTracingUtils::createCpuAccelerationStructure(const Scene&            scene,
+                                                           const BvhBuildSettings& bottomLevelSettings,
+                                                           BvhCache*               bvhCache)
+{
+  // Every mesh gets one BLAS, which all nodes that reference the mesh share.
+  std::vector<TopLevelAS::Instance> instances;
+  std::vector<ui32>                 meshBottomLevelASIndices(scene.getNumberOfMeshes(), RayHit::INVALID);
+  std::vector<ui32>                 meshIndices;
+  for (ui32 i = 0; i < scene.getNumberOfNodes(); i++)
+  {
+    const auto& currentNode = scene.getNode(i);
+    for (const auto meshIdx : currentNode.meshIndices)
+    {
+      if (!scene.getMesh(meshIdx).isLoaded())
+      {
+        continue;
+      }
+      if (meshBottomLevelASIndices[meshIdx] == RayHit::INVALID)
+      {
+        meshBottomLevelASIndices[meshIdx] = static_cast<ui32>(meshIndices.size());
+        meshIndices.push_back(meshIdx);
+      }
+      TopLevelAS::Instance instance = {currentNode.worldSpaceTransformation, meshBottomLevelASIndices[meshIdx]};
+      instance.instanceID           = meshIdx;
+      instance.userData             = i;
+      instances.push_back(instance);
+    }
+  }
+
+  // Small meshes are built in parallel with each other, large ones additionally split their top levels into tasks.
+  std::vector<BottomLevelAS> bottomLevelAS(meshIndices.size());
+  ThreadPool::getGlobal().parallelFor(0, static_cast<ui32>(meshIndices.size()), 1,
+                                      [&](ui32 begin, ui32 end)
+                                      {
+                                        for (ui32 i = begin; i < end; i++)
+                                        {
+                                          const auto& mesh = scene.getMesh(meshIndices[i]);
+                                          bottomLevelAS[i] =
+                                              bvhCache != nullptr
+                                                  ? bvhCache->getBottomLevelAS(mesh.getPositions(), mesh.getIndices(),
+                                                                               bottomLevelSettings)
+                                                  : BottomLevelAS(mesh.getPositions(), mesh.getIndices(),
+                                                                  bottomLevelSettings);
+                                        }
+                                      });
+
+  BvhBuildStatistics statistics;
+  for (const auto& blas : bottomLevelAS)
+  {
+    statistics += blas.getBvh().getBuildStatistics();
+  }
+  std::cout << "CPU BLAS build: ";
+  statistics.print(std::cout);
+  return TopLevelAS(std::move(bottomLevelAS), std::move(instances));
+}
+
+#pragma endregion
@@ -24,6 +24,10 @@ void addToCommandListImpl(Scene& scene, ui32 nodeIdx, f32m4 accuModelView,
   for (ui32 m = 0; m < (ui32)currentNode.meshIndices.size(); m++)
   {
     const auto& meshToDraw   = scene.getMesh(currentNode.meshIndices[m]);
+    if (!meshToDraw.isLoaded())
+    {
+      continue;
+    }
     const auto& meshMaterial = scene.getMaterial(meshToDraw.getMaterialIndex());
     commandList->SetGraphicsRoot32BitConstants(modelViewRootParameterIdx, 16, &accuModelView, 0);
     commandList->SetGraphicsRoot32BitConstants(modelViewRootParameterIdx, 16, &worldTransformation, 16);
@@ -89,4 +93,50 @@ void Scene::addToCommandList(const ComPtr<ID3D12GraphicsCommandList>& commandLis
   addToCommandListImpl(*this, 0, modelView, commandList, modelViewRootParameterIdx,
                        materialConstantsRootParameterIdx, srvRootParameterIdx);
 }
+
+void Scene::setPickingAccelerationStructure(TopLevelAS pickingAS)
+{
+  m_pickingAS = std::move(pickingAS);
+  for (auto& mesh : m_meshes)
+  {
+    mesh.releaseCpuCopy();
+  }
+}
+
+Scene::PickResult Scene::pick(const Ray& ray) const
+{
+  PickResult result;
+  RayHit     hit;
+  if (!m_pickingAS.intersect(ray, hit))
+  {
+    return result;
+  }
+  const auto& instance = m_pickingAS.getInstances()[hit.instanceIdx];
+  result.nodeIdx       = static_cast<ui32>(instance.userData);
+  result.meshIdx       = hit.instanceID;
+  result.triangleIdx   = hit.triangleIdx;
+  result.barycentrics  = hit.barycentrics;
+  result.distance      = hit.t * glm::length(ray.direction);
+  return result;
+}
+
+Scene::PickResult Scene::pick(const f32v2& normalizedCoordinates, const f32m4& worldToClip) const
+{
+  const f32m4 clipToWorld = glm::inverse(worldToClip);
+  const f32v4 nearPoint   = clipToWorld * f32v4(normalizedCoordinates, 0.0f, 1.0f);
+  const f32v4 farPoint    = clipToWorld * f32v4(normalizedCoordinates, 1.0f, 1.0f);
+  const f32v3 origin      = f32v3(nearPoint) / nearPoint.w;
+  const f32v3 direction   = f32v3(farPoint) / farPoint.w - origin;
+  const f32   length      = glm::length(direction);
+  if (!(length > 0.0f))
+  {
+    return PickResult();
+  }
+
+  Ray ray;
+  ray.origin    = origin;
+  ray.direction = direction / length;
+  ray.tMax      = length;
+  return pick(ray);
+}
 } // namespace gims
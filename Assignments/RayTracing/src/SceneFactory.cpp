@@ -1,41 +1,39 @@
 #include "SceneFactory.hpp"
+#include "GltfConversion.hpp"
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <d3dx12/d3dx12.h>
 #include <gimslib/d3d/UploadHelper.hpp>
 #include <gimslib/dbg/HrException.hpp>
+#include <gimslib/io/GltfFile.hpp>
+#include <gimslib/mesh/MeshOptimizer.hpp>
 #include <iostream>
 using namespace gims;
 
 namespace
 {
+f32v3 aiVector3DToGlm(const aiVector3D& v)
+{
+  return f32v3(v.x, v.y, v.z);
+}
+
 /// <summary>
-/// Converts the index buffer required for D3D12 rendering from an aiMesh.
+/// Counts the triangles of an aiMesh. Faces that are not triangles (points and lines) are ignored.
 /// </summary>
-/// <param name="mesh">The ai mesh containing an index buffer.</param>
-/// <returns></returns>
-std::vector<ui32v3> getTriangleIndicesFromAiMesh(aiMesh const* const mesh)
+/// <param name="mesh">The ai mesh.</param>
+/// <returns>Number of faces with 3 indices.</returns>
+ui32 getNumTrianglesOfAiMesh(aiMesh const* const mesh)
 {
-  std::vector<ui32v3> result;
-  if (!mesh->HasFaces())
-    return result;
-
-  result.reserve(mesh->mNumFaces);
+  ui32 numTriangles = 0;
   for (ui32 i = 0; i < mesh->mNumFaces; i++)
   {
-    const aiFace& currentFace = mesh->mFaces[i];
-    if (currentFace.mNumIndices == 3)
+    if (mesh->mFaces[i].mNumIndices == 3)
     {
-      result.emplace_back(currentFace.mIndices[0], currentFace.mIndices[1], currentFace.mIndices[2]);
-    }
-    else
-    {
-      std::cout << "Not 3 indices" << std::endl;
+      numTriangles++;
     }
   }
-
-  return result;
+  return numTriangles;
 }
 
 ui8 getDefaultTextureIndexForTextureType(aiTextureType aiTextureTypeValue)
@@ -124,13 +122,29 @@ f32v4 getColor(char const* const pKey, unsigned int type, unsigned int idx, aiMa
   }
 }
 
+/// <summary>
+/// Creates a shader visible descriptor heap for the textures of one material.
+/// </summary>
+/// <param name="device">The device.</param>
+/// <returns>Descriptor heap with 5 descriptors for the different texture types.</returns>
+ComPtr<ID3D12DescriptorHeap> createTextureDescriptorHeap(const ComPtr<ID3D12Device>& device)
+{
+  D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+  heapDesc.NumDescriptors             = 5; // 5 descriptors for different texture types
+  heapDesc.Type                       = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+  heapDesc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+  ComPtr<ID3D12DescriptorHeap> textureDescriptorHeap;
+  throwIfFailed(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&textureDescriptorHeap)));
+  return textureDescriptorHeap;
+}
+
 } // namespace
 
 namespace gims
 {
 Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path       pathToScene,
                                                const ComPtr<ID3D12Device>&       device,
-                                               const ComPtr<ID3D12CommandQueue>& commandQueue)
+                                               const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy)
 {
   Scene outputScene;
 
@@ -142,8 +156,8 @@ Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path
 
   const auto arguments = aiPostProcessSteps::aiProcess_Triangulate | aiProcess_GenSmoothNormals |
                          aiProcess_GenUVCoords | aiProcess_ConvertToLeftHanded | aiProcess_OptimizeMeshes |
-                         aiProcess_RemoveRedundantMaterials | aiProcess_ImproveCacheLocality |
-                         aiProcess_FindInvalidData | aiProcess_FindDegenerates | aiProcess_CalcTangentSpace;
+                         aiProcess_RemoveRedundantMaterials | aiProcess_FindInvalidData | aiProcess_FindDegenerates |
+                         aiProcess_CalcTangentSpace;
 
   Assimp::Importer imp;
   imp.SetPropertyBool(AI_CONFIG_PP_FD_REMOVE, true);
@@ -154,7 +168,7 @@ Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path
   }
   const auto textureFileNameToTextureIndex = textureFilenameToIndex(inputScene);
 
-  createMeshes(inputScene, device, commandQueue, outputScene);
+  createMeshes(inputScene, device, commandQueue, keepCpuCopy, outputScene);
 
   f32m4 identity = glm::identity<f32m4>();
   createNodes(inputScene, outputScene, inputScene->mRootNode, identity);
@@ -174,94 +188,82 @@ Scene SceneGraphFactory::createFromAssImpScene(const std::filesystem::path
 /// <param name="inputScene"></param>
 /// <param name="device"></param>
 /// <param name="commandQueue"></param>
+/// <param name="keepCpuCopy"></param>
 /// <param name="outputScene"></param>
 void SceneGraphFactory::createMeshes(aiScene const* const inputScene, const ComPtr<ID3D12Device>& device,
-                                     const ComPtr<ID3D12CommandQueue>& commandQueue, Scene& outputScene)
+                                     const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy,
+                                     Scene& outputScene)
 {
+  MeshOptimizationStatistics statistics;
   for (ui32 i = 0; i < inputScene->mNumMeshes; i++)
   {
     const aiMesh* currentMesh = inputScene->mMeshes[i];
 
-    // get positions and normals
-    const ui32         numVertices = currentMesh->mNumVertices;
-    std::vector<f32v3> positions;
-    positions.reserve(numVertices);
-    std::vector<f32v3> normals;
-    normals.reserve(numVertices);
-    std::vector<f32v3> textureCoords;
-    textureCoords.reserve(numVertices);
-    std::vector<f32v3> tangents;
-    tangents.reserve(numVertices);
-    for (ui32 n = 0; n < numVertices; n++)
+    const ui32 numVertices  = currentMesh->mNumVertices;
+    const ui32 numTriangles = getNumTrianglesOfAiMesh(currentMesh);
+    if (numTriangles != currentMesh->mNumFaces)
     {
-      const aiVector3D& currentPos = currentMesh->mVertices[n];
-      positions.emplace_back(currentPos.x, currentPos.y, currentPos.z);
+      std::cout << "Not 3 indices" << std::endl;
+    }
 
-      if (currentMesh->HasNormals())
-      {
-        const aiVector3D& currentNormal = currentMesh->mNormals[n];
-        normals.emplace_back(currentNormal.x, currentNormal.y, currentNormal.z);
-      }
-      else
+    // Triangles are reordered for the vertex cache and overdraw first, so the vertices can be written once in their
+    // final order.
+    std::vector<ui32> indices;
+    indices.reserve(3 * numTriangles);
+    for (ui32 f = 0; f < currentMesh->mNumFaces; f++)
+    {
+      const aiFace& currentFace = currentMesh->mFaces[f];
+      if (currentFace.mNumIndices == 3)
       {
-        normals.emplace_back(0.0f, 0.0f, 0.0f); // default normal if missing
+        indices.insert(indices.end(), currentFace.mIndices, currentFace.mIndices + 3);
       }
+    }
+    std::vector<ui32> vertexRemap;
+    statistics += optimizeMesh(indices.data(), indices.size(), reinterpret_cast<const f32v3*>(currentMesh->mVertices),
+                               sizeof(aiVector3D), numVertices, vertexRemap);
 
-      if (currentMesh->HasTextureCoords(0))
-      {
-        const aiVector3D& currentTexCoord = currentMesh->mTextureCoords[0][n];
-        textureCoords.emplace_back(currentTexCoord.x, currentTexCoord.y, 0.0f);
-      }
-      else
-      {
-        textureCoords.emplace_back(0.0f, 0.0f, 0.0f); // default UV if missing
-      }
+    // Vertices and indices are written once, directly into the upload buffers.
+    TriangleMeshStagingD3D12 staging(numVertices, 3 * numTriangles, device, keepCpuCopy);
 
-      if (currentMesh->HasTangentsAndBitangents())
-      {
-        const aiVector3D& currentTangent = currentMesh->mTangents[i];
-        tangents.emplace_back(currentTangent.x, currentTangent.y, currentTangent.z);
-      }
-      else
-      {
-        tangents.emplace_back(0.0f, 0.0f, 0.0f);
-      }
+    // The upload buffer is write-combined, so the vertices are written in output order and gathered from the Assimp
+    // arrays instead.
+    std::vector<ui32> inverseVertexRemap(numVertices);
+    for (ui32 n = 0; n < numVertices; n++)
+    {
+      inverseVertexRemap[vertexRemap[n]] = n;
+    }
+
+    const bool hasNormals            = currentMesh->HasNormals();
+    const bool hasTextureCoordinates = currentMesh->HasTextureCoords(0);
+    const bool hasTangents           = currentMesh->HasTangentsAndBitangents();
+    for (ui32 v = 0; v < numVertices; v++)
+    {
+      const ui32 n = inverseVertexRemap[v];
+
+      // default normal, UV and tangent if missing
+      const aiVector3D currentTexCoord = hasTextureCoordinates ? currentMesh->mTextureCoords[0][n] : aiVector3D();
+
+      Vertex vertex;
+      vertex.position          = aiVector3DToGlm(currentMesh->mVertices[n]);
+      vertex.normal            = hasNormals ? aiVector3DToGlm(currentMesh->mNormals[n]) : f32v3(0.0f);
+      vertex.textureCoordinate = f32v2(currentTexCoord.x, currentTexCoord.y);
+      vertex.tangents          = hasTangents ? aiVector3DToGlm(currentMesh->mTangents[n]) : f32v3(0.0f);
+      staging.setVertex(v, vertex);
     }
 
-    // get triangle indices
-    const std::vector<ui32v3> indexBuffer = getTriangleIndicesFromAiMesh(currentMesh);
-    const ui32                numIndices  = 3 * static_cast<ui32>(indexBuffer.size()); // mul by 3, because of vec3
+    for (ui32 t = 0; t < numTriangles; t++)
+    {
+      staging.setTriangle(t, ui32v3(indices[3 * t], indices[3 * t + 1], indices[3 * t + 2]));
+    }
 
     std::cout << "NumVertices: " << numVertices << std::endl;
-    std::cout << "NumIndices: " << numIndices << std::endl;
-
-    //// manual calculation of tangents -> not needed, assimp already provides
-    // std::vector<f32v3> tangents;
-    // tangents.reserve(indexBuffer.size());
-
-    //// calculations for normal mapping
-    // for (const auto& triangleFace : indexBuffer)
-    //{
-    //   f32v3 edge1    = positions[triangleFace[1]] - positions[triangleFace[0]];
-    //   f32v3 edge2    = positions[triangleFace[2]] - positions[triangleFace[0]];
-    //   f32v2 deltaUV1 = textureCoords[triangleFace[1]] - textureCoords[triangleFace[0]];
-    //   f32v2 deltaUV2 = textureCoords[triangleFace[2]] - textureCoords[triangleFace[0]];
-
-    //  float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-    //  f32 tangent1_x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-    //  f32 tangent1_y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-    //  f32 tangent1_z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-    //  tangents.emplace_back(tangent1_x, tangent1_y, tangent1_z);
-    //}
-
-    // create internal mesh
-    TriangleMeshD3D12 createdMesh = TriangleMeshD3D12::TriangleMeshD3D12(
-        positions.data(), normals.data(), textureCoords.data(), numVertices, indexBuffer.data(), numIndices,
-        tangents.data(), currentMesh->mMaterialIndex, device, commandQueue);
-
-    outputScene.m_meshes.push_back(createdMesh);
+    std::cout << "NumIndices: " << staging.getNumIndices() << std::endl;
+
+    // create internal mesh, the staging memory is handed over and released after the upload
+    outputScene.m_meshes.emplace_back(std::move(staging), currentMesh->mMaterialIndex, device, commandQueue);
   }
+  std::cout << "Mesh optimization: ";
+  statistics.print(std::cout);
 }
 
 ui32 SceneGraphFactory::createNodes(aiScene const* const inputScene, Scene& outputScene, aiNode const* const assimpNode,
@@ -364,13 +366,7 @@ void SceneGraphFactory::createMaterials(aiScene const* const
     ConstantBufferD3D12 materialConstantBuffer(mcb, device);
 
     // Create descriptor heap for the textures
-    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-    heapDesc.NumDescriptors             = 5; // 5 descriptors for different texture types
-    heapDesc.Type                       = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    heapDesc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    ComPtr<ID3D12DescriptorHeap> textureDescriptorHeap;
-    device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&textureDescriptorHeap));
-    CD3DX12_CPU_DESCRIPTOR_HANDLE descriptorHandle(textureDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+    const auto textureDescriptorHeap = createTextureDescriptorHeap(device);
 
     // create material and add to scene
     outputScene.m_materials.emplace_back(materialConstantBuffer, textureDescriptorHeap);
@@ -400,4 +396,222 @@ void SceneGraphFactory::createMaterials(aiScene const* const
   // Assignment 10
 }
 
+#pragma region glTF
+
+Scene SceneGraphFactory::createFromGltf(const std::filesystem::path       pathToScene,
+                                        const ComPtr<ID3D12Device>&       device,
+                                        const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy)
+{
+  Scene outputScene;
+
+  const auto absolutePath = std::filesystem::weakly_canonical(pathToScene);
+  if (!std::filesystem::exists(absolutePath))
+  {
+    throw std::exception((absolutePath.string() + std::string(" does not exist.")).c_str());
+  }
+
+  const GltfFile inputScene(absolutePath);
+
+  const auto sceneMeshIndices = createMeshes(inputScene, device, commandQueue, keepCpuCopy, outputScene);
+
+  createNodes(inputScene, sceneMeshIndices, outputScene);
+
+  computeSceneAABB(outputScene, outputScene.m_aabb, 0, glm::identity<f32m4>());
+
+  // Only textures that are referenced by a material are loaded.
+  std::unordered_map<std::filesystem::path, ui32> textureFileNameToTextureIndex;
+  ui32                                            textureIdx = 3;
+  for (const auto& material : inputScene.getMaterials())
+  {
+    for (const i32 materialTextureIdx :
+         {material.diffuseTexture, material.specularTexture, material.emissiveTexture, material.normalTexture})
+    {
+      if (materialTextureIdx < 0)
+      {
+        continue;
+      }
+      const auto& textureFileName = inputScene.getTextureFileName(static_cast<ui32>(materialTextureIdx));
+      if (textureFileNameToTextureIndex.emplace(textureFileName, textureIdx).second)
+      {
+        textureIdx++;
+      }
+    }
+  }
+  createTextures(textureFileNameToTextureIndex, absolutePath.parent_path(), device, commandQueue, outputScene);
+  createMaterials(inputScene, textureFileNameToTextureIndex, device, outputScene);
+
+  return outputScene;
+}
+
+std::vector<std::vector<ui32>> SceneGraphFactory::createMeshes(const GltfFile&                   inputScene,
+                                                               const ComPtr<ID3D12Device>&       device,
+                                                               const ComPtr<ID3D12CommandQueue>& commandQueue,
+                                                               bool keepCpuCopy, Scene& outputScene)
+{
+  std::vector<std::vector<ui32>> sceneMeshIndices;
+  MeshOptimizationStatistics     statistics;
+  for (const auto& mesh : inputScene.getMeshes())
+  {
+    sceneMeshIndices.emplace_back();
+    for (const auto& primitive : mesh.primitives)
+    {
+      if (!isTrianglePrimitive(primitive))
+      {
+        std::cout << "Skipping non-triangle primitive of mesh " << mesh.name << std::endl;
+        continue;
+      }
+      outputScene.m_meshes.push_back(
+          createMesh(inputScene, primitive, device, commandQueue, keepCpuCopy, statistics));
+      sceneMeshIndices.back().push_back(static_cast<ui32>(outputScene.m_meshes.size() - 1));
+    }
+  }
+  std::cout << "Mesh optimization: ";
+  statistics.print(std::cout);
+  return sceneMeshIndices;
+}
+
+std::vector<std::vector<ui32>> SceneGraphFactory::createMeshPlaceholders(
+    const GltfFile& inputScene, Scene& outputScene, std::vector<GltfFile::Primitive const*>& scenePrimitives)
+{
+  std::vector<std::vector<ui32>> sceneMeshIndices;
+  for (const auto& mesh : inputScene.getMeshes())
+  {
+    sceneMeshIndices.emplace_back();
+    for (const auto& primitive : mesh.primitives)
+    {
+      if (!isTrianglePrimitive(primitive))
+      {
+        std::cout << "Skipping non-triangle primitive of mesh " << mesh.name << std::endl;
+        continue;
+      }
+      outputScene.m_meshes.emplace_back(getPrimitiveAABB(inputScene, primitive),
+                                        getMaterialIndex(inputScene, primitive));
+      scenePrimitives.push_back(&primitive);
+      sceneMeshIndices.back().push_back(static_cast<ui32>(outputScene.m_meshes.size() - 1));
+    }
+  }
+  return sceneMeshIndices;
+}
+
+TriangleMeshD3D12 SceneGraphFactory::createMesh(const GltfFile& inputScene, const GltfFile::Primitive& primitive,
+                                                const ComPtr<ID3D12Device>&       device,
+                                                const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy,
+                                                MeshOptimizationStatistics&       statistics)
+{
+  std::vector<Vertex> vertices;
+  std::vector<ui32>   indices;
+  convertGltfPrimitive(inputScene, primitive, vertices, indices);
+
+  std::vector<ui32> vertexRemap;
+  statistics += optimizeMesh(indices.data(), indices.size(), &vertices.data()->position, sizeof(Vertex),
+                             static_cast<ui32>(vertices.size()), vertexRemap);
+  remapVertices(vertices, vertexRemap);
+
+  return TriangleMeshD3D12(vertices.data(), static_cast<ui32>(vertices.size()), indices.data(),
+                           static_cast<ui32>(indices.size()), getMaterialIndex(inputScene, primitive), device,
+                           commandQueue, keepCpuCopy);
+}
+
+void SceneGraphFactory::createNodes(const GltfFile& inputScene, const std::vector<std::vector<ui32>>& sceneMeshIndices,
+                                    Scene& outputScene)
+{
+  // Like Assimp, introduce an additional root node only if the glTF scene has more than one root.
+  const f32m4 identity  = glm::identity<f32m4>();
+  const auto& rootNodes = inputScene.getRootNodes();
+  if (rootNodes.size() == 1)
+  {
+    createNodes(inputScene, sceneMeshIndices, outputScene, rootNodes[0], identity);
+  }
+  else
+  {
+    outputScene.m_nodes.emplace_back();
+    outputScene.m_nodes.back().transformation           = identity;
+    outputScene.m_nodes.back().worldSpaceTransformation = identity;
+    for (const auto rootNodeIdx : rootNodes)
+    {
+      const ui32 childNodeIndex = createNodes(inputScene, sceneMeshIndices, outputScene, rootNodeIdx, identity);
+      outputScene.m_nodes.at(0).childIndices.emplace_back(childNodeIndex);
+    }
+  }
+}
+
+ui32 SceneGraphFactory::createNodes(const GltfFile& inputScene, const std::vector<std::vector<ui32>>& sceneMeshIndices,
+                                    Scene& outputScene, ui32 nodeIdx, f32m4 worldSpaceTransformation)
+{
+  const auto& inputNode = inputScene.getNodes().at(nodeIdx);
+
+  // create node and add to list
+  outputScene.m_nodes.emplace_back();
+  const auto   currentNodeIndex = static_cast<ui32>(outputScene.m_nodes.size() - 1);
+  Scene::Node& currentNode      = outputScene.m_nodes.back();
+
+  currentNode.transformation           = toLeftHanded(inputNode.transformation);
+  worldSpaceTransformation             = worldSpaceTransformation * currentNode.transformation;
+  currentNode.worldSpaceTransformation = worldSpaceTransformation;
+
+  if (inputNode.mesh >= 0)
+  {
+    currentNode.meshIndices = sceneMeshIndices.at(inputNode.mesh);
+  }
+
+  for (const auto childIdx : inputNode.childIndices)
+  {
+    const ui32 childNodeIndex =
+        createNodes(inputScene, sceneMeshIndices, outputScene, childIdx, worldSpaceTransformation);
+    outputScene.m_nodes.at(currentNodeIndex).childIndices.emplace_back(childNodeIndex);
+  }
+
+  return currentNodeIndex;
+}
+
+void SceneGraphFactory::createMaterials(
+    const GltfFile& inputScene, const std::unordered_map<std::filesystem::path, ui32>& textureFileNameToTextureIndex,
+    const ComPtr<ID3D12Device>& device, Scene& outputScene)
+{
+  std::vector<GltfFile::Material> materials = inputScene.getMaterials();
+  if (gltfNeedsDefaultMaterial(inputScene))
+  {
+    materials.emplace_back();
+  }
+
+  for (const auto& currentMaterial : materials)
+  {
+    // glTF has no ambient color. As in the Assimp path, the emissive color is used as ambient color.
+    Scene::MaterialConstantBuffer mcb;
+    mcb.ambientColor             = f32v4(currentMaterial.emissiveFactor, 0.0f);
+    mcb.diffuseColor             = f32v4(f32v3(currentMaterial.diffuseFactor), 0.0f);
+    mcb.specularColorAndExponent = f32v4(currentMaterial.specularFactor, currentMaterial.shininess);
+
+    ConstantBufferD3D12 materialConstantBuffer(mcb, device);
+    const auto          textureDescriptorHeap = createTextureDescriptorHeap(device);
+    outputScene.m_materials.emplace_back(materialConstantBuffer, textureDescriptorHeap);
+
+    const auto textureIndex = [&](i32 materialTextureIdx, aiTextureType aiTextureTypeValue) -> ui32 {
+      if (materialTextureIdx >= 0)
+      {
+        const auto textureIter =
+            textureFileNameToTextureIndex.find(inputScene.getTextureFileName(static_cast<ui32>(materialTextureIdx)));
+        if (textureIter != textureFileNameToTextureIndex.end())
+        {
+          return textureIter->second;
+        }
+      }
+      return getDefaultTextureIndexForTextureType(aiTextureTypeValue);
+    };
+
+    // Same descriptor order as in the Assimp path: ambient, diffuse, specular, emissive, normal.
+    ui8 descriptorIndex = 0;
+    for (const ui32 textureIdx : {textureIndex(-1, aiTextureType_AMBIENT),
+                                  textureIndex(currentMaterial.diffuseTexture, aiTextureType_DIFFUSE),
+                                  textureIndex(currentMaterial.specularTexture, aiTextureType_SPECULAR),
+                                  textureIndex(currentMaterial.emissiveTexture, aiTextureType_EMISSIVE),
+                                  textureIndex(currentMaterial.normalTexture, aiTextureType_HEIGHT)})
+    {
+      outputScene.m_textures.at(textureIdx).addToDescriptorHeap(device, textureDescriptorHeap, descriptorIndex++);
+    }
+  }
+}
+
+#pragma endregion
+
 } // namespace gims
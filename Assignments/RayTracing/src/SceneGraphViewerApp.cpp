@@ -15,14 +15,30 @@ using namespace gims;
 
 #define MAX_LIGHTS 8
 
+// The meshes keep a CPU copy of positions and indices for the picking acceleration structure.
 SceneGraphViewerApp::SceneGraphViewerApp(const DX12AppConfig config, const std::filesystem::path pathToScene)
     : DX12App(config)
     , m_examinerController(true)
-    , m_scene(SceneGraphFactory::createFromAssImpScene(pathToScene, getDevice(), getCommandQueue()))
+    , m_scene(pathToScene.extension() == ".gltf"
+                  ? Scene()
+                  : SceneGraphFactory::createFromAssImpScene(pathToScene, getDevice(), getCommandQueue(), true))
+    , m_sceneLoader(pathToScene.extension() == ".gltf"
+                        ? std::make_unique<ProgressiveSceneLoader>(pathToScene, getDevice(), m_scene, true)
+                        : nullptr)
     , m_rayTracingUtils(RayTracingUtils::createRayTracingUtils(getDevice(), m_scene, getCommandList(),
                                                                getCommandAllocator(), getCommandQueue(), (*this)))
 {
-  m_examinerController.setTranslationVector(f32v3(0, -0.25f, 1.5));
+  throwIfFailed(getDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                    IID_PPV_ARGS(&m_loadingCommandAllocator)));
+  throwIfFailed(getDevice()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_loadingCommandAllocator.Get(),
+                                               nullptr, IID_PPV_ARGS(&m_loadingCommandList)));
+  throwIfFailed(m_loadingCommandList->Close());
+
+  m_examinerController.setTranslationVector(DEFAULT_CAMERA_TRANSLATION);
+  if (!m_sceneLoader)
+  {
+    startPickingAccelerationStructureBuild();
+  }
   createRootSignatures();
   createSceneConstantBuffer();
   createLightConstantBuffer();
@@ -124,6 +140,9 @@ void SceneGraphViewerApp::onDraw()
     }
   }
 
+  updateScene();
+  updatePickResult();
+
   const auto commandList = getCommandList();
   const auto rtvHandle   = getRTVHandle();
   const auto dsvHandle   = getDSVHandle();
@@ -168,6 +187,21 @@ void SceneGraphViewerApp::onDrawUI()
   ImGui::Text("Million Primary Rays/s: %f", m_numRaysPerSecond);
   ImGui::ColorEdit3("Background Color", &m_uiData.m_backgroundColor[0]);
   ImGui::SliderFloat("Shadow bias", &m_uiData.m_shadowBias, 0.0f, 5.0f);
+  if (m_sceneLoader)
+  {
+    ImGui::Text("Loading: %u / %u", m_sceneLoader->getNumLoadedResources(), m_sceneLoader->getNumResources());
+  }
+  if (m_pickResult.isHit())
+  {
+    ImGui::Text("Picked: node %u, mesh %u, triangle %u", m_pickResult.nodeIdx, m_pickResult.meshIdx,
+                m_pickResult.triangleIdx);
+    ImGui::Text("Barycentrics: %.3f %.3f, distance: %.3f", m_pickResult.barycentrics.x, m_pickResult.barycentrics.y,
+                m_pickResult.distance);
+  }
+  else
+  {
+    ImGui::Text("Picked: none");
+  }
 
   static i8 selectedLight = 0;
   // List existing lights
@@ -226,6 +260,54 @@ void SceneGraphViewerApp::onDrawUI()
   ImGui::End();
 }
 
+void SceneGraphViewerApp::updateScene()
+{
+  if (m_pickingASBuild.valid() && m_pickingASBuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+  {
+    m_scene.setPickingAccelerationStructure(m_pickingASBuild.get());
+  }
+
+  if (!m_sceneLoader || !m_sceneLoader->hasUpdates())
+  {
+    return;
+  }
+
+  // Texture descriptors and acceleration structures are replaced, so no frame in flight may use them.
+  waitForGPU();
+  if (m_sceneLoader->update(m_scene))
+  {
+    throwIfFailed(m_loadingCommandAllocator->Reset());
+    m_rayTracingUtils.createAccelerationStructures(getDevice(), m_scene, m_loadingCommandList,
+                                                   m_loadingCommandAllocator, getCommandQueue(), (*this));
+  }
+  if (m_sceneLoader->isFinished())
+  {
+    // Picking sees the scene once it is complete. The meshes do not change anymore, so the build can read them while
+    // frames are drawn.
+    m_sceneLoader.reset();
+    startPickingAccelerationStructureBuild();
+  }
+}
+
+void SceneGraphViewerApp::startPickingAccelerationStructureBuild()
+{
+  m_pickingASBuild = std::async(std::launch::async,
+                                [this]() { return RayTracingUtils::createCpuAccelerationStructure(m_scene); });
+}
+
+void SceneGraphViewerApp::updatePickResult()
+{
+  if (ImGui::GetIO().WantCaptureMouse)
+  {
+    m_pickResult = Scene::PickResult();
+    return;
+  }
+  const auto worldToClip = getProjectionMatrix(getWidth(), getHeight()) *
+                           m_examinerController.getTransformationMatrix() *
+                           m_scene.getAABB().getNormalizationTransformation();
+  m_pickResult = m_scene.pick(getNormalizedMouseCoordinates(), worldToClip);
+}
+
 void SceneGraphViewerApp::drawScene(const ComPtr<ID3D12GraphicsCommandList>& cmdLst)
 {
   const auto cameraMatrix = m_examinerController.getTransformationMatrix();
@@ -236,6 +318,17 @@ void SceneGraphViewerApp::drawScene(const ComPtr<ID3D12GraphicsCommandList>& cmd
   const auto modelMatrix            = m_scene.getAABB().getNormalizationTransformation();
   const auto cameraAndNormalization = cameraMatrix * modelMatrix;
 
+  if (m_sceneLoader)
+  {
+    m_sceneLoader->setModelView(cameraAndNormalization);
+  }
+
+  // Nothing to draw as long as no mesh is loaded.
+  if (!m_rayTracingUtils.m_topLevelAS)
+  {
+    return;
+  }
+
   cmdLst->SetPipelineState(m_pipelineState.Get());
 
   cmdLst->SetGraphicsRootSignature(m_graphicsRootSignature.Get());
@@ -290,8 +383,7 @@ void SceneGraphViewerApp::updateSceneConstantBuffer()
   SceneConstantBuffer cb;
 
   cb.shadowBias = m_uiData.m_shadowBias;
-  cb.projectionMatrix =
-      glm::perspectiveFovLH_ZO<f32>(glm::radians(45.0f), (f32)getWidth(), (f32)getHeight(), 0.01f, 1000.0f);
+  cb.projectionMatrix = getProjectionMatrix(getWidth(), getHeight());
   m_sceneConstantBuffers[getFrameIndex()].upload(&cb);
 }
 
@@ -309,22 +401,7 @@ void SceneGraphViewerApp::createLightConstantBuffer()
     m_lightConstantBuffers[i] = ConstantBufferD3D12(cb, getDevice());
   }
 
-  PointLight p1;
-  p1.position[0] = -20.0f;
-  p1.position[1] = 55.5f;
-  p1.position[2] = -30.0f;
-  p1.color       = f32v3(1.0f, 0.5f, 0.5f);
-  p1.intensity   = 50.0f;
-
-  PointLight p2;
-  p2.position[0] = 22.0f;
-  p2.position[1] = 11.0f;
-  p2.position[2] = -21.0f;
-  p2.color       = f32v3(1.0f, 1.0f, 1.0f);
-  p2.intensity   = 50.0f;
-
-  m_pointLights.push_back(p1);
-  m_pointLights.push_back(p2);
+  m_pointLights = getDefaultPointLights();
 }
 
 void SceneGraphViewerApp::updateLightConstantBuffer()
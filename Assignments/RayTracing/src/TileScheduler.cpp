@@ -0,0 +1,225 @@
+#include "TileScheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+using namespace gims;
+
+namespace
+{
+/// <summary>
+/// Spreads the lower 16 bits of v to the even bits.
+/// </summary>
+ui32 expandBits(ui32 v)
+{
+  v = (v | (v << 8)) & 0x00FF00FFu;
+  v = (v | (v << 4)) & 0x0F0F0F0Fu;
+  v = (v | (v << 2)) & 0x33333333u;
+  v = (v | (v << 1)) & 0x55555555u;
+  return v;
+}
+
+/// <summary>
+/// Morton code of a tile position.
+/// </summary>
+ui32 computeMortonCode(ui32 x, ui32 y)
+{
+  return (expandBits(y) << 1) | expandBits(x);
+}
+
+/// <summary>
+/// Tile indices of one thread. The owner pops from the front, thieves from the back. A tile takes far longer than the
+/// lock, so a mutex per deque does not limit the scaling.
+/// </summary>
+class TileQueue
+{
+public:
+  void push(ui32 tileIdx)
+  {
+    m_tileIndices.push_back(tileIdx);
+  }
+
+  bool popFront(ui32& tileIdx)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_tileIndices.empty())
+    {
+      return false;
+    }
+    tileIdx = m_tileIndices.front();
+    m_tileIndices.pop_front();
+    return true;
+  }
+
+  bool popBack(ui32& tileIdx)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_tileIndices.empty())
+    {
+      return false;
+    }
+    tileIdx = m_tileIndices.back();
+    m_tileIndices.pop_back();
+    return true;
+  }
+
+private:
+  std::mutex       m_mutex;
+  std::deque<ui32> m_tileIndices;
+};
+} // namespace
+
+namespace gims
+{
+void TileScheduler::CostHistogram::print(std::ostream& stream) const
+{
+  const ui32 maxNumTiles = numTiles.empty() ? 0 : *std::max_element(numTiles.begin(), numTiles.end());
+  f64        upperBound  = firstBinSeconds;
+  for (ui32 i = 0; i < static_cast<ui32>(numTiles.size()); i++, upperBound *= 2.0)
+  {
+    // The last bin has no upper bound.
+    const bool isLastBin = i + 1 == numTiles.size();
+    const ui32 barLength = (numTiles[i] * 40 + maxNumTiles - 1) / maxNumTiles;
+    stream << (isLastBin ? "  >= " : "  <  ") << std::fixed << std::setprecision(3) << std::setw(8)
+           << (isLastBin ? upperBound / 2.0 : upperBound) * 1000.0 << " ms: " << std::setw(6) << numTiles[i] << " "
+           << std::string(barLength, '#') << std::defaultfloat << std::endl;
+  }
+}
+
+f64 TileScheduler::Statistics::getImbalance() const
+{
+  if (threadSeconds.empty())
+  {
+    return 1.0;
+  }
+  const f64 totalSeconds = std::accumulate(threadSeconds.begin(), threadSeconds.end(), 0.0);
+  const f64 maxSeconds   = *std::max_element(threadSeconds.begin(), threadSeconds.end());
+  return totalSeconds > 0.0 ? maxSeconds * static_cast<f64>(threadSeconds.size()) / totalSeconds : 1.0;
+}
+
+TileScheduler::CostHistogram TileScheduler::Statistics::getCostHistogram(ui32 numBins) const
+{
+  CostHistogram histogram;
+  if (tileSeconds.empty() || numBins == 0)
+  {
+    return histogram;
+  }
+  // Tiles below 0.1 us are below the resolution of the clock.
+  const f64 cheapestSeconds = *std::min_element(tileSeconds.begin(), tileSeconds.end());
+  const f64 minSeconds      = std::max(cheapestSeconds, 1e-7);
+  histogram.firstBinSeconds = 2.0 * minSeconds;
+  histogram.numTiles.resize(numBins, 0);
+  for (const f32 seconds : tileSeconds)
+  {
+    const f64  ratio = std::max(static_cast<f64>(seconds) / minSeconds, 1.0);
+    const ui32 bin   = std::min(static_cast<ui32>(std::log2(ratio)), numBins - 1);
+    histogram.numTiles[bin]++;
+  }
+  return histogram;
+}
+
+TileScheduler::TileScheduler(ui32 width, ui32 height, ui32 tileSize)
+{
+  tileSize             = std::max(tileSize, 1u);
+  const ui32 numTilesX = (width + tileSize - 1) / tileSize;
+  const ui32 numTilesY = (height + tileSize - 1) / tileSize;
+
+  std::vector<std::pair<ui32, Tile>> codesAndTiles;
+  codesAndTiles.reserve(static_cast<size_t>(numTilesX) * numTilesY);
+  for (ui32 y = 0; y < numTilesY; y++)
+  {
+    for (ui32 x = 0; x < numTilesX; x++)
+    {
+      const Tile tile = {x * tileSize, y * tileSize, std::min((x + 1) * tileSize, width),
+                         std::min((y + 1) * tileSize, height)};
+      codesAndTiles.emplace_back(computeMortonCode(x, y), tile);
+    }
+  }
+  std::sort(codesAndTiles.begin(), codesAndTiles.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  m_tiles.reserve(codesAndTiles.size());
+  for (const auto& codeAndTile : codesAndTiles)
+  {
+    m_tiles.push_back(codeAndTile.second);
+  }
+}
+
+const std::vector<TileScheduler::Tile>& TileScheduler::getTiles() const
+{
+  return m_tiles;
+}
+
+TileScheduler::Statistics TileScheduler::run(ThreadPool&                                   threadPool,
+                                             const std::function<void(const Tile&, ui32)>& function) const
+{
+  const ui32 numTiles   = static_cast<ui32>(m_tiles.size());
+  const ui32 numThreads = std::max(std::min(threadPool.getNumThreads(), numTiles), 1u);
+
+  // Every thread starts with a contiguous range of the Morton order.
+  std::vector<std::unique_ptr<TileQueue>> queues;
+  for (ui32 threadIdx = 0; threadIdx < numThreads; threadIdx++)
+  {
+    queues.push_back(std::make_unique<TileQueue>());
+    const ui32 begin = static_cast<ui32>(static_cast<ui64>(numTiles) * threadIdx / numThreads);
+    const ui32 end   = static_cast<ui32>(static_cast<ui64>(numTiles) * (threadIdx + 1) / numThreads);
+    for (ui32 tileIdx = begin; tileIdx < end; tileIdx++)
+    {
+      queues.back()->push(tileIdx);
+    }
+  }
+
+  Statistics statistics;
+  statistics.tileSeconds.resize(numTiles, 0.0f);
+  statistics.threadSeconds.resize(numThreads, 0.0);
+  statistics.threadNumTiles.resize(numThreads, 0);
+  std::atomic<ui32> numSteals = 0;
+
+  const auto work = [&](ui32 threadIdx)
+  {
+    ui32 tileIdx;
+    while (true)
+    {
+      if (!queues[threadIdx]->popFront(tileIdx))
+      {
+        // Steal from the other threads, starting with the next one so that thieves spread over the victims. No tiles
+        // are added during a run, so the thread is done once all deques are empty.
+        bool stolen = false;
+        for (ui32 i = 1; i < numThreads && !stolen; i++)
+        {
+          stolen = queues[(threadIdx + i) % numThreads]->popBack(tileIdx);
+        }
+        if (!stolen)
+        {
+          return;
+        }
+        numSteals++;
+      }
+
+      const auto start = std::chrono::steady_clock::now();
+      function(m_tiles[tileIdx], tileIdx);
+      const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+      statistics.tileSeconds[tileIdx] = static_cast<f32>(seconds);
+      statistics.threadSeconds[threadIdx] += seconds;
+      statistics.threadNumTiles[threadIdx]++;
+    }
+  };
+
+  ThreadPool::TaskGroup taskGroup(threadPool);
+  for (ui32 threadIdx = 1; threadIdx < numThreads; threadIdx++)
+  {
+    taskGroup.run([&work, threadIdx]() { work(threadIdx); });
+  }
+  work(0);
+  taskGroup.wait();
+
+  statistics.numSteals = numSteals;
+  return statistics;
+}
+} // namespace gims
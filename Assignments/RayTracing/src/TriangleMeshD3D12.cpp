@@ -2,9 +2,99 @@
 #include <d3dx12/d3dx12.h>
 #include <gimslib/d3d/UploadHelper.hpp>
 #include <iostream>
+#include <utility>
 
 namespace gims
 {
+#pragma region TriangleMeshStagingD3D12
+
+TriangleMeshStagingD3D12::TriangleMeshStagingD3D12(ui32 nVertices, ui32 nIndices, const ComPtr<ID3D12Device>& device,
+                                                   bool keepCpuCopy)
+    : m_nVertices(nVertices)
+    , m_nIndices(nIndices)
+    , m_vertexUploadHelper(std::make_unique<UploadHelper>(device, nVertices * sizeof(Vertex)))
+    , m_indexUploadHelper(std::make_unique<UploadHelper>(device, nIndices * sizeof(ui32)))
+    , m_vertices(static_cast<Vertex*>(m_vertexUploadHelper->mapUploadBuffer()))
+    , m_indices(static_cast<ui32*>(m_indexUploadHelper->mapUploadBuffer()))
+    , m_lowerLeftBottom(std::numeric_limits<f32>::max())
+    , m_upperRightTop(-std::numeric_limits<f32>::max())
+    , m_positionsCPU(keepCpuCopy ? nVertices : 0)
+    , m_indicesCPU(keepCpuCopy ? nIndices : 0)
+{
+}
+
+TriangleMeshStagingD3D12::~TriangleMeshStagingD3D12()
+{
+}
+
+TriangleMeshStagingD3D12::TriangleMeshStagingD3D12(TriangleMeshStagingD3D12&& other) noexcept
+    : m_nVertices(std::exchange(other.m_nVertices, 0))
+    , m_nIndices(std::exchange(other.m_nIndices, 0))
+    , m_vertexUploadHelper(std::move(other.m_vertexUploadHelper))
+    , m_indexUploadHelper(std::move(other.m_indexUploadHelper))
+    , m_vertices(std::exchange(other.m_vertices, nullptr))
+    , m_indices(std::exchange(other.m_indices, nullptr))
+    , m_lowerLeftBottom(other.m_lowerLeftBottom)
+    , m_upperRightTop(other.m_upperRightTop)
+    , m_positionsCPU(std::move(other.m_positionsCPU))
+    , m_indicesCPU(std::move(other.m_indicesCPU))
+{
+}
+
+TriangleMeshStagingD3D12& TriangleMeshStagingD3D12::operator=(TriangleMeshStagingD3D12&& other) noexcept
+{
+  if (this != &other)
+  {
+    m_nVertices          = std::exchange(other.m_nVertices, 0);
+    m_nIndices           = std::exchange(other.m_nIndices, 0);
+    m_vertexUploadHelper = std::move(other.m_vertexUploadHelper);
+    m_indexUploadHelper  = std::move(other.m_indexUploadHelper);
+    m_vertices           = std::exchange(other.m_vertices, nullptr);
+    m_indices            = std::exchange(other.m_indices, nullptr);
+    m_lowerLeftBottom    = other.m_lowerLeftBottom;
+    m_upperRightTop      = other.m_upperRightTop;
+    m_positionsCPU       = std::move(other.m_positionsCPU);
+    m_indicesCPU         = std::move(other.m_indicesCPU);
+  }
+  return *this;
+}
+
+void TriangleMeshStagingD3D12::setVertex(ui32 vertexIdx, const Vertex& vertex)
+{
+  m_vertices[vertexIdx] = vertex;
+  m_lowerLeftBottom     = glm::min(m_lowerLeftBottom, vertex.position);
+  m_upperRightTop       = glm::max(m_upperRightTop, vertex.position);
+  if (!m_positionsCPU.empty())
+  {
+    m_positionsCPU[vertexIdx] = vertex.position;
+  }
+}
+
+void TriangleMeshStagingD3D12::setTriangle(ui32 triangleIdx, const ui32v3& triangle)
+{
+  m_indices[3 * triangleIdx + 0] = triangle.x;
+  m_indices[3 * triangleIdx + 1] = triangle.y;
+  m_indices[3 * triangleIdx + 2] = triangle.z;
+  if (!m_indicesCPU.empty())
+  {
+    m_indicesCPU[3 * triangleIdx + 0] = triangle.x;
+    m_indicesCPU[3 * triangleIdx + 1] = triangle.y;
+    m_indicesCPU[3 * triangleIdx + 2] = triangle.z;
+  }
+}
+
+ui32 TriangleMeshStagingD3D12::getNumVertices() const
+{
+  return m_nVertices;
+}
+
+ui32 TriangleMeshStagingD3D12::getNumIndices() const
+{
+  return m_nIndices;
+}
+
+#pragma endregion
+
 const std::vector<D3D12_INPUT_ELEMENT_DESC> TriangleMeshD3D12::m_inputElementDescs = {
     {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
     {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
@@ -15,7 +105,8 @@ TriangleMeshD3D12::TriangleMeshD3D12(f32v3 const* const positions, f32v3 const*
                                      f32v3 const* const textureCoordinates, ui32 nVertices,
                                      ui32v3 const* const indexBuffer, ui32 nIndices, f32v3 const* const tangents,
                                      ui32 materialIndex,
-                                     const ComPtr<ID3D12Device>& device, const ComPtr<ID3D12CommandQueue>& commandQueue)
+                                     const ComPtr<ID3D12Device>& device, const ComPtr<ID3D12CommandQueue>& commandQueue,
+                                     bool keepCpuCopy)
     : m_nIndices(nIndices)
     , m_vertexBufferSize(static_cast<ui32>(nVertices * sizeof(Vertex)))
     , m_indexBufferSize(static_cast<ui32>(nIndices * sizeof(ui32)))
@@ -34,15 +125,95 @@ TriangleMeshD3D12::TriangleMeshD3D12(f32v3 const* const positions, f32v3 const*
     vertexBuffer.emplace_back(positions[i], normals[i], textureCoordinates[i], tangents[i]);
   }
 
-  UploadHelper uploadHelperVertexBuffer(device, m_vertexBufferSize);
+#pragma endregion
+
+#pragma region Index Buffer
+
+  std::vector<ui32> indexBufferCPU;
+  indexBufferCPU.reserve(nIndices);
+  for (ui32 i = 0; i < ui32(nIndices / 3); i++) // need to divide by 3, because we iterate over vec3
+  {
+    indexBufferCPU.emplace_back(indexBuffer[i].x);
+    indexBufferCPU.emplace_back(indexBuffer[i].y);
+    indexBufferCPU.emplace_back(indexBuffer[i].z);
+  }
+
+#pragma endregion
+
+  createBuffers(vertexBuffer.data(), indexBufferCPU.data(), device, commandQueue);
+  if (keepCpuCopy)
+  {
+    m_positionsCPU.assign(positions, positions + nVertices);
+    m_indicesCPU = std::move(indexBufferCPU);
+  }
+}
+
+TriangleMeshD3D12::TriangleMeshD3D12(Vertex const* const vertices, ui32 nVertices, ui32 const* const indexBuffer,
+                                     ui32 nIndices, ui32 materialIndex, const ComPtr<ID3D12Device>& device,
+                                     const ComPtr<ID3D12CommandQueue>& commandQueue, bool keepCpuCopy)
+    : m_nIndices(nIndices)
+    , m_vertexBufferSize(static_cast<ui32>(nVertices * sizeof(Vertex)))
+    , m_indexBufferSize(static_cast<ui32>(nIndices * sizeof(ui32)))
+    , m_materialIndex(materialIndex)
+{
+  f32v3 lowerLeftBottom(std::numeric_limits<f32>::max());
+  f32v3 upperRightTop(-std::numeric_limits<f32>::max());
+  for (ui32 i = 0; i < nVertices; i++)
+  {
+    lowerLeftBottom = glm::min(lowerLeftBottom, vertices[i].position);
+    upperRightTop   = glm::max(upperRightTop, vertices[i].position);
+  }
+  m_aabb = AABB(lowerLeftBottom, upperRightTop);
+  if (keepCpuCopy)
+  {
+    m_positionsCPU.reserve(nVertices);
+    for (ui32 i = 0; i < nVertices; i++)
+    {
+      m_positionsCPU.emplace_back(vertices[i].position);
+    }
+    m_indicesCPU.assign(indexBuffer, indexBuffer + nIndices);
+  }
+
+  createBuffers(vertices, indexBuffer, device, commandQueue);
+}
+
+TriangleMeshD3D12::TriangleMeshD3D12(TriangleMeshStagingD3D12 staging, ui32 materialIndex,
+                                     const ComPtr<ID3D12Device>&       device,
+                                     const ComPtr<ID3D12CommandQueue>& commandQueue)
+    : m_nIndices(staging.m_nIndices)
+    , m_vertexBufferSize(static_cast<ui32>(staging.m_nVertices * sizeof(Vertex)))
+    , m_indexBufferSize(static_cast<ui32>(staging.m_nIndices * sizeof(ui32)))
+    , m_aabb(staging.m_lowerLeftBottom, staging.m_upperRightTop)
+    , m_materialIndex(materialIndex)
+    , m_positionsCPU(std::move(staging.m_positionsCPU))
+    , m_indicesCPU(std::move(staging.m_indicesCPU))
+{
+  createBuffers(device);
+  staging.m_vertexUploadHelper->uploadMappedBuffer(m_vertexBuffer, m_vertexBufferSize, commandQueue);
+  staging.m_indexUploadHelper->uploadMappedBuffer(m_indexBuffer, m_indexBufferSize, commandQueue);
+}
+
+TriangleMeshD3D12::TriangleMeshD3D12(const AABB& aabb, ui32 materialIndex)
+    : m_nIndices(0)
+    , m_vertexBufferSize(0)
+    , m_indexBufferSize(0)
+    , m_aabb(aabb)
+    , m_materialIndex(materialIndex)
+    , m_vertexBufferView()
+    , m_indexBufferView()
+{
+}
+
+void TriangleMeshD3D12::createBuffers(const ComPtr<ID3D12Device>& device)
+{
+#pragma region Vertex Buffer
+
   // Create resource on GPU
   const CD3DX12_RESOURCE_DESC   vertexBufferDescription = CD3DX12_RESOURCE_DESC::Buffer(m_vertexBufferSize);
   const CD3DX12_HEAP_PROPERTIES defaultHeapProperties   = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
   device->CreateCommittedResource(&defaultHeapProperties, D3D12_HEAP_FLAG_NONE, &vertexBufferDescription,
                                   D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&m_vertexBuffer));
 
-  // Upload to GPU
-  uploadHelperVertexBuffer.uploadBuffer(vertexBuffer.data(), m_vertexBuffer, m_vertexBufferSize, commandQueue);
   m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
   m_vertexBufferView.SizeInBytes    = m_vertexBufferSize;
   m_vertexBufferView.StrideInBytes  = sizeof(Vertex);
@@ -51,21 +222,10 @@ TriangleMeshD3D12::TriangleMeshD3D12(f32v3 const* const positions, f32v3 const*
 
 #pragma region Index Buffer
 
-  std::vector<ui32> indexBufferCPU;
-  indexBufferCPU.reserve(nIndices);
-  for (ui32 i = 0; i < ui32(nIndices / 3); i++) // need to divide by 3, because we iterate over vec3
-  {
-    indexBufferCPU.emplace_back(indexBuffer[i].x);
-    indexBufferCPU.emplace_back(indexBuffer[i].y);
-    indexBufferCPU.emplace_back(indexBuffer[i].z);
-  }
-
-  UploadHelper                uploadHelperIndexBuffer(device, m_indexBufferSize);
   const CD3DX12_RESOURCE_DESC indexBufferDescription = CD3DX12_RESOURCE_DESC::Buffer(m_indexBufferSize);
   device->CreateCommittedResource(&defaultHeapProperties, D3D12_HEAP_FLAG_NONE, &indexBufferDescription,
                                   D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&m_indexBuffer));
 
-  uploadHelperIndexBuffer.uploadBuffer(indexBufferCPU.data(), m_indexBuffer, m_indexBufferSize, commandQueue);
   m_indexBufferView.BufferLocation = m_indexBuffer->GetGPUVirtualAddress();
   m_indexBufferView.SizeInBytes    = m_indexBufferSize;
   m_indexBufferView.Format         = DXGI_FORMAT_R32_UINT;
@@ -73,6 +233,20 @@ TriangleMeshD3D12::TriangleMeshD3D12(f32v3 const* const positions, f32v3 const*
 #pragma endregion
 }
 
+void TriangleMeshD3D12::createBuffers(void const* const vertexData, void const* const indexData,
+                                      const ComPtr<ID3D12Device>&       device,
+                                      const ComPtr<ID3D12CommandQueue>& commandQueue)
+{
+  createBuffers(device);
+
+  // Upload to GPU
+  UploadHelper uploadHelperVertexBuffer(device, m_vertexBufferSize);
+  uploadHelperVertexBuffer.uploadBuffer(vertexData, m_vertexBuffer, m_vertexBufferSize, commandQueue);
+
+  UploadHelper uploadHelperIndexBuffer(device, m_indexBufferSize);
+  uploadHelperIndexBuffer.uploadBuffer(indexData, m_indexBuffer, m_indexBufferSize, commandQueue);
+}
+
 void TriangleMeshD3D12::addToCommandList(const ComPtr<ID3D12GraphicsCommandList>& commandList) const
 {
   commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
@@ -83,6 +257,11 @@ void TriangleMeshD3D12::addToCommandList(const ComPtr<ID3D12GraphicsCommandList>
   commandList->DrawIndexedInstanced(m_nIndices, 1, 0, 0, 0);
 }
 
+bool TriangleMeshD3D12::isLoaded() const
+{
+  return m_vertexBuffer != nullptr;
+}
+
 const ComPtr<ID3D12Resource>& TriangleMeshD3D12::getVertexBuffer() const
 {
   return m_vertexBuffer;
@@ -93,6 +272,22 @@ const ComPtr<ID3D12Resource>& TriangleMeshD3D12::getIndexBuffer() const
   return m_indexBuffer;
 }
 
+const std::vector<f32v3>& TriangleMeshD3D12::getPositions() const
+{
+  return m_positionsCPU;
+}
+
+const std::vector<ui32>& TriangleMeshD3D12::getIndices() const
+{
+  return m_indicesCPU;
+}
+
+void TriangleMeshD3D12::releaseCpuCopy()
+{
+  m_positionsCPU = std::vector<f32v3>();
+  m_indicesCPU   = std::vector<ui32>();
+}
+
 const AABB TriangleMeshD3D12::getAABB() const
 {
   return m_aabb;
@@ -15,6 +15,13 @@ public:
   void uploadBuffer(const void* const src, ComPtr<ID3D12Resource>& dst, size_t size,
                     const ComPtr<ID3D12CommandQueue>& commandQueue);
 
+  // Maps the upload buffer, so that data can be written into it in place. The memory is write-combined: write it
+  // sequentially and never read from it.
+  void* mapUploadBuffer();
+
+  // Unmaps the upload buffer and copies the first size bytes that were written into it to dst.
+  void uploadMappedBuffer(ComPtr<ID3D12Resource>& dst, size_t size, const ComPtr<ID3D12CommandQueue>& commandQueue);
+
   void uploadTexture(const void* const imageData, ComPtr<ID3D12Resource> texture, i32 textureWidth, i32 textureHeight,
                      const ComPtr<ID3D12CommandQueue>& commandQueue);
 
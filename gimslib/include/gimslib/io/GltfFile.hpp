@@ -0,0 +1,140 @@
+#pragma once
+#include <filesystem>
+#include <gimslib/io/MemoryMappedFile.hpp>
+#include <gimslib/types.hpp>
+#include <string>
+#include <vector>
+
+namespace gims
+{
+//! \brief Reader for glTF 2.0 files (.gltf with external binary buffers).
+//!
+//! The JSON part is parsed into plain structs. The binary buffers are memory mapped and never copied: an Accessor
+//! points directly into the mapped buffer, so vertex data can be read in place and converted only where its layout
+//! differs from what the caller needs.
+//!
+//! Only the subset of glTF that is required to build a Scene is supported: nodes, triangle meshes, materials
+//! (metallic-roughness and KHR_materials_pbrSpecularGlossiness) and textures that reference image files. Sparse
+//! accessors and embedded (base64) buffers are rejected with a std::runtime_error.
+class GltfFile
+{
+public:
+  //! Accessor component types as defined by the glTF specification.
+  enum ComponentType : ui32
+  {
+    BYTE           = 5120,
+    UNSIGNED_BYTE  = 5121,
+    SHORT          = 5122,
+    UNSIGNED_SHORT = 5123,
+    UNSIGNED_INT   = 5125,
+    FLOAT          = 5126
+  };
+
+  //! Primitive topology for triangle lists.
+  static constexpr ui32 TRIANGLES = 4;
+
+  //! \brief Typed view of a buffer range. The data pointer refers to the memory mapped buffer.
+  struct Accessor
+  {
+    const ui8* data          = nullptr;     //! First byte of the first element.
+    ui32       count         = 0;           //! Number of elements.
+    ui32       byteStride    = 0;           //! Distance in bytes between two consecutive elements.
+    ui32       componentType = 0;           //! One of ComponentType.
+    ui32       numComponents = 0;           //! 1 for SCALAR, 2 for VEC2, 3 for VEC3, 4 for VEC4.
+    bool       normalized    = false;       //! True, if integer components map to [0,1] or [-1,1].
+    bool       hasBounds     = false;       //! True, if min and max are given (always the case for positions).
+    f32v3      min           = f32v3(0.0f); //! Component-wise minimum of the first three components.
+    f32v3      max           = f32v3(0.0f); //! Component-wise maximum of the first three components.
+
+    //! \brief Returns true, if the elements are tightly packed and of the given type, i.e., they can be used as is.
+    bool isTightlyPacked(ui32 componentTypeValue, ui32 numComponentsValue) const;
+
+    //! \brief Reads element idx and converts it to floats. Missing components are 0.
+    f32v4 getFloat(ui32 idx) const;
+
+    //! \brief Reads element idx of a scalar integer accessor (used for index buffers).
+    ui32 getIndex(ui32 idx) const;
+  };
+
+  //! \brief A primitive of a mesh. Attribute members hold accessor indices or -1 if not present.
+  struct Primitive
+  {
+    i32  positions          = -1;        //! Accessor of POSITION.
+    i32  normals            = -1;        //! Accessor of NORMAL.
+    i32  textureCoordinates = -1;        //! Accessor of TEXCOORD_0.
+    i32  tangents           = -1;        //! Accessor of TANGENT.
+    i32  indices            = -1;        //! Accessor of the index buffer. -1 for non-indexed geometry.
+    i32  material           = -1;        //! Material index, -1 for the default material.
+    ui32 mode               = TRIANGLES; //! Topology.
+  };
+
+  //! \brief A mesh consists of one or more primitives.
+  struct Mesh
+  {
+    std::string            name;
+    std::vector<Primitive> primitives;
+  };
+
+  //! \brief Node of the scene graph.
+  struct Node
+  {
+    std::string       name;
+    f32m4             transformation = f32m4(1.0f); //! Transformation to parent node.
+    i32               mesh           = -1;          //! Mesh index or -1.
+    std::vector<ui32> childIndices;                 //! Indices of the child nodes.
+  };
+
+  //! \brief Material information. Texture members hold texture indices or -1 if not present.
+  struct Material
+  {
+    std::string name;
+    f32v4       diffuseFactor   = f32v4(1.0f); //! Base color or diffuse factor.
+    f32v3       specularFactor  = f32v3(0.0f); //! Specular color (specular-glossiness materials only).
+    f32v3       emissiveFactor  = f32v3(0.0f); //! Emissive color.
+    f32         shininess       = 0.0f;        //! Specular exponent derived from roughness or glossiness.
+    i32         diffuseTexture  = -1;          //! Base color or diffuse texture.
+    i32         specularTexture = -1;          //! Specular-glossiness texture.
+    i32         emissiveTexture = -1;          //! Emissive texture.
+    i32         normalTexture   = -1;          //! Tangent space normal map.
+  };
+
+  //! \brief Loads a glTF file and maps the buffers it references.
+  //! \param[in]  fileName Path to the .gltf file.
+  explicit GltfFile(const std::filesystem::path& fileName);
+
+  GltfFile(const GltfFile& other)                = delete;
+  GltfFile& operator=(const GltfFile& other)     = delete;
+  GltfFile(GltfFile&& other) noexcept            = default;
+  GltfFile& operator=(GltfFile&& other) noexcept = default;
+
+  //! \brief Returns the nodes of the scene. Nodes are stored in a flat array and reference each other by index.
+  const std::vector<Node>& getNodes() const;
+
+  //! \brief Returns the root nodes of the default scene.
+  const std::vector<ui32>& getRootNodes() const;
+
+  //! \brief Returns the meshes.
+  const std::vector<Mesh>& getMeshes() const;
+
+  //! \brief Returns the materials.
+  const std::vector<Material>& getMaterials() const;
+
+  //! \brief Returns the accessor with the given index.
+  const Accessor& getAccessor(ui32 accessorIdx) const;
+
+  //! \brief Returns the number of textures.
+  ui32 getNumTextures() const;
+
+  //! \brief Returns the image file of a texture relative to the directory of the glTF file.
+  const std::filesystem::path& getTextureFileName(ui32 textureIdx) const;
+
+private:
+  std::vector<Node>                  m_nodes;            //! Flat array of nodes.
+  std::vector<ui32>                  m_rootNodes;        //! Root nodes of the default scene.
+  std::vector<Mesh>                  m_meshes;           //! Meshes.
+  std::vector<Material>              m_materials;        //! Materials.
+  std::vector<Accessor>              m_accessors;        //! Accessors pointing into m_buffers.
+  std::vector<std::filesystem::path> m_textureFileNames; //! Image file per texture.
+  std::vector<MemoryMappedFile>      m_buffers;          //! The mapped binary buffers.
+};
+} // namespace gims
@@ -0,0 +1,55 @@
+#pragma once
+#include <filesystem>
+#include <gimslib/types.hpp>
+
+namespace gims
+{
+//! \brief Read-only view of a file that is mapped into the address space of the process.
+//!
+//! The contents are paged in by the operating system on first access. Nothing is copied, so the data returned by
+//! getData() stays valid for the lifetime of the object.
+class MemoryMappedFile
+{
+public:
+  //! \brief Creates an empty mapping.
+  MemoryMappedFile() = default;
+
+  //! \brief Maps the file read-only. Throws a std::runtime_error, if the file cannot be opened or mapped.
+  //! \param[in]  fileName Path to the file that should be mapped.
+  explicit MemoryMappedFile(const std::filesystem::path& fileName);
+
+  //! \brief Unmaps the file.
+  ~MemoryMappedFile();
+
+  MemoryMappedFile(const MemoryMappedFile& other)            = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+
+  //! Move construction.
+  MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+
+  //! Move operator.
+  MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+  //! \brief Returns a pointer to the first byte of the file, or nullptr if nothing is mapped.
+  const ui8* getData() const;
+
+  //! \brief Returns the size of the file in bytes.
+  size_t getSize() const;
+
+private:
+  //! Unmaps the view and closes all handles.
+  void close();
+
+  //! Start of the mapped view.
+  const ui8* m_data = nullptr;
+
+  //! Size of the mapped view in bytes.
+  size_t m_size = 0;
+
+  //! Operating system handle of the file (HANDLE on Windows, file descriptor elsewhere).
+  intptr_t m_fileHandle = -1;
+
+  //! Operating system handle of the mapping object (Windows only).
+  intptr_t m_mappingHandle = 0;
+};
+} // namespace gims
@@ -0,0 +1,16 @@
+#pragma once
+#include <filesystem>
+#include <gimslib/types.hpp>
+
+namespace gims
+{
+//! \brief Writes an RGBA8 image as PNG file. Throws a std::runtime_error, if the file cannot be written.
+//!
+//! The pixel data is stored in uncompressed deflate blocks, so no compression library is needed. The files are about
+//! as large as the raw pixels, which is fine for regression images that are compared pixel by pixel.
+//! \param[in]  fileName Path to the file that is created or overwritten.
+//! \param[in]  width Width of the image in pixels.
+//! \param[in]  height Height of the image in pixels.
+//! \param[in]  pixels width * height pixels, row by row, starting with the top row.
+void writePngFile(const std::filesystem::path& fileName, ui32 width, ui32 height, const ui8v4* pixels);
+} // namespace gims
@@ -0,0 +1,158 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <ostream>
+#include <vector>
+
+namespace gims
+{
+class CograBinaryMeshFile;
+
+//! \brief Result of simulating a FIFO post-transform vertex cache on an index buffer.
+struct VertexCacheStatistics
+{
+  ui64 numTransformedVertices = 0; //! Number of cache misses, i.e., vertex shader invocations.
+  ui64 numTriangles           = 0; //! Number of triangles.
+  ui64 numVertices            = 0; //! Number of vertices that are referenced by at least one triangle.
+
+  //! \brief Average cache miss ratio: transformed vertices per triangle. 0.5 is optimal for large regular meshes,
+  //! 3 is the worst case.
+  f32 getACMR() const;
+
+  //! \brief Average transform to vertex ratio: transformed vertices per referenced vertex. 1 is optimal.
+  f32 getATVR() const;
+
+  //! \brief Accumulates the counts, e.g., to report statistics of all meshes of a scene.
+  VertexCacheStatistics& operator+=(const VertexCacheStatistics& other);
+};
+
+//! \brief Result of measureOverdraw().
+struct OverdrawStatistics
+{
+  ui64 numCoveredPixels = 0; //! Number of pixels covered by at least one triangle, summed over all views.
+  ui64 numShadedPixels  = 0; //! Number of fragments that passed the depth test, summed over all views.
+
+  //! \brief Shaded fragments per covered pixel. 1 is optimal.
+  f32 getOverdraw() const;
+
+  //! \brief Accumulates the counts, e.g., to report statistics of all meshes of a scene.
+  OverdrawStatistics& operator+=(const OverdrawStatistics& other);
+};
+
+//! \brief Parameters of optimizeMesh().
+struct MeshOptimizationSettings
+{
+  f32  overdrawThreshold = 1.05f; //! ACMR may grow by this factor for optimizeOverdraw(). Values below 1 disable it.
+  ui32 numOverdrawViews  = 0;     //! View directions for measuring the overdraw before and after. 0 skips it.
+};
+
+//! \brief Vertex cache and overdraw statistics before and after optimizeMesh().
+struct MeshOptimizationStatistics
+{
+  VertexCacheStatistics before;         //! Statistics of the input index buffer.
+  VertexCacheStatistics after;          //! Statistics of the optimized index buffer.
+  OverdrawStatistics    overdrawBefore; //! Overdraw of the input, if MeshOptimizationSettings::numOverdrawViews > 0.
+  OverdrawStatistics    overdrawAfter;  //! Overdraw of the optimized index buffer.
+
+  //! \brief Accumulates the counts of another mesh.
+  MeshOptimizationStatistics& operator+=(const MeshOptimizationStatistics& other);
+
+  //! \brief Prints ACMR, ATVR and, if measured, the overdraw before and after the optimization in a single line.
+  //! \param[in,out]  stream The stream the information should be written to.
+  void print(std::ostream& stream) const;
+};
+
+//! \brief Simulates a FIFO post-transform vertex cache.
+//! \param[in]  indices Triangle list index buffer.
+//! \param[in]  nIndices Number of indices, a multiple of 3.
+//! \param[in]  nVertices Number of vertices. All indices must be smaller.
+//! \param[in]  cacheSize Number of cache entries. 16 matches the behavior of many GPUs reasonably well.
+VertexCacheStatistics analyzeVertexCache(const ui32* indices, size_t nIndices, ui32 nVertices, ui32 cacheSize = 16);
+
+//! \brief Reorders the triangles of a triangle list for a post-transform vertex cache.
+//!
+//! Implements Forsyth's "Linear-Speed Vertex Cache Optimisation": the next triangle is always the one with the
+//! highest score, where vertices score high if they are in a simulated LRU cache or if only few triangles that use
+//! them remain. The result is not tied to a particular cache size. Runs in time linear in the number of triangles.
+//! \param[in,out]  indices Triangle list index buffer. Triangles are reordered, the winding is preserved.
+//! \param[in]  nIndices Number of indices, a multiple of 3.
+//! \param[in]  nVertices Number of vertices. All indices must be smaller.
+void optimizeVertexCache(ui32* indices, size_t nIndices, ui32 nVertices);
+
+//! \brief Reorders the triangles of a cache optimized triangle list to reduce overdraw.
+//!
+//! Follows Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw": the triangle list is
+//! split into clusters wherever the vertex cache would be cold anyway, and further, as long as the ACMR of the clusters
+//! stays within threshold times the ACMR of the input. The clusters are then sorted by their view-independent
+//! occlusion potential, i.e., how far their surface faces away from the center of the mesh, such that the outer
+//! surfaces are likely to be drawn first and occlude what is inside. The orientation of the triangles is determined
+//! from the signed volume of the mesh, so both winding conventions work.
+//! \param[in,out]  indices Triangle list index buffer, ideally the output of optimizeVertexCache().
+//! \param[in]  nIndices Number of indices, a multiple of 3.
+//! \param[in]  positions Position of the first vertex.
+//! \param[in]  positionStride Distance in bytes between the positions of two consecutive vertices.
+//! \param[in]  nVertices Number of vertices. All indices must be smaller.
+//! \param[in]  threshold Factor by which the ACMR may grow, e.g., 1.05 allows 5% more vertex shader invocations.
+void optimizeOverdraw(ui32* indices, size_t nIndices, const f32v3* positions, size_t positionStride, ui32 nVertices,
+                      f32 threshold = 1.05f);
+
+//! \brief Measures overdraw with a depth-only software rasterizer.
+//!
+//! The mesh is rendered orthographically from numViews directions that are evenly distributed on the sphere. Front
+//! and back faces are rasterized into separate depth buffers, which makes the result independent of the winding
+//! convention and corresponds to rendering with back face culling from both sides.
+//! \param[in]  indices Triangle list index buffer.
+//! \param[in]  nIndices Number of indices, a multiple of 3.
+//! \param[in]  positions Position of the first vertex.
+//! \param[in]  positionStride Distance in bytes between the positions of two consecutive vertices.
+//! \param[in]  nVertices Number of vertices. All indices must be smaller.
+//! \param[in]  numViews Number of view directions.
+//! \param[in]  resolution Width and height of the depth buffer.
+OverdrawStatistics measureOverdraw(const ui32* indices, size_t nIndices, const f32v3* positions, size_t positionStride,
+                                   ui32 nVertices, ui32 numViews = 16, ui32 resolution = 256);
+
+//! \brief Renumbers the vertices in the order they are first used by the index buffer.
+//!
+//! Call after optimizeVertexCache(). Afterwards, vertices are fetched nearly sequentially. Unreferenced vertices are
+//! moved to the end, so the number of vertices does not change.
+//! \param[in,out]  indices Triangle list index buffer. Receives the new vertex indices.
+//! \param[in]  nIndices Number of indices.
+//! \param[in]  nVertices Number of vertices. All indices must be smaller.
+//! \return Remap table: vertex i moves to position remap[i]. Pass it to remapVertices().
+std::vector<ui32> optimizeVertexFetch(ui32* indices, size_t nIndices, ui32 nVertices);
+
+//! \brief Moves vertex i of an array of vertices to position remap[i].
+//! \param[in,out]  vertices Array of nVertices elements with vertexSize bytes each.
+//! \param[in]  nVertices Number of vertices.
+//! \param[in]  vertexSize Size of one vertex in bytes.
+//! \param[in]  remap Permutation as returned by optimizeVertexFetch().
+void remapVertices(void* vertices, ui32 nVertices, size_t vertexSize, const std::vector<ui32>& remap);
+
+//! \brief Moves vertex i to position remap[i]. T must be trivially copyable.
+template <typename T> void remapVertices(std::vector<T>& vertices, const std::vector<ui32>& remap)
+{
+  remapVertices(vertices.data(), static_cast<ui32>(vertices.size()), sizeof(T), remap);
+}
+
+//! \brief Runs optimizeVertexCache(), optimizeOverdraw() and optimizeVertexFetch() on an index buffer.
+//!
+//! The vertices themselves are not touched, the caller applies vertexRemap. This way vertices can be written
+//! directly to their final location, e.g., into an upload buffer.
+//! \param[in,out]  indices Triangle list index buffer.
+//! \param[in]  nIndices Number of indices, a multiple of 3.
+//! \param[in]  positions Position of the first vertex.
+//! \param[in]  positionStride Distance in bytes between the positions of two consecutive vertices.
+//! \param[in]  nVertices Number of vertices.
+//! \param[out]  vertexRemap Vertex i has to be moved to position vertexRemap[i].
+//! \param[in]  settings Overdraw threshold and measurement.
+//! \return Statistics before and after the optimization.
+MeshOptimizationStatistics optimizeMesh(ui32* indices, size_t nIndices, const f32v3* positions, size_t positionStride,
+                                        ui32 nVertices, std::vector<ui32>& vertexRemap,
+                                        const MeshOptimizationSettings& settings = MeshOptimizationSettings());
+
+//! \brief Optimizes the triangle order and the vertex order of a mesh file, including positions and all attributes.
+//! \param[in,out]  mesh The mesh.
+//! \param[in]  settings Overdraw threshold and measurement.
+//! \return Statistics before and after the optimization.
+MeshOptimizationStatistics optimizeMesh(CograBinaryMeshFile&            mesh,
+                                        const MeshOptimizationSettings& settings = MeshOptimizationSettings());
+} // namespace gims
@@ -0,0 +1,126 @@
+#pragma once
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/LeafTriangles.hpp>
+#include <gimslib/rt/Ray.hpp>
+#include <gimslib/rt/TraversalBvh.hpp>
+#include <gimslib/types.hpp>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace gims
+{
+//! \brief CPU bottom level acceleration structure: a BVH over the triangles of one mesh.
+//!
+//! Triangles are double-sided and opaque, like the triangles of the DXR acceleration structures that are built
+//! without geometry flags except D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE. The ray/triangle test is watertight: rays
+//! that hit an edge or vertex shared by several triangles hit at least one of them, so, e.g., shadow rays do not leak
+//! through closed meshes. The tests only read LeafTriangles, a compact copy of the triangles in the leaf order of the
+//! BVH.
+class BottomLevelAS
+{
+public:
+  //! \brief Creates an empty acceleration structure that is never hit.
+  BottomLevelAS() = default;
+
+  //! \brief Copies the geometry and builds the BVH.
+  //! \param[in]  positions Vertex positions.
+  //! \param[in]  indices Triangle list index buffer. All indices must be smaller than positions.size().
+  //! \param[in]  settings BVH build parameters. If leafPositionBits is 16, the positions are moved to the grid of the
+  //! LeafTriangles, see LeafTriangles::snapToGrid().
+  BottomLevelAS(const std::vector<f32v3>& positions, const std::vector<ui32>& indices,
+                const BvhBuildSettings& settings = BvhBuildSettings());
+
+  //! \brief Copies the geometry and takes a BVH that was built over its triangles before, e.g., loaded by a BvhCache.
+  //! \param[in]  positions Vertex positions.
+  //! \param[in]  indices Triangle list index buffer. All indices must be smaller than positions.size().
+  //! \param[in]  bvh BVH whose primitives are the triangles of the index buffer.
+  BottomLevelAS(const std::vector<f32v3>& positions, const std::vector<ui32>& indices, Bvh bvh);
+
+  //! \brief Replaces the vertex positions of a deforming mesh and refits the BVH, which is rebuilt if its quality
+  //! degraded too much, see Bvh::update().
+  //! \param[in]  positions New vertex positions, as many as before.
+  //! \return True, if the BVH was rebuilt.
+  bool update(const std::vector<f32v3>& positions);
+
+  //! \brief Finds the closest hit in [ray.tMin, min(ray.tMax, hit.t)].
+  //! \param[in]  ray The ray in object space.
+  //! \param[in,out]  hit Receives t, barycentrics and triangleIdx of a closer hit. instanceIdx is not touched.
+  //! \param[in,out]  counters If not null, the visited nodes and tested triangles are added to it.
+  //! \return True, if a closer hit was found.
+  bool intersect(const Ray& ray, RayHit& hit, TraversalCounters* counters = nullptr) const;
+
+  //! \brief Finds the closest hits of a batch of rays, see intersect(std::span<const Ray>, std::span<RayHit>,
+  //! RayBatchTraversal).
+  //! \param[in,out]  batch The rays in object space. batch.hits is resized to the number of rays, new entries start
+  //! without a hit.
+  void intersect(RayBatch& batch) const;
+
+  //! \brief Finds the closest hit of every ray in [ray.tMin, min(ray.tMax, hit.t)], traversing the binary BVH in
+  //! packets or as a stream.
+  //! \param[in]  rays The rays in object space.
+  //! \param[in,out]  hits One hit per ray, updated like the hit of intersect(const Ray&, RayHit&).
+  //! \param[in]  traversal Traversal algorithm.
+  void intersect(std::span<const Ray> rays, std::span<RayHit> hits, RayBatchTraversal traversal) const;
+
+  //! \brief Returns true, if any triangle is hit in [ray.tMin, ray.tMax]. Stops at the first hit found.
+  bool occluded(const Ray& ray) const;
+
+  //! \brief Occlusion query that tests the leaf of the last occluder first and remembers the new one.
+  //! \param[in]  ray The ray in object space.
+  //! \param[in,out]  lastOccluder The leaf that occluded the previous ray, replaced on hits in other leaves.
+  //! instanceIdx is not touched.
+  //! \param[in,out]  counters If not null, the visited nodes and tested triangles are added to it.
+  //! \return True, if any triangle is hit in [ray.tMin, ray.tMax].
+  bool occluded(const Ray& ray, Occluder& lastOccluder, TraversalCounters* counters = nullptr) const;
+
+  //! \brief Returns true, if a triangle of the leaf of an occluder is hit in [ray.tMin, ray.tMax]. Occluders that do
+  //! not fit this acceleration structure, e.g., after it was rebuilt, are never hit. If counters is not null, the
+  //! tested triangles are added to it.
+  bool isOccludedBy(const Ray& ray, const Occluder& occluder, TraversalCounters* counters = nullptr) const;
+
+  //! \brief Returns the bounds of all triangles.
+  BoundingBox getBounds() const;
+
+  //! \brief Returns the number of triangles.
+  ui32 getNumTriangles() const;
+
+  //! \brief Returns the vertex positions, on the grid of the LeafTriangles if they are quantized.
+  const std::vector<f32v3>& getPositions() const;
+
+  //! \brief Returns the triangles, i.e., three vertex indices each.
+  const std::vector<ui32v3>& getTriangles() const;
+
+  //! \brief Returns the BVH. Its primitives are the triangles.
+  const Bvh& getBvh() const;
+
+  //! \brief Returns the BVH in the layout that rays traverse.
+  const TraversalBvh& getTraversalBvh() const;
+
+  //! \brief Returns the triangles in the leaf order of the traversal layout, which the intersection tests read.
+  const LeafTriangles& getLeafTriangles() const;
+
+  //! \brief Returns the size of the geometry, the BVHs and the LeafTriangles in bytes.
+  size_t getMemorySize() const;
+
+private:
+  //! \brief Copies the geometry and checks the indices.
+  void setGeometry(const std::vector<f32v3>& positions, const std::vector<ui32>& indices);
+
+  //! \brief Computes the bounds of all triangles in parallel.
+  std::vector<BoundingBox> computeTriangleBounds(const BvhBuildSettings& settings) const;
+
+  //! \brief Moves the positions to the grid of 16 bit LeafTriangles, if the settings ask for them.
+  //! \return The grid, or nothing for 32 bit LeafTriangles.
+  std::optional<LeafTriangles::Grid> snapToGrid(const BvhBuildSettings& settings);
+
+  //! \brief Copies the triangles to the leaf order of the BVH, after it was built or updated.
+  void storeLeafTriangles(const LeafTriangles::Grid* grid);
+
+  std::vector<f32v3>  m_positions;           //! Vertex positions.
+  std::vector<ui32v3> m_triangles;           //! Vertex indices of the triangles.
+  TraversalBvh        m_bvh;                 //! BVH over the triangles.
+  LeafTriangles       m_leafTriangles;       //! Triangles in the leaf order of the traversal layout.
+  LeafTriangles       m_binaryLeafTriangles; //! Triangles in the leaf order of the binary BVH, if the orders differ.
+};
+} // namespace gims
@@ -0,0 +1,230 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace gims
+{
+class ThreadPool;
+
+//! \brief Axis-aligned bounding box used by the acceleration structures. A default constructed box is empty.
+struct BoundingBox
+{
+  f32v3 lowerLeftBottom = f32v3(std::numeric_limits<f32>::max());  //! Component-wise minimum.
+  f32v3 upperRightTop   = f32v3(-std::numeric_limits<f32>::max()); //! Component-wise maximum.
+
+  //! \brief Extends the box such that it contains the point.
+  void extend(const f32v3& point)
+  {
+    lowerLeftBottom = glm::min(lowerLeftBottom, point);
+    upperRightTop   = glm::max(upperRightTop, point);
+  }
+
+  //! \brief Extends the box such that it contains the other box.
+  void extend(const BoundingBox& other)
+  {
+    lowerLeftBottom = glm::min(lowerLeftBottom, other.lowerLeftBottom);
+    upperRightTop   = glm::max(upperRightTop, other.upperRightTop);
+  }
+
+  //! \brief Returns the center of the box.
+  f32v3 getCenter() const
+  {
+    return 0.5f * (lowerLeftBottom + upperRightTop);
+  }
+
+  //! \brief Returns the surface area of the box, 0 for empty boxes.
+  f32 getSurfaceArea() const
+  {
+    const f32v3 extent = glm::max(upperRightTop - lowerLeftBottom, f32v3(0.0f));
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+  }
+
+  //! \brief Returns true, if the box contains no point.
+  bool isEmpty() const
+  {
+    return lowerLeftBottom.x > upperRightTop.x || lowerLeftBottom.y > upperRightTop.y ||
+           lowerLeftBottom.z > upperRightTop.z;
+  }
+};
+
+//! \brief Node of a binary BVH (32 bytes).
+//!
+//! The two children of an inner node are stored next to each other, so an inner node only stores the index of the
+//! first child. A leaf stores a range of Bvh::getPrimitiveIndices().
+struct BvhNode
+{
+  f32v3 lowerLeftBottom; //! Bounds of the subtree.
+  ui32  firstIndex;      //! Inner node: index of the first child. Leaf: index of the first primitive index.
+  f32v3 upperRightTop;   //! Bounds of the subtree.
+  ui32  numPrimitives;   //! Number of primitives of a leaf, 0 for inner nodes.
+
+  //! \brief Returns true for leaves.
+  bool isLeaf() const
+  {
+    return numPrimitives > 0;
+  }
+};
+
+//! \brief BVH construction algorithms.
+enum class BvhBuilder
+{
+  BinnedSah, //! Top-down binned SAH. The CPU counterpart of PREFER_FAST_TRACE.
+  Linear,    //! LBVH over sorted Morton codes. Much faster to build, the CPU counterpart of PREFER_FAST_BUILD.
+};
+
+//! \brief Parameters of the BVH construction.
+struct BvhBuildSettings
+{
+  //! Construction algorithm.
+  BvhBuilder  builder                   = BvhBuilder::BinnedSah;
+  ui32        maxLeafSize               = 4;       //! Nodes with more primitives are always split.
+  ui32        numBins                   = 16;      //! BinnedSah: bins per axis for evaluating the SAH, at most 32.
+  ui32        mortonCodeBits            = 30;      //! Linear: 30 or 63 bit Morton codes.
+  ui32        treeletOptimizationPasses = 0;       //! Linear: passes of treelet reordering, 0 disables it.
+  f32         traversalCost             = 1.0f;    //! SAH cost of traversing an inner node.
+  f32         intersectionCost          = 1.0f;    //! SAH cost of intersecting a primitive.
+  f32         maxRefitSahCostRatio      = 1.5f;    //! Bvh::update() rebuilds if refits exceed this SAH cost ratio.
+  ui32        branchingFactor           = 4;       //! TraversalBvh: traversal with 2, 4 or 8 wide BVHs.
+  ui32        quantizationBits          = 0;       //! TraversalBvh: 8 or 16 for quantized 4 wide BVHs, 0 disables it.
+  ui32        leafPositionBits          = 0;       //! BottomLevelAS: 16 for 16 bit LeafTriangles, 0 for floats.
+  //! Pool for parallel builds and refits, nullptr uses ThreadPool::getGlobal(). Must outlive the BVH.
+  ThreadPool* threadPool                = nullptr;
+};
+
+//! \brief Build time and quality of a BVH.
+struct BvhBuildStatistics
+{
+  ui64 numPrimitives = 0; //! Number of primitives.
+  ui64 numNodes      = 0; //! Number of nodes.
+  f64  buildTime     = 0; //! Build time in seconds.
+  f64  sahCost       = 0; //! Expected cost of a ray that hits the root, see Bvh::computeSahCost().
+
+  //! \brief Returns the build speed in million primitives per second.
+  f64 getMPrimitivesPerSecond() const;
+
+  //! \brief Accumulates the statistics of another BVH. The SAH cost is averaged, weighted by the primitive counts.
+  BvhBuildStatistics& operator+=(const BvhBuildStatistics& other);
+
+  //! \brief Prints the statistics in a single line.
+  //! \param[in,out]  stream The stream the information should be written to.
+  void print(std::ostream& stream) const;
+};
+
+//! \brief Structure and size of a BVH, see Bvh::computeQualityStatistics(). Builder settings are compared by these
+//! numbers: the SAH cost estimates the traversal cost, overlapping children are both visited by rays through the
+//! overlap, and deep or large leaves increase the work per ray.
+struct BvhQualityStatistics
+{
+  ui64              numPrimitives = 0;  //! Number of primitives.
+  ui64              numInnerNodes = 0;  //! Number of inner nodes.
+  ui64              numLeaves     = 0;  //! Number of leaves.
+  f64               sahCost       = 0;  //! SAH cost with the cost parameters of the build settings.
+  f64               overlapRatio  = 0;  //! Overlap area of the children of inner nodes per inner node area, 0 to 1.
+  std::vector<ui64> leafDepthHistogram; //! Number of leaves per depth, the root has depth 0.
+  std::vector<ui64> leafSizeHistogram;  //! Number of leaves per number of primitives.
+  size_t            memorySize    = 0;  //! Size of the nodes and primitive indices in bytes.
+
+  //! \brief Returns the mean depth of the leaves.
+  f64 getMeanLeafDepth() const;
+
+  //! \brief Accumulates the statistics of another BVH. SAH cost and overlap ratio are averaged, weighted by the
+  //! primitive counts, histograms and sizes are added.
+  BvhQualityStatistics& operator+=(const BvhQualityStatistics& other);
+
+  //! \brief Prints the statistics, one line per histogram bin.
+  //! \param[in,out]  stream The stream the information should be written to.
+  void print(std::ostream& stream) const;
+};
+
+//! \brief Binary bounding volume hierarchy over primitives that are given by their bounding boxes.
+//!
+//! The BVH does not know the primitives, it only orders them: leaves refer to ranges of getPrimitiveIndices(), which
+//! hold indices into the array of bounding boxes the BVH was built from. The root is node 0.
+class Bvh
+{
+public:
+  //! Upper bound for the number of levels, traversal stacks of this size never overflow.
+  static constexpr ui32 MAX_DEPTH = 64;
+
+  //! \brief Creates an empty BVH.
+  Bvh() = default;
+
+  //! \brief Builds the hierarchy with the builder selected in the settings.
+  //!
+  //! BvhBuilder::BinnedSah works top-down: every node bins the centroids of its primitives into settings.numBins bins
+  //! per axis and splits at the bin boundary with the lowest SAH cost, or becomes a leaf if that is cheaper and it has
+  //! at most settings.maxLeafSize primitives. Large nodes are binned in parallel and subtrees are built as parallel
+  //! tasks.
+  //!
+  //! BvhBuilder::Linear sorts the primitives along a Morton curve with a parallel radix sort and emits all inner
+  //! nodes in parallel (Karras, "Maximizing Parallelism in the Construction of BVHs, Octrees, and k-d Trees").
+  //! Optionally, treelets of seven leaves are then restructured for a lower SAH cost (Karras and Aila, "Fast
+  //! Parallel Construction of High-Quality Bounding Volume Hierarchies"). Subtrees with at most
+  //! settings.maxLeafSize primitives become leaves.
+  //! \param[in]  primitiveBounds Bounding box of every primitive.
+  //! \param[in]  settings Build parameters.
+  explicit Bvh(const std::vector<BoundingBox>& primitiveBounds,
+               const BvhBuildSettings&         settings = BvhBuildSettings());
+
+  //! \brief Restores a BVH from the nodes and primitive indices of an earlier build, e.g., loaded by a BvhCache. The
+  //! arrays are taken as they are, only the SAH cost is computed again. The build time is 0.
+  //! \param[in]  nodes The nodes, the root is the first node.
+  //! \param[in]  primitiveIndices The primitive indices the leaves refer to.
+  //! \param[in]  settings The settings for refits and rebuilds.
+  Bvh(std::vector<BvhNode> nodes, std::vector<ui32> primitiveIndices, const BvhBuildSettings& settings);
+
+  //! \brief Returns the nodes. The root is the first node.
+  const std::vector<BvhNode>& getNodes() const;
+
+  //! \brief Returns the primitive indices the leaves refer to.
+  const std::vector<ui32>& getPrimitiveIndices() const;
+
+  //! \brief Returns the bounds of all primitives.
+  BoundingBox getBounds() const;
+
+  //! \brief Returns true, if the BVH contains no primitives.
+  bool isEmpty() const;
+
+  //! \brief Returns the size of the nodes and the primitive indices in bytes.
+  size_t getMemorySize() const;
+
+  //! \brief Returns the build time and the SAH cost with the cost parameters of the build settings.
+  const BvhBuildStatistics& getBuildStatistics() const;
+
+  //! \brief Returns the settings the BVH was built with.
+  const BvhBuildSettings& getBuildSettings() const;
+
+  //! \brief Updates the bounds of all nodes to new primitive bounds and keeps the topology, e.g., after vertices
+  //! moved. Subtrees are refit bottom-up in parallel, then the nodes above them. The SAH cost is updated on the way.
+  //! \param[in]  primitiveBounds New bounding box of every primitive. The number of primitives must not change.
+  void refit(const std::vector<BoundingBox>& primitiveBounds);
+
+  //! \brief Refits the BVH, or rebuilds it with the build settings if the SAH cost of the refit BVH exceeds the cost
+  //! after the last build by more than the factor BvhBuildSettings::maxRefitSahCostRatio.
+  //! \param[in]  primitiveBounds New bounding box of every primitive. The number of primitives must not change.
+  //! \return True, if the BVH was rebuilt.
+  bool update(const std::vector<BoundingBox>& primitiveBounds);
+
+  //! \brief Returns the SAH cost after the last build or refit.
+  f64 getSahCost() const;
+
+  //! \brief Returns the SAH cost: the traversal and intersection costs of all nodes, weighted by the probability
+  //! that a ray which hits the root also hits the node, i.e., by the ratio of the surface areas.
+  //! \param[in]  traversalCost Cost of traversing an inner node.
+  //! \param[in]  intersectionCost Cost of intersecting a primitive.
+  f64 computeSahCost(f32 traversalCost = 1.0f, f32 intersectionCost = 1.0f) const;
+
+  //! \brief Computes the SAH cost, the overlap ratio, the histograms of leaf depths and sizes, and the memory size.
+  //! Traverses all nodes, so it is meant for analysis rather than for every frame.
+  BvhQualityStatistics computeQualityStatistics() const;
+
+private:
+  std::vector<BvhNode> m_nodes;            //! Nodes, the root is m_nodes[0].
+  std::vector<ui32>    m_primitiveIndices; //! Primitive indices in leaf order.
+  BvhBuildSettings     m_buildSettings;    //! Settings of the build, also used for refits and rebuilds.
+  BvhBuildStatistics   m_buildStatistics;  //! Build time and quality.
+  f64                  m_sahCost = 0.0;    //! SAH cost after the last build or refit.
+};
+} // namespace gims
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <gimslib/rt/BottomLevelAS.hpp>
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/types.hpp>
+#include <optional>
+#include <vector>
+
+namespace gims
+{
+//! \brief Directory of binary BVHs that were built before, so static meshes are built only once.
+//!
+//! Every file holds the nodes and primitive indices of one binary Bvh behind a header with the hash of the mesh
+//! contents and the build parameters that shape the binary BVH. Nodes refer to each other and to the primitive
+//! indices by index only, so the arrays are position independent and are loaded from a memory mapping of the file
+//! with one copy each. The traversal layout, i.e., wide or quantized nodes, is derived from the binary BVH after
+//! loading, so files are shared by all layouts. Files are written in the byte order of the machine.
+class BvhCache
+{
+public:
+  //! \brief Uses a directory for the cache files and creates it if it does not exist.
+  //! \param[in]  directory The directory. Files of any mesh and build parameters can share one directory.
+  explicit BvhCache(const std::filesystem::path& directory);
+
+  //! \brief Loads the BLAS of a mesh from the cache or builds it and adds it to the cache. May be called from several
+  //! threads at once.
+  //! \param[in]  positions Vertex positions.
+  //! \param[in]  indices Triangle list index buffer.
+  //! \param[in]  settings BVH build parameters.
+  //! \return The acceleration structure.
+  BottomLevelAS getBottomLevelAS(const std::vector<f32v3>& positions, const std::vector<ui32>& indices,
+                                 const BvhBuildSettings& settings = BvhBuildSettings());
+
+  //! \brief Returns the number of BVHs that were loaded from the cache.
+  ui32 getNumHits() const;
+
+  //! \brief Returns the number of BVHs that were built, because they were not in the cache.
+  ui32 getNumMisses() const;
+
+  //! \brief Returns a hash of the vertex positions and the indices of a mesh.
+  static ui64 computeMeshHash(const std::vector<f32v3>& positions, const std::vector<ui32>& indices);
+
+  //! \brief Writes a BVH into a file. The file is written under a temporary name and renamed afterwards, so readers
+  //! never see partial files. Throws a std::runtime_error, if the file cannot be written.
+  //! \param[in]  fileName The file.
+  //! \param[in]  bvh The BVH.
+  //! \param[in]  meshHash Hash of the mesh the BVH was built for, see computeMeshHash().
+  static void save(const std::filesystem::path& fileName, const Bvh& bvh, ui64 meshHash);
+
+  //! \brief Loads a BVH from a file, if the file exists and was written for the same mesh with the same build
+  //! parameters. Files of other versions and corrupted files are ignored.
+  //! \param[in]  fileName The file.
+  //! \param[in]  meshHash Hash of the mesh, see computeMeshHash().
+  //! \param[in]  numPrimitives Number of triangles of the mesh.
+  //! \param[in]  settings Build parameters the BVH must have been built with. They are also used for refits.
+  //! \return The BVH, or nothing if the file cannot be used.
+  static std::optional<Bvh> load(const std::filesystem::path& fileName, ui64 meshHash, ui32 numPrimitives,
+                                 const BvhBuildSettings& settings);
+
+private:
+  std::filesystem::path m_directory;     //! The cache directory.
+  std::atomic<ui32>     m_numHits   = 0; //! BVHs loaded from the cache.
+  std::atomic<ui32>     m_numMisses = 0; //! BVHs built and added to the cache.
+};
+} // namespace gims
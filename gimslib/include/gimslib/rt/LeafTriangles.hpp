@@ -0,0 +1,87 @@
+#pragma once
+#include <gimslib/rt/Ray.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+class ThreadPool;
+
+//! \brief Compact copy of the triangles of a BottomLevelAS in the leaf order of its BVH, which is all that the
+//! ray/triangle tests read.
+//!
+//! Only vertex positions are stored, in SoA layout and in the order of the primitive indices of the BVH, so the
+//! triangles of a leaf are consecutive and are loaded into SIMD registers without index lookups or gathers. The layout
+//! consists of nine planes of getStride() coordinates: x, y and z of the first, second and third vertex, i.e., plane
+//! 3 * vertex + axis. getTriangleIdx() maps back to the triangles of the mesh.
+//!
+//! Coordinates are 32 bit floats, or 16 bit integers on a grid over the bounds of the mesh, which halves the size.
+//! Rays are transformed to grid space for the tests, which does not change distances and barycentrics. The grid spans
+//! the whole mesh rather than single nodes, so a vertex that is shared by triangles in different leaves has the same
+//! coordinates in all of them and the tests stay watertight.
+class LeafTriangles
+{
+public:
+  //! \brief Grid with 2^16 points per axis on which 16 bit coordinates lie.
+  struct Grid
+  {
+    f32v3 origin  = f32v3(0.0f); //! Position of grid point (0, 0, 0).
+    f32v3 spacing = f32v3(1.0f); //! Distance of neighboring grid points along every axis.
+  };
+
+  //! \brief Creates an empty copy without triangles.
+  LeafTriangles() = default;
+
+  //! \brief Copies triangles to leaf order.
+  //! \param[in]  positions Vertex positions. With a grid, they must lie on it, see snapToGrid().
+  //! \param[in]  triangles Vertex indices of the triangles.
+  //! \param[in]  primitiveIndices Triangle indices in leaf order, i.e., the primitive indices of a BVH.
+  //! \param[in]  grid Grid of 16 bit coordinates, nullptr stores 32 bit floats.
+  //! \param[in]  threadPool Pool that fills the planes.
+  LeafTriangles(const std::vector<f32v3>& positions, const std::vector<ui32v3>& triangles,
+                const std::vector<ui32>& primitiveIndices, const Grid* grid, ThreadPool& threadPool);
+
+  //! \brief Computes the grid over the bounds of the positions and moves every position to its closest grid point.
+  //! Must happen before a BVH is built over the triangles, so that the bounds of its nodes contain the stored
+  //! triangles.
+  //! \param[in,out]  positions Vertex positions.
+  //! \return The grid.
+  static Grid snapToGrid(std::vector<f32v3>& positions);
+
+  //! \brief Returns true, if the coordinates are 16 bit integers, see getQuantizedCoordinates().
+  bool isQuantized() const;
+
+  //! \brief Returns the nine planes of 32 bit coordinates, or nullptr if the coordinates are quantized.
+  const f32* getCoordinates() const;
+
+  //! \brief Returns the nine planes of 16 bit coordinates, or nullptr if the coordinates are floats.
+  const ui16* getQuantizedCoordinates() const;
+
+  //! \brief Returns the number of coordinates per plane. The padding after the last triangle allows loading eight
+  //! coordinates from every triangle.
+  size_t getStride() const;
+
+  //! \brief Returns the number of triangles.
+  ui32 getNumTriangles() const;
+
+  //! \brief Returns the index of the mesh triangle at position i in leaf order.
+  ui32 getTriangleIdx(ui32 i) const;
+
+  //! \brief Returns the indices of the mesh triangles in leaf order, see getTriangleIdx().
+  const ui32* getTriangleIndices() const;
+
+  //! \brief Transforms a ray into the space of the coordinates: grid space if they are quantized, otherwise the ray
+  //! is returned unchanged. t is the same in both spaces.
+  Ray transformRay(const Ray& ray) const;
+
+  //! \brief Returns the size of the coordinates and the triangle indices in bytes.
+  size_t getMemorySize() const;
+
+private:
+  std::vector<f32>  m_coordinates;          //! Planes of 32 bit coordinates.
+  std::vector<ui16> m_quantizedCoordinates; //! Planes of 16 bit coordinates.
+  std::vector<ui32> m_triangleIndices;      //! Mesh triangle of every position in leaf order.
+  Grid              m_grid;                 //! Grid of the 16 bit coordinates.
+  size_t            m_stride = 0;           //! Coordinates per plane.
+};
+} // namespace gims
@@ -0,0 +1,72 @@
+#pragma once
+#include <bit>
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+//! \brief Node of a QuantizedBvh with up to four children (64 bytes with 8 bit, 96 bytes with 16 bit bounds).
+//!
+//! Child bounds are stored as unsigned integers q relative to a frame of the node, the box b = origin + q * 2^exponent
+//! per axis. Lower bounds are rounded down and upper bounds up, so the decoded box always contains the exact one. The
+//! inner children of a node are stored next to each other starting at firstChild, the primitive indices of its leaf
+//! children next to each other starting at firstPrimitive, both in slot order.
+template <typename Quantized> struct alignas(sizeof(Quantized) == 1 ? 64 : 32) QuantizedBvhNode
+{
+  static constexpr ui8 INNER_CHILD = 0xFF;
+
+  f32v3     origin;         //! Lower corner of the frame, the lower corner of the node bounds.
+  i8        exponents[3];   //! Scale of the frame per axis as power of two.
+  ui8       usedChildren;   //! Bit mask of the used child slots.
+  ui32      firstChild;     //! Node index of the first inner child.
+  ui32      firstPrimitive; //! Index of the first primitive index of the first leaf child.
+  ui8       childTypes[4];  //! INNER_CHILD, or the number of primitives of a leaf child.
+  Quantized bounds[6][4];   //! Child bounds: lower x, upper x, lower y, upper y, lower z, upper z.
+  //! Pads the node to its alignment.
+  ui8       padding[sizeof(Quantized) == 1 ? 12 : 20];
+
+  //! \brief Returns the scale 2^exponent of an axis.
+  f32 getScale(ui32 axis) const
+  {
+    return std::bit_cast<f32>(static_cast<ui32>(exponents[axis] + 127) << 23);
+  }
+};
+
+//! \brief BVH with four children per node and quantized child bounds, collapsed from a binary Bvh.
+//!
+//! Nodes are two (8 bit) or four thirds (16 bit) times smaller than the nodes of a Bvh4, so more of the tree fits
+//! into the caches, at the cost of decoding the bounds during traversal and of looser bounds. The children of a node
+//! are selected like for a WideBvh. The BVH stores its own primitive indices, in the order of the leaf children.
+template <typename Quantized> class QuantizedBvh
+{
+  static_assert(sizeof(Quantized) <= 2, "QuantizedBvh supports 8 and 16 bit bounds.");
+
+public:
+  //! Largest quantized coordinate.
+  static constexpr ui32 MAX_QUANTIZED = (1u << (8 * sizeof(Quantized))) - 1;
+
+  //! \brief Creates an empty BVH.
+  QuantizedBvh() = default;
+
+  //! \brief Collapses and quantizes a binary BVH. Its leaves must have at most 254 primitives.
+  //! \param[in]  bvh The binary BVH.
+  explicit QuantizedBvh(const Bvh& bvh);
+
+  //! \brief Returns the nodes. The root is the first node.
+  const std::vector<QuantizedBvhNode<Quantized>>& getNodes() const;
+
+  //! \brief Returns the primitive indices the leaves refer to.
+  const std::vector<ui32>& getPrimitiveIndices() const;
+
+  //! \brief Returns true, if the BVH contains no primitives.
+  bool isEmpty() const;
+
+  //! \brief Returns the size of the nodes and the primitive indices in bytes.
+  size_t getMemorySize() const;
+
+private:
+  std::vector<QuantizedBvhNode<Quantized>> m_nodes;            //! Nodes, the root is m_nodes[0].
+  std::vector<ui32>                        m_primitiveIndices; //! Primitive indices in leaf order.
+};
+} // namespace gims
@@ -0,0 +1,85 @@
+#pragma once
+#include <gimslib/types.hpp>
+#include <limits>
+#include <vector>
+
+namespace gims
+{
+//! \brief A ray with the valid interval [tMin, tMax].
+//!
+//! The direction does not have to be normalized: t is measured in multiples of the direction, which keeps t unchanged
+//! when the ray is transformed into the object space of an instance.
+struct Ray
+{
+  f32v3 origin    = f32v3(0.0f);                           //! Origin.
+  f32   tMin      = 0.0f;                                  //! Hits closer than tMin are ignored.
+  f32v3 direction = f32v3(0.0f, 0.0f, 1.0f);               //! Direction.
+  f32   tMax      = std::numeric_limits<f32>::infinity(); //! Hits farther than tMax are ignored.
+};
+
+//! \brief Result of a closest-hit query.
+struct RayHit
+{
+  //! Value of triangleIdx and instanceIdx if nothing was hit.
+  static constexpr ui32 INVALID = std::numeric_limits<ui32>::max();
+
+  f32   t            = std::numeric_limits<f32>::infinity(); //! Ray parameter of the hit.
+  f32v2 barycentrics = f32v2(0.0f); //! Weights of the second and the third vertex, like the barycentrics of DXR.
+  ui32  triangleIdx  = INVALID;     //! Index of the triangle in the mesh.
+  ui32  instanceIdx  = INVALID;     //! Index of the instance in the top level acceleration structure.
+  ui32  instanceID   = INVALID;     //! TopLevelAS::Instance::instanceID of the instance.
+
+  //! \brief Returns true, if a triangle was hit.
+  bool isHit() const
+  {
+    return triangleIdx != INVALID;
+  }
+};
+
+//! \brief The BVH leaf that occluded the last shadow ray of a query, e.g., per light and tile. Neighboring shadow rays
+//! towards the same light are likely blocked by the same few triangles, which are tested before the BVH is traversed.
+struct Occluder
+{
+  ui32 firstIndex    = 0;               //! First primitive index of the leaf in the traversal layout of the BVH.
+  ui32 numPrimitives = 0;               //! Number of primitives of the leaf, 0 if there is no occluder.
+  ui32 instanceIdx   = RayHit::INVALID; //! Index of the instance in the top level acceleration structure.
+};
+
+//! \brief Work of single-ray queries, which add to the counters they are given. Counting is opt-in and meant for
+//! analysis, e.g., heatmaps of the traversal cost per pixel or tile.
+struct TraversalCounters
+{
+  ui64 numNodesVisited    = 0; //! Inner nodes and leaves that were visited, in both levels of the hierarchy.
+  ui64 numTrianglesTested = 0; //! Ray/triangle tests.
+
+  //! \brief Adds the counts of other queries.
+  TraversalCounters& operator+=(const TraversalCounters& other)
+  {
+    numNodesVisited += other.numNodesVisited;
+    numTrianglesTested += other.numTrianglesTested;
+    return *this;
+  }
+};
+
+//! \brief How the rays of a RayBatch traverse the binary BVH.
+enum class RayBatchTraversal
+{
+  //! Packets of 8 consecutive rays, for coherent rays such as the primary or shadow rays of a tile. A node is skipped
+  //! without testing single rays if the interval bounds of the packet miss it.
+  Packet8,
+  //! Packets of 16 consecutive rays. Pays off for very coherent rays.
+  Packet16,
+  //! All rays of the batch at once, for incoherent rays: every node filters the rays that reach it and passes them on
+  //! to its children, so each node is loaded once per batch instead of once per ray.
+  Stream,
+};
+
+//! \brief Rays that are intersected together, see BottomLevelAS::intersect(RayBatch&).
+struct RayBatch
+{
+  std::vector<Ray>    rays;                                               //! The rays.
+  std::vector<RayHit> hits;                                               //! Closest hit of every ray.
+  RayBatchTraversal   traversal             = RayBatchTraversal::Packet8; //! Traversal algorithm.
+  ui8                 instanceInclusionMask = 0xFF;                       //! See TopLevelAS::intersect().
+};
+} // namespace gims
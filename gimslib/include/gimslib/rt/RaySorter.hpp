@@ -0,0 +1,49 @@
+#pragma once
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/Ray.hpp>
+#include <gimslib/types.hpp>
+#include <span>
+#include <vector>
+
+namespace gims
+{
+class ThreadPool;
+
+//! \brief Reorders rays such that rays which start close to each other and point in similar directions are traced
+//! one after another.
+//!
+//! Secondary rays of neighboring pixels, e.g., towards different lights or in random hemisphere directions, visit
+//! different parts of the BVH. Traced in sorted order, consecutive rays visit the same nodes and triangles, which keeps
+//! them in the cache and lets occlusion queries reuse their last Occluder. The sort key of a ray consists of, from the
+//! most to the least significant bits, the octant of its direction, the Morton code of the cell of its origin in a
+//! grid over the scene bounds, and its direction within the octant.
+class RaySorter
+{
+public:
+  static constexpr ui32 ORIGIN_BITS_PER_AXIS = 6; //! The origin grid has 64^3 cells.
+  static constexpr ui32 DIRECTION_BITS       = 5; //! Per coordinate of the direction within its octant.
+  static constexpr ui32 NUM_KEY_BITS         = 3 + 3 * ORIGIN_BITS_PER_AXIS + 2 * DIRECTION_BITS; //! Bits per key.
+
+  //! \brief Creates a sorter whose origin grid covers no volume. All origins fall into one cell.
+  RaySorter() = default;
+
+  //! \brief Creates a sorter whose origin grid covers the bounds. Origins outside are clamped to the border cells.
+  //! \param[in]  bounds Bounds of the ray origins, usually those of the scene.
+  explicit RaySorter(const BoundingBox& bounds);
+
+  //! \brief Returns the sort key of a ray, see the class description.
+  ui32 computeKey(const Ray& ray) const;
+
+  //! \brief Computes the order in which rays are traced coherently. The keys are sorted with a stable parallel radix
+  //! sort, so rays with equal keys keep their relative order.
+  //! \param[in]  rays The rays.
+  //! \param[out]  order Receives the indices of the rays in sorted order. Results of the rays that are traced in
+  //! this order are scattered back to rays[order[i]].
+  //! \param[in]  threadPool Pool that executes the sort. Small batches are sorted by the calling thread.
+  void sort(std::span<const Ray> rays, std::vector<ui32>& order, ThreadPool& threadPool) const;
+
+private:
+  f32v3 m_lowerLeftBottom = f32v3(0.0f); //! Corner of the origin grid.
+  f32v3 m_cellsPerUnit    = f32v3(0.0f); //! Number of cells per unit length along every axis.
+};
+} // namespace gims
@@ -0,0 +1,127 @@
+#pragma once
+#include <gimslib/rt/BottomLevelAS.hpp>
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/Ray.hpp>
+#include <gimslib/rt/TraversalBvh.hpp>
+#include <gimslib/types.hpp>
+#include <span>
+#include <vector>
+
+namespace gims
+{
+//! \brief CPU top level acceleration structure: a BVH over transformed instances of bottom level acceleration
+//! structures.
+//!
+//! Rays are transformed into the object space of each instance they reach. Since t is measured in multiples of the
+//! ray direction, hit distances of different instances remain comparable. Instances may share a bottom level
+//! acceleration structure, so memory and build time scale with the unique geometry instead of its placements. Like in
+//! DXR, queries take an instance inclusion mask and only see the instances whose mask shares a bit with it.
+class TopLevelAS
+{
+public:
+  //! \brief Placement of a bottom level acceleration structure in world space.
+  struct Instance
+  {
+    f32m4 transformation;    //! Object to world transformation.
+    ui32  bottomLevelASIdx;  //! Index of the bottom level acceleration structure, which instances may share.
+    ui32  instanceID = 0;    //! User-defined ID, reported as RayHit::instanceID. Unlike in DXR, it has 32 bits.
+    ui8   mask       = 0xFF; //! Only queries whose instance inclusion mask shares a bit with it see the instance.
+    ui64  userData   = 0;    //! Not used by the acceleration structure, e.g., an index into application data.
+  };
+
+  //! Instance inclusion mask of queries that see all instances.
+  static constexpr ui8 ALL_INSTANCES = 0xFF;
+
+  //! \brief Creates an empty acceleration structure that is never hit.
+  TopLevelAS() = default;
+
+  //! \brief Takes ownership of the bottom level acceleration structures and builds the BVH over the instances.
+  //! \param[in]  bottomLevelAS The bottom level acceleration structures.
+  //! \param[in]  instances The instances. RayHit::instanceIdx refers to this array.
+  //! \param[in]  settings Build parameters of the BVH over the instances.
+  TopLevelAS(std::vector<BottomLevelAS> bottomLevelAS, std::vector<Instance> instances,
+             const BvhBuildSettings& settings = BvhBuildSettings());
+
+  //! \brief Moves the instances and refits the BVH over them, which is rebuilt if its quality degraded too much, see
+  //! Bvh::update(). The BVH only has one leaf per instance, so both are cheap compared to bottom level updates.
+  //! \param[in]  transformations New object to world transformation of every instance.
+  //! \return True, if the BVH was rebuilt.
+  bool updateTransformations(const std::vector<f32m4>& transformations);
+
+  //! \brief Replaces the vertex positions of a bottom level acceleration structure, see BottomLevelAS::update(), and
+  //! refits the BVH over the instances.
+  //! \param[in]  bottomLevelASIdx Index of the bottom level acceleration structure.
+  //! \param[in]  positions New vertex positions, as many as before.
+  //! \return True, if the BVH of the bottom level acceleration structure or the BVH over the instances was rebuilt.
+  bool updateBottomLevelAS(ui32 bottomLevelASIdx, const std::vector<f32v3>& positions);
+
+  //! \brief Finds the closest hit in [ray.tMin, min(ray.tMax, hit.t)].
+  //! \param[in]  ray The ray in world space.
+  //! \param[in,out]  hit Receives the closer hit, if any.
+  //! \param[in]  instanceInclusionMask Instances whose mask shares no bit with it are ignored.
+  //! \param[in,out]  counters If not null, the visited nodes of both levels and the tested triangles are added to it.
+  //! \return True, if a closer hit was found.
+  bool intersect(const Ray& ray, RayHit& hit, ui8 instanceInclusionMask = ALL_INSTANCES,
+                 TraversalCounters* counters = nullptr) const;
+
+  //! \brief Finds the closest hits of a batch of rays, see intersect(std::span<const Ray>, std::span<RayHit>,
+  //! RayBatchTraversal).
+  //! \param[in,out]  batch The rays in world space. batch.hits is resized to the number of rays, new entries start
+  //! without a hit. batch.instanceInclusionMask selects the instances.
+  void intersect(RayBatch& batch) const;
+
+  //! \brief Finds the closest hit of every ray in [ray.tMin, min(ray.tMax, hit.t)]. The BVH over the instances is
+  //! traversed in packets or as a stream, and the rays that reach an instance are transformed and intersected with
+  //! its bottom level acceleration structure as a batch with the same traversal algorithm.
+  //! \param[in]  rays The rays in world space.
+  //! \param[in,out]  hits One hit per ray, updated like the hit of intersect(const Ray&, RayHit&).
+  //! \param[in]  traversal Traversal algorithm.
+  //! \param[in]  instanceInclusionMask Instances whose mask shares no bit with it are ignored.
+  void intersect(std::span<const Ray> rays, std::span<RayHit> hits, RayBatchTraversal traversal,
+                 ui8 instanceInclusionMask = ALL_INSTANCES) const;
+
+  //! \brief Returns true, if any instance that the mask selects is hit in [ray.tMin, ray.tMax]. Stops at the first
+  //! hit found.
+  bool occluded(const Ray& ray, ui8 instanceInclusionMask = ALL_INSTANCES) const;
+
+  //! \brief Occlusion query that tests the last occluder first and remembers the new one. Renderers keep one
+  //! Occluder per light and tile, since the shadow rays of a tile towards a light are coherent.
+  //! \param[in]  ray The ray in world space.
+  //! \param[in,out]  lastOccluder The triangle that occluded the previous ray, updated on hits.
+  //! \param[in]  instanceInclusionMask Instances whose mask shares no bit with it are ignored.
+  //! \param[in,out]  counters If not null, the visited nodes of both levels and the tested triangles are added to it.
+  //! \return True, if any instance is hit in [ray.tMin, ray.tMax].
+  bool occluded(const Ray& ray, Occluder& lastOccluder, ui8 instanceInclusionMask = ALL_INSTANCES,
+                TraversalCounters* counters = nullptr) const;
+
+  //! \brief Returns the world space bounds of all instances.
+  BoundingBox getBounds() const;
+
+  //! \brief Returns the instances.
+  const std::vector<Instance>& getInstances() const;
+
+  //! \brief Returns the number of bottom level acceleration structures.
+  ui32 getNumBottomLevelAS() const;
+
+  //! \brief Returns a bottom level acceleration structure.
+  const BottomLevelAS& getBottomLevelAS(ui32 bottomLevelASIdx) const;
+
+  //! \brief Returns the BVH. Its primitives are the instances.
+  const Bvh& getBvh() const;
+
+  //! \brief Returns the BVH in the layout that rays traverse.
+  const TraversalBvh& getTraversalBvh() const;
+
+  //! \brief Returns the size of the bottom level acceleration structures, the instances and the BVH in bytes.
+  size_t getMemorySize() const;
+
+private:
+  //! \brief Computes the world space bounds of all instances.
+  std::vector<BoundingBox> computeInstanceBounds() const;
+
+  std::vector<BottomLevelAS> m_bottomLevelAS;          //! The bottom level acceleration structures.
+  std::vector<Instance>      m_instances;              //! The instances.
+  std::vector<f32m4>         m_inverseTransformations; //! World to object transformation of every instance.
+  TraversalBvh               m_bvh;                    //! BVH over the world space bounds of the instances.
+};
+} // namespace gims
@@ -0,0 +1,67 @@
+#pragma once
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/QuantizedBvh.hpp>
+#include <gimslib/rt/WideBvh.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+//! \brief BVH of an acceleration structure: the binary Bvh, which is built and refit, and the layout that rays
+//! traverse, which is derived from it.
+//!
+//! BvhBuildSettings::quantizationBits selects a QuantizedBvh, otherwise BvhBuildSettings::branchingFactor selects the
+//! binary BVH itself, a Bvh4, or a Bvh8.
+class TraversalBvh
+{
+public:
+  //! \brief Creates an empty BVH.
+  TraversalBvh() = default;
+
+  //! \brief Builds the binary BVH and derives the traversal layout.
+  //! \param[in]  primitiveBounds Bounding box of every primitive.
+  //! \param[in]  settings Build parameters, including the traversal layout.
+  TraversalBvh(const std::vector<BoundingBox>& primitiveBounds, const BvhBuildSettings& settings);
+
+  //! \brief Takes a binary BVH that was built before and derives the traversal layout of its build settings.
+  explicit TraversalBvh(Bvh bvh);
+
+  //! \brief Refits or rebuilds the binary BVH, see Bvh::update(), and derives the traversal layout again.
+  //! \return True, if the binary BVH was rebuilt.
+  bool update(const std::vector<BoundingBox>& primitiveBounds);
+
+  //! \brief Returns the binary BVH.
+  const Bvh& getBvh() const;
+
+  //! \brief Returns the 4-wide BVH, which is empty unless it is the traversal layout.
+  const Bvh4& getBvh4() const;
+
+  //! \brief Returns the 8-wide BVH, which is empty unless it is the traversal layout.
+  const Bvh8& getBvh8() const;
+
+  //! \brief Returns the BVH with 8 bit bounds, which is empty unless it is the traversal layout.
+  const QuantizedBvh<ui8>& getQuantizedBvh8() const;
+
+  //! \brief Returns the BVH with 16 bit bounds, which is empty unless it is the traversal layout.
+  const QuantizedBvh<ui16>& getQuantizedBvh16() const;
+
+  //! \brief Returns the primitive indices the leaves of the traversal layout refer to.
+  const std::vector<ui32>& getPrimitiveIndices() const;
+
+  //! \brief Returns the bounds of all primitives.
+  BoundingBox getBounds() const;
+
+  //! \brief Returns the size of the binary BVH and the traversal layout in bytes.
+  size_t getMemorySize() const;
+
+private:
+  //! \brief Derives the traversal layout from m_bvh.
+  void deriveTraversalLayout();
+
+  Bvh                m_bvh;            //! The binary BVH.
+  Bvh4               m_bvh4;           //! m_bvh collapsed to four children per node, if selected.
+  Bvh8               m_bvh8;           //! m_bvh collapsed to eight children per node, if selected.
+  QuantizedBvh<ui8>  m_quantizedBvh8;  //! m_bvh collapsed and quantized to 8 bit, if selected.
+  QuantizedBvh<ui16> m_quantizedBvh16; //! m_bvh collapsed and quantized to 16 bit, if selected.
+};
+} // namespace gims
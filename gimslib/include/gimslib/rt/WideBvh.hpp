@@ -0,0 +1,51 @@
+#pragma once
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+//! \brief Node of a WideBvh with up to Width children (128 bytes for 4, 256 bytes for 8).
+//!
+//! The child bounds are stored as structure of arrays, so the slab tests of all children are a few SIMD
+//! instructions. Unused child slots have empty bounds, which no ray hits.
+template <ui32 Width> struct alignas(64) WideBvhNode
+{
+  f32  bounds[6][Width];     //! Child bounds: lower x, upper x, lower y, upper y, lower z, upper z.
+  ui32 children[Width];      //! Inner child: node index. Leaf child: index of the first primitive index.
+  ui32 numPrimitives[Width]; //! Number of primitives of a leaf child, 0 for inner children and unused slots.
+};
+
+//! \brief BVH with four or eight children per node, collapsed from a binary Bvh for faster traversal.
+//!
+//! Every node of the binary BVH that is kept is expanded by repeatedly replacing its inner child with the largest
+//! surface area by that child's children, until there are Width children. The leaves are the leaves of the binary
+//! BVH and refer to ranges of its Bvh::getPrimitiveIndices(). The root is node 0.
+template <ui32 Width> class WideBvh
+{
+  static_assert(Width == 4 || Width == 8, "WideBvh supports 4 and 8 children per node.");
+
+public:
+  //! \brief Creates an empty BVH.
+  WideBvh() = default;
+
+  //! \brief Collapses a binary BVH. Its primitive indices remain valid for the leaves of the wide BVH.
+  //! \param[in]  bvh The binary BVH.
+  explicit WideBvh(const Bvh& bvh);
+
+  //! \brief Returns the nodes. The root is the first node.
+  const std::vector<WideBvhNode<Width>>& getNodes() const;
+
+  //! \brief Returns true, if the BVH contains no primitives.
+  bool isEmpty() const;
+
+  //! \brief Returns the size of the nodes in bytes. The primitive indices belong to the binary BVH.
+  size_t getMemorySize() const;
+
+private:
+  std::vector<WideBvhNode<Width>> m_nodes; //! Nodes, the root is m_nodes[0].
+};
+
+using Bvh4 = WideBvh<4>;
+using Bvh8 = WideBvh<8>;
+} // namespace gims
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <gimslib/types.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gims
+{
+//! \brief Fixed set of worker threads that execute tasks from a shared queue.
+//!
+//! Tasks are grouped by TaskGroup. Threads that wait for a group help executing queued tasks, so tasks may spawn and
+//! wait for further tasks without deadlocking the pool.
+class ThreadPool
+{
+public:
+  //! \brief Tasks that can be waited for together.
+  class TaskGroup
+  {
+  public:
+    //! \brief Creates an empty group whose tasks are executed by the given pool.
+    explicit TaskGroup(ThreadPool& threadPool);
+
+    //! \brief Waits for all tasks of the group. Exceptions of the tasks are discarded, call wait() to receive them.
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup& other)            = delete;
+    TaskGroup& operator=(const TaskGroup& other) = delete;
+
+    //! \brief Queues a task. It may run on any thread of the pool, including threads that wait.
+    void run(std::function<void()> task);
+
+    //! \brief Executes queued tasks until all tasks of this group are done. Rethrows the first exception of a task.
+    void wait();
+
+  private:
+    friend class ThreadPool;
+
+    ThreadPool&        m_threadPool;      //! The pool that executes the tasks.
+    std::atomic<ui32>  m_numPendingTasks; //! Tasks that are queued or running.
+    std::mutex         m_exceptionMutex;  //! Guards m_exception.
+    std::exception_ptr m_exception;       //! First exception thrown by a task.
+  };
+
+  //! \brief Starts the worker threads.
+  //! \param[in]  numThreads Number of threads that execute tasks, including the thread that waits. 0 uses one
+  //! thread per hardware thread. A pool with a single thread starts no workers and runs all tasks in wait().
+  explicit ThreadPool(ui32 numThreads = 0);
+
+  //! \brief Stops the worker threads. Tasks must not be pending anymore.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool& other)            = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  //! \brief Returns the number of threads that execute tasks, including the waiting thread.
+  ui32 getNumThreads() const;
+
+  //! \brief Splits [begin, end) into chunks of grainSize elements and calls function(chunkBegin, chunkEnd) for each
+  //! chunk in parallel. Returns when all chunks are done.
+  void parallelFor(ui32 begin, ui32 end, ui32 grainSize, const std::function<void(ui32, ui32)>& function);
+
+  //! \brief Returns a pool with one thread per hardware thread, which is created on first use.
+  static ThreadPool& getGlobal();
+
+private:
+  struct Task
+  {
+    std::function<void()> function;
+    TaskGroup*            taskGroup;
+  };
+
+  //! \brief Executes one queued task, if there is any. Returns false if the queue was empty.
+  bool runQueuedTask();
+
+  //! \brief Executes a task and notifies its group.
+  void runTask(Task& task);
+
+  //! \brief Loop of the worker threads.
+  void work();
+
+  std::vector<std::thread> m_workers;   //! Worker threads.
+  std::deque<Task>         m_tasks;     //! Queued tasks.
+  std::mutex               m_mutex;     //! Guards m_tasks and m_stop.
+  std::condition_variable  m_condition; //! Wakes up workers when tasks are queued or the pool stops.
+  bool                     m_stop;      //! Tells the workers to return.
+};
+} // namespace gims
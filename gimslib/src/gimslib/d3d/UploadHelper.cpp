@@ -27,11 +27,22 @@ UploadHelper::~UploadHelper()
 
 void UploadHelper::uploadBuffer(const void* const src, ComPtr<ID3D12Resource>& dst, size_t size,
                                 const ComPtr<ID3D12CommandQueue>& commandQueue)
+{
+  ::memcpy(mapUploadBuffer(), src, size);
+  uploadMappedBuffer(dst, size, commandQueue);
+}
+
+void* UploadHelper::mapUploadBuffer()
 {
   void* cpuMappedUploadBuffer = nullptr;
   throwIfFailed(m_uploadBuffer->Map(0, nullptr, &cpuMappedUploadBuffer));
   throwIfNullptr(cpuMappedUploadBuffer);
-  ::memcpy(cpuMappedUploadBuffer, src, size);
+  return cpuMappedUploadBuffer;
+}
+
+void UploadHelper::uploadMappedBuffer(ComPtr<ID3D12Resource>& dst, size_t size,
+                                      const ComPtr<ID3D12CommandQueue>& commandQueue)
+{
   m_uploadBuffer->Unmap(0, nullptr);
   m_uploadCommandList->CopyBufferRegion(dst.Get(), 0, m_uploadBuffer.Get(), 0, size);
 
@@ -7,6 +7,7 @@
 #include <gimslib/io/CograBinaryMeshFile.hpp>
 #include <istream>
 #include <ostream>
+#include <utility>
 
 namespace gims
 {
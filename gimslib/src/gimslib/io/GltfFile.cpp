@@ -0,0 +1,854 @@
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <gimslib/io/GltfFile.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// Minimal JSON document object model. Objects keep their members in file order.
+/// </summary>
+struct JsonValue
+{
+  enum class Type
+  {
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object
+  };
+
+  Type                                           type    = Type::Null;
+  bool                                           boolean = false;
+  f64                                            number  = 0.0;
+  std::string                                    string;
+  std::vector<JsonValue>                         array;
+  std::vector<std::pair<std::string, JsonValue>> object;
+
+  /// <summary>
+  /// Returns the member with the given key or nullptr, if this is not an object or the key does not exist.
+  /// </summary>
+  const JsonValue* find(const char* key) const
+  {
+    for (const auto& member : object)
+    {
+      if (member.first == key)
+      {
+        return &member.second;
+      }
+    }
+    return nullptr;
+  }
+
+  bool isArray() const
+  {
+    return type == Type::Array;
+  }
+};
+
+/// <summary>
+/// Recursive descent parser for RFC 8259 JSON.
+/// </summary>
+class JsonParser
+{
+public:
+  JsonParser(const char* begin, const char* end)
+      : m_current(begin)
+      , m_end(end)
+  {
+  }
+
+  JsonValue parseDocument()
+  {
+    JsonValue result = parseValue(0);
+    skipWhitespace();
+    if (m_current != m_end)
+    {
+      fail("trailing characters");
+    }
+    return result;
+  }
+
+private:
+  static constexpr ui32 c_maxDepth = 256;
+
+  [[noreturn]] void fail(const char* what) const
+  {
+    throw std::runtime_error(std::string("Invalid JSON: ") + what);
+  }
+
+  void skipWhitespace()
+  {
+    while (m_current != m_end && (*m_current == ' ' || *m_current == '\t' || *m_current == '\n' || *m_current == '\r'))
+    {
+      m_current++;
+    }
+  }
+
+  void expect(char c)
+  {
+    skipWhitespace();
+    if (m_current == m_end || *m_current != c)
+    {
+      fail("unexpected character");
+    }
+    m_current++;
+  }
+
+  bool consumeSeparator()
+  {
+    skipWhitespace();
+    if (m_current != m_end && *m_current == ',')
+    {
+      m_current++;
+      return true;
+    }
+    return false;
+  }
+
+  bool consumeLiteral(const char* literal)
+  {
+    const size_t length = std::strlen(literal);
+    if (static_cast<size_t>(m_end - m_current) >= length && std::memcmp(m_current, literal, length) == 0)
+    {
+      m_current += length;
+      return true;
+    }
+    return false;
+  }
+
+  JsonValue parseValue(ui32 depth)
+  {
+    if (depth > c_maxDepth)
+    {
+      fail("nesting too deep");
+    }
+    skipWhitespace();
+    if (m_current == m_end)
+    {
+      fail("unexpected end of file");
+    }
+
+    JsonValue result;
+    switch (*m_current)
+    {
+      case '{':
+        result.type = JsonValue::Type::Object;
+        m_current++;
+        skipWhitespace();
+        if (m_current != m_end && *m_current == '}')
+        {
+          m_current++;
+          return result;
+        }
+        for (;;)
+        {
+          skipWhitespace();
+          std::string key = parseString();
+          expect(':');
+          result.object.emplace_back(std::move(key), parseValue(depth + 1));
+          if (!consumeSeparator())
+          {
+            break;
+          }
+        }
+        expect('}');
+        return result;
+      case '[':
+        result.type = JsonValue::Type::Array;
+        m_current++;
+        skipWhitespace();
+        if (m_current != m_end && *m_current == ']')
+        {
+          m_current++;
+          return result;
+        }
+        for (;;)
+        {
+          result.array.emplace_back(parseValue(depth + 1));
+          if (!consumeSeparator())
+          {
+            break;
+          }
+        }
+        expect(']');
+        return result;
+      case '"':
+        result.type   = JsonValue::Type::String;
+        result.string = parseString();
+        return result;
+      case 't':
+      case 'f':
+        result.type = JsonValue::Type::Boolean;
+        if (consumeLiteral("true"))
+        {
+          result.boolean = true;
+        }
+        else if (!consumeLiteral("false"))
+        {
+          fail("invalid literal");
+        }
+        return result;
+      case 'n':
+        if (!consumeLiteral("null"))
+        {
+          fail("invalid literal");
+        }
+        return result;
+      default:
+        result.type = JsonValue::Type::Number;
+        {
+          const auto [end, error] = std::from_chars(m_current, m_end, result.number);
+          if (error != std::errc() || end == m_current)
+          {
+            fail("invalid number");
+          }
+          m_current = end;
+        }
+        return result;
+    }
+  }
+
+  static void appendUtf8(std::string& out, ui32 codePoint)
+  {
+    if (codePoint < 0x80)
+    {
+      out.push_back(static_cast<char>(codePoint));
+    }
+    else if (codePoint < 0x800)
+    {
+      out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+      out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+      out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+      out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+  }
+
+  ui32 parseHex4()
+  {
+    if (m_end - m_current < 4)
+    {
+      fail("truncated escape sequence");
+    }
+    ui32 value = 0;
+    for (ui32 i = 0; i < 4; i++)
+    {
+      const char c = *m_current++;
+      value <<= 4;
+      if (c >= '0' && c <= '9')
+        value |= static_cast<ui32>(c - '0');
+      else if (c >= 'a' && c <= 'f')
+        value |= static_cast<ui32>(c - 'a' + 10);
+      else if (c >= 'A' && c <= 'F')
+        value |= static_cast<ui32>(c - 'A' + 10);
+      else
+        fail("invalid escape sequence");
+    }
+    return value;
+  }
+
+  std::string parseString()
+  {
+    if (m_current == m_end || *m_current != '"')
+    {
+      fail("string expected");
+    }
+    m_current++;
+
+    std::string result;
+    while (m_current != m_end && *m_current != '"')
+    {
+      const char c = *m_current++;
+      if (c != '\\')
+      {
+        result.push_back(c);
+        continue;
+      }
+      if (m_current == m_end)
+      {
+        break;
+      }
+      const char escaped = *m_current++;
+      switch (escaped)
+      {
+        case '"':
+        case '\\':
+        case '/':
+          result.push_back(escaped);
+          break;
+        case 'b':
+          result.push_back('\b');
+          break;
+        case 'f':
+          result.push_back('\f');
+          break;
+        case 'n':
+          result.push_back('\n');
+          break;
+        case 'r':
+          result.push_back('\r');
+          break;
+        case 't':
+          result.push_back('\t');
+          break;
+        case 'u':
+        {
+          ui32 codePoint = parseHex4();
+          if (codePoint >= 0xD800 && codePoint < 0xDC00 && consumeLiteral("\\u"))
+          {
+            const ui32 low = parseHex4();
+            codePoint      = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+          }
+          appendUtf8(result, codePoint);
+          break;
+        }
+        default:
+          fail("invalid escape sequence");
+      }
+    }
+    if (m_current == m_end)
+    {
+      fail("unterminated string");
+    }
+    m_current++;
+    return result;
+  }
+
+  const char* m_current;
+  const char* m_end;
+};
+
+const JsonValue& getArray(const JsonValue& object, const char* key)
+{
+  static const JsonValue emptyArray = []() {
+    JsonValue v;
+    v.type = JsonValue::Type::Array;
+    return v;
+  }();
+  const auto value = object.find(key);
+  return (value != nullptr && value->isArray()) ? *value : emptyArray;
+}
+
+f64 getNumber(const JsonValue& object, const char* key, f64 defaultValue)
+{
+  const auto value = object.find(key);
+  return (value != nullptr && value->type == JsonValue::Type::Number) ? value->number : defaultValue;
+}
+
+i32 getIndex(const JsonValue& object, const char* key)
+{
+  return static_cast<i32>(getNumber(object, key, -1.0));
+}
+
+/// <summary>
+/// Returns a count, offset, length or stride, 0 if missing. Throws, if the value is negative, not an integer or
+/// larger than maxValue, since casting it would wrap around or truncate.
+/// </summary>
+size_t getSize(const JsonValue& object, const char* key, f64 maxValue)
+{
+  const f64 value = getNumber(object, key, 0.0);
+  if (!(value >= 0.0 && value <= maxValue) || value != std::floor(value))
+  {
+    throw std::runtime_error(std::string("Invalid glTF ") + key + ".");
+  }
+  return static_cast<size_t>(value);
+}
+
+/// <summary>
+/// Largest value of getSize() that fits into ui32.
+/// </summary>
+constexpr f64 MAX_UI32_SIZE = 4294967295.0;
+
+/// <summary>
+/// Largest value of getSize() for byte offsets and lengths, the largest integer that doubles represent exactly.
+/// </summary>
+constexpr f64 MAX_BYTE_SIZE = 9007199254740992.0;
+
+std::string getString(const JsonValue& object, const char* key)
+{
+  const auto value = object.find(key);
+  return (value != nullptr && value->type == JsonValue::Type::String) ? value->string : std::string();
+}
+
+template<class VectorType> VectorType getVector(const JsonValue& object, const char* key, VectorType defaultValue)
+{
+  const auto& array = getArray(object, key);
+  for (ui32 i = 0; i < static_cast<ui32>(VectorType::length()) && i < array.array.size(); i++)
+  {
+    defaultValue[i] = static_cast<f32>(array.array[i].number);
+  }
+  return defaultValue;
+}
+
+/// <summary>
+/// Returns the "index" member of a textureInfo object, e.g., "baseColorTexture": {"index": 3}.
+/// </summary>
+i32 getTextureIndex(const JsonValue& object, const char* key)
+{
+  const auto textureInfo = object.find(key);
+  return textureInfo != nullptr ? getIndex(*textureInfo, "index") : -1;
+}
+
+/// <summary>
+/// Decodes percent-encoded characters of a relative URI, e.g., "my%20texture.png".
+/// </summary>
+std::string decodeUri(const std::string& uri)
+{
+  std::string result;
+  result.reserve(uri.size());
+  for (size_t i = 0; i < uri.size(); i++)
+  {
+    if (uri[i] == '%' && i + 2 < uri.size())
+    {
+      ui32 value = 0;
+      const auto [end, error] = std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16);
+      if (error == std::errc() && end == uri.data() + i + 3)
+      {
+        result.push_back(static_cast<char>(value));
+        i += 2;
+        continue;
+      }
+    }
+    result.push_back(uri[i]);
+  }
+  return result;
+}
+
+std::filesystem::path utf8ToPath(const std::string& utf8)
+{
+  return std::filesystem::path(std::u8string(reinterpret_cast<const char8_t*>(utf8.data()), utf8.size()));
+}
+
+std::filesystem::path resolveUri(const std::filesystem::path& parentPath, const std::string& uri)
+{
+  if (uri.rfind("data:", 0) == 0)
+  {
+    throw std::runtime_error("Embedded glTF data URIs are not supported.");
+  }
+  return parentPath / utf8ToPath(decodeUri(uri));
+}
+
+ui32 getNumComponents(const std::string& type)
+{
+  if (type == "SCALAR")
+    return 1;
+  if (type == "VEC2")
+    return 2;
+  if (type == "VEC3")
+    return 3;
+  if (type == "VEC4")
+    return 4;
+  throw std::runtime_error("Unsupported glTF accessor type " + type + ".");
+}
+
+ui32 getComponentSize(ui32 componentType)
+{
+  switch (componentType)
+  {
+    case GltfFile::BYTE:
+    case GltfFile::UNSIGNED_BYTE:
+      return 1;
+    case GltfFile::SHORT:
+    case GltfFile::UNSIGNED_SHORT:
+      return 2;
+    case GltfFile::UNSIGNED_INT:
+    case GltfFile::FLOAT:
+      return 4;
+    default:
+      throw std::runtime_error("Unsupported glTF component type " + std::to_string(componentType) + ".");
+  }
+}
+
+/// <summary>
+/// Computes the matrix of a node, either from "matrix" or from "translation", "rotation" and "scale".
+/// </summary>
+f32m4 getNodeTransformation(const JsonValue& node)
+{
+  const auto& matrix = getArray(node, "matrix");
+  if (matrix.array.size() == 16)
+  {
+    f32m4 result;
+    for (ui32 i = 0; i < 16; i++)
+    {
+      result[i / 4][i % 4] = static_cast<f32>(matrix.array[i].number); // glTF matrices are column-major.
+    }
+    return result;
+  }
+
+  const f32v3 t = getVector(node, "translation", f32v3(0.0f));
+  const f32v4 q = getVector(node, "rotation", f32v4(0.0f, 0.0f, 0.0f, 1.0f)); // x, y, z, w
+  const f32v3 s = getVector(node, "scale", f32v3(1.0f));
+
+  f32m4 result(1.0f);
+  result[0] = f32v4(1.0f - 2.0f * (q.y * q.y + q.z * q.z), 2.0f * (q.x * q.y + q.z * q.w),
+                    2.0f * (q.x * q.z - q.y * q.w), 0.0f) *
+              s.x;
+  result[1] = f32v4(2.0f * (q.x * q.y - q.z * q.w), 1.0f - 2.0f * (q.x * q.x + q.z * q.z),
+                    2.0f * (q.y * q.z + q.x * q.w), 0.0f) *
+              s.y;
+  result[2] = f32v4(2.0f * (q.x * q.z + q.y * q.w), 2.0f * (q.y * q.z - q.x * q.w),
+                    1.0f - 2.0f * (q.x * q.x + q.y * q.y), 0.0f) *
+              s.z;
+  result[3] = f32v4(t, 1.0f);
+  return result;
+}
+
+template<class T> f32 readComponent(const ui8* src, bool normalized)
+{
+  T value;
+  std::memcpy(&value, src, sizeof(T));
+  if (!normalized)
+  {
+    return static_cast<f32>(value);
+  }
+  // Normalized integers map to [0,1] (unsigned) or [-1,1] (signed).
+  return glm::max(static_cast<f32>(value) / static_cast<f32>(std::numeric_limits<T>::max()), -1.0f);
+}
+} // namespace
+
+namespace gims
+{
+bool GltfFile::Accessor::isTightlyPacked(ui32 componentTypeValue, ui32 numComponentsValue) const
+{
+  return componentType == componentTypeValue && numComponents == numComponentsValue &&
+         byteStride == getComponentSize(componentTypeValue) * numComponentsValue;
+}
+
+f32v4 GltfFile::Accessor::getFloat(ui32 idx) const
+{
+  f32v4      result(0.0f);
+  const ui8* element       = data + static_cast<size_t>(idx) * byteStride;
+  const ui32 componentSize = getComponentSize(componentType);
+  for (ui32 c = 0; c < numComponents; c++)
+  {
+    const ui8* src = element + c * componentSize;
+    switch (componentType)
+    {
+      case FLOAT:
+        result[c] = readComponent<f32>(src, false);
+        break;
+      case UNSIGNED_INT:
+        result[c] = readComponent<ui32>(src, normalized);
+        break;
+      case UNSIGNED_SHORT:
+        result[c] = readComponent<ui16>(src, normalized);
+        break;
+      case SHORT:
+        result[c] = readComponent<i16>(src, normalized);
+        break;
+      case UNSIGNED_BYTE:
+        result[c] = readComponent<ui8>(src, normalized);
+        break;
+      case BYTE:
+        result[c] = readComponent<i8>(src, normalized);
+        break;
+    }
+  }
+  return result;
+}
+
+ui32 GltfFile::Accessor::getIndex(ui32 idx) const
+{
+  const ui8* element = data + static_cast<size_t>(idx) * byteStride;
+  switch (componentType)
+  {
+    case UNSIGNED_INT:
+    {
+      ui32 value;
+      std::memcpy(&value, element, sizeof(value));
+      return value;
+    }
+    case UNSIGNED_SHORT:
+    {
+      ui16 value;
+      std::memcpy(&value, element, sizeof(value));
+      return value;
+    }
+    case UNSIGNED_BYTE:
+      return *element;
+    default:
+      throw std::runtime_error("Invalid glTF index buffer component type.");
+  }
+}
+
+GltfFile::GltfFile(const std::filesystem::path& fileName)
+{
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file)
+  {
+    throw std::runtime_error(fileName.string() + std::string(" can't be opened."));
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  const std::string json = contents.str();
+
+  const JsonValue root       = JsonParser(json.data(), json.data() + json.size()).parseDocument();
+  const auto      parentPath = fileName.parent_path();
+
+  // Buffers are mapped, not read.
+  for (const auto& buffer : getArray(root, "buffers").array)
+  {
+    const auto uri = getString(buffer, "uri");
+    if (uri.empty())
+    {
+      throw std::runtime_error("glTF buffers without URI (GLB) are not supported.");
+    }
+    m_buffers.emplace_back(resolveUri(parentPath, uri));
+    if (m_buffers.back().getSize() < getSize(buffer, "byteLength", MAX_BYTE_SIZE))
+    {
+      throw std::runtime_error(uri + " is smaller than its declared byteLength.");
+    }
+  }
+
+  const auto& bufferViews = getArray(root, "bufferViews").array;
+  for (const auto& accessorJson : getArray(root, "accessors").array)
+  {
+    if (accessorJson.find("sparse") != nullptr)
+    {
+      throw std::runtime_error("Sparse glTF accessors are not supported.");
+    }
+
+    Accessor accessor;
+    accessor.count                = static_cast<ui32>(getSize(accessorJson, "count", MAX_UI32_SIZE));
+    accessor.componentType        = static_cast<ui32>(getNumber(accessorJson, "componentType", 0.0));
+    accessor.numComponents        = getNumComponents(getString(accessorJson, "type"));
+    const auto normalized         = accessorJson.find("normalized");
+    accessor.normalized           = normalized != nullptr && normalized->boolean;
+    const ui32 elementSize        = getComponentSize(accessor.componentType) * accessor.numComponents;
+    accessor.hasBounds            = accessorJson.find("min") != nullptr && accessorJson.find("max") != nullptr;
+    accessor.min                  = getVector(accessorJson, "min", f32v3(0.0f));
+    accessor.max                  = getVector(accessorJson, "max", f32v3(0.0f));
+
+    const i32 bufferViewIdx = getIndex(accessorJson, "bufferView");
+    if (bufferViewIdx < 0 || bufferViewIdx >= static_cast<i32>(bufferViews.size()))
+    {
+      throw std::runtime_error("glTF accessors without buffer view are not supported.");
+    }
+    const auto& bufferView = bufferViews[bufferViewIdx];
+    const i32   bufferIdx  = getIndex(bufferView, "buffer");
+    if (bufferIdx < 0 || bufferIdx >= static_cast<i32>(m_buffers.size()))
+    {
+      throw std::runtime_error("Invalid glTF buffer index.");
+    }
+
+    const size_t viewOffset = getSize(bufferView, "byteOffset", MAX_BYTE_SIZE);
+    const size_t viewLength = getSize(bufferView, "byteLength", MAX_BYTE_SIZE);
+    const size_t offset     = getSize(accessorJson, "byteOffset", MAX_BYTE_SIZE);
+    const ui32   viewStride = static_cast<ui32>(getSize(bufferView, "byteStride", MAX_UI32_SIZE));
+    accessor.byteStride     = viewStride != 0 ? viewStride : elementSize;
+
+    // Validate once here, so that reading elements later on never leaves the mapped range.
+    const size_t requiredLength =
+        accessor.count == 0 ? 0 : offset + static_cast<size_t>(accessor.count - 1) * accessor.byteStride + elementSize;
+    if (requiredLength > viewLength || viewOffset + viewLength > m_buffers[bufferIdx].getSize())
+    {
+      throw std::runtime_error("glTF accessor exceeds its buffer.");
+    }
+    accessor.data = m_buffers[bufferIdx].getData() + viewOffset + offset;
+    m_accessors.push_back(accessor);
+  }
+
+  const auto validAccessor = [this](i32 accessorIdx) {
+    if (accessorIdx < -1 || accessorIdx >= static_cast<i32>(m_accessors.size()))
+    {
+      throw std::runtime_error("Invalid glTF accessor index.");
+    }
+    return accessorIdx;
+  };
+
+  for (const auto& meshJson : getArray(root, "meshes").array)
+  {
+    Mesh mesh;
+    mesh.name = getString(meshJson, "name");
+    for (const auto& primitiveJson : getArray(meshJson, "primitives").array)
+    {
+      Primitive primitive;
+      if (const auto attributes = primitiveJson.find("attributes"))
+      {
+        primitive.positions          = validAccessor(getIndex(*attributes, "POSITION"));
+        primitive.normals            = validAccessor(getIndex(*attributes, "NORMAL"));
+        primitive.textureCoordinates = validAccessor(getIndex(*attributes, "TEXCOORD_0"));
+        primitive.tangents           = validAccessor(getIndex(*attributes, "TANGENT"));
+      }
+      primitive.indices  = validAccessor(getIndex(primitiveJson, "indices"));
+      primitive.material = getIndex(primitiveJson, "material");
+      primitive.mode     = static_cast<ui32>(getNumber(primitiveJson, "mode", TRIANGLES));
+      mesh.primitives.push_back(primitive);
+    }
+    m_meshes.push_back(std::move(mesh));
+  }
+
+  for (const auto& materialJson : getArray(root, "materials").array)
+  {
+    Material material;
+    material.name            = getString(materialJson, "name");
+    material.emissiveFactor  = getVector(materialJson, "emissiveFactor", f32v3(0.0f));
+    material.emissiveTexture = getTextureIndex(materialJson, "emissiveTexture");
+    material.normalTexture   = getTextureIndex(materialJson, "normalTexture");
+
+    // Same conversions to the Phong model as in Assimp's glTF 2.0 importer.
+    const auto extensions         = materialJson.find("extensions");
+    const auto specularGlossiness = extensions ? extensions->find("KHR_materials_pbrSpecularGlossiness") : nullptr;
+    if (specularGlossiness != nullptr)
+    {
+      material.diffuseFactor   = getVector(*specularGlossiness, "diffuseFactor", f32v4(1.0f));
+      material.specularFactor  = getVector(*specularGlossiness, "specularFactor", f32v3(1.0f));
+      material.shininess       = static_cast<f32>(getNumber(*specularGlossiness, "glossinessFactor", 1.0)) * 1000.0f;
+      material.diffuseTexture  = getTextureIndex(*specularGlossiness, "diffuseTexture");
+      material.specularTexture = getTextureIndex(*specularGlossiness, "specularGlossinessTexture");
+    }
+    else if (const auto metallicRoughness = materialJson.find("pbrMetallicRoughness"))
+    {
+      const f32 smoothness    = 1.0f - static_cast<f32>(getNumber(*metallicRoughness, "roughnessFactor", 1.0));
+      material.diffuseFactor  = getVector(*metallicRoughness, "baseColorFactor", f32v4(1.0f));
+      material.shininess      = smoothness * smoothness * 1000.0f;
+      material.diffuseTexture = getTextureIndex(*metallicRoughness, "baseColorTexture");
+    }
+    m_materials.push_back(std::move(material));
+  }
+  for (const auto& mesh : m_meshes)
+  {
+    for (const auto& primitive : mesh.primitives)
+    {
+      if (primitive.material < -1 || primitive.material >= static_cast<i32>(m_materials.size()))
+      {
+        throw std::runtime_error("Invalid glTF material index.");
+      }
+    }
+  }
+
+  const auto& images = getArray(root, "images").array;
+  for (const auto& texture : getArray(root, "textures").array)
+  {
+    const i32 imageIdx = getIndex(texture, "source");
+    if (imageIdx < 0 || imageIdx >= static_cast<i32>(images.size()) || getString(images[imageIdx], "uri").empty())
+    {
+      throw std::runtime_error("glTF textures must reference an image file.");
+    }
+    m_textureFileNames.push_back(utf8ToPath(decodeUri(getString(images[imageIdx], "uri"))));
+  }
+
+  for (const auto& nodeJson : getArray(root, "nodes").array)
+  {
+    Node node;
+    node.name           = getString(nodeJson, "name");
+    node.transformation = getNodeTransformation(nodeJson);
+    node.mesh           = getIndex(nodeJson, "mesh");
+    for (const auto& child : getArray(nodeJson, "children").array)
+    {
+      if (!(child.number >= 0.0 && child.number < MAX_UI32_SIZE) || child.number != std::floor(child.number))
+      {
+        throw std::runtime_error("Invalid glTF node index.");
+      }
+      node.childIndices.push_back(static_cast<ui32>(child.number));
+    }
+    m_nodes.push_back(std::move(node));
+  }
+  // The hierarchy is created recursively, so it must be a forest: every node has at most one parent and roots have
+  // none. A cycle then cannot be reached from a root.
+  std::vector<bool> isChild(m_nodes.size(), false);
+  for (const auto& node : m_nodes)
+  {
+    if (node.mesh < -1 || node.mesh >= static_cast<i32>(m_meshes.size()))
+    {
+      throw std::runtime_error("Invalid glTF mesh index.");
+    }
+    for (const auto childIdx : node.childIndices)
+    {
+      if (childIdx >= m_nodes.size())
+      {
+        throw std::runtime_error("Invalid glTF node index.");
+      }
+      if (isChild[childIdx])
+      {
+        throw std::runtime_error("glTF nodes must have at most one parent.");
+      }
+      isChild[childIdx] = true;
+    }
+  }
+
+  const auto& scenes   = getArray(root, "scenes").array;
+  const i32   sceneIdx = glm::max(getIndex(root, "scene"), 0);
+  if (sceneIdx < static_cast<i32>(scenes.size()))
+  {
+    for (const auto& nodeIdx : getArray(scenes[sceneIdx], "nodes").array)
+    {
+      if (nodeIdx.number < 0.0 || nodeIdx.number >= static_cast<f64>(m_nodes.size()) ||
+          nodeIdx.number != std::floor(nodeIdx.number))
+      {
+        throw std::runtime_error("Invalid glTF node index.");
+      }
+      if (isChild[static_cast<ui32>(nodeIdx.number)])
+      {
+        throw std::runtime_error("glTF scene root nodes must not have a parent.");
+      }
+      m_rootNodes.push_back(static_cast<ui32>(nodeIdx.number));
+    }
+  }
+  else
+  {
+    // No scene given: every node that is nobody's child is a root.
+    for (ui32 i = 0; i < static_cast<ui32>(m_nodes.size()); i++)
+    {
+      if (!isChild[i])
+      {
+        m_rootNodes.push_back(i);
+      }
+    }
+  }
+}
+
+const std::vector<GltfFile::Node>& GltfFile::getNodes() const
+{
+  return m_nodes;
+}
+
+const std::vector<ui32>& GltfFile::getRootNodes() const
+{
+  return m_rootNodes;
+}
+
+const std::vector<GltfFile::Mesh>& GltfFile::getMeshes() const
+{
+  return m_meshes;
+}
+
+const std::vector<GltfFile::Material>& GltfFile::getMaterials() const
+{
+  return m_materials;
+}
+
+const GltfFile::Accessor& GltfFile::getAccessor(ui32 accessorIdx) const
+{
+  return m_accessors.at(accessorIdx);
+}
+
+ui32 GltfFile::getNumTextures() const
+{
+  return static_cast<ui32>(m_textureFileNames.size());
+}
+
+const std::filesystem::path& GltfFile::getTextureFileName(ui32 textureIdx) const
+{
+  return m_textureFileNames.at(textureIdx);
+}
+} // namespace gims
@@ -0,0 +1,147 @@
+#include <gimslib/io/MemoryMappedFile.hpp>
+#include <stdexcept>
+#include <utility>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gims
+{
+MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& fileName)
+{
+  const auto errorMessage = fileName.string() + std::string(" can't be mapped into memory.");
+#ifdef _WIN32
+  const HANDLE file = CreateFileW(fileName.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    throw std::runtime_error(errorMessage);
+  }
+  m_fileHandle = reinterpret_cast<intptr_t>(file);
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize))
+  {
+    close();
+    throw std::runtime_error(errorMessage);
+  }
+  m_size = static_cast<size_t>(fileSize.QuadPart);
+  if (m_size == 0)
+  {
+    return;
+  }
+
+  const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr)
+  {
+    close();
+    throw std::runtime_error(errorMessage);
+  }
+  m_mappingHandle = reinterpret_cast<intptr_t>(mapping);
+
+  m_data = static_cast<const ui8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+  const int file = ::open(fileName.c_str(), O_RDONLY);
+  if (file < 0)
+  {
+    throw std::runtime_error(errorMessage);
+  }
+  m_fileHandle = file;
+
+  struct stat fileStatus;
+  if (::fstat(file, &fileStatus) != 0)
+  {
+    close();
+    throw std::runtime_error(errorMessage);
+  }
+  m_size = static_cast<size_t>(fileStatus.st_size);
+  if (m_size == 0)
+  {
+    return;
+  }
+
+  void* view = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+  m_data     = view == MAP_FAILED ? nullptr : static_cast<const ui8*>(view);
+#endif
+  if (m_data == nullptr)
+  {
+    close();
+    throw std::runtime_error(errorMessage);
+  }
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+  close();
+}
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_fileHandle(std::exchange(other.m_fileHandle, -1))
+    , m_mappingHandle(std::exchange(other.m_mappingHandle, 0))
+{
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept
+{
+  if (this != &other)
+  {
+    close();
+    m_data          = std::exchange(other.m_data, nullptr);
+    m_size          = std::exchange(other.m_size, 0);
+    m_fileHandle    = std::exchange(other.m_fileHandle, -1);
+    m_mappingHandle = std::exchange(other.m_mappingHandle, 0);
+  }
+  return *this;
+}
+
+const ui8* MemoryMappedFile::getData() const
+{
+  return m_data;
+}
+
+size_t MemoryMappedFile::getSize() const
+{
+  return m_size;
+}
+
+void MemoryMappedFile::close()
+{
+#ifdef _WIN32
+  if (m_data != nullptr)
+  {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mappingHandle != 0)
+  {
+    CloseHandle(reinterpret_cast<HANDLE>(m_mappingHandle));
+  }
+  if (m_fileHandle != -1)
+  {
+    CloseHandle(reinterpret_cast<HANDLE>(m_fileHandle));
+  }
+#else
+  if (m_data != nullptr)
+  {
+    ::munmap(const_cast<ui8*>(m_data), m_size);
+  }
+  if (m_fileHandle != -1)
+  {
+    ::close(static_cast<int>(m_fileHandle));
+  }
+#endif
+  m_data          = nullptr;
+  m_size          = 0;
+  m_fileHandle    = -1;
+  m_mappingHandle = 0;
+}
+} // namespace gims
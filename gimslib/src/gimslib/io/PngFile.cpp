@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <gimslib/io/PngFile.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// CRC-32 of the PNG chunks, see ISO 3309.
+/// </summary>
+ui32 updateCrc(ui32 crc, const ui8* data, size_t size)
+{
+  static const std::array<ui32, 256> table = []
+  {
+    std::array<ui32, 256> values;
+    for (ui32 n = 0; n < 256; n++)
+    {
+      ui32 c = n;
+      for (ui32 k = 0; k < 8; k++)
+      {
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      values[n] = c;
+    }
+    return values;
+  }();
+  for (size_t i = 0; i < size; i++)
+  {
+    crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+void appendBigEndian(std::vector<ui8>& output, ui32 value)
+{
+  output.push_back(static_cast<ui8>(value >> 24));
+  output.push_back(static_cast<ui8>(value >> 16));
+  output.push_back(static_cast<ui8>(value >> 8));
+  output.push_back(static_cast<ui8>(value));
+}
+
+/// <summary>
+/// Appends a chunk: length, type, data and the CRC of type and data.
+/// </summary>
+void appendChunk(std::vector<ui8>& output, const char type[4], const std::vector<ui8>& data)
+{
+  appendBigEndian(output, static_cast<ui32>(data.size()));
+  const size_t typeBegin = output.size();
+  output.insert(output.end(), type, type + 4);
+  output.insert(output.end(), data.begin(), data.end());
+  const ui32 crc = updateCrc(0xffffffffu, output.data() + typeBegin, output.size() - typeBegin) ^ 0xffffffffu;
+  appendBigEndian(output, crc);
+}
+} // namespace
+
+namespace gims
+{
+void writePngFile(const std::filesystem::path& fileName, ui32 width, ui32 height, const ui8v4* pixels)
+{
+  std::vector<ui8> header;
+  appendBigEndian(header, width);
+  appendBigEndian(header, height);
+  header.insert(header.end(), {8, 6, 0, 0, 0}); // 8 bits per channel, RGBA, deflate, adaptive filters, no interlace
+
+  // Every row starts with filter type 0 (none).
+  const size_t     rowSize = 1 + static_cast<size_t>(width) * sizeof(ui8v4);
+  std::vector<ui8> scanlines(rowSize * height);
+  for (ui32 y = 0; y < height; y++)
+  {
+    scanlines[y * rowSize] = 0;
+    std::memcpy(&scanlines[y * rowSize + 1], pixels + static_cast<size_t>(y) * width, rowSize - 1);
+  }
+
+  // zlib stream of stored deflate blocks of at most 65535 bytes, followed by the Adler-32 checksum.
+  constexpr size_t MAX_BLOCK_SIZE = 65535;
+  std::vector<ui8> imageData      = {0x78, 0x01};
+  imageData.reserve(scanlines.size() + 5 * (scanlines.size() / MAX_BLOCK_SIZE + 1) + 6);
+  size_t position = 0;
+  do
+  {
+    const size_t blockSize = std::min(MAX_BLOCK_SIZE, scanlines.size() - position);
+    const bool   isLast    = position + blockSize == scanlines.size();
+    imageData.push_back(isLast ? 1 : 0);
+    imageData.push_back(static_cast<ui8>(blockSize));
+    imageData.push_back(static_cast<ui8>(blockSize >> 8));
+    imageData.push_back(static_cast<ui8>(~blockSize));
+    imageData.push_back(static_cast<ui8>(~blockSize >> 8));
+    imageData.insert(imageData.end(), scanlines.begin() + position, scanlines.begin() + position + blockSize);
+    position += blockSize;
+  } while (position < scanlines.size());
+
+  ui32 a = 1;
+  ui32 b = 0;
+  for (const ui8 value : scanlines)
+  {
+    a = (a + value) % 65521;
+    b = (b + a) % 65521;
+  }
+  appendBigEndian(imageData, (b << 16) | a);
+
+  std::vector<ui8> file = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  appendChunk(file, "IHDR", header);
+  appendChunk(file, "IDAT", imageData);
+  appendChunk(file, "IEND", {});
+
+  std::ofstream stream(fileName, std::ios::binary);
+  stream.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+  if (!stream)
+  {
+    throw std::runtime_error(fileName.string() + std::string(" can't be written."));
+  }
+}
+} // namespace gims
@@ -0,0 +1,652 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <gimslib/io/CograBinaryMeshFile.hpp>
+#include <gimslib/mesh/MeshOptimizer.hpp>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+using namespace gims;
+
+constexpr ui32 INVALID_INDEX = std::numeric_limits<ui32>::max();
+
+// Parameters of Forsyth's scoring function.
+constexpr ui32 FORSYTH_CACHE_SIZE  = 32;
+constexpr ui32 FORSYTH_MAX_VALENCE = 32;
+constexpr f32  CACHE_DECAY_POWER   = 1.5f;
+constexpr f32  LAST_TRIANGLE_SCORE = 0.75f;
+constexpr f32  VALENCE_BOOST_SCALE = 2.0f;
+constexpr f32  VALENCE_BOOST_POWER = 0.5f;
+
+/// <summary>
+/// Precomputed scores for cache positions and remaining valences, so the inner loop does not call pow().
+/// </summary>
+struct ScoreTable
+{
+  std::array<f32, FORSYTH_CACHE_SIZE>      cache;
+  std::array<f32, FORSYTH_MAX_VALENCE + 1> valence;
+
+  ScoreTable()
+  {
+    for (ui32 i = 0; i < FORSYTH_CACHE_SIZE; i++)
+    {
+      // The three vertices of the last triangle get a fixed score, otherwise the next triangle would be biased
+      // towards reusing them in a particular order.
+      cache[i] = i < 3 ? LAST_TRIANGLE_SCORE
+                       : std::pow(1.0f - static_cast<f32>(i - 3) / static_cast<f32>(FORSYTH_CACHE_SIZE - 3),
+                                  CACHE_DECAY_POWER);
+    }
+    valence[0] = 0.0f;
+    for (ui32 i = 1; i <= FORSYTH_MAX_VALENCE; i++)
+    {
+      // Favors vertices with few remaining triangles, which avoids leaving isolated triangles behind.
+      valence[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<f32>(i), -VALENCE_BOOST_POWER);
+    }
+  }
+
+  f32 getScore(ui32 cachePosition, ui32 remainingTriangles) const
+  {
+    if (remainingTriangles == 0)
+    {
+      return -1.0f;
+    }
+    const f32 cacheScore = cachePosition < FORSYTH_CACHE_SIZE ? cache[cachePosition] : 0.0f;
+    return cacheScore + valence[std::min(remainingTriangles, FORSYTH_MAX_VALENCE)];
+  }
+};
+
+f32v3 getPosition(const f32v3* positions, size_t positionStride, ui32 vertexIdx)
+{
+  return *reinterpret_cast<const f32v3*>(reinterpret_cast<const ui8*>(positions) + positionStride * vertexIdx);
+}
+
+/// <summary>
+/// FIFO cache simulation for a single triangle. Returns the number of cache misses. The cache is cleared by
+/// advancing time by more than cacheSize.
+/// </summary>
+ui32 updateFifoCache(const ui32* triangle, ui32 cacheSize, std::vector<ui64>& insertionTime, ui64& time)
+{
+  ui32 misses = 0;
+  for (ui32 c = 0; c < 3; c++)
+  {
+    if (time - insertionTime[triangle[c]] > cacheSize)
+    {
+      insertionTime[triangle[c]] = time++;
+      misses++;
+    }
+  }
+  return misses;
+}
+
+/// <summary>
+/// Splits a cache optimized triangle list into clusters that can be reordered without increasing the ACMR by more
+/// than threshold. Returns the first triangle of each cluster.
+/// </summary>
+std::vector<ui32> generateClusters(const ui32* indices, size_t nTriangles, ui32 nVertices, ui32 cacheSize,
+                                   f32 threshold)
+{
+  std::vector<ui64> insertionTime(nVertices, 0);
+  ui64              time = static_cast<ui64>(cacheSize) + 1;
+
+  // Hard boundaries: a triangle with three cache misses usually starts a new patch of the mesh, so it does not
+  // depend on the cache content left by the triangles before.
+  std::vector<ui32> hardBoundaries;
+  for (size_t t = 0; t < nTriangles; t++)
+  {
+    if (updateFifoCache(&indices[3 * t], cacheSize, insertionTime, time) == 3 || t == 0)
+    {
+      hardBoundaries.push_back(static_cast<ui32>(t));
+    }
+  }
+  hardBoundaries.push_back(static_cast<ui32>(nTriangles));
+
+  // Soft boundaries: within a hard cluster, end a cluster as soon as its ACMR with a cold cache is below threshold
+  // times the ACMR of the whole hard cluster.
+  std::vector<ui32> clusters;
+  for (size_t h = 0; h + 1 < hardBoundaries.size(); h++)
+  {
+    const ui32 begin = hardBoundaries[h];
+    const ui32 end   = hardBoundaries[h + 1];
+
+    time += cacheSize + 1;
+    ui32 hardClusterMisses = 0;
+    for (ui32 t = begin; t < end; t++)
+    {
+      hardClusterMisses += updateFifoCache(&indices[3 * t], cacheSize, insertionTime, time);
+    }
+    const f32 maxACMR = threshold * static_cast<f32>(hardClusterMisses) / static_cast<f32>(end - begin);
+
+    time += cacheSize + 1;
+    ui32 clusterBegin  = begin;
+    ui32 clusterMisses = 0;
+    clusters.push_back(begin);
+    for (ui32 t = begin; t < end; t++)
+    {
+      clusterMisses += updateFifoCache(&indices[3 * t], cacheSize, insertionTime, time);
+      if (t + 1 < end && static_cast<f32>(clusterMisses) <= maxACMR * static_cast<f32>(t + 1 - clusterBegin))
+      {
+        clusterBegin  = t + 1;
+        clusterMisses = 0;
+        clusters.push_back(clusterBegin);
+        time += cacheSize + 1;
+      }
+    }
+  }
+  return clusters;
+}
+
+/// <summary>
+/// Scan line free rasterizer for measureOverdraw(): tests the pixel centers inside the bounding box of a triangle
+/// against its edge functions.
+/// </summary>
+void rasterizeDepth(const f32v3& v0, f32v3 v1, f32v3 v2, ui32 resolution, f32* depthBuffer, ui32* shadedBuffer)
+{
+  f32 area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+  if (area == 0.0f)
+  {
+    return;
+  }
+  if (area < 0.0f)
+  {
+    std::swap(v1, v2);
+    area = -area;
+  }
+
+  const f32  maxCoordinate = static_cast<f32>(resolution - 1);
+  const auto clampToPixel  = [&](f32 coordinate) {
+    return static_cast<ui32>(std::clamp(coordinate, 0.0f, maxCoordinate));
+  };
+  const ui32 xMin = clampToPixel(std::floor(std::min({v0.x, v1.x, v2.x})));
+  const ui32 xMax = clampToPixel(std::ceil(std::max({v0.x, v1.x, v2.x})));
+  const ui32 yMin = clampToPixel(std::floor(std::min({v0.y, v1.y, v2.y})));
+  const ui32 yMax = clampToPixel(std::ceil(std::max({v0.y, v1.y, v2.y})));
+
+  const auto edge = [](const f32v3& a, const f32v3& b, f32 x, f32 y) {
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+  };
+  for (ui32 y = yMin; y <= yMax; y++)
+  {
+    const f32 pixelY = static_cast<f32>(y) + 0.5f;
+    for (ui32 x = xMin; x <= xMax; x++)
+    {
+      const f32 pixelX = static_cast<f32>(x) + 0.5f;
+      const f32 w0     = edge(v1, v2, pixelX, pixelY);
+      const f32 w1     = edge(v2, v0, pixelX, pixelY);
+      const f32 w2     = edge(v0, v1, pixelX, pixelY);
+      if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+      {
+        continue;
+      }
+      const f32    depth = (w0 * v0.z + w1 * v1.z + w2 * v2.z) / area;
+      const size_t pixel = static_cast<size_t>(y) * resolution + x;
+      if (depth < depthBuffer[pixel])
+      {
+        depthBuffer[pixel] = depth;
+        shadedBuffer[pixel]++;
+      }
+    }
+  }
+}
+
+void validateIndices(const ui32* indices, size_t nIndices, ui32 nVertices)
+{
+  if (nIndices % 3 != 0)
+  {
+    throw std::runtime_error("Number of indices is not a multiple of 3.");
+  }
+  for (size_t i = 0; i < nIndices; i++)
+  {
+    if (indices[i] >= nVertices)
+    {
+      throw std::runtime_error("Vertex index out of range.");
+    }
+  }
+}
+} // namespace
+
+namespace gims
+{
+f32 VertexCacheStatistics::getACMR() const
+{
+  return numTriangles == 0 ? 0.0f : static_cast<f32>(numTransformedVertices) / static_cast<f32>(numTriangles);
+}
+
+f32 VertexCacheStatistics::getATVR() const
+{
+  return numVertices == 0 ? 0.0f : static_cast<f32>(numTransformedVertices) / static_cast<f32>(numVertices);
+}
+
+VertexCacheStatistics& VertexCacheStatistics::operator+=(const VertexCacheStatistics& other)
+{
+  numTransformedVertices += other.numTransformedVertices;
+  numTriangles += other.numTriangles;
+  numVertices += other.numVertices;
+  return *this;
+}
+
+f32 OverdrawStatistics::getOverdraw() const
+{
+  return numCoveredPixels == 0 ? 0.0f : static_cast<f32>(numShadedPixels) / static_cast<f32>(numCoveredPixels);
+}
+
+OverdrawStatistics& OverdrawStatistics::operator+=(const OverdrawStatistics& other)
+{
+  numCoveredPixels += other.numCoveredPixels;
+  numShadedPixels += other.numShadedPixels;
+  return *this;
+}
+
+MeshOptimizationStatistics& MeshOptimizationStatistics::operator+=(const MeshOptimizationStatistics& other)
+{
+  before += other.before;
+  after += other.after;
+  overdrawBefore += other.overdrawBefore;
+  overdrawAfter += other.overdrawAfter;
+  return *this;
+}
+
+void MeshOptimizationStatistics::print(std::ostream& stream) const
+{
+  stream << "ACMR: " << before.getACMR() << " -> " << after.getACMR() << ", ATVR: " << before.getATVR() << " -> "
+         << after.getATVR();
+  if (overdrawBefore.numCoveredPixels > 0)
+  {
+    stream << ", overdraw: " << overdrawBefore.getOverdraw() << " -> " << overdrawAfter.getOverdraw();
+  }
+  stream << " (" << after.numTriangles << " triangles)" << std::endl;
+}
+
+VertexCacheStatistics analyzeVertexCache(const ui32* indices, size_t nIndices, ui32 nVertices, ui32 cacheSize)
+{
+  validateIndices(indices, nIndices, nVertices);
+
+  VertexCacheStatistics result;
+  result.numTriangles = nIndices / 3;
+
+  // A vertex is in the FIFO cache if it was inserted during the last cacheSize insertions.
+  std::vector<ui64> insertionTime(nVertices, 0);
+  std::vector<bool> referenced(nVertices, false);
+  ui64              time = static_cast<ui64>(cacheSize) + 1;
+  for (size_t i = 0; i < nIndices; i++)
+  {
+    const ui32 v = indices[i];
+    if (time - insertionTime[v] > cacheSize)
+    {
+      insertionTime[v] = time++;
+      result.numTransformedVertices++;
+    }
+    if (!referenced[v])
+    {
+      referenced[v] = true;
+      result.numVertices++;
+    }
+  }
+  return result;
+}
+
+void optimizeVertexCache(ui32* indices, size_t nIndices, ui32 nVertices)
+{
+  validateIndices(indices, nIndices, nVertices);
+  const size_t nTriangles = nIndices / 3;
+  if (nTriangles == 0)
+  {
+    return;
+  }
+  static const ScoreTable scoreTable;
+
+  // Triangle adjacency of every vertex. The first remainingTriangles[v] entries of a vertex are the triangles that
+  // have not been emitted yet.
+  std::vector<ui32> remainingTriangles(nVertices, 0);
+  for (size_t i = 0; i < nIndices; i++)
+  {
+    remainingTriangles[indices[i]]++;
+  }
+  std::vector<ui32> adjacencyOffsets(static_cast<size_t>(nVertices) + 1, 0);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+  }
+  std::vector<ui32> adjacency(nIndices);
+  {
+    std::vector<ui32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < nIndices; i++)
+    {
+      adjacency[fill[indices[i]]++] = static_cast<ui32>(i / 3);
+    }
+  }
+
+  std::vector<ui32> cachePosition(nVertices, INVALID_INDEX);
+  std::vector<f32>  vertexScore(nVertices);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    vertexScore[v] = scoreTable.getScore(INVALID_INDEX, remainingTriangles[v]);
+  }
+
+  const auto triangleScore = [&](ui32 t) {
+    return vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+  };
+
+  ui32 bestTriangle = 0;
+  f32  bestScore    = triangleScore(0);
+  for (ui32 t = 1; t < nTriangles; t++)
+  {
+    const f32 score = triangleScore(t);
+    if (score > bestScore)
+    {
+      bestTriangle = t;
+      bestScore    = score;
+    }
+  }
+
+  std::vector<ui32>                        output(nIndices);
+  std::vector<bool>                        emitted(nTriangles, false);
+  std::array<ui32, FORSYTH_CACHE_SIZE + 3> cache;
+  std::array<ui32, FORSYTH_CACHE_SIZE + 3> newCache;
+  ui32                                     cacheEntries = 0;
+  size_t                                   inputCursor  = 0;
+
+  for (size_t i = 0; i < nTriangles; i++)
+  {
+    if (bestTriangle == INVALID_INDEX)
+    {
+      // Dead end: none of the cached vertices has triangles left. Continue with the next triangle in input order,
+      // which is cheaper than searching all triangles and rarely worse.
+      while (emitted[inputCursor])
+      {
+        inputCursor++;
+      }
+      bestTriangle = static_cast<ui32>(inputCursor);
+    }
+
+    const ui32* triangle = &indices[3 * bestTriangle];
+    std::copy(triangle, triangle + 3, &output[3 * i]);
+    emitted[bestTriangle] = true;
+
+    // Remove the triangle from the adjacency of its vertices.
+    for (ui32 c = 0; c < 3; c++)
+    {
+      const ui32 v     = triangle[c];
+      ui32*      begin = &adjacency[adjacencyOffsets[v]];
+      ui32*      end   = begin + remainingTriangles[v];
+      ui32*      it    = std::find(begin, end, bestTriangle);
+      std::swap(*it, *(end - 1));
+      remainingTriangles[v]--;
+    }
+
+    // The vertices of the triangle move to the front of the LRU cache, the other entries are shifted back.
+    ui32 newCacheEntries = 0;
+    for (ui32 c = 0; c < 3; c++)
+    {
+      if (std::find(newCache.begin(), newCache.begin() + newCacheEntries, triangle[c]) ==
+          newCache.begin() + newCacheEntries)
+      {
+        newCache[newCacheEntries++] = triangle[c];
+      }
+    }
+    for (ui32 c = 0; c < cacheEntries; c++)
+    {
+      const ui32 v = cache[c];
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+      {
+        newCache[newCacheEntries++] = v;
+      }
+    }
+
+    // Update the scores of all vertices whose cache position changed, including the evicted ones.
+    for (ui32 c = 0; c < newCacheEntries; c++)
+    {
+      const ui32 v     = newCache[c];
+      cachePosition[v] = c < FORSYTH_CACHE_SIZE ? c : INVALID_INDEX;
+      vertexScore[v]   = scoreTable.getScore(cachePosition[v], remainingTriangles[v]);
+    }
+
+    // The next triangle is the best one that uses a cached vertex.
+    bestTriangle = INVALID_INDEX;
+    bestScore    = -1.0f;
+    for (ui32 c = 0; c < newCacheEntries; c++)
+    {
+      const ui32 v     = newCache[c];
+      const ui32 begin = adjacencyOffsets[v];
+      for (ui32 a = begin; a < begin + remainingTriangles[v]; a++)
+      {
+        const f32 score = triangleScore(adjacency[a]);
+        if (score > bestScore)
+        {
+          bestTriangle = adjacency[a];
+          bestScore    = score;
+        }
+      }
+    }
+
+    cacheEntries = std::min(newCacheEntries, FORSYTH_CACHE_SIZE);
+    std::copy(newCache.begin(), newCache.begin() + cacheEntries, cache.begin());
+  }
+
+  std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeOverdraw(ui32* indices, size_t nIndices, const f32v3* positions, size_t positionStride, ui32 nVertices,
+                      f32 threshold)
+{
+  validateIndices(indices, nIndices, nVertices);
+  const size_t nTriangles = nIndices / 3;
+  if (nTriangles == 0)
+  {
+    return;
+  }
+  const std::vector<ui32> clusters = generateClusters(indices, nTriangles, nVertices, 16, threshold);
+  if (clusters.size() < 2)
+  {
+    return;
+  }
+
+  // Area weighted centroid and normal of every cluster. The cross product has twice the area as its length.
+  std::vector<f32v3> clusterCentroids(clusters.size(), f32v3(0.0f));
+  std::vector<f32v3> clusterNormals(clusters.size(), f32v3(0.0f));
+  f32v3              meshCentroid(0.0f);
+  f32                meshArea     = 0.0f;
+  f32                signedVolume = 0.0f;
+  for (size_t c = 0; c < clusters.size(); c++)
+  {
+    const ui32 end  = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<ui32>(nTriangles);
+    f32        area = 0.0f;
+    for (ui32 t = clusters[c]; t < end; t++)
+    {
+      const f32v3 p0         = getPosition(positions, positionStride, indices[3 * t]);
+      const f32v3 p1         = getPosition(positions, positionStride, indices[3 * t + 1]);
+      const f32v3 p2         = getPosition(positions, positionStride, indices[3 * t + 2]);
+      const f32v3 normal     = glm::cross(p1 - p0, p2 - p0);
+      const f32   doubleArea = glm::length(normal);
+      clusterCentroids[c] += (p0 + p1 + p2) * (doubleArea / 3.0f);
+      clusterNormals[c] += normal;
+      area += doubleArea;
+      signedVolume += glm::dot(p0, glm::cross(p1, p2));
+    }
+    meshCentroid += clusterCentroids[c];
+    meshArea += area;
+    clusterCentroids[c] = area > 0.0f ? clusterCentroids[c] / area : clusterCentroids[c];
+  }
+  meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+  // Clusters whose surface points away from the center occlude the rest of the mesh from many directions. A negative
+  // signed volume means that the normals of the winding convention point inwards.
+  const f32         orientation = signedVolume < 0.0f ? -1.0f : 1.0f;
+  std::vector<f32>  occlusionPotential(clusters.size());
+  std::vector<ui32> clusterOrder(clusters.size());
+  for (size_t c = 0; c < clusters.size(); c++)
+  {
+    const f32   normalLength = glm::length(clusterNormals[c]);
+    const f32v3 normal       = normalLength > 0.0f ? clusterNormals[c] / normalLength : f32v3(0.0f);
+    occlusionPotential[c]    = orientation * glm::dot(clusterCentroids[c] - meshCentroid, normal);
+    clusterOrder[c]          = static_cast<ui32>(c);
+  }
+  std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+                   [&](ui32 a, ui32 b) { return occlusionPotential[a] > occlusionPotential[b]; });
+
+  std::vector<ui32> output;
+  output.reserve(nIndices);
+  for (const ui32 c : clusterOrder)
+  {
+    const ui32 end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<ui32>(nTriangles);
+    output.insert(output.end(), indices + 3 * static_cast<size_t>(clusters[c]),
+                  indices + 3 * static_cast<size_t>(end));
+  }
+  std::copy(output.begin(), output.end(), indices);
+}
+
+OverdrawStatistics measureOverdraw(const ui32* indices, size_t nIndices, const f32v3* positions, size_t positionStride,
+                                   ui32 nVertices, ui32 numViews, ui32 resolution)
+{
+  validateIndices(indices, nIndices, nVertices);
+  OverdrawStatistics result;
+  if (nIndices == 0 || nVertices == 0 || resolution == 0)
+  {
+    return result;
+  }
+
+  f32v3 lowerLeftBottom = getPosition(positions, positionStride, 0);
+  f32v3 upperRightTop   = lowerLeftBottom;
+  for (ui32 v = 1; v < nVertices; v++)
+  {
+    lowerLeftBottom = glm::min(lowerLeftBottom, getPosition(positions, positionStride, v));
+    upperRightTop   = glm::max(upperRightTop, getPosition(positions, positionStride, v));
+  }
+  const f32v3 center = (lowerLeftBottom + upperRightTop) * 0.5f;
+  const f32   radius = std::max(glm::length(upperRightTop - center), std::numeric_limits<f32>::min());
+
+  // One depth and one counter buffer for front faces, another one for back faces.
+  const size_t       nPixels = static_cast<size_t>(resolution) * resolution;
+  std::vector<f32>   depthBuffer(2 * nPixels);
+  std::vector<ui32>  shadedBuffer(2 * nPixels);
+  std::vector<f32v3> projected(nVertices);
+  for (ui32 view = 0; view < numViews; view++)
+  {
+    // Fibonacci lattice on the sphere.
+    const f32   goldenAngle = glm::pi<f32>() * (3.0f - std::sqrt(5.0f));
+    const f32   z           = 1.0f - 2.0f * (static_cast<f32>(view) + 0.5f) / static_cast<f32>(numViews);
+    const f32   r           = std::sqrt(std::max(0.0f, 1.0f - z * z));
+    const f32   phi         = goldenAngle * static_cast<f32>(view);
+    const f32v3 direction(r * std::cos(phi), r * std::sin(phi), z);
+    const f32v3 helper = std::abs(direction.x) < 0.9f ? f32v3(1.0f, 0.0f, 0.0f) : f32v3(0.0f, 1.0f, 0.0f);
+    const f32v3 u      = glm::normalize(glm::cross(helper, direction));
+    const f32v3 v      = glm::cross(direction, u);
+
+    const f32 scale = 0.5f * static_cast<f32>(resolution) / radius;
+    for (ui32 i = 0; i < nVertices; i++)
+    {
+      const f32v3 p = getPosition(positions, positionStride, i) - center;
+      projected[i]  = f32v3((glm::dot(p, u) + radius) * scale, (glm::dot(p, v) + radius) * scale,
+                            glm::dot(p, direction));
+    }
+
+    std::fill(depthBuffer.begin(), depthBuffer.end(), std::numeric_limits<f32>::max());
+    std::fill(shadedBuffer.begin(), shadedBuffer.end(), 0);
+    for (size_t i = 0; i < nIndices; i += 3)
+    {
+      const f32v3& v0         = projected[indices[i]];
+      const f32v3& v1         = projected[indices[i + 1]];
+      const f32v3& v2         = projected[indices[i + 2]];
+      const bool   backFacing = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x) < 0.0f;
+      const size_t layer      = backFacing ? nPixels : 0;
+      rasterizeDepth(v0, v1, v2, resolution, &depthBuffer[layer], &shadedBuffer[layer]);
+    }
+
+    for (const ui32 shaded : shadedBuffer)
+    {
+      result.numCoveredPixels += shaded > 0 ? 1 : 0;
+      result.numShadedPixels += shaded;
+    }
+  }
+  return result;
+}
+
+std::vector<ui32> optimizeVertexFetch(ui32* indices, size_t nIndices, ui32 nVertices)
+{
+  validateIndices(indices, nIndices, nVertices);
+
+  std::vector<ui32> remap(nVertices, INVALID_INDEX);
+  ui32              nextVertex = 0;
+  for (size_t i = 0; i < nIndices; i++)
+  {
+    ui32& newIndex = remap[indices[i]];
+    if (newIndex == INVALID_INDEX)
+    {
+      newIndex = nextVertex++;
+    }
+    indices[i] = newIndex;
+  }
+  for (auto& newIndex : remap)
+  {
+    if (newIndex == INVALID_INDEX)
+    {
+      newIndex = nextVertex++;
+    }
+  }
+  return remap;
+}
+
+void remapVertices(void* vertices, ui32 nVertices, size_t vertexSize, const std::vector<ui32>& remap)
+{
+  if (remap.size() != nVertices)
+  {
+    throw std::runtime_error("Remap table does not match the number of vertices.");
+  }
+  const auto       dst = static_cast<ui8*>(vertices);
+  std::vector<ui8> src(dst, dst + vertexSize * nVertices);
+  for (ui32 v = 0; v < nVertices; v++)
+  {
+    std::memcpy(dst + vertexSize * remap[v], src.data() + vertexSize * v, vertexSize);
+  }
+}
+
+MeshOptimizationStatistics optimizeMesh(ui32* indices, size_t nIndices, const f32v3* positions, size_t positionStride,
+                                        ui32 nVertices, std::vector<ui32>& vertexRemap,
+                                        const MeshOptimizationSettings& settings)
+{
+  MeshOptimizationStatistics result;
+  result.before = analyzeVertexCache(indices, nIndices, nVertices);
+  if (settings.numOverdrawViews > 0)
+  {
+    result.overdrawBefore =
+        measureOverdraw(indices, nIndices, positions, positionStride, nVertices, settings.numOverdrawViews);
+  }
+
+  optimizeVertexCache(indices, nIndices, nVertices);
+  if (settings.overdrawThreshold >= 1.0f)
+  {
+    optimizeOverdraw(indices, nIndices, positions, positionStride, nVertices, settings.overdrawThreshold);
+  }
+  if (settings.numOverdrawViews > 0)
+  {
+    result.overdrawAfter =
+        measureOverdraw(indices, nIndices, positions, positionStride, nVertices, settings.numOverdrawViews);
+  }
+  vertexRemap  = optimizeVertexFetch(indices, nIndices, nVertices);
+  result.after = analyzeVertexCache(indices, nIndices, nVertices);
+  return result;
+}
+
+MeshOptimizationStatistics optimizeMesh(CograBinaryMeshFile& mesh, const MeshOptimizationSettings& settings)
+{
+  const ui32        nVertices = mesh.getNumVertices();
+  const size_t      nIndices  = 3 * static_cast<size_t>(mesh.getNumTriangles());
+  std::vector<ui32> vertexRemap;
+  if (nIndices == 0)
+  {
+    return MeshOptimizationStatistics();
+  }
+  const auto result = optimizeMesh(mesh.getTriangleIndices(), nIndices,
+                                   reinterpret_cast<const f32v3*>(mesh.getPositionsPtr()), sizeof(f32v3), nVertices,
+                                   vertexRemap, settings);
+
+  remapVertices(mesh.getPositionsPtr(), nVertices, 3 * sizeof(CograBinaryMeshFile::FloatType), vertexRemap);
+  for (CograBinaryMeshFile::SizeType i = 0; i < mesh.getNumAttributes(); i++)
+  {
+    remapVertices(mesh.getAttributePtr(i), nVertices, mesh.getAttributeElementSize(i), vertexRemap);
+  }
+  return result;
+}
+} // namespace gims
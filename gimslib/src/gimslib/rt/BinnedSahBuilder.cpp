@@ -0,0 +1,375 @@
+#include "impl/BvhBuilders.hpp"
+#include "impl/Simd.hpp"
+#include <algorithm>
+#include <atomic>
+#include <gimslib/sys/ThreadPool.hpp>
+
+namespace
+{
+using namespace gims;
+using impl::f32x4;
+
+constexpr ui32 MAX_BINS                   = 32;
+constexpr ui32 PARALLEL_SUBTREE_THRESHOLD = 4096;  // Subtrees with more primitives are built as separate tasks.
+constexpr ui32 PARALLEL_BINNING_THRESHOLD = 65536; // Nodes with more primitives are binned in parallel.
+constexpr ui32 BINNING_GRAIN_SIZE         = 16384;
+
+/// <summary>
+/// Bounds of a primitive in the layout the binning works on. The fourth components are unused.
+/// </summary>
+struct BuildPrimitive
+{
+  f32x4 lowerLeftBottom;
+  f32x4 upperRightTop;
+  ui32  index;
+  ui32  padding[3];
+};
+
+/// <summary>
+/// Bounds and doubled-centroid bounds of a set of primitives, i.e., of a bin or a node. The default constructor leaves
+/// the members uninitialized, since thousands of bins are created per build. Start from createEmpty().
+/// </summary>
+struct BuildBounds
+{
+  f32x4 lowerLeftBottom;
+  f32x4 upperRightTop;
+  f32x4 centroidLowerLeftBottom;
+  f32x4 centroidUpperRightTop;
+  ui32  count;
+  ui32  padding[3];
+
+  static BuildBounds createEmpty()
+  {
+    BuildBounds bounds;
+    bounds.lowerLeftBottom         = f32x4(std::numeric_limits<f32>::max());
+    bounds.upperRightTop           = f32x4(-std::numeric_limits<f32>::max());
+    bounds.centroidLowerLeftBottom = f32x4(std::numeric_limits<f32>::max());
+    bounds.centroidUpperRightTop   = f32x4(-std::numeric_limits<f32>::max());
+    bounds.count                   = 0;
+    return bounds;
+  }
+
+  void extend(const BuildPrimitive& primitive, const f32x4& centroid)
+  {
+    lowerLeftBottom         = impl::min(lowerLeftBottom, primitive.lowerLeftBottom);
+    upperRightTop           = impl::max(upperRightTop, primitive.upperRightTop);
+    centroidLowerLeftBottom = impl::min(centroidLowerLeftBottom, centroid);
+    centroidUpperRightTop   = impl::max(centroidUpperRightTop, centroid);
+    count++;
+  }
+
+  void extend(const BuildBounds& other)
+  {
+    lowerLeftBottom         = impl::min(lowerLeftBottom, other.lowerLeftBottom);
+    upperRightTop           = impl::max(upperRightTop, other.upperRightTop);
+    centroidLowerLeftBottom = impl::min(centroidLowerLeftBottom, other.centroidLowerLeftBottom);
+    centroidUpperRightTop   = impl::max(centroidUpperRightTop, other.centroidUpperRightTop);
+    count += other.count;
+  }
+
+  f32 getSurfaceArea() const
+  {
+    const f32x4 extent = impl::max(upperRightTop - lowerLeftBottom, f32x4(0.0f));
+    return 2.0f * (extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0]);
+  }
+};
+
+/// <summary>
+/// Per-axis bins of the centroids of a range of primitives. Only the first numBins bins per axis are used.
+/// </summary>
+struct Binning
+{
+  BuildBounds bins[3][MAX_BINS];
+
+  explicit Binning(ui32 numBins)
+  {
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      std::fill_n(bins[axis], numBins, BuildBounds::createEmpty());
+    }
+  }
+
+  void merge(const Binning& other, ui32 numBins)
+  {
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      for (ui32 b = 0; b < numBins; b++)
+      {
+        bins[axis][b].extend(other.bins[axis][b]);
+      }
+    }
+  }
+};
+
+/// <summary>
+/// Maps doubled centroids to bin indices for all three axes at once. Binning and partitioning use the same
+/// arithmetic, so both assign every primitive to the same bin.
+/// </summary>
+struct BinMapping
+{
+  f32x4 offset;
+  f32x4 scale;
+  ui32  numBins;
+
+  BinMapping(const BuildBounds& bounds, ui32 binCount)
+      : offset(bounds.centroidLowerLeftBottom)
+      , numBins(binCount)
+  {
+    f32 scales[3];
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      const f32 extent = bounds.centroidUpperRightTop[axis] - bounds.centroidLowerLeftBottom[axis];
+      scales[axis]     = extent > 0.0f ? 0.99999f * static_cast<f32>(numBins) / extent : 0.0f;
+    }
+    scale = f32x4(scales[0], scales[1], scales[2], 0.0f);
+  }
+
+  void getBins(const f32x4& centroid, i32 bins[4]) const
+  {
+    impl::truncate((centroid - offset) * scale, bins);
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      bins[axis] = std::clamp(bins[axis], 0, static_cast<i32>(numBins) - 1);
+    }
+  }
+};
+
+f32x4 getDoubledCentroid(const BuildPrimitive& primitive)
+{
+  return primitive.lowerLeftBottom + primitive.upperRightTop;
+}
+
+/// <summary>
+/// Top-down binned SAH construction. Nodes are allocated from a preallocated array with an atomic counter, so
+/// subtrees can be built by different tasks. Siblings are allocated together and are adjacent.
+/// </summary>
+class SahBuilder
+{
+public:
+  SahBuilder(const std::vector<BoundingBox>& primitiveBounds, const BvhBuildSettings& settings,
+             std::vector<BvhNode>& nodes, std::vector<ui32>& primitiveIndices)
+      : m_settings(settings)
+      , m_threadPool(settings.threadPool ? *settings.threadPool : ThreadPool::getGlobal())
+      , m_nodes(nodes)
+      , m_primitiveIndices(primitiveIndices)
+      , m_numNodes(1)
+  {
+    m_settings.maxLeafSize = std::max(m_settings.maxLeafSize, 1u);
+    m_settings.numBins     = std::clamp(m_settings.numBins, 2u, MAX_BINS);
+
+    const ui32 nPrimitives = static_cast<ui32>(primitiveBounds.size());
+    m_primitives.resize(nPrimitives);
+    m_threadPool.parallelFor(0, nPrimitives, BINNING_GRAIN_SIZE,
+                             [&](ui32 begin, ui32 end)
+                             {
+                               for (ui32 i = begin; i < end; i++)
+                               {
+                                 const f32v3& lowerLeftBottom    = primitiveBounds[i].lowerLeftBottom;
+                                 const f32v3& upperRightTop      = primitiveBounds[i].upperRightTop;
+                                 m_primitives[i].lowerLeftBottom = f32x4(lowerLeftBottom.x, lowerLeftBottom.y,
+                                                                         lowerLeftBottom.z, 0.0f);
+                                 m_primitives[i].upperRightTop =
+                                     f32x4(upperRightTop.x, upperRightTop.y, upperRightTop.z, 0.0f);
+                                 m_primitives[i].index = i;
+                               }
+                             });
+    // A binary tree with at least one primitive per leaf has at most 2n - 1 nodes.
+    m_nodes.resize(2 * static_cast<size_t>(nPrimitives) - 1);
+  }
+
+  void build()
+  {
+    const ui32 nPrimitives = static_cast<ui32>(m_primitives.size());
+    {
+      ThreadPool::TaskGroup taskGroup(m_threadPool);
+      buildNode(0, 0, nPrimitives, computeBounds(0, nPrimitives), 1, taskGroup);
+      taskGroup.wait();
+    }
+    m_nodes.resize(m_numNodes);
+    m_primitiveIndices.resize(nPrimitives);
+    m_threadPool.parallelFor(0, nPrimitives, BINNING_GRAIN_SIZE,
+                             [&](ui32 begin, ui32 end)
+                             {
+                               for (ui32 i = begin; i < end; i++)
+                               {
+                                 m_primitiveIndices[i] = m_primitives[i].index;
+                               }
+                             });
+  }
+
+private:
+  BuildBounds computeBounds(ui32 begin, ui32 end) const
+  {
+    BuildBounds bounds = BuildBounds::createEmpty();
+    for (ui32 i = begin; i < end; i++)
+    {
+      bounds.extend(m_primitives[i], getDoubledCentroid(m_primitives[i]));
+    }
+    return bounds;
+  }
+
+  void binPrimitives(ui32 begin, ui32 end, const BinMapping& mapping, Binning& binning) const
+  {
+    for (ui32 i = begin; i < end; i++)
+    {
+      const f32x4 centroid = getDoubledCentroid(m_primitives[i]);
+      i32         bins[4];
+      mapping.getBins(centroid, bins);
+      binning.bins[0][bins[0]].extend(m_primitives[i], centroid);
+      binning.bins[1][bins[1]].extend(m_primitives[i], centroid);
+      binning.bins[2][bins[2]].extend(m_primitives[i], centroid);
+    }
+  }
+
+  void binPrimitivesInParallel(ui32 begin, ui32 end, const BinMapping& mapping, Binning& binning)
+  {
+    const ui32           numChunks = (end - begin + BINNING_GRAIN_SIZE - 1) / BINNING_GRAIN_SIZE;
+    std::vector<Binning> chunkBinnings(numChunks, Binning(mapping.numBins));
+    m_threadPool.parallelFor(begin, end, BINNING_GRAIN_SIZE,
+                             [&](ui32 chunkBegin, ui32 chunkEnd)
+                             {
+                               binPrimitives(chunkBegin, chunkEnd, mapping,
+                                             chunkBinnings[(chunkBegin - begin) / BINNING_GRAIN_SIZE]);
+                             });
+    for (const auto& chunkBinning : chunkBinnings)
+    {
+      binning.merge(chunkBinning, mapping.numBins);
+    }
+  }
+
+  void buildNode(ui32 nodeIdx, ui32 begin, ui32 end, const BuildBounds& bounds, ui32 depth,
+                 ThreadPool::TaskGroup& taskGroup)
+  {
+    BvhNode& node        = m_nodes[nodeIdx];
+    node.lowerLeftBottom = f32v3(bounds.lowerLeftBottom[0], bounds.lowerLeftBottom[1], bounds.lowerLeftBottom[2]);
+    node.upperRightTop   = f32v3(bounds.upperRightTop[0], bounds.upperRightTop[1], bounds.upperRightTop[2]);
+    node.firstIndex      = begin;
+    node.numPrimitives   = end - begin;
+    if (node.numPrimitives == 1)
+    {
+      return;
+    }
+
+    // Find the bin boundary with the lowest SAH cost. Small nodes use fewer bins, which saves clearing and sweeping
+    // bins that would stay empty anyway.
+    const ui32       numBins = std::min(m_settings.numBins, std::max(node.numPrimitives, 4u));
+    const BinMapping mapping(bounds, numBins);
+    Binning          binning(numBins);
+    if (node.numPrimitives > PARALLEL_BINNING_THRESHOLD && m_threadPool.getNumThreads() > 1)
+    {
+      binPrimitivesInParallel(begin, end, mapping, binning);
+    }
+    else
+    {
+      binPrimitives(begin, end, mapping, binning);
+    }
+    f32  bestCost  = std::numeric_limits<f32>::max();
+    ui32 bestAxis  = 0;
+    ui32 bestSplit = 0;
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      const BuildBounds* bins = binning.bins[axis];
+      f32                rightArea[MAX_BINS];
+      ui32               rightCount[MAX_BINS];
+      BuildBounds        right = BuildBounds::createEmpty();
+      for (ui32 b = numBins - 1; b > 0; b--)
+      {
+        right.extend(bins[b]);
+        rightArea[b]  = right.getSurfaceArea();
+        rightCount[b] = right.count;
+      }
+      BuildBounds left = BuildBounds::createEmpty();
+      for (ui32 split = 1; split < numBins; split++)
+      {
+        left.extend(bins[split - 1]);
+        if (left.count == 0 || rightCount[split] == 0)
+        {
+          continue;
+        }
+        const f32 cost = left.getSurfaceArea() * static_cast<f32>(left.count) +
+                         rightArea[split] * static_cast<f32>(rightCount[split]);
+        if (cost < bestCost)
+        {
+          bestCost  = cost;
+          bestAxis  = axis;
+          bestSplit = split;
+        }
+      }
+    }
+
+    const f32 area      = bounds.getSurfaceArea();
+    const f32 leafCost  = m_settings.intersectionCost * static_cast<f32>(node.numPrimitives);
+    const f32 splitCost = m_settings.traversalCost + m_settings.intersectionCost * bestCost / std::max(area, 1e-30f);
+    if (node.numPrimitives <= m_settings.maxLeafSize && leafCost <= splitCost)
+    {
+      return;
+    }
+
+    // Partition at the best bin boundary. If all centroids fall into one bin or the tree becomes too deep to stay
+    // within MAX_DEPTH, split at the median instead.
+    const auto  first       = m_primitives.begin() + begin;
+    const auto  last        = m_primitives.begin() + end;
+    BuildBounds leftBounds  = BuildBounds::createEmpty();
+    BuildBounds rightBounds = BuildBounds::createEmpty();
+    ui32        middle;
+    if (bestSplit > 0 && depth < Bvh::MAX_DEPTH / 2)
+    {
+      for (ui32 b = 0; b < numBins; b++)
+      {
+        (b < bestSplit ? leftBounds : rightBounds).extend(binning.bins[bestAxis][b]);
+      }
+      const auto isLeft = [&](const BuildPrimitive& primitive)
+      {
+        i32 bins[4];
+        mapping.getBins(getDoubledCentroid(primitive), bins);
+        return static_cast<ui32>(bins[bestAxis]) < bestSplit;
+      };
+      middle = static_cast<ui32>(std::partition(first, last, isLeft) - m_primitives.begin());
+    }
+    else
+    {
+      const f32x4 extent = bounds.centroidUpperRightTop - bounds.centroidLowerLeftBottom;
+      const ui32  axis   = extent[0] > extent[1] ? (extent[0] > extent[2] ? 0 : 2) : (extent[1] > extent[2] ? 1 : 2);
+      const auto  isLess = [axis](const BuildPrimitive& a, const BuildPrimitive& b)
+      { return getDoubledCentroid(a)[axis] < getDoubledCentroid(b)[axis]; };
+      middle = begin + node.numPrimitives / 2;
+      std::nth_element(first, m_primitives.begin() + middle, last, isLess);
+      leftBounds  = computeBounds(begin, middle);
+      rightBounds = computeBounds(middle, end);
+    }
+
+    const ui32 firstChild = m_numNodes.fetch_add(2);
+    node.firstIndex       = firstChild;
+    node.numPrimitives    = 0;
+    if (middle - begin > PARALLEL_SUBTREE_THRESHOLD && m_threadPool.getNumThreads() > 1)
+    {
+      taskGroup.run([this, firstChild, begin, middle, leftBounds, depth, &taskGroup]()
+                    { buildNode(firstChild, begin, middle, leftBounds, depth + 1, taskGroup); });
+    }
+    else
+    {
+      buildNode(firstChild, begin, middle, leftBounds, depth + 1, taskGroup);
+    }
+    buildNode(firstChild + 1, middle, end, rightBounds, depth + 1, taskGroup);
+  }
+
+  BvhBuildSettings            m_settings;         //! Build parameters, clamped to the supported ranges.
+  ThreadPool&                 m_threadPool;       //! Pool for parallel binning and subtrees.
+  std::vector<BvhNode>&       m_nodes;            //! Output nodes.
+  std::vector<ui32>&          m_primitiveIndices; //! Output primitive indices.
+  std::vector<BuildPrimitive> m_primitives;       //! Primitives, reordered into leaf order during the build.
+  std::atomic<ui32>           m_numNodes;         //! Number of allocated nodes.
+};
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+void buildBinnedSahBvh(const std::vector<BoundingBox>& primitiveBounds, const BvhBuildSettings& settings,
+                       std::vector<BvhNode>& nodes, std::vector<ui32>& primitiveIndices)
+{
+  SahBuilder(primitiveBounds, settings, nodes, primitiveIndices).build();
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,279 @@
+#include "impl/Traversal.hpp"
+#include "impl/TriangleIntersection.hpp"
+#include <gimslib/rt/BottomLevelAS.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// Finds the closest hit among the triangles of a leaf and maps it back to the triangle of the mesh.
+/// </summary>
+bool intersectLeaf(const LeafTriangles& leafTriangles, const impl::WatertightRay& ray, ui32 firstIndex,
+                   ui32 numPrimitives, f32& tMax, RayHit& hit)
+{
+  const bool leafHit =
+      leafTriangles.isQuantized()
+          ? impl::intersectLeafTriangles(ray, leafTriangles.getQuantizedCoordinates(), leafTriangles.getStride(),
+                                         leafTriangles.getTriangleIndices(), firstIndex, numPrimitives, tMax,
+                                         hit.barycentrics, hit.triangleIdx)
+          : impl::intersectLeafTriangles(ray, leafTriangles.getCoordinates(), leafTriangles.getStride(),
+                                         leafTriangles.getTriangleIndices(), firstIndex, numPrimitives, tMax,
+                                         hit.barycentrics, hit.triangleIdx);
+  if (leafHit)
+  {
+    hit.t = tMax;
+  }
+  return leafHit;
+}
+
+/// <summary>
+/// Returns true, if any triangle of a leaf is hit in [ray.tMin, tMax].
+/// </summary>
+bool occludeLeaf(const LeafTriangles& leafTriangles, const impl::WatertightRay& ray, ui32 firstIndex,
+                 ui32 numPrimitives, f32 tMax)
+{
+  return leafTriangles.isQuantized()
+             ? impl::occludeLeafTriangles(ray, leafTriangles.getQuantizedCoordinates(), leafTriangles.getStride(),
+                                          firstIndex, numPrimitives, tMax)
+             : impl::occludeLeafTriangles(ray, leafTriangles.getCoordinates(), leafTriangles.getStride(), firstIndex,
+                                          numPrimitives, tMax);
+}
+} // namespace
+
+namespace gims
+{
+BottomLevelAS::BottomLevelAS(const std::vector<f32v3>& positions, const std::vector<ui32>& indices,
+                             const BvhBuildSettings& settings)
+{
+  setGeometry(positions, indices);
+  const auto grid = snapToGrid(settings);
+  m_bvh           = TraversalBvh(computeTriangleBounds(settings), settings);
+  storeLeafTriangles(grid ? &*grid : nullptr);
+}
+
+BottomLevelAS::BottomLevelAS(const std::vector<f32v3>& positions, const std::vector<ui32>& indices, Bvh bvh)
+{
+  setGeometry(positions, indices);
+  if (bvh.getPrimitiveIndices().size() != m_triangles.size())
+  {
+    throw std::runtime_error("The BVH does not fit the number of triangles.");
+  }
+  const auto grid = snapToGrid(bvh.getBuildSettings());
+  m_bvh           = TraversalBvh(std::move(bvh));
+  storeLeafTriangles(grid ? &*grid : nullptr);
+}
+
+bool BottomLevelAS::update(const std::vector<f32v3>& positions)
+{
+  if (positions.size() != m_positions.size())
+  {
+    throw std::runtime_error("The number of vertices of an updated mesh must not change.");
+  }
+  m_positions        = positions;
+  const auto grid    = snapToGrid(m_bvh.getBvh().getBuildSettings());
+  const bool rebuilt = m_bvh.update(computeTriangleBounds(m_bvh.getBvh().getBuildSettings()));
+  storeLeafTriangles(grid ? &*grid : nullptr);
+  return rebuilt;
+}
+
+bool BottomLevelAS::intersect(const Ray& ray, RayHit& hit, TraversalCounters* counters) const
+{
+  const impl::WatertightRay watertightRay(m_leafTriangles.transformRay(ray));
+  const auto                intersectLeafTriangles = [&](ui32 firstIndex, ui32 numPrimitives, f32& tMax)
+  {
+    if (counters)
+    {
+      counters->numTrianglesTested += numPrimitives;
+    }
+    return intersectLeaf(m_leafTriangles, watertightRay, firstIndex, numPrimitives, tMax, hit);
+  };
+  f32 tMax = std::min(ray.tMax, hit.t);
+  return impl::traverse<false>(m_bvh, ray, tMax, intersectLeafTriangles, counters);
+}
+
+void BottomLevelAS::intersect(RayBatch& batch) const
+{
+  batch.hits.resize(batch.rays.size());
+  intersect(batch.rays, batch.hits, batch.traversal);
+}
+
+void BottomLevelAS::intersect(std::span<const Ray> rays, std::span<RayHit> hits, RayBatchTraversal traversal) const
+{
+  if (hits.size() != rays.size())
+  {
+    throw std::runtime_error("Expected one hit per ray.");
+  }
+  const LeafTriangles& leafTriangles =
+      m_binaryLeafTriangles.getNumTriangles() != 0 ? m_binaryLeafTriangles : m_leafTriangles;
+  std::vector<impl::WatertightRay> watertightRays;
+  watertightRays.reserve(rays.size());
+  for (const Ray& ray : rays)
+  {
+    watertightRays.emplace_back(leafTriangles.transformRay(ray));
+  }
+  const auto intersectLeafTriangles = [&](ui32 firstIndex, ui32 numPrimitives, const ui32* rayIndices,
+                                          ui32 numRayIndices, f32* tMax)
+  {
+    for (ui32 i = 0; i < numRayIndices; i++)
+    {
+      const ui32 rayIdx = rayIndices[i];
+      intersectLeaf(leafTriangles, watertightRays[rayIdx], firstIndex, numPrimitives, tMax[rayIdx], hits[rayIdx]);
+    }
+  };
+  impl::traverseBatch(m_bvh.getBvh(), traversal, rays, hits, intersectLeafTriangles);
+}
+
+bool BottomLevelAS::occluded(const Ray& ray) const
+{
+  Occluder lastOccluder;
+  return occluded(ray, lastOccluder);
+}
+
+bool BottomLevelAS::occluded(const Ray& ray, Occluder& lastOccluder, TraversalCounters* counters) const
+{
+  if (isOccludedBy(ray, lastOccluder, counters))
+  {
+    return true;
+  }
+  const impl::WatertightRay watertightRay(m_leafTriangles.transformRay(ray));
+  const auto                occludeLeafTriangles = [&](ui32 firstIndex, ui32 numPrimitives, f32&)
+  {
+    if (counters)
+    {
+      counters->numTrianglesTested += numPrimitives;
+    }
+    if (occludeLeaf(m_leafTriangles, watertightRay, firstIndex, numPrimitives, ray.tMax))
+    {
+      lastOccluder = {firstIndex, numPrimitives, lastOccluder.instanceIdx};
+      return true;
+    }
+    return false;
+  };
+  f32 tMax = ray.tMax;
+  return impl::traverse<true>(m_bvh, ray, tMax, occludeLeafTriangles, counters);
+}
+
+bool BottomLevelAS::isOccludedBy(const Ray& ray, const Occluder& occluder, TraversalCounters* counters) const
+{
+  if (occluder.firstIndex + occluder.numPrimitives > m_triangles.size())
+  {
+    return false;
+  }
+  if (counters)
+  {
+    counters->numTrianglesTested += occluder.numPrimitives;
+  }
+  return occludeLeaf(m_leafTriangles, impl::WatertightRay(m_leafTriangles.transformRay(ray)), occluder.firstIndex,
+                     occluder.numPrimitives, ray.tMax);
+}
+
+BoundingBox BottomLevelAS::getBounds() const
+{
+  return m_bvh.getBounds();
+}
+
+ui32 BottomLevelAS::getNumTriangles() const
+{
+  return static_cast<ui32>(m_triangles.size());
+}
+
+const std::vector<f32v3>& BottomLevelAS::getPositions() const
+{
+  return m_positions;
+}
+
+const std::vector<ui32v3>& BottomLevelAS::getTriangles() const
+{
+  return m_triangles;
+}
+
+const Bvh& BottomLevelAS::getBvh() const
+{
+  return m_bvh.getBvh();
+}
+
+const TraversalBvh& BottomLevelAS::getTraversalBvh() const
+{
+  return m_bvh;
+}
+
+const LeafTriangles& BottomLevelAS::getLeafTriangles() const
+{
+  return m_leafTriangles;
+}
+
+size_t BottomLevelAS::getMemorySize() const
+{
+  return m_positions.size() * sizeof(f32v3) + m_triangles.size() * sizeof(ui32v3) + m_bvh.getMemorySize() +
+         m_leafTriangles.getMemorySize() + m_binaryLeafTriangles.getMemorySize();
+}
+
+void BottomLevelAS::setGeometry(const std::vector<f32v3>& positions, const std::vector<ui32>& indices)
+{
+  if (indices.size() % 3 != 0)
+  {
+    throw std::runtime_error("The number of indices is not a multiple of 3.");
+  }
+  m_positions = positions;
+  m_triangles.resize(indices.size() / 3);
+  for (size_t i = 0; i < m_triangles.size(); i++)
+  {
+    m_triangles[i] = ui32v3(indices[3 * i + 0], indices[3 * i + 1], indices[3 * i + 2]);
+    for (ui32 j = 0; j < 3; j++)
+    {
+      if (m_triangles[i][j] >= m_positions.size())
+      {
+        throw std::runtime_error("Vertex index out of bounds.");
+      }
+    }
+  }
+}
+
+std::optional<LeafTriangles::Grid> BottomLevelAS::snapToGrid(const BvhBuildSettings& settings)
+{
+  switch (settings.leafPositionBits)
+  {
+  case 0:
+    return std::nullopt;
+  case 16:
+    return LeafTriangles::snapToGrid(m_positions);
+  default:
+    throw std::runtime_error("The number of leaf position bits must be 0 or 16.");
+  }
+}
+
+void BottomLevelAS::storeLeafTriangles(const LeafTriangles::Grid* grid)
+{
+  const BvhBuildSettings& settings   = m_bvh.getBvh().getBuildSettings();
+  ThreadPool&             threadPool = settings.threadPool ? *settings.threadPool : ThreadPool::getGlobal();
+  m_leafTriangles       = LeafTriangles(m_positions, m_triangles, m_bvh.getPrimitiveIndices(), grid, threadPool);
+  m_binaryLeafTriangles = LeafTriangles();
+  if (&m_bvh.getPrimitiveIndices() != &m_bvh.getBvh().getPrimitiveIndices())
+  {
+    m_binaryLeafTriangles =
+        LeafTriangles(m_positions, m_triangles, m_bvh.getBvh().getPrimitiveIndices(), grid, threadPool);
+  }
+}
+
+std::vector<BoundingBox> BottomLevelAS::computeTriangleBounds(const BvhBuildSettings& settings) const
+{
+  std::vector<BoundingBox> triangleBounds(m_triangles.size());
+  ThreadPool&              threadPool = settings.threadPool ? *settings.threadPool : ThreadPool::getGlobal();
+  threadPool.parallelFor(0, static_cast<ui32>(m_triangles.size()), 16384,
+                         [&](ui32 begin, ui32 end)
+                         {
+                           for (ui32 i = begin; i < end; i++)
+                           {
+                             for (ui32 j = 0; j < 3; j++)
+                             {
+                               triangleBounds[i].extend(m_positions[m_triangles[i][j]]);
+                             }
+                           }
+                         });
+  return triangleBounds;
+}
+} // namespace gims
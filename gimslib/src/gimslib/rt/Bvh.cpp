@@ -0,0 +1,374 @@
+#include "impl/BvhBuilders.hpp"
+#include <algorithm>
+#include <chrono>
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <iomanip>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// Refits the subtree below nodeIdx and returns its SAH cost, not normalized by the root area.
+/// </summary>
+f64 refitSubtree(std::vector<BvhNode>& nodes, const std::vector<ui32>& primitiveIndices,
+                 const std::vector<BoundingBox>& primitiveBounds, ui32 nodeIdx, const BvhBuildSettings& settings)
+{
+  BvhNode&    node = nodes[nodeIdx];
+  BoundingBox bounds;
+  f64         cost = 0.0;
+  if (node.isLeaf())
+  {
+    for (ui32 i = node.firstIndex; i < node.firstIndex + node.numPrimitives; i++)
+    {
+      bounds.extend(primitiveBounds[primitiveIndices[i]]);
+    }
+    cost = static_cast<f64>(settings.intersectionCost) * node.numPrimitives * bounds.getSurfaceArea();
+  }
+  else
+  {
+    cost = refitSubtree(nodes, primitiveIndices, primitiveBounds, node.firstIndex, settings) +
+           refitSubtree(nodes, primitiveIndices, primitiveBounds, node.firstIndex + 1, settings);
+    bounds = {nodes[node.firstIndex].lowerLeftBottom, nodes[node.firstIndex].upperRightTop};
+    bounds.extend({nodes[node.firstIndex + 1].lowerLeftBottom, nodes[node.firstIndex + 1].upperRightTop});
+    cost += static_cast<f64>(settings.traversalCost) * bounds.getSurfaceArea();
+  }
+  node.lowerLeftBottom = bounds.lowerLeftBottom;
+  node.upperRightTop   = bounds.upperRightTop;
+  return cost;
+}
+
+/// <summary>
+/// Adds the bins of a histogram to another one, which grows if it has fewer bins.
+/// </summary>
+void addHistogram(std::vector<ui64>& histogram, const std::vector<ui64>& other)
+{
+  histogram.resize(std::max(histogram.size(), other.size()), 0);
+  for (size_t i = 0; i < other.size(); i++)
+  {
+    histogram[i] += other[i];
+  }
+}
+
+/// <summary>
+/// Prints the non-empty bins of a histogram, one per line.
+/// </summary>
+void printHistogram(std::ostream& stream, const char* name, const std::vector<ui64>& histogram, ui64 total)
+{
+  stream << name << ":" << std::endl;
+  for (size_t i = 0; i < histogram.size(); i++)
+  {
+    if (histogram[i] > 0)
+    {
+      stream << std::setw(6) << i << ": " << std::setw(10) << histogram[i] << " (" << std::setprecision(1)
+             << 100.0 * static_cast<f64>(histogram[i]) / static_cast<f64>(total) << "%)" << std::endl;
+    }
+  }
+}
+} // namespace
+
+namespace gims
+{
+f64 BvhBuildStatistics::getMPrimitivesPerSecond() const
+{
+  return buildTime > 0.0 ? static_cast<f64>(numPrimitives) / buildTime / 1e6 : 0.0;
+}
+
+BvhBuildStatistics& BvhBuildStatistics::operator+=(const BvhBuildStatistics& other)
+{
+  const ui64 totalPrimitives = numPrimitives + other.numPrimitives;
+  if (totalPrimitives > 0)
+  {
+    sahCost = (sahCost * static_cast<f64>(numPrimitives) + other.sahCost * static_cast<f64>(other.numPrimitives)) /
+              static_cast<f64>(totalPrimitives);
+  }
+  numPrimitives = totalPrimitives;
+  numNodes += other.numNodes;
+  buildTime += other.buildTime;
+  return *this;
+}
+
+void BvhBuildStatistics::print(std::ostream& stream) const
+{
+  const std::streamsize precision = stream.precision();
+  stream << numPrimitives << " primitives, " << numNodes << " nodes, " << std::fixed << std::setprecision(1)
+         << buildTime * 1000.0 << " ms (" << std::setprecision(2) << getMPrimitivesPerSecond()
+         << " Mprims/s), SAH cost " << sahCost << std::defaultfloat << std::setprecision(precision) << std::endl;
+}
+
+f64 BvhQualityStatistics::getMeanLeafDepth() const
+{
+  ui64 depthSum = 0;
+  for (size_t depth = 0; depth < leafDepthHistogram.size(); depth++)
+  {
+    depthSum += depth * leafDepthHistogram[depth];
+  }
+  return numLeaves > 0 ? static_cast<f64>(depthSum) / static_cast<f64>(numLeaves) : 0.0;
+}
+
+BvhQualityStatistics& BvhQualityStatistics::operator+=(const BvhQualityStatistics& other)
+{
+  const ui64 totalPrimitives = numPrimitives + other.numPrimitives;
+  if (totalPrimitives > 0)
+  {
+    const f64 weight      = static_cast<f64>(numPrimitives) / static_cast<f64>(totalPrimitives);
+    const f64 otherWeight = static_cast<f64>(other.numPrimitives) / static_cast<f64>(totalPrimitives);
+    sahCost               = sahCost * weight + other.sahCost * otherWeight;
+    overlapRatio          = overlapRatio * weight + other.overlapRatio * otherWeight;
+  }
+  numPrimitives = totalPrimitives;
+  numInnerNodes += other.numInnerNodes;
+  numLeaves += other.numLeaves;
+  addHistogram(leafDepthHistogram, other.leafDepthHistogram);
+  addHistogram(leafSizeHistogram, other.leafSizeHistogram);
+  memorySize += other.memorySize;
+  return *this;
+}
+
+void BvhQualityStatistics::print(std::ostream& stream) const
+{
+  const std::streamsize precision = stream.precision();
+  stream << numPrimitives << " primitives, " << numInnerNodes << " inner nodes, " << numLeaves << " leaves, "
+         << std::fixed << std::setprecision(2) << "SAH cost " << sahCost << ", overlap ratio " << overlapRatio
+         << ", mean leaf depth " << getMeanLeafDepth() << ", " << static_cast<f64>(memorySize) / (1024.0 * 1024.0)
+         << " MiB" << std::endl;
+  printHistogram(stream, "Leaves per depth", leafDepthHistogram, numLeaves);
+  printHistogram(stream, "Leaves per number of primitives", leafSizeHistogram, numLeaves);
+  stream << std::defaultfloat << std::setprecision(precision);
+}
+
+Bvh::Bvh(const std::vector<BoundingBox>& primitiveBounds, const BvhBuildSettings& settings)
+    : m_buildSettings(settings)
+{
+  if (primitiveBounds.empty())
+  {
+    return;
+  }
+  const auto start = std::chrono::high_resolution_clock::now();
+  switch (settings.builder)
+  {
+  case BvhBuilder::BinnedSah:
+    impl::buildBinnedSahBvh(primitiveBounds, settings, m_nodes, m_primitiveIndices);
+    break;
+  case BvhBuilder::Linear:
+    impl::buildLinearBvh(primitiveBounds, settings, m_nodes, m_primitiveIndices);
+    break;
+  }
+  const auto end = std::chrono::high_resolution_clock::now();
+
+  m_buildStatistics.numPrimitives = primitiveBounds.size();
+  m_buildStatistics.numNodes      = m_nodes.size();
+  m_buildStatistics.buildTime     = std::chrono::duration<f64>(end - start).count();
+  m_buildStatistics.sahCost       = computeSahCost(settings.traversalCost, settings.intersectionCost);
+  m_sahCost                       = m_buildStatistics.sahCost;
+}
+
+Bvh::Bvh(std::vector<BvhNode> nodes, std::vector<ui32> primitiveIndices, const BvhBuildSettings& settings)
+    : m_nodes(std::move(nodes))
+    , m_primitiveIndices(std::move(primitiveIndices))
+    , m_buildSettings(settings)
+{
+  m_buildStatistics.numPrimitives = m_primitiveIndices.size();
+  m_buildStatistics.numNodes      = m_nodes.size();
+  m_buildStatistics.sahCost       = computeSahCost(settings.traversalCost, settings.intersectionCost);
+  m_sahCost                       = m_buildStatistics.sahCost;
+}
+
+const std::vector<BvhNode>& Bvh::getNodes() const
+{
+  return m_nodes;
+}
+
+const std::vector<ui32>& Bvh::getPrimitiveIndices() const
+{
+  return m_primitiveIndices;
+}
+
+BoundingBox Bvh::getBounds() const
+{
+  BoundingBox bounds;
+  if (!m_nodes.empty())
+  {
+    bounds.lowerLeftBottom = m_nodes[0].lowerLeftBottom;
+    bounds.upperRightTop   = m_nodes[0].upperRightTop;
+  }
+  return bounds;
+}
+
+bool Bvh::isEmpty() const
+{
+  return m_nodes.empty();
+}
+
+size_t Bvh::getMemorySize() const
+{
+  return m_nodes.size() * sizeof(BvhNode) + m_primitiveIndices.size() * sizeof(ui32);
+}
+
+const BvhBuildStatistics& Bvh::getBuildStatistics() const
+{
+  return m_buildStatistics;
+}
+
+const BvhBuildSettings& Bvh::getBuildSettings() const
+{
+  return m_buildSettings;
+}
+
+void Bvh::refit(const std::vector<BoundingBox>& primitiveBounds)
+{
+  if (primitiveBounds.size() != m_primitiveIndices.size())
+  {
+    throw std::runtime_error("The number of primitives of a refit BVH must not change.");
+  }
+  if (m_nodes.empty())
+  {
+    return;
+  }
+
+  // Split the tree breadth-first into a few top nodes and enough subtrees below them to keep all threads busy. Since
+  // children are listed after their parents, the top nodes are refit in reverse order after the subtrees.
+  ThreadPool&       threadPool  = m_buildSettings.threadPool ? *m_buildSettings.threadPool : ThreadPool::getGlobal();
+  const size_t      numSubtrees = 8 * static_cast<size_t>(threadPool.getNumThreads());
+  std::vector<ui32> topNodes;
+  std::vector<ui32> subtrees;
+  std::vector<ui32> queue = {0};
+  for (size_t i = 0; i < queue.size(); i++)
+  {
+    const BvhNode& node = m_nodes[queue[i]];
+    if (!node.isLeaf() && subtrees.size() + queue.size() - i < numSubtrees)
+    {
+      topNodes.push_back(queue[i]);
+      queue.push_back(node.firstIndex);
+      queue.push_back(node.firstIndex + 1);
+    }
+    else
+    {
+      subtrees.push_back(queue[i]);
+    }
+  }
+
+  std::vector<f64> subtreeCosts(subtrees.size());
+  threadPool.parallelFor(0, static_cast<ui32>(subtrees.size()), 1,
+                         [&](ui32 begin, ui32 end)
+                         {
+                           for (ui32 i = begin; i < end; i++)
+                           {
+                             subtreeCosts[i] = refitSubtree(m_nodes, m_primitiveIndices, primitiveBounds, subtrees[i],
+                                                            m_buildSettings);
+                           }
+                         });
+
+  f64 cost = 0.0;
+  for (const f64 subtreeCost : subtreeCosts)
+  {
+    cost += subtreeCost;
+  }
+  for (auto it = topNodes.rbegin(); it != topNodes.rend(); it++)
+  {
+    BvhNode&       node   = m_nodes[*it];
+    const BvhNode& left   = m_nodes[node.firstIndex];
+    const BvhNode& right  = m_nodes[node.firstIndex + 1];
+    BoundingBox    bounds = {left.lowerLeftBottom, left.upperRightTop};
+    bounds.extend({right.lowerLeftBottom, right.upperRightTop});
+    node.lowerLeftBottom = bounds.lowerLeftBottom;
+    node.upperRightTop   = bounds.upperRightTop;
+    cost += static_cast<f64>(m_buildSettings.traversalCost) * bounds.getSurfaceArea();
+  }
+
+  const f64 rootArea = getBounds().getSurfaceArea();
+  m_sahCost = rootArea > 0.0 ? cost / rootArea
+                             : m_buildSettings.intersectionCost * static_cast<f64>(m_primitiveIndices.size());
+}
+
+bool Bvh::update(const std::vector<BoundingBox>& primitiveBounds)
+{
+  refit(primitiveBounds);
+  if (m_sahCost <= m_buildStatistics.sahCost * m_buildSettings.maxRefitSahCostRatio)
+  {
+    return false;
+  }
+  *this = Bvh(primitiveBounds, m_buildSettings);
+  return true;
+}
+
+f64 Bvh::getSahCost() const
+{
+  return m_sahCost;
+}
+
+f64 Bvh::computeSahCost(f32 traversalCost, f32 intersectionCost) const
+{
+  if (m_nodes.empty())
+  {
+    return 0.0;
+  }
+  const f64 rootArea = getBounds().getSurfaceArea();
+  if (rootArea <= 0.0)
+  {
+    return intersectionCost * static_cast<f64>(m_primitiveIndices.size());
+  }
+  f64 cost = 0.0;
+  for (const auto& node : m_nodes)
+  {
+    const BoundingBox bounds = {node.lowerLeftBottom, node.upperRightTop};
+    const f64         area   = bounds.getSurfaceArea();
+    cost += node.isLeaf() ? area * intersectionCost * node.numPrimitives : area * traversalCost;
+  }
+  return cost / rootArea;
+}
+
+BvhQualityStatistics Bvh::computeQualityStatistics() const
+{
+  BvhQualityStatistics statistics;
+  statistics.numPrimitives = m_primitiveIndices.size();
+  statistics.sahCost       = computeSahCost(m_buildSettings.traversalCost, m_buildSettings.intersectionCost);
+  statistics.memorySize    = getMemorySize();
+  if (m_nodes.empty())
+  {
+    return statistics;
+  }
+
+  struct StackEntry
+  {
+    ui32 nodeIdx;
+    ui32 depth;
+  };
+  std::vector<StackEntry> stack       = {{0, 0}};
+  f64                     innerArea   = 0.0;
+  f64                     overlapArea = 0.0;
+  while (!stack.empty())
+  {
+    const StackEntry entry = stack.back();
+    stack.pop_back();
+    const BvhNode& node = m_nodes[entry.nodeIdx];
+    if (node.isLeaf())
+    {
+      std::vector<ui64>& depths = statistics.leafDepthHistogram;
+      std::vector<ui64>& sizes  = statistics.leafSizeHistogram;
+      depths.resize(std::max<size_t>(depths.size(), entry.depth + 1), 0);
+      sizes.resize(std::max<size_t>(sizes.size(), node.numPrimitives + 1), 0);
+      depths[entry.depth]++;
+      sizes[node.numPrimitives]++;
+      statistics.numLeaves++;
+      continue;
+    }
+
+    // Rays through the overlap of the children visit both of them.
+    const BvhNode&    left    = m_nodes[node.firstIndex];
+    const BvhNode&    right   = m_nodes[node.firstIndex + 1];
+    const BoundingBox overlap = {glm::max(left.lowerLeftBottom, right.lowerLeftBottom),
+                                 glm::min(left.upperRightTop, right.upperRightTop)};
+    statistics.numInnerNodes++;
+    innerArea += BoundingBox{node.lowerLeftBottom, node.upperRightTop}.getSurfaceArea();
+    overlapArea += overlap.isEmpty() ? 0.0 : overlap.getSurfaceArea();
+    stack.push_back({node.firstIndex, entry.depth + 1});
+    stack.push_back({node.firstIndex + 1, entry.depth + 1});
+  }
+  statistics.overlapRatio = innerArea > 0.0 ? overlapArea / innerArea : 0.0;
+  return statistics;
+}
+} // namespace gims
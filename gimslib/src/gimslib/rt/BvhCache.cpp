@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <gimslib/io/MemoryMappedFile.hpp>
+#include <gimslib/rt/BvhCache.hpp>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// Version of the file layout. Files of other versions are rebuilt.
+/// </summary>
+constexpr ui32 BVH_CACHE_VERSION = 2;
+
+/// <summary>
+/// Alignment of the arrays in the file, so they can be read from the mapping in place.
+/// </summary>
+constexpr ui64 BVH_CACHE_ALIGNMENT = 64;
+
+/// <summary>
+/// Header of a cache file. Everything before numNodes identifies the BVH; a file is only used if this part matches
+/// exactly. The arrays follow at the given offsets from the start of the file.
+/// </summary>
+struct BvhCacheHeader
+{
+  char magic[8];                  // "GIMSBVH" and a terminating zero.
+  ui32 version;                   // BVH_CACHE_VERSION.
+  ui32 headerSize;                // sizeof(BvhCacheHeader).
+  ui64 meshHash;                  // BvhCache::computeMeshHash() of the mesh.
+  ui32 numPrimitives;             // Number of triangles of the mesh.
+  ui32 builder;                   // BvhBuildSettings::builder.
+  ui32 maxLeafSize;               // BvhBuildSettings::maxLeafSize.
+  ui32 numBins;                   // BvhBuildSettings::numBins.
+  ui32 mortonCodeBits;            // BvhBuildSettings::mortonCodeBits.
+  ui32 treeletOptimizationPasses; // BvhBuildSettings::treeletOptimizationPasses.
+  f32  traversalCost;             // BvhBuildSettings::traversalCost.
+  f32  intersectionCost;          // BvhBuildSettings::intersectionCost.
+  ui32 leafPositionBits;          // BvhBuildSettings::leafPositionBits, which moves the vertices to a grid.
+  ui32 reserved;                  // Zero.
+  ui64 numNodes;                  // Number of BvhNode.
+  ui64 nodesOffset;               // Offset of the nodes in bytes.
+  ui64 numPrimitiveIndices;       // Number of primitive indices, equals numPrimitives.
+  ui64 primitiveIndicesOffset;    // Offset of the primitive indices in bytes.
+};
+static_assert(sizeof(BvhCacheHeader) == 96, "The header must not contain padding.");
+static_assert(sizeof(BvhNode) == 32, "The file layout assumes 32 byte nodes.");
+
+/// <summary>
+/// Size of the part of the header that identifies a BVH.
+/// </summary>
+constexpr size_t BVH_CACHE_KEY_SIZE = offsetof(BvhCacheHeader, numNodes);
+
+/// <summary>
+/// Fills the identifying part of a header.
+/// </summary>
+BvhCacheHeader createHeader(ui64 meshHash, ui32 numPrimitives, const BvhBuildSettings& settings)
+{
+  BvhCacheHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "GIMSBVH", 8);
+  header.version                   = BVH_CACHE_VERSION;
+  header.headerSize                = sizeof(BvhCacheHeader);
+  header.meshHash                  = meshHash;
+  header.numPrimitives             = numPrimitives;
+  header.builder                   = static_cast<ui32>(settings.builder);
+  header.maxLeafSize               = settings.maxLeafSize;
+  header.numBins                   = settings.numBins;
+  header.mortonCodeBits            = settings.mortonCodeBits;
+  header.treeletOptimizationPasses = settings.treeletOptimizationPasses;
+  header.traversalCost             = settings.traversalCost;
+  header.intersectionCost          = settings.intersectionCost;
+  header.leafPositionBits          = settings.leafPositionBits;
+  return header;
+}
+
+/// <summary>
+/// Rounds up to a multiple of BVH_CACHE_ALIGNMENT.
+/// </summary>
+ui64 alignOffset(ui64 offset)
+{
+  return (offset + BVH_CACHE_ALIGNMENT - 1) / BVH_CACHE_ALIGNMENT * BVH_CACHE_ALIGNMENT;
+}
+
+/// <summary>
+/// Finalizer of MurmurHash3, spreads every input bit over all output bits.
+/// </summary>
+ui64 mixBits(ui64 x)
+{
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDull;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+/// <summary>
+/// Hashes bytes eight at a time. Not cryptographic, but fast enough to hash large meshes on every start.
+/// </summary>
+ui64 hashBytes(const void* data, size_t size, ui64 seed)
+{
+  const ui8* bytes = static_cast<const ui8*>(data);
+  ui64       hash  = seed ^ (size * 0x9E3779B97F4A7C15ull);
+  size_t     i     = 0;
+  for (; i + 8 <= size; i += 8)
+  {
+    ui64 word;
+    std::memcpy(&word, bytes + i, 8);
+    hash = std::rotl(hash ^ mixBits(word), 27) * 0x9E3779B97F4A7C15ull;
+  }
+  ui64 tail = 0;
+  std::memcpy(&tail, bytes + i, size - i);
+  return mixBits(hash ^ mixBits(tail));
+}
+
+/// <summary>
+/// Returns the name of the cache file of a BVH: a hash of the identifying part of its header.
+/// </summary>
+std::string getFileName(const BvhCacheHeader& header)
+{
+  std::ostringstream stream;
+  stream << std::hex << std::setw(16) << std::setfill('0') << hashBytes(&header, BVH_CACHE_KEY_SIZE, 0) << ".bvh";
+  return stream.str();
+}
+
+/// <summary>
+/// Returns true, if the nodes form a tree that the traversals can handle: walked from the root, children have larger
+/// indices than their parent, every node is reached exactly once and no node is deeper than Bvh::MAX_DEPTH, which
+/// bounds the traversal stacks. The child indices must already be known to lie within the array.
+/// </summary>
+bool isValidTree(const std::vector<BvhNode>& nodes)
+{
+  if (nodes.empty())
+  {
+    return true;
+  }
+  struct StackEntry
+  {
+    ui32 nodeIdx;
+    ui32 depth;
+  };
+  std::vector<bool>       reached(nodes.size(), false);
+  std::vector<StackEntry> stack = {{0, 0}};
+  reached[0]                    = true;
+  while (!stack.empty())
+  {
+    const StackEntry entry = stack.back();
+    stack.pop_back();
+    if (entry.depth > Bvh::MAX_DEPTH)
+    {
+      return false;
+    }
+    const BvhNode& node = nodes[entry.nodeIdx];
+    if (node.isLeaf())
+    {
+      continue;
+    }
+    if (node.firstIndex <= entry.nodeIdx)
+    {
+      return false;
+    }
+    for (const ui32 childIdx : {node.firstIndex, node.firstIndex + 1})
+    {
+      if (reached[childIdx])
+      {
+        return false;
+      }
+      reached[childIdx] = true;
+      stack.push_back({childIdx, entry.depth + 1});
+    }
+  }
+  return std::find(reached.begin(), reached.end(), false) == reached.end();
+}
+} // namespace
+
+namespace gims
+{
+BvhCache::BvhCache(const std::filesystem::path& directory)
+    : m_directory(directory)
+{
+  std::filesystem::create_directories(m_directory);
+}
+
+BottomLevelAS BvhCache::getBottomLevelAS(const std::vector<f32v3>& positions, const std::vector<ui32>& indices,
+                                         const BvhBuildSettings& settings)
+{
+  const ui32 numTriangles = static_cast<ui32>(indices.size() / 3);
+  if (numTriangles == 0 || indices.size() % 3 != 0)
+  {
+    return BottomLevelAS(positions, indices, settings);
+  }
+
+  const ui64 meshHash = computeMeshHash(positions, indices);
+  const auto fileName = m_directory / getFileName(createHeader(meshHash, numTriangles, settings));
+  if (auto bvh = load(fileName, meshHash, numTriangles, settings))
+  {
+    m_numHits++;
+    return BottomLevelAS(positions, indices, std::move(*bvh));
+  }
+
+  m_numMisses++;
+  BottomLevelAS bottomLevelAS(positions, indices, settings);
+  try
+  {
+    save(fileName, bottomLevelAS.getBvh(), meshHash);
+  }
+  catch (const std::exception&)
+  {
+    // A cache that cannot be written only costs a rebuild on the next start.
+  }
+  return bottomLevelAS;
+}
+
+ui32 BvhCache::getNumHits() const
+{
+  return m_numHits;
+}
+
+ui32 BvhCache::getNumMisses() const
+{
+  return m_numMisses;
+}
+
+ui64 BvhCache::computeMeshHash(const std::vector<f32v3>& positions, const std::vector<ui32>& indices)
+{
+  const ui64 positionHash = hashBytes(positions.data(), positions.size() * sizeof(f32v3), 0);
+  return hashBytes(indices.data(), indices.size() * sizeof(ui32), positionHash);
+}
+
+void BvhCache::save(const std::filesystem::path& fileName, const Bvh& bvh, ui64 meshHash)
+{
+  const std::vector<BvhNode>& nodes            = bvh.getNodes();
+  const std::vector<ui32>&    primitiveIndices = bvh.getPrimitiveIndices();
+
+  BvhCacheHeader header = createHeader(meshHash, static_cast<ui32>(primitiveIndices.size()), bvh.getBuildSettings());
+  header.numNodes               = nodes.size();
+  header.nodesOffset            = alignOffset(sizeof(BvhCacheHeader));
+  header.numPrimitiveIndices    = primitiveIndices.size();
+  header.primitiveIndicesOffset = alignOffset(header.nodesOffset + nodes.size() * sizeof(BvhNode));
+
+  // Threads that build the same mesh at the same time write different temporary files.
+  auto temporaryFileName = fileName;
+  temporaryFileName += ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream file(temporaryFileName, std::ios::binary | std::ios::trunc);
+    const char    padding[BVH_CACHE_ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, static_cast<std::streamsize>(header.nodesOffset - sizeof(header)));
+    file.write(reinterpret_cast<const char*>(nodes.data()),
+               static_cast<std::streamsize>(nodes.size() * sizeof(BvhNode)));
+    file.write(padding, static_cast<std::streamsize>(header.primitiveIndicesOffset - header.nodesOffset -
+                                                     nodes.size() * sizeof(BvhNode)));
+    file.write(reinterpret_cast<const char*>(primitiveIndices.data()),
+               static_cast<std::streamsize>(primitiveIndices.size() * sizeof(ui32)));
+    if (!file)
+    {
+      file.close();
+      std::filesystem::remove(temporaryFileName);
+      throw std::runtime_error(fileName.string() + " can't be written.");
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporaryFileName, fileName, error);
+  if (error)
+  {
+    std::filesystem::remove(temporaryFileName, error);
+    throw std::runtime_error(fileName.string() + " can't be written.");
+  }
+}
+
+std::optional<Bvh> BvhCache::load(const std::filesystem::path& fileName, ui64 meshHash, ui32 numPrimitives,
+                                  const BvhBuildSettings& settings)
+{
+  if (!std::filesystem::exists(fileName))
+  {
+    return std::nullopt;
+  }
+  MemoryMappedFile file;
+  try
+  {
+    file = MemoryMappedFile(fileName);
+  }
+  catch (const std::exception&)
+  {
+    return std::nullopt;
+  }
+
+  // The identifying part of the header must match, and the arrays must lie within the file.
+  const BvhCacheHeader expected = createHeader(meshHash, numPrimitives, settings);
+  const ui8* const     data     = file.getData();
+  const ui64           size     = file.getSize();
+  BvhCacheHeader       header;
+  if (size < sizeof(header))
+  {
+    return std::nullopt;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(&header, &expected, BVH_CACHE_KEY_SIZE) != 0 || header.numPrimitiveIndices != numPrimitives ||
+      header.nodesOffset > size || header.numNodes > (size - header.nodesOffset) / sizeof(BvhNode) ||
+      header.primitiveIndicesOffset > size ||
+      header.numPrimitiveIndices > (size - header.primitiveIndicesOffset) / sizeof(ui32))
+  {
+    return std::nullopt;
+  }
+
+  std::vector<BvhNode> nodes(header.numNodes);
+  std::vector<ui32>    primitiveIndices(header.numPrimitiveIndices);
+  std::memcpy(nodes.data(), data + header.nodesOffset, nodes.size() * sizeof(BvhNode));
+  std::memcpy(primitiveIndices.data(), data + header.primitiveIndicesOffset, primitiveIndices.size() * sizeof(ui32));
+
+  // Indices out of range would make the traversal read out of bounds.
+  for (const BvhNode& node : nodes)
+  {
+    const bool valid = node.isLeaf() ? static_cast<ui64>(node.firstIndex) + node.numPrimitives <= numPrimitives
+                                     : static_cast<ui64>(node.firstIndex) + 1 < nodes.size();
+    if (!valid)
+    {
+      return std::nullopt;
+    }
+  }
+  for (const ui32 primitiveIdx : primitiveIndices)
+  {
+    if (primitiveIdx >= numPrimitives)
+    {
+      return std::nullopt;
+    }
+  }
+  // Cycles and too deep trees would make the build of the derived structures and the traversal stacks overflow.
+  if (!isValidTree(nodes))
+  {
+    return std::nullopt;
+  }
+  return Bvh(std::move(nodes), std::move(primitiveIndices), settings);
+}
+} // namespace gims
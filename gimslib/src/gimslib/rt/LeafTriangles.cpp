@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/LeafTriangles.hpp>
+#include <gimslib/sys/ThreadPool.hpp>
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// Largest 16 bit grid coordinate.
+/// </summary>
+constexpr f32 MAX_GRID_COORDINATE = 65535.0f;
+
+/// <summary>
+/// Returns the grid coordinates of the grid point closest to a position.
+/// </summary>
+f32v3 toGrid(const f32v3& position, const LeafTriangles::Grid& grid)
+{
+  const f32v3 coordinates = (position - grid.origin) / grid.spacing;
+  return f32v3(std::clamp(std::round(coordinates.x), 0.0f, MAX_GRID_COORDINATE),
+               std::clamp(std::round(coordinates.y), 0.0f, MAX_GRID_COORDINATE),
+               std::clamp(std::round(coordinates.z), 0.0f, MAX_GRID_COORDINATE));
+}
+
+/// <summary>
+/// Copies the coordinates of triangles to the planes, converting them with toCoordinate(position, axis).
+/// </summary>
+template <typename Coordinate, typename ConversionFunction>
+void fillPlanes(std::vector<Coordinate>& planes, size_t stride, const std::vector<f32v3>& positions,
+                const std::vector<ui32v3>& triangles, const std::vector<ui32>& primitiveIndices,
+                ThreadPool& threadPool, ConversionFunction&& toCoordinate)
+{
+  planes.assign(9 * stride, Coordinate(0));
+  threadPool.parallelFor(0, static_cast<ui32>(primitiveIndices.size()), 16384,
+                         [&](ui32 begin, ui32 end)
+                         {
+                           for (ui32 i = begin; i < end; i++)
+                           {
+                             const ui32v3& triangle = triangles[primitiveIndices[i]];
+                             for (ui32 vertex = 0; vertex < 3; vertex++)
+                             {
+                               const f32v3 coordinates = toCoordinate(positions[triangle[vertex]]);
+                               for (ui32 axis = 0; axis < 3; axis++)
+                               {
+                                 planes[(3 * vertex + axis) * stride + i] = static_cast<Coordinate>(coordinates[axis]);
+                               }
+                             }
+                           }
+                         });
+}
+} // namespace
+
+namespace gims
+{
+LeafTriangles::LeafTriangles(const std::vector<f32v3>& positions, const std::vector<ui32v3>& triangles,
+                             const std::vector<ui32>& primitiveIndices, const Grid* grid, ThreadPool& threadPool)
+    : m_triangleIndices(primitiveIndices)
+    , m_stride(primitiveIndices.size() + 7)
+{
+  if (grid)
+  {
+    m_grid = *grid;
+    fillPlanes(m_quantizedCoordinates, m_stride, positions, triangles, primitiveIndices, threadPool,
+               [&](const f32v3& position) { return toGrid(position, m_grid); });
+  }
+  else
+  {
+    fillPlanes(m_coordinates, m_stride, positions, triangles, primitiveIndices, threadPool,
+               [](const f32v3& position) { return position; });
+  }
+}
+
+LeafTriangles::Grid LeafTriangles::snapToGrid(std::vector<f32v3>& positions)
+{
+  BoundingBox bounds;
+  for (const f32v3& position : positions)
+  {
+    bounds.extend(position);
+  }
+  Grid grid;
+  if (bounds.isEmpty())
+  {
+    return grid;
+  }
+  const f32v3 extent = bounds.upperRightTop - bounds.lowerLeftBottom;
+  grid.origin        = bounds.lowerLeftBottom;
+  for (ui32 axis = 0; axis < 3; axis++)
+  {
+    grid.spacing[axis] = extent[axis] > 0.0f ? extent[axis] / MAX_GRID_COORDINATE : 1.0f;
+  }
+  for (f32v3& position : positions)
+  {
+    position = grid.origin + toGrid(position, grid) * grid.spacing;
+  }
+  return grid;
+}
+
+bool LeafTriangles::isQuantized() const
+{
+  return !m_quantizedCoordinates.empty();
+}
+
+const f32* LeafTriangles::getCoordinates() const
+{
+  return m_coordinates.empty() ? nullptr : m_coordinates.data();
+}
+
+const ui16* LeafTriangles::getQuantizedCoordinates() const
+{
+  return m_quantizedCoordinates.empty() ? nullptr : m_quantizedCoordinates.data();
+}
+
+size_t LeafTriangles::getStride() const
+{
+  return m_stride;
+}
+
+ui32 LeafTriangles::getNumTriangles() const
+{
+  return static_cast<ui32>(m_triangleIndices.size());
+}
+
+ui32 LeafTriangles::getTriangleIdx(ui32 i) const
+{
+  return m_triangleIndices[i];
+}
+
+const ui32* LeafTriangles::getTriangleIndices() const
+{
+  return m_triangleIndices.data();
+}
+
+Ray LeafTriangles::transformRay(const Ray& ray) const
+{
+  if (!isQuantized())
+  {
+    return ray;
+  }
+  Ray transformed       = ray;
+  transformed.origin    = (ray.origin - m_grid.origin) / m_grid.spacing;
+  transformed.direction = ray.direction / m_grid.spacing;
+  return transformed;
+}
+
+size_t LeafTriangles::getMemorySize() const
+{
+  return m_coordinates.size() * sizeof(f32) + m_quantizedCoordinates.size() * sizeof(ui16) +
+         m_triangleIndices.size() * sizeof(ui32);
+}
+} // namespace gims
@@ -0,0 +1,483 @@
+#include "impl/BvhBuilders.hpp"
+#include "impl/RadixSort.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <gimslib/sys/ThreadPool.hpp>
+
+namespace
+{
+using namespace gims;
+
+constexpr ui32 INVALID_NODE               = std::numeric_limits<ui32>::max();
+constexpr ui32 TREELET_SIZE               = 7;    // Number of leaves of the treelets that are restructured.
+constexpr ui32 PARALLEL_SUBTREE_THRESHOLD = 4096; // Subtrees with more primitives are converted as separate tasks.
+constexpr ui32 GRAIN_SIZE                 = 16384;
+
+/// <summary>
+/// Inserts two zero bits between each of the lowest 10 bits.
+/// </summary>
+ui32 expandBits(ui32 v)
+{
+  v = (v * 0x00010001u) & 0xFF0000FFu;
+  v = (v * 0x00000101u) & 0x0F00F00Fu;
+  v = (v * 0x00000011u) & 0xC30C30C3u;
+  v = (v * 0x00000005u) & 0x49249249u;
+  return v;
+}
+
+/// <summary>
+/// Inserts two zero bits between each of the lowest 21 bits.
+/// </summary>
+ui64 expandBits(ui64 v)
+{
+  v &= 0x1FFFFFull;
+  v = (v | v << 32) & 0x1F00000000FFFFull;
+  v = (v | v << 16) & 0x1F0000FF0000FFull;
+  v = (v | v << 8) & 0x100F00F00F00F00Full;
+  v = (v | v << 4) & 0x10C30C30C30C30C3ull;
+  v = (v | v << 2) & 0x1249249249249249ull;
+  return v;
+}
+
+/// <summary>
+/// Morton code of a point in the unit cube, with 10 (ui32) or 21 (ui64) bits per axis.
+/// </summary>
+template <typename Key> Key computeMortonCode(const f32v3& p)
+{
+  constexpr f32 scale = static_cast<f32>((Key(1) << (sizeof(Key) == 4 ? 10 : 21)) - 1);
+  const Key     x     = static_cast<Key>(std::clamp(p.x, 0.0f, 1.0f) * scale);
+  const Key     y     = static_cast<Key>(std::clamp(p.y, 0.0f, 1.0f) * scale);
+  const Key     z     = static_cast<Key>(std::clamp(p.z, 0.0f, 1.0f) * scale);
+  return (expandBits(x) << 2) | (expandBits(y) << 1) | expandBits(z);
+}
+
+/// <summary>
+/// LBVH construction. The intermediate binary tree has one primitive per leaf and uses the node numbering of Karras:
+/// inner nodes are 0..n-2 with the root at 0, the leaf of the i-th sorted primitive is n-1+i. It is converted into
+/// the BvhNode layout at the end, where small subtrees are collapsed into leaves.
+/// </summary>
+template <typename Key> class LinearBuilder
+{
+public:
+  LinearBuilder(const std::vector<BoundingBox>& primitiveBounds, const BvhBuildSettings& settings,
+                std::vector<BvhNode>& nodes, std::vector<ui32>& primitiveIndices)
+      : m_primitiveBounds(primitiveBounds)
+      , m_settings(settings)
+      , m_threadPool(settings.threadPool ? *settings.threadPool : ThreadPool::getGlobal())
+      , m_nodes(nodes)
+      , m_primitiveIndices(primitiveIndices)
+      , m_numPrimitives(static_cast<ui32>(primitiveBounds.size()))
+      , m_numOutputNodes(1)
+  {
+    m_settings.maxLeafSize = std::max(m_settings.maxLeafSize, 1u);
+  }
+
+  void build()
+  {
+    sortPrimitives();
+    const ui32 numNodes = 2 * m_numPrimitives - 1;
+    m_children.resize(m_numPrimitives - 1);
+    m_parents.assign(numNodes, INVALID_NODE);
+    m_bounds.resize(numNodes);
+    m_costs.resize(numNodes);
+    m_numLeaves.resize(numNodes);
+    m_threadPool.parallelFor(0, m_numPrimitives - 1, GRAIN_SIZE,
+                             [&](ui32 begin, ui32 end)
+                             {
+                               for (ui32 i = begin; i < end; i++)
+                               {
+                                 emitInnerNode(i);
+                               }
+                             });
+    const ui32 numPasses = std::max(m_settings.treeletOptimizationPasses, 1u);
+    for (ui32 pass = 0; pass < numPasses; pass++)
+    {
+      // Like Karras and Aila, restrict later passes to increasingly large subtrees, where most of the cost is.
+      refitBottomUp(m_settings.treeletOptimizationPasses > 0 ? TREELET_SIZE << pass : INVALID_NODE);
+    }
+
+    m_nodes.resize(numNodes);
+    m_primitiveIndices.resize(m_numPrimitives);
+    {
+      ThreadPool::TaskGroup taskGroup(m_threadPool);
+      convert(m_numPrimitives > 1 ? 0 : getLeaf(0), 0, 0, 1, taskGroup);
+      taskGroup.wait();
+    }
+    m_nodes.resize(m_numOutputNodes);
+  }
+
+private:
+  ui32 getLeaf(ui32 sortedPrimitiveIdx) const
+  {
+    return m_numPrimitives - 1 + sortedPrimitiveIdx;
+  }
+
+  bool isLeaf(ui32 node) const
+  {
+    return node >= m_numPrimitives - 1;
+  }
+
+  void sortPrimitives()
+  {
+    BoundingBox centroidBounds;
+    for (const auto& bounds : m_primitiveBounds)
+    {
+      centroidBounds.extend(bounds.getCenter());
+    }
+    const f32v3 offset = centroidBounds.lowerLeftBottom;
+    const f32v3 extent = centroidBounds.upperRightTop - centroidBounds.lowerLeftBottom;
+    const f32v3 scale  = 1.0f / glm::max(extent, f32v3(std::numeric_limits<f32>::min()));
+
+    m_mortonCodes.resize(m_numPrimitives);
+    m_sortedPrimitives.resize(m_numPrimitives);
+    m_threadPool.parallelFor(0, m_numPrimitives, GRAIN_SIZE,
+                             [&](ui32 begin, ui32 end)
+                             {
+                               for (ui32 i = begin; i < end; i++)
+                               {
+                                 const f32v3 p = (m_primitiveBounds[i].getCenter() - offset) * scale;
+                                 m_mortonCodes[i]      = computeMortonCode<Key>(p);
+                                 m_sortedPrimitives[i] = i;
+                               }
+                             });
+    impl::radixSort(m_mortonCodes, m_sortedPrimitives, sizeof(Key) == 4 ? 30 : 63, m_threadPool);
+  }
+
+  /// <summary>
+  /// Length of the common prefix of the codes of the sorted primitives i and j. Duplicate codes are distinguished by
+  /// the index, -1 for j out of range.
+  /// </summary>
+  i32 getCommonPrefixLength(ui32 i, i64 j) const
+  {
+    if (j < 0 || j >= m_numPrimitives)
+    {
+      return -1;
+    }
+    const Key a = m_mortonCodes[i];
+    const Key b = m_mortonCodes[static_cast<ui32>(j)];
+    if (a == b)
+    {
+      return static_cast<i32>(sizeof(Key) * 8) + std::countl_zero(i ^ static_cast<ui32>(j));
+    }
+    return std::countl_zero(a ^ b);
+  }
+
+  /// <summary>
+  /// Determines range and split of inner node i independently of all other nodes.
+  /// </summary>
+  void emitInnerNode(ui32 i)
+  {
+    const i64 d = getCommonPrefixLength(i, i64(i) + 1) > getCommonPrefixLength(i, i64(i) - 1) ? 1 : -1;
+
+    // Find the other end of the range with an exponential and a binary search.
+    const i32 minPrefixLength = getCommonPrefixLength(i, i64(i) - d);
+    i64       maxLength       = 2;
+    while (getCommonPrefixLength(i, i64(i) + maxLength * d) > minPrefixLength)
+    {
+      maxLength *= 2;
+    }
+    i64 length = 0;
+    for (i64 t = maxLength / 2; t >= 1; t /= 2)
+    {
+      if (getCommonPrefixLength(i, i64(i) + (length + t) * d) > minPrefixLength)
+      {
+        length += t;
+      }
+    }
+    const i64 j = i64(i) + length * d;
+
+    // Find the split position with a binary search for the highest differing bit.
+    const i32 nodePrefixLength = getCommonPrefixLength(i, j);
+    i64       split            = 0;
+    i64       t                = length;
+    do
+    {
+      t = (t + 1) / 2;
+      if (getCommonPrefixLength(i, i64(i) + (split + t) * d) > nodePrefixLength)
+      {
+        split += t;
+      }
+    } while (t > 1);
+    const ui32 gamma = static_cast<ui32>(i64(i) + split * d + std::min<i64>(d, 0));
+
+    const ui32 left  = std::min<i64>(i, j) == gamma ? getLeaf(gamma) : gamma;
+    const ui32 right = std::max<i64>(i, j) == gamma + 1 ? getLeaf(gamma + 1) : gamma + 1;
+    m_children[i]    = {left, right};
+    m_parents[left]  = i;
+    m_parents[right] = i;
+  }
+
+  /// <summary>
+  /// Computes bounds, leaf counts and SAH costs from the leaves to the root. The second thread that reaches an inner
+  /// node continues with it, so every node is processed once, after both of its children. Treelets are optimized at
+  /// nodes with at least minTreeletRootLeaves primitives.
+  /// </summary>
+  void refitBottomUp(ui32 minTreeletRootLeaves)
+  {
+    std::vector<std::atomic<ui32>> visits(m_numPrimitives - 1);
+    m_threadPool.parallelFor(0, m_numPrimitives, GRAIN_SIZE,
+                             [&](ui32 begin, ui32 end)
+                             {
+                               for (ui32 i = begin; i < end; i++)
+                               {
+                                 const ui32 leaf   = getLeaf(i);
+                                 m_bounds[leaf]    = m_primitiveBounds[m_sortedPrimitives[i]];
+                                 m_numLeaves[leaf] = 1;
+                                 m_costs[leaf]     = m_settings.intersectionCost * m_bounds[leaf].getSurfaceArea();
+                                 for (ui32 node = m_parents[leaf]; node != INVALID_NODE; node = m_parents[node])
+                                 {
+                                   if (visits[node].fetch_add(1, std::memory_order_acq_rel) == 0)
+                                   {
+                                     break;
+                                   }
+                                   updateNode(node);
+                                   if (m_numLeaves[node] >= minTreeletRootLeaves)
+                                   {
+                                     optimizeTreelet(node);
+                                   }
+                                 }
+                               }
+                             });
+  }
+
+  void updateNode(ui32 node)
+  {
+    const ui32 left  = m_children[node][0];
+    const ui32 right = m_children[node][1];
+    m_bounds[node]   = m_bounds[left];
+    m_bounds[node].extend(m_bounds[right]);
+    m_numLeaves[node] = m_numLeaves[left] + m_numLeaves[right];
+    m_costs[node]     = m_settings.traversalCost * m_bounds[node].getSurfaceArea() + m_costs[left] + m_costs[right];
+  }
+
+  /// <summary>
+  /// Restructures the treelet below node, i.e., node and up to five of its descendants, which are the inner nodes
+  /// of a tree over seven treelet leaves. The treelet leaves are chosen by repeatedly expanding the one with the
+  /// largest surface area. All topologies are evaluated by dynamic programming over the subsets of treelet leaves.
+  /// </summary>
+  void optimizeTreelet(ui32 node)
+  {
+    ui32 treeletLeaves[TREELET_SIZE] = {m_children[node][0], m_children[node][1]};
+    ui32 treeletNodes[TREELET_SIZE - 2];
+    ui32 numTreeletLeaves = 2;
+    ui32 numTreeletNodes  = 0;
+    while (numTreeletLeaves < TREELET_SIZE)
+    {
+      ui32 largest     = INVALID_NODE;
+      f32  largestArea = -1.0f;
+      for (ui32 i = 0; i < numTreeletLeaves; i++)
+      {
+        const f32 area = m_bounds[treeletLeaves[i]].getSurfaceArea();
+        if (!isLeaf(treeletLeaves[i]) && area > largestArea)
+        {
+          largest     = i;
+          largestArea = area;
+        }
+      }
+      if (largest == INVALID_NODE)
+      {
+        break;
+      }
+      const ui32 expanded               = treeletLeaves[largest];
+      treeletNodes[numTreeletNodes++]   = expanded;
+      treeletLeaves[largest]            = m_children[expanded][0];
+      treeletLeaves[numTreeletLeaves++] = m_children[expanded][1];
+    }
+    if (numTreeletLeaves < 3)
+    {
+      return;
+    }
+
+    const ui32  numSubsets = 1u << numTreeletLeaves;
+    BoundingBox subsetBounds[1 << TREELET_SIZE];
+    f32         subsetCosts[1 << TREELET_SIZE];
+    ui32        subsetSplits[1 << TREELET_SIZE];
+    for (ui32 subset = 1; subset < numSubsets; subset++)
+    {
+      const ui32 lowest    = std::countr_zero(subset);
+      subsetBounds[subset] = subsetBounds[subset & (subset - 1)];
+      subsetBounds[subset].extend(m_bounds[treeletLeaves[lowest]]);
+      if (std::popcount(subset) == 1)
+      {
+        subsetCosts[subset] = m_costs[treeletLeaves[lowest]];
+        continue;
+      }
+      // Enumerate the partitions into two non-empty subsets once each: the left one contains the lowest leaf.
+      f32  bestCost  = std::numeric_limits<f32>::max();
+      ui32 bestSplit = 0;
+      for (ui32 left = (subset - 1) & subset; left > 0; left = (left - 1) & subset)
+      {
+        if ((left & (1u << lowest)) == 0)
+        {
+          continue;
+        }
+        const f32 cost = subsetCosts[left] + subsetCosts[subset ^ left];
+        if (cost < bestCost)
+        {
+          bestCost  = cost;
+          bestSplit = left;
+        }
+      }
+      subsetCosts[subset]  = m_settings.traversalCost * subsetBounds[subset].getSurfaceArea() + bestCost;
+      subsetSplits[subset] = bestSplit;
+    }
+
+    const ui32 allLeaves = numSubsets - 1;
+    if (subsetCosts[allLeaves] >= m_costs[node] * 0.999f)
+    {
+      return;
+    }
+
+    // Rebuild the treelet from the best partitions, reusing the inner nodes.
+    struct Entry
+    {
+      ui32 node;
+      ui32 subset;
+    };
+    Entry entries[TREELET_SIZE - 1] = {{node, allLeaves}};
+    ui32  numEntries                = 1;
+    ui32  numUsedNodes              = 0;
+    for (ui32 e = 0; e < numEntries; e++)
+    {
+      const Entry entry      = entries[e];
+      const ui32  subsets[2] = {subsetSplits[entry.subset], entry.subset ^ subsetSplits[entry.subset]};
+      for (ui32 c = 0; c < 2; c++)
+      {
+        ui32 child;
+        if (std::popcount(subsets[c]) == 1)
+        {
+          child = treeletLeaves[std::countr_zero(subsets[c])];
+        }
+        else
+        {
+          child                 = treeletNodes[numUsedNodes++];
+          entries[numEntries++] = {child, subsets[c]};
+        }
+        m_children[entry.node][c] = child;
+        m_parents[child]          = entry.node;
+      }
+    }
+    // Children were created after their parents, so updating in reverse order processes them first.
+    for (ui32 e = numEntries; e-- > 0;)
+    {
+      updateNode(entries[e].node);
+    }
+  }
+
+  /// <summary>
+  /// Writes node of the intermediate tree to the output node outputIdx. Its primitives go to the primitive indices
+  /// starting at firstPrimitive.
+  /// </summary>
+  void convert(ui32 node, ui32 outputIdx, ui32 firstPrimitive, ui32 depth, ThreadPool::TaskGroup& taskGroup)
+  {
+    const ui32 numLeaves = m_numLeaves[node];
+    if (numLeaves <= m_settings.maxLeafSize || depth >= Bvh::MAX_DEPTH / 2)
+    {
+      // Collect the primitives of the subtree. Deep subtrees, which only arise for very unevenly distributed
+      // primitives, are built balanced over the collected primitives to stay within MAX_DEPTH.
+      std::vector<ui32> stack = {node};
+      ui32              primitive = firstPrimitive;
+      while (!stack.empty())
+      {
+        const ui32 current = stack.back();
+        stack.pop_back();
+        if (isLeaf(current))
+        {
+          m_primitiveIndices[primitive++] = m_sortedPrimitives[current - (m_numPrimitives - 1)];
+        }
+        else
+        {
+          stack.push_back(m_children[current][1]);
+          stack.push_back(m_children[current][0]);
+        }
+      }
+      emitBalanced(outputIdx, firstPrimitive, firstPrimitive + numLeaves);
+      return;
+    }
+
+    BvhNode& output        = m_nodes[outputIdx];
+    output.lowerLeftBottom = m_bounds[node].lowerLeftBottom;
+    output.upperRightTop   = m_bounds[node].upperRightTop;
+    output.numPrimitives   = 0;
+    output.firstIndex      = m_numOutputNodes.fetch_add(2);
+
+    const ui32 left       = m_children[node][0];
+    const ui32 right      = m_children[node][1];
+    const ui32 firstChild = output.firstIndex;
+    if (m_numLeaves[left] > PARALLEL_SUBTREE_THRESHOLD && m_threadPool.getNumThreads() > 1)
+    {
+      taskGroup.run([this, left, firstChild, firstPrimitive, depth, &taskGroup]()
+                    { convert(left, firstChild, firstPrimitive, depth + 1, taskGroup); });
+    }
+    else
+    {
+      convert(left, firstChild, firstPrimitive, depth + 1, taskGroup);
+    }
+    convert(right, firstChild + 1, firstPrimitive + m_numLeaves[left], depth + 1, taskGroup);
+  }
+
+  /// <summary>
+  /// Builds a balanced subtree over a range of primitive indices, which are already in leaf order.
+  /// </summary>
+  void emitBalanced(ui32 outputIdx, ui32 begin, ui32 end)
+  {
+    BoundingBox bounds;
+    for (ui32 i = begin; i < end; i++)
+    {
+      bounds.extend(m_primitiveBounds[m_primitiveIndices[i]]);
+    }
+    BvhNode& output        = m_nodes[outputIdx];
+    output.lowerLeftBottom = bounds.lowerLeftBottom;
+    output.upperRightTop   = bounds.upperRightTop;
+    if (end - begin <= m_settings.maxLeafSize)
+    {
+      output.firstIndex    = begin;
+      output.numPrimitives = end - begin;
+      return;
+    }
+    const ui32 firstChild = m_numOutputNodes.fetch_add(2);
+    const ui32 middle     = begin + (end - begin) / 2;
+    output.firstIndex     = firstChild;
+    output.numPrimitives  = 0;
+    emitBalanced(firstChild, begin, middle);
+    emitBalanced(firstChild + 1, middle, end);
+  }
+
+  const std::vector<BoundingBox>&  m_primitiveBounds;  //! Input bounds.
+  BvhBuildSettings                 m_settings;         //! Build parameters, clamped to the supported ranges.
+  ThreadPool&                      m_threadPool;       //! Pool for all parallel steps.
+  std::vector<BvhNode>&            m_nodes;            //! Output nodes.
+  std::vector<ui32>&               m_primitiveIndices; //! Output primitive indices.
+  ui32                             m_numPrimitives;    //! Number of primitives.
+  std::atomic<ui32>                m_numOutputNodes;   //! Number of allocated output nodes.
+  std::vector<Key>                 m_mortonCodes;      //! Sorted Morton codes.
+  std::vector<ui32>                m_sortedPrimitives; //! Primitive indices in Morton order.
+  std::vector<std::array<ui32, 2>> m_children;         //! Children of the inner nodes of the intermediate tree.
+  std::vector<ui32>                m_parents;          //! Parents of all nodes of the intermediate tree.
+  std::vector<BoundingBox>         m_bounds;           //! Bounds of all nodes of the intermediate tree.
+  std::vector<f32>                 m_costs;            //! SAH cost of the subtrees, not normalized by the root area.
+  std::vector<ui32>                m_numLeaves;        //! Number of primitives of the subtrees.
+};
+} // namespace
+
+namespace gims
+{
+namespace impl
+{
+void buildLinearBvh(const std::vector<BoundingBox>& primitiveBounds, const BvhBuildSettings& settings,
+                    std::vector<BvhNode>& nodes, std::vector<ui32>& primitiveIndices)
+{
+  if (settings.mortonCodeBits > 30)
+  {
+    LinearBuilder<ui64>(primitiveBounds, settings, nodes, primitiveIndices).build();
+  }
+  else
+  {
+    LinearBuilder<ui32>(primitiveBounds, settings, nodes, primitiveIndices).build();
+  }
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,168 @@
+#include "impl/BvhCollapse.hpp"
+#include <algorithm>
+#include <cmath>
+#include <gimslib/rt/QuantizedBvh.hpp>
+#include <stdexcept>
+
+namespace
+{
+using namespace gims;
+
+constexpr i32 MIN_EXPONENT = -126; // Smallest exponent of a normalized float.
+constexpr i32 MAX_EXPONENT = 127;  // Largest exponent of a float.
+
+/// <summary>
+/// Returns the smallest exponent whose scale maps an extent into [0, maxQuantized - 1]. The spare step guarantees
+/// that upper bounds can always be rounded up.
+/// </summary>
+i32 computeExponent(f32 extent, ui32 maxQuantized)
+{
+  const f32 maxSteps = static_cast<f32>(maxQuantized - 1);
+  i32       exponent = MIN_EXPONENT;
+  if (extent > 0.0f)
+  {
+    std::frexp(extent / maxSteps, &exponent);
+    exponent = std::clamp(exponent - 1, MIN_EXPONENT, MAX_EXPONENT);
+  }
+  while (exponent < MAX_EXPONENT && extent / std::ldexp(1.0f, exponent) > maxSteps)
+  {
+    exponent++;
+  }
+  return exponent;
+}
+
+/// <summary>
+/// Quantizes a lower bound by rounding down. Since q * scale is exact, the check with the decoding of the traversal
+/// is exact as well, even if the compiler contracts the decoding into a fused multiply-add.
+/// </summary>
+ui32 quantizeLower(f32 value, f32 origin, f32 scale, ui32 maxQuantized)
+{
+  ui32 q = static_cast<ui32>(std::clamp(std::floor((value - origin) / scale), 0.0f, static_cast<f32>(maxQuantized)));
+  while (q > 0 && origin + static_cast<f32>(q) * scale > value)
+  {
+    q--;
+  }
+  return q;
+}
+
+/// <summary>
+/// Quantizes an upper bound by rounding up.
+/// </summary>
+ui32 quantizeUpper(f32 value, f32 origin, f32 scale, ui32 maxQuantized)
+{
+  ui32 q = static_cast<ui32>(std::clamp(std::ceil((value - origin) / scale), 0.0f, static_cast<f32>(maxQuantized)));
+  while (q < maxQuantized && origin + static_cast<f32>(q) * scale < value)
+  {
+    q++;
+  }
+  return q;
+}
+} // namespace
+
+namespace gims
+{
+template <typename Quantized> QuantizedBvh<Quantized>::QuantizedBvh(const Bvh& bvh)
+{
+  const std::vector<BvhNode>& binaryNodes = bvh.getNodes();
+  if (binaryNodes.empty())
+  {
+    return;
+  }
+
+  // Each entry pairs a binary node with the node it is expanded into. The inner children of a node are allocated
+  // together when it is filled.
+  struct Entry
+  {
+    ui32 binaryNodeIdx;
+    ui32 nodeIdx;
+  };
+  std::vector<Entry> entries = {{0, 0}};
+  m_nodes.reserve(binaryNodes.size() / 2 + 1);
+  m_nodes.emplace_back();
+  m_primitiveIndices.reserve(bvh.getPrimitiveIndices().size());
+  for (size_t e = 0; e < entries.size(); e++)
+  {
+    ui32       children[4];
+    const ui32 numChildren = impl::selectWideChildren<4>(binaryNodes, entries[e].binaryNodeIdx, children);
+
+    BoundingBox nodeBounds;
+    for (ui32 slot = 0; slot < numChildren; slot++)
+    {
+      nodeBounds.extend(BoundingBox{binaryNodes[children[slot]].lowerLeftBottom,
+                                    binaryNodes[children[slot]].upperRightTop});
+    }
+
+    QuantizedBvhNode<Quantized> node = {};
+    node.origin                      = nodeBounds.lowerLeftBottom;
+    node.firstChild                  = static_cast<ui32>(m_nodes.size());
+    node.firstPrimitive              = static_cast<ui32>(m_primitiveIndices.size());
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      const f32 extent     = nodeBounds.upperRightTop[axis] - nodeBounds.lowerLeftBottom[axis];
+      node.exponents[axis] = static_cast<i8>(computeExponent(extent, MAX_QUANTIZED));
+      const f32 scale      = node.getScale(axis);
+      for (ui32 slot = 0; slot < 4; slot++)
+      {
+        ui32 lower = MAX_QUANTIZED;
+        ui32 upper = 0;
+        if (slot < numChildren)
+        {
+          const BvhNode& child = binaryNodes[children[slot]];
+          lower                = quantizeLower(child.lowerLeftBottom[axis], node.origin[axis], scale, MAX_QUANTIZED);
+          upper                = quantizeUpper(child.upperRightTop[axis], node.origin[axis], scale, MAX_QUANTIZED);
+        }
+        node.bounds[2 * axis + 0][slot] = static_cast<Quantized>(lower);
+        node.bounds[2 * axis + 1][slot] = static_cast<Quantized>(upper);
+      }
+    }
+
+    for (ui32 slot = 0; slot < numChildren; slot++)
+    {
+      const BvhNode& child = binaryNodes[children[slot]];
+      node.usedChildren |= static_cast<ui8>(1 << slot);
+      if (child.isLeaf())
+      {
+        if (child.numPrimitives >= QuantizedBvhNode<Quantized>::INNER_CHILD)
+        {
+          throw std::runtime_error("Leaves of a quantized BVH must have at most 254 primitives.");
+        }
+        node.childTypes[slot] = static_cast<ui8>(child.numPrimitives);
+        m_primitiveIndices.insert(m_primitiveIndices.end(),
+                                  bvh.getPrimitiveIndices().begin() + child.firstIndex,
+                                  bvh.getPrimitiveIndices().begin() + child.firstIndex + child.numPrimitives);
+      }
+      else
+      {
+        node.childTypes[slot] = QuantizedBvhNode<Quantized>::INNER_CHILD;
+        entries.push_back({children[slot], static_cast<ui32>(m_nodes.size())});
+        m_nodes.emplace_back();
+      }
+    }
+    m_nodes[entries[e].nodeIdx] = node;
+  }
+}
+
+template <typename Quantized>
+const std::vector<QuantizedBvhNode<Quantized>>& QuantizedBvh<Quantized>::getNodes() const
+{
+  return m_nodes;
+}
+
+template <typename Quantized> const std::vector<ui32>& QuantizedBvh<Quantized>::getPrimitiveIndices() const
+{
+  return m_primitiveIndices;
+}
+
+template <typename Quantized> bool QuantizedBvh<Quantized>::isEmpty() const
+{
+  return m_nodes.empty();
+}
+
+template <typename Quantized> size_t QuantizedBvh<Quantized>::getMemorySize() const
+{
+  return m_nodes.size() * sizeof(QuantizedBvhNode<Quantized>) + m_primitiveIndices.size() * sizeof(ui32);
+}
+
+template class QuantizedBvh<ui8>;
+template class QuantizedBvh<ui16>;
+} // namespace gims
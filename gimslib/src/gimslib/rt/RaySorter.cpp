@@ -0,0 +1,82 @@
+#include "impl/RadixSort.hpp"
+#include <algorithm>
+#include <cmath>
+#include <gimslib/rt/RaySorter.hpp>
+#include <numeric>
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// Spreads the lower 10 bits of v to every third bit.
+/// </summary>
+ui32 expandBits(ui32 v)
+{
+  v = (v * 0x00010001u) & 0xFF0000FFu;
+  v = (v * 0x00000101u) & 0x0F00F00Fu;
+  v = (v * 0x00000011u) & 0xC30C30C3u;
+  v = (v * 0x00000005u) & 0x49249249u;
+  return v;
+}
+
+/// <summary>
+/// Quantizes x in [0, 1] to numBits bits.
+/// </summary>
+ui32 quantize(f32 x, ui32 numBits)
+{
+  const f32 maxValue = static_cast<f32>((1u << numBits) - 1);
+  return static_cast<ui32>(std::clamp(x * maxValue + 0.5f, 0.0f, maxValue));
+}
+} // namespace
+
+namespace gims
+{
+RaySorter::RaySorter(const BoundingBox& bounds)
+{
+  if (bounds.isEmpty())
+  {
+    return;
+  }
+  const f32v3 extent = bounds.upperRightTop - bounds.lowerLeftBottom;
+  const f32   cells  = static_cast<f32>(1u << ORIGIN_BITS_PER_AXIS);
+  m_lowerLeftBottom  = bounds.lowerLeftBottom;
+  m_cellsPerUnit     = f32v3(extent.x > 0.0f ? cells / extent.x : 0.0f, extent.y > 0.0f ? cells / extent.y : 0.0f,
+                             extent.z > 0.0f ? cells / extent.z : 0.0f);
+}
+
+ui32 RaySorter::computeKey(const Ray& ray) const
+{
+  const f32v3& d      = ray.direction;
+  const ui32   octant = (d.x < 0.0f ? 1u : 0u) | (d.y < 0.0f ? 2u : 0u) | (d.z < 0.0f ? 4u : 0u);
+
+  const f32v3 cell    = glm::clamp((ray.origin - m_lowerLeftBottom) * m_cellsPerUnit, f32v3(0.0f),
+                                   f32v3(static_cast<f32>((1u << ORIGIN_BITS_PER_AXIS) - 1)));
+  const ui32  morton  = (expandBits(static_cast<ui32>(cell.z)) << 2) | (expandBits(static_cast<ui32>(cell.y)) << 1) |
+                      expandBits(static_cast<ui32>(cell.x));
+
+  // Within an octant, the direction is projected onto the plane |x| + |y| + |z| = 1, like an octahedral mapping.
+  const f32  sum = std::abs(d.x) + std::abs(d.y) + std::abs(d.z);
+  const ui32 u   = sum > 0.0f ? quantize(std::abs(d.x) / sum, DIRECTION_BITS) : 0;
+  const ui32 v   = sum > 0.0f ? quantize(std::abs(d.y) / sum, DIRECTION_BITS) : 0;
+
+  return (octant << (3 * ORIGIN_BITS_PER_AXIS + 2 * DIRECTION_BITS)) | (morton << (2 * DIRECTION_BITS)) |
+         (u << DIRECTION_BITS) | v;
+}
+
+void RaySorter::sort(std::span<const Ray> rays, std::vector<ui32>& order, ThreadPool& threadPool) const
+{
+  std::vector<ui32> keys(rays.size());
+  threadPool.parallelFor(0, static_cast<ui32>(rays.size()), 4096,
+                         [&](ui32 begin, ui32 end)
+                         {
+                           for (ui32 i = begin; i < end; i++)
+                           {
+                             keys[i] = computeKey(rays[i]);
+                           }
+                         });
+  order.resize(rays.size());
+  std::iota(order.begin(), order.end(), 0);
+  impl::radixSort(keys, order, NUM_KEY_BITS, threadPool);
+}
+} // namespace gims
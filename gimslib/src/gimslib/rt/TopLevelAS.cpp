@@ -0,0 +1,258 @@
+#include "impl/Traversal.hpp"
+#include <gimslib/rt/TopLevelAS.hpp>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// Returns the bounds of the eight transformed corners of a box.
+/// </summary>
+BoundingBox transformBounds(const BoundingBox& bounds, const f32m4& transformation)
+{
+  BoundingBox result;
+  if (bounds.isEmpty())
+  {
+    return result;
+  }
+  for (ui32 i = 0; i < 8; i++)
+  {
+    const f32v3 corner((i & 1) ? bounds.upperRightTop.x : bounds.lowerLeftBottom.x,
+                       (i & 2) ? bounds.upperRightTop.y : bounds.lowerLeftBottom.y,
+                       (i & 4) ? bounds.upperRightTop.z : bounds.lowerLeftBottom.z);
+    result.extend(f32v3(transformation * f32v4(corner, 1.0f)));
+  }
+  return result;
+}
+
+/// <summary>
+/// Transforms a ray into the object space of an instance. The interval stays the same.
+/// </summary>
+Ray transformRay(const Ray& ray, const f32m4& inverseTransformation)
+{
+  Ray result       = ray;
+  result.origin    = f32v3(inverseTransformation * f32v4(ray.origin, 1.0f));
+  result.direction = f32v3(inverseTransformation * f32v4(ray.direction, 0.0f));
+  return result;
+}
+} // namespace
+
+namespace gims
+{
+TopLevelAS::TopLevelAS(std::vector<BottomLevelAS> bottomLevelAS, std::vector<Instance> instances,
+                       const BvhBuildSettings& settings)
+    : m_bottomLevelAS(std::move(bottomLevelAS))
+    , m_instances(std::move(instances))
+{
+  m_inverseTransformations.reserve(m_instances.size());
+  for (const auto& instance : m_instances)
+  {
+    if (instance.bottomLevelASIdx >= m_bottomLevelAS.size())
+    {
+      throw std::runtime_error("Bottom level acceleration structure index out of bounds.");
+    }
+    m_inverseTransformations.emplace_back(glm::inverse(instance.transformation));
+  }
+  m_bvh = TraversalBvh(computeInstanceBounds(), settings);
+}
+
+bool TopLevelAS::updateTransformations(const std::vector<f32m4>& transformations)
+{
+  if (transformations.size() != m_instances.size())
+  {
+    throw std::runtime_error("Expected one transformation per instance.");
+  }
+  for (size_t i = 0; i < m_instances.size(); i++)
+  {
+    m_instances[i].transformation = transformations[i];
+    m_inverseTransformations[i]   = glm::inverse(transformations[i]);
+  }
+  return m_bvh.update(computeInstanceBounds());
+}
+
+bool TopLevelAS::updateBottomLevelAS(ui32 bottomLevelASIdx, const std::vector<f32v3>& positions)
+{
+  if (bottomLevelASIdx >= m_bottomLevelAS.size())
+  {
+    throw std::runtime_error("Bottom level acceleration structure index out of bounds.");
+  }
+  const bool rebuiltBottomLevel = m_bottomLevelAS[bottomLevelASIdx].update(positions);
+  const bool rebuiltTopLevel    = m_bvh.update(computeInstanceBounds());
+  return rebuiltBottomLevel || rebuiltTopLevel;
+}
+
+bool TopLevelAS::intersect(const Ray& ray, RayHit& hit, ui8 instanceInclusionMask, TraversalCounters* counters) const
+{
+  const auto intersectLeaf = [&](ui32 firstIndex, ui32 numPrimitives, f32& tMax)
+  {
+    bool leafHit = false;
+    for (ui32 i = firstIndex; i < firstIndex + numPrimitives; i++)
+    {
+      const ui32      instanceIdx = m_bvh.getPrimitiveIndices()[i];
+      const Instance& instance    = m_instances[instanceIdx];
+      if ((instance.mask & instanceInclusionMask) == 0)
+      {
+        continue;
+      }
+      Ray objectRay  = transformRay(ray, m_inverseTransformations[instanceIdx]);
+      objectRay.tMax = tMax;
+      if (m_bottomLevelAS[instance.bottomLevelASIdx].intersect(objectRay, hit, counters))
+      {
+        hit.instanceIdx = instanceIdx;
+        hit.instanceID  = instance.instanceID;
+        tMax            = hit.t;
+        leafHit         = true;
+      }
+    }
+    return leafHit;
+  };
+  f32 tMax = std::min(ray.tMax, hit.t);
+  return impl::traverse<false>(m_bvh, ray, tMax, intersectLeaf, counters);
+}
+
+void TopLevelAS::intersect(RayBatch& batch) const
+{
+  batch.hits.resize(batch.rays.size());
+  intersect(batch.rays, batch.hits, batch.traversal, batch.instanceInclusionMask);
+}
+
+void TopLevelAS::intersect(std::span<const Ray> rays, std::span<RayHit> hits, RayBatchTraversal traversal,
+                           ui8 instanceInclusionMask) const
+{
+  if (hits.size() != rays.size())
+  {
+    throw std::runtime_error("Expected one hit per ray.");
+  }
+  const std::vector<ui32>& primitiveIndices = m_bvh.getBvh().getPrimitiveIndices();
+  std::vector<Ray>         objectRays;
+  std::vector<RayHit>      objectHits;
+  const auto intersectLeaf = [&](ui32 firstIndex, ui32 numPrimitives, const ui32* rayIndices, ui32 numRayIndices,
+                                 f32* tMax)
+  {
+    for (ui32 i = firstIndex; i < firstIndex + numPrimitives; i++)
+    {
+      const ui32      instanceIdx = primitiveIndices[i];
+      const Instance& instance    = m_instances[instanceIdx];
+      if ((instance.mask & instanceInclusionMask) == 0)
+      {
+        continue;
+      }
+      objectRays.resize(numRayIndices);
+      objectHits.assign(numRayIndices, RayHit());
+      for (ui32 j = 0; j < numRayIndices; j++)
+      {
+        objectRays[j]      = transformRay(rays[rayIndices[j]], m_inverseTransformations[instanceIdx]);
+        objectRays[j].tMax = tMax[rayIndices[j]];
+      }
+      m_bottomLevelAS[instance.bottomLevelASIdx].intersect(objectRays, objectHits, traversal);
+      for (ui32 j = 0; j < numRayIndices; j++)
+      {
+        if (objectHits[j].isHit())
+        {
+          hits[rayIndices[j]]             = objectHits[j];
+          hits[rayIndices[j]].instanceIdx = instanceIdx;
+          hits[rayIndices[j]].instanceID  = instance.instanceID;
+          tMax[rayIndices[j]]             = objectHits[j].t;
+        }
+      }
+    }
+  };
+  impl::traverseBatch(m_bvh.getBvh(), traversal, rays, hits, intersectLeaf);
+}
+
+bool TopLevelAS::occluded(const Ray& ray, ui8 instanceInclusionMask) const
+{
+  Occluder lastOccluder;
+  return occluded(ray, lastOccluder, instanceInclusionMask);
+}
+
+bool TopLevelAS::occluded(const Ray& ray, Occluder& lastOccluder, ui8 instanceInclusionMask,
+                          TraversalCounters* counters) const
+{
+  const ui32 lastInstanceIdx = lastOccluder.instanceIdx;
+  if (lastInstanceIdx < m_instances.size() && (m_instances[lastInstanceIdx].mask & instanceInclusionMask) != 0 &&
+      m_bottomLevelAS[m_instances[lastInstanceIdx].bottomLevelASIdx].isOccludedBy(
+          transformRay(ray, m_inverseTransformations[lastInstanceIdx]), lastOccluder, counters))
+  {
+    return true;
+  }
+  const auto intersectLeaf = [&](ui32 firstIndex, ui32 numPrimitives, f32&)
+  {
+    for (ui32 i = firstIndex; i < firstIndex + numPrimitives; i++)
+    {
+      const ui32      instanceIdx = m_bvh.getPrimitiveIndices()[i];
+      const Instance& instance    = m_instances[instanceIdx];
+      if ((instance.mask & instanceInclusionMask) == 0)
+      {
+        continue;
+      }
+      Occluder objectOccluder = {};
+      if (m_bottomLevelAS[instance.bottomLevelASIdx].occluded(
+              transformRay(ray, m_inverseTransformations[instanceIdx]), objectOccluder, counters))
+      {
+        lastOccluder             = objectOccluder;
+        lastOccluder.instanceIdx = instanceIdx;
+        return true;
+      }
+    }
+    return false;
+  };
+  f32 tMax = ray.tMax;
+  return impl::traverse<true>(m_bvh, ray, tMax, intersectLeaf, counters);
+}
+
+BoundingBox TopLevelAS::getBounds() const
+{
+  return m_bvh.getBounds();
+}
+
+const std::vector<TopLevelAS::Instance>& TopLevelAS::getInstances() const
+{
+  return m_instances;
+}
+
+ui32 TopLevelAS::getNumBottomLevelAS() const
+{
+  return static_cast<ui32>(m_bottomLevelAS.size());
+}
+
+const BottomLevelAS& TopLevelAS::getBottomLevelAS(ui32 bottomLevelASIdx) const
+{
+  return m_bottomLevelAS[bottomLevelASIdx];
+}
+
+const Bvh& TopLevelAS::getBvh() const
+{
+  return m_bvh.getBvh();
+}
+
+const TraversalBvh& TopLevelAS::getTraversalBvh() const
+{
+  return m_bvh;
+}
+
+size_t TopLevelAS::getMemorySize() const
+{
+  size_t memorySize = m_instances.size() * sizeof(Instance) + m_inverseTransformations.size() * sizeof(f32m4) +
+                      m_bvh.getMemorySize();
+  for (const auto& bottomLevelAS : m_bottomLevelAS)
+  {
+    memorySize += bottomLevelAS.getMemorySize();
+  }
+  return memorySize;
+}
+
+std::vector<BoundingBox> TopLevelAS::computeInstanceBounds() const
+{
+  std::vector<BoundingBox> instanceBounds;
+  instanceBounds.reserve(m_instances.size());
+  for (const auto& instance : m_instances)
+  {
+    instanceBounds.emplace_back(
+        transformBounds(m_bottomLevelAS[instance.bottomLevelASIdx].getBounds(), instance.transformation));
+  }
+  return instanceBounds;
+}
+} // namespace gims
@@ -0,0 +1,110 @@
+#include <gimslib/rt/TraversalBvh.hpp>
+#include <stdexcept>
+#include <utility>
+
+namespace gims
+{
+TraversalBvh::TraversalBvh(const std::vector<BoundingBox>& primitiveBounds, const BvhBuildSettings& settings)
+    : m_bvh(primitiveBounds, settings)
+{
+  deriveTraversalLayout();
+}
+
+TraversalBvh::TraversalBvh(Bvh bvh)
+    : m_bvh(std::move(bvh))
+{
+  deriveTraversalLayout();
+}
+
+bool TraversalBvh::update(const std::vector<BoundingBox>& primitiveBounds)
+{
+  const bool rebuilt = m_bvh.update(primitiveBounds);
+  deriveTraversalLayout();
+  return rebuilt;
+}
+
+const Bvh& TraversalBvh::getBvh() const
+{
+  return m_bvh;
+}
+
+const Bvh4& TraversalBvh::getBvh4() const
+{
+  return m_bvh4;
+}
+
+const Bvh8& TraversalBvh::getBvh8() const
+{
+  return m_bvh8;
+}
+
+const QuantizedBvh<ui8>& TraversalBvh::getQuantizedBvh8() const
+{
+  return m_quantizedBvh8;
+}
+
+const QuantizedBvh<ui16>& TraversalBvh::getQuantizedBvh16() const
+{
+  return m_quantizedBvh16;
+}
+
+const std::vector<ui32>& TraversalBvh::getPrimitiveIndices() const
+{
+  if (!m_quantizedBvh8.isEmpty())
+  {
+    return m_quantizedBvh8.getPrimitiveIndices();
+  }
+  if (!m_quantizedBvh16.isEmpty())
+  {
+    return m_quantizedBvh16.getPrimitiveIndices();
+  }
+  return m_bvh.getPrimitiveIndices();
+}
+
+BoundingBox TraversalBvh::getBounds() const
+{
+  return m_bvh.getBounds();
+}
+
+size_t TraversalBvh::getMemorySize() const
+{
+  return m_bvh.getMemorySize() + m_bvh4.getMemorySize() + m_bvh8.getMemorySize() + m_quantizedBvh8.getMemorySize() +
+         m_quantizedBvh16.getMemorySize();
+}
+
+void TraversalBvh::deriveTraversalLayout()
+{
+  m_bvh4           = Bvh4();
+  m_bvh8           = Bvh8();
+  m_quantizedBvh8  = QuantizedBvh<ui8>();
+  m_quantizedBvh16 = QuantizedBvh<ui16>();
+
+  const BvhBuildSettings& settings = m_bvh.getBuildSettings();
+  switch (settings.quantizationBits)
+  {
+  case 0:
+    break;
+  case 8:
+    m_quantizedBvh8 = QuantizedBvh<ui8>(m_bvh);
+    return;
+  case 16:
+    m_quantizedBvh16 = QuantizedBvh<ui16>(m_bvh);
+    return;
+  default:
+    throw std::runtime_error("The number of quantization bits must be 0, 8 or 16.");
+  }
+  switch (settings.branchingFactor)
+  {
+  case 2:
+    break;
+  case 4:
+    m_bvh4 = Bvh4(m_bvh);
+    break;
+  case 8:
+    m_bvh8 = Bvh8(m_bvh);
+    break;
+  default:
+    throw std::runtime_error("The branching factor must be 2, 4 or 8.");
+  }
+}
+} // namespace gims
@@ -0,0 +1,93 @@
+#include "impl/BvhCollapse.hpp"
+#include <gimslib/rt/WideBvh.hpp>
+#include <limits>
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// Sets the bounds of a child slot.
+/// </summary>
+template <ui32 Width>
+void setChildBounds(WideBvhNode<Width>& node, ui32 slot, const f32v3& lowerLeftBottom, const f32v3& upperRightTop)
+{
+  for (ui32 axis = 0; axis < 3; axis++)
+  {
+    node.bounds[2 * axis + 0][slot] = lowerLeftBottom[axis];
+    node.bounds[2 * axis + 1][slot] = upperRightTop[axis];
+  }
+}
+} // namespace
+
+namespace gims
+{
+template <ui32 Width> WideBvh<Width>::WideBvh(const Bvh& bvh)
+{
+  const std::vector<BvhNode>& binaryNodes = bvh.getNodes();
+  if (binaryNodes.empty())
+  {
+    return;
+  }
+
+  // Each entry pairs a binary node with the wide node it is expanded into. Wide nodes are allocated when their parent
+  // is filled, so children are stored after their parents.
+  struct Entry
+  {
+    ui32 binaryNodeIdx;
+    ui32 nodeIdx;
+  };
+  std::vector<Entry> entries = {{0, 0}};
+  m_nodes.reserve(binaryNodes.size() / (Width / 2) + 1);
+  m_nodes.emplace_back();
+  for (size_t e = 0; e < entries.size(); e++)
+  {
+    ui32       children[Width];
+    const ui32 numChildren = impl::selectWideChildren<Width>(binaryNodes, entries[e].binaryNodeIdx, children);
+
+    WideBvhNode<Width> node;
+    for (ui32 slot = 0; slot < Width; slot++)
+    {
+      if (slot >= numChildren)
+      {
+        setChildBounds(node, slot, f32v3(std::numeric_limits<f32>::max()), f32v3(-std::numeric_limits<f32>::max()));
+        node.children[slot]      = 0;
+        node.numPrimitives[slot] = 0;
+        continue;
+      }
+      const BvhNode& child = binaryNodes[children[slot]];
+      setChildBounds(node, slot, child.lowerLeftBottom, child.upperRightTop);
+      node.numPrimitives[slot] = child.numPrimitives;
+      if (child.isLeaf())
+      {
+        node.children[slot] = child.firstIndex;
+      }
+      else
+      {
+        node.children[slot] = static_cast<ui32>(m_nodes.size());
+        entries.push_back({children[slot], node.children[slot]});
+        m_nodes.emplace_back();
+      }
+    }
+    m_nodes[entries[e].nodeIdx] = node;
+  }
+}
+
+template <ui32 Width> const std::vector<WideBvhNode<Width>>& WideBvh<Width>::getNodes() const
+{
+  return m_nodes;
+}
+
+template <ui32 Width> bool WideBvh<Width>::isEmpty() const
+{
+  return m_nodes.empty();
+}
+
+template <ui32 Width> size_t WideBvh<Width>::getMemorySize() const
+{
+  return m_nodes.size() * sizeof(WideBvhNode<Width>);
+}
+
+template class WideBvh<4>;
+template class WideBvh<8>;
+} // namespace gims
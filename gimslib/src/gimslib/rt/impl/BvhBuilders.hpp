@@ -0,0 +1,17 @@
+#pragma once
+#include <gimslib/rt/Bvh.hpp>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Builds a BVH with BvhBuilder::BinnedSah. Node 0 is the root, siblings are adjacent.
+void buildBinnedSahBvh(const std::vector<BoundingBox>& primitiveBounds, const BvhBuildSettings& settings,
+                       std::vector<BvhNode>& nodes, std::vector<ui32>& primitiveIndices);
+
+//! \brief Builds a BVH with BvhBuilder::Linear. Node 0 is the root, siblings are adjacent.
+void buildLinearBvh(const std::vector<BoundingBox>& primitiveBounds, const BvhBuildSettings& settings,
+                    std::vector<BvhNode>& nodes, std::vector<ui32>& primitiveIndices);
+} // namespace impl
+} // namespace gims
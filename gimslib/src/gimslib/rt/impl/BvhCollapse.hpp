@@ -0,0 +1,45 @@
+#pragma once
+#include <gimslib/rt/Bvh.hpp>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Selects the children of a wide node that replaces a binary node: starting with the binary node itself, the
+//! inner node with the largest surface area is replaced by its two children until there are Width nodes or only
+//! leaves. A binary leaf stays the only child.
+//! \param[in]  nodes Nodes of the binary BVH.
+//! \param[in]  nodeIdx The binary node.
+//! \param[out]  children Indices of the selected binary nodes.
+//! \return The number of selected children.
+template <ui32 Width> ui32 selectWideChildren(const std::vector<BvhNode>& nodes, ui32 nodeIdx, ui32 children[Width])
+{
+  children[0]      = nodeIdx;
+  ui32 numChildren = 1;
+  while (numChildren < Width)
+  {
+    ui32 largest     = Width;
+    f32  largestArea = -1.0f;
+    for (ui32 i = 0; i < numChildren; i++)
+    {
+      const BvhNode& child = nodes[children[i]];
+      const f32      area  = BoundingBox{child.lowerLeftBottom, child.upperRightTop}.getSurfaceArea();
+      if (!child.isLeaf() && area > largestArea)
+      {
+        largest     = i;
+        largestArea = area;
+      }
+    }
+    if (largest == Width)
+    {
+      break;
+    }
+    const ui32 firstChild   = nodes[children[largest]].firstIndex;
+    children[largest]       = firstChild;
+    children[numChildren++] = firstChild + 1;
+  }
+  return numChildren;
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/Ray.hpp>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Scale of the exit distances of all slab tests. Rounding may otherwise cull a box whose triangles the
+//! watertight triangle test hits, e.g., a flat box or a triangle on the box surface. Ize, "Robust BVH Ray Traversal",
+//! JCGT 2013, shows that 1 + 2 * gamma(3) covers the error of the slab test; the margin is larger since the distances
+//! that the triangle test computes are rounded, too.
+constexpr f32 SLAB_EXIT_SCALE = 1.0f + 0x1.0p-16f;
+
+//! \brief Per-ray constants of the slab test.
+struct RayBoxData
+{
+  f32v3 origin;
+  f32v3 inverseDirection;
+
+  explicit RayBoxData(const Ray& ray)
+      : origin(ray.origin)
+      , inverseDirection(1.0f / ray.direction)
+  {
+  }
+};
+
+//! \brief Slab test. Returns the entry distance, or infinity if the interval [tMin, tMax] misses the box.
+inline f32 intersectBox(const BvhNode& node, const RayBoxData& ray, f32 tMin, f32 tMax)
+{
+  const f32v3 t0    = (node.lowerLeftBottom - ray.origin) * ray.inverseDirection;
+  const f32v3 t1    = (node.upperRightTop - ray.origin) * ray.inverseDirection;
+  const f32v3 tNear = glm::min(t0, t1);
+  const f32v3 tFar  = glm::max(t0, t1);
+  const f32   entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, tMin));
+  const f32   exit  = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+  return entry <= exit * SLAB_EXIT_SCALE ? entry : std::numeric_limits<f32>::infinity();
+}
+
+//! \brief Depth-first traversal of a BVH, near child first.
+//!
+//! intersectLeaf(firstIndex, numPrimitives, tMax) intersects the primitives of a leaf, shortens tMax to the closest
+//! hit and returns true, if it found a hit. With AnyHit, traversal stops at the first hit. If counters is not null,
+//! the visited nodes are added to it.
+//! \return True, if any leaf reported a hit.
+template <bool AnyHit, typename LeafFunction>
+bool traverseBvh(const Bvh& bvh, const Ray& ray, f32& tMax, LeafFunction&& intersectLeaf,
+                 TraversalCounters* counters = nullptr)
+{
+  const std::vector<BvhNode>& nodes = bvh.getNodes();
+  if (nodes.empty())
+  {
+    return false;
+  }
+  const RayBoxData rayBoxData(ray);
+  if (intersectBox(nodes[0], rayBoxData, ray.tMin, tMax) == std::numeric_limits<f32>::infinity())
+  {
+    return false;
+  }
+
+  struct StackEntry
+  {
+    ui32 nodeIdx;
+    f32  tEntry;
+  };
+  StackEntry stack[Bvh::MAX_DEPTH];
+  ui32       stackSize = 0;
+  bool       hit       = false;
+  ui32       nodeIdx   = 0;
+  while (true)
+  {
+    const BvhNode& node = nodes[nodeIdx];
+    if (counters)
+    {
+      counters->numNodesVisited++;
+    }
+    if (node.isLeaf())
+    {
+      if (intersectLeaf(node.firstIndex, node.numPrimitives, tMax))
+      {
+        hit = true;
+        if constexpr (AnyHit)
+        {
+          return true;
+        }
+      }
+    }
+    else
+    {
+      f32  tNear = intersectBox(nodes[node.firstIndex], rayBoxData, ray.tMin, tMax);
+      f32  tFar  = intersectBox(nodes[node.firstIndex + 1], rayBoxData, ray.tMin, tMax);
+      ui32 near  = node.firstIndex;
+      ui32 far   = node.firstIndex + 1;
+      if (tFar < tNear)
+      {
+        std::swap(tNear, tFar);
+        std::swap(near, far);
+      }
+      if (tNear != std::numeric_limits<f32>::infinity())
+      {
+        if (tFar != std::numeric_limits<f32>::infinity())
+        {
+          stack[stackSize++] = {far, tFar};
+        }
+        nodeIdx = near;
+        continue;
+      }
+    }
+
+    // Pop the next node, skipping nodes that lie behind the closest hit found in the meantime. The entry distance is
+    // rounded like the one of the slab test, so the same margin applies.
+    do
+    {
+      if (stackSize == 0)
+      {
+        return hit;
+      }
+      stackSize--;
+    } while (stack[stackSize].tEntry > tMax * SLAB_EXIT_SCALE);
+    nodeIdx = stack[stackSize].nodeIdx;
+  }
+}
+} // namespace impl
+} // namespace gims
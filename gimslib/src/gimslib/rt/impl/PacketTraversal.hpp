@@ -0,0 +1,233 @@
+#pragma once
+#include "BvhTraversal.hpp"
+#include "Simd.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/Ray.hpp>
+#include <limits>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief SIMD type for the slab tests of a packet: AVX registers of eight rays if available, SSE registers otherwise.
+#ifdef GIMS_RT_AVX2
+using PacketLanes = f32x8;
+#else
+using PacketLanes = f32x4;
+#endif
+
+//! \brief Per-packet constants of the slab tests of Size rays in SoA layout.
+template <ui32 Size> struct RayPacket
+{
+  static constexpr ui32 NUM_GROUPS = Size / PacketLanes::SIZE;
+
+  PacketLanes origin[3][NUM_GROUPS];           //! Ray origins.
+  PacketLanes inverseDirection[3][NUM_GROUPS]; //! Inverse ray directions.
+  PacketLanes isNegative[3][NUM_GROUPS];       //! All bits set where the inverse direction is negative.
+  PacketLanes tMin[NUM_GROUPS];                //! Start of the ray intervals, infinity for missing rays.
+
+  //! \brief Loads 1 to Size rays. The slab tests of missing rays never hit.
+  RayPacket(const Ray* rays, ui32 numRays)
+  {
+    const f32       allBits = std::bit_cast<f32>(~0u);
+    alignas(32) f32 values[3][3][Size];
+    alignas(32) f32 tMins[Size];
+    for (ui32 i = 0; i < Size; i++)
+    {
+      const Ray&  ray     = rays[std::min(i, numRays - 1)];
+      const f32v3 inverse = 1.0f / ray.direction;
+      for (ui32 axis = 0; axis < 3; axis++)
+      {
+        values[0][axis][i] = ray.origin[axis];
+        values[1][axis][i] = inverse[axis];
+        values[2][axis][i] = inverse[axis] < 0.0f ? allBits : 0.0f;
+      }
+      tMins[i] = i < numRays ? ray.tMin : std::numeric_limits<f32>::infinity();
+    }
+    for (ui32 g = 0; g < NUM_GROUPS; g++)
+    {
+      for (ui32 axis = 0; axis < 3; axis++)
+      {
+        origin[axis][g]           = PacketLanes::load(&values[0][axis][g * PacketLanes::SIZE]);
+        inverseDirection[axis][g] = PacketLanes::load(&values[1][axis][g * PacketLanes::SIZE]);
+        isNegative[axis][g]       = PacketLanes::load(&values[2][axis][g * PacketLanes::SIZE]);
+      }
+      tMin[g] = PacketLanes::load(&tMins[g * PacketLanes::SIZE]);
+    }
+  }
+};
+
+//! \brief Interval bounds of the origins and inverse directions of a packet, which reject nodes that all rays miss
+//! with a single slab test.
+struct PacketIntervals
+{
+  bool  isValid = true; //! False, if an axis has inverse directions of both signs or infinite ones.
+  f32v3 originMin;
+  f32v3 originMax;
+  f32v3 inverseDirectionMin;
+  f32v3 inverseDirectionMax;
+  f32   tMin;
+
+  PacketIntervals(const Ray* rays, ui32 numRays)
+      : originMin(rays[0].origin)
+      , originMax(rays[0].origin)
+      , inverseDirectionMin(1.0f / rays[0].direction)
+      , inverseDirectionMax(1.0f / rays[0].direction)
+      , tMin(rays[0].tMin)
+  {
+    for (ui32 i = 1; i < numRays; i++)
+    {
+      const f32v3 inverse = 1.0f / rays[i].direction;
+      originMin           = glm::min(originMin, rays[i].origin);
+      originMax           = glm::max(originMax, rays[i].origin);
+      inverseDirectionMin = glm::min(inverseDirectionMin, inverse);
+      inverseDirectionMax = glm::max(inverseDirectionMax, inverse);
+      tMin                = std::min(tMin, rays[i].tMin);
+    }
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      isValid = isValid && std::isfinite(inverseDirectionMin[axis]) && std::isfinite(inverseDirectionMax[axis]) &&
+                (inverseDirectionMax[axis] < 0.0f || inverseDirectionMin[axis] > 0.0f);
+    }
+  }
+
+  //! \brief Returns true, if no ray of the packet hits the node in [tMin, tMax].
+  //!
+  //! Each axis bounds (plane - origin) * inverseDirection over all rays by the products of the interval ends. Since
+  //! rounding is monotonic, the bounds also hold for the rounded per-ray values of intersectPacket().
+  bool missesNode(const BvhNode& node, f32 tMax) const
+  {
+    f32 entry = tMin;
+    f32 exit  = tMax;
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      const bool negative = inverseDirectionMax[axis] < 0.0f;
+      const f32  near     = negative ? node.upperRightTop[axis] : node.lowerLeftBottom[axis];
+      const f32  far      = negative ? node.lowerLeftBottom[axis] : node.upperRightTop[axis];
+      const f32  i0       = inverseDirectionMin[axis];
+      const f32  i1       = inverseDirectionMax[axis];
+      const f32  n0       = near - originMax[axis];
+      const f32  n1       = near - originMin[axis];
+      const f32  f0       = far - originMax[axis];
+      const f32  f1       = far - originMin[axis];
+      entry = std::max(entry, std::min(std::min(n0 * i0, n0 * i1), std::min(n1 * i0, n1 * i1)));
+      exit  = std::min(exit, std::max(std::max(f0 * i0, f0 * i1), std::max(f1 * i0, f1 * i1)));
+    }
+    return entry > exit * SLAB_EXIT_SCALE;
+  }
+};
+
+//! \brief Slab test of all rays of a packet. Returns a bit mask of the rays that hit the node in [tMin, tMax].
+template <ui32 Size> ui32 intersectPacket(const BvhNode& node, const RayPacket<Size>& packet, const f32* tMax)
+{
+  ui32 mask = 0;
+  for (ui32 g = 0; g < RayPacket<Size>::NUM_GROUPS; g++)
+  {
+    // The near and far planes are selected per ray by the direction signs. NaNs from 0 * infinity, i.e., rays in a
+    // plane of the box, are dropped by passing the running interval as the second operand of min and max.
+    PacketLanes entry = packet.tMin[g];
+    PacketLanes exit  = PacketLanes::load(tMax + g * PacketLanes::SIZE);
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      const PacketLanes lower(node.lowerLeftBottom[axis]);
+      const PacketLanes upper(node.upperRightTop[axis]);
+      const PacketLanes tNear = (select(packet.isNegative[axis][g], lower, upper) - packet.origin[axis][g]) *
+                                packet.inverseDirection[axis][g];
+      const PacketLanes tFar = (select(packet.isNegative[axis][g], upper, lower) - packet.origin[axis][g]) *
+                               packet.inverseDirection[axis][g];
+      entry = max(tNear, entry);
+      exit  = min(tFar, exit);
+    }
+    mask |= lessEqualMask(entry, exit * PacketLanes(SLAB_EXIT_SCALE)) << (g * PacketLanes::SIZE);
+  }
+  return mask;
+}
+
+//! \brief Depth-first traversal of a BVH with a packet of up to Size coherent rays, near child first.
+//!
+//! A node is skipped if the interval bounds of the packet miss it, otherwise all rays are tested at once and the
+//! node is skipped if none of them hits it. Only the rays that hit a node are passed on to its children.
+//!
+//! intersectLeaf(firstIndex, numPrimitives, rayIndices, numRayIndices, tMax) intersects the primitives of a leaf with
+//! the rays rays[rayIndices[i]] and shortens tMax[rayIndices[i]] to their closest hits.
+//! \param[in]  rays All rays of the batch.
+//! \param[in,out]  tMax End of the interval of every ray of the batch.
+//! \param[in]  firstRay Index of the first ray of the packet.
+//! \param[in]  numRays Number of rays of the packet, 1 to Size.
+template <ui32 Size, typename LeafFunction>
+void traversePacket(const Bvh& bvh, const Ray* rays, f32* tMax, ui32 firstRay, ui32 numRays,
+                    LeafFunction&& intersectLeaf)
+{
+  const std::vector<BvhNode>& nodes = bvh.getNodes();
+  if (nodes.empty())
+  {
+    return;
+  }
+  const RayPacket<Size> packet(rays + firstRay, numRays);
+  const PacketIntervals intervals(rays + firstRay, numRays);
+  const f32v3&          direction = rays[firstRay].direction;
+
+  // Missing rays get an empty interval. The copy is refreshed after every leaf.
+  alignas(32) f32 packetTMax[Size];
+  for (ui32 i = 0; i < Size; i++)
+  {
+    packetTMax[i] = i < numRays ? tMax[firstRay + i] : -std::numeric_limits<f32>::infinity();
+  }
+
+  struct StackEntry
+  {
+    ui32 nodeIdx;
+    ui32 mask; //! Rays that hit the parent.
+  };
+  StackEntry stack[Bvh::MAX_DEPTH + 1];
+  ui32       stackSize = 0;
+  stack[stackSize++]   = {0, (1u << numRays) - 1};
+  while (stackSize > 0)
+  {
+    const StackEntry entry = stack[--stackSize];
+    const BvhNode&   node  = nodes[entry.nodeIdx];
+    if (intervals.isValid && intervals.missesNode(node, *std::max_element(packetTMax, packetTMax + Size)))
+    {
+      continue;
+    }
+    const ui32 mask = intersectPacket(node, packet, packetTMax) & entry.mask;
+    if (mask == 0)
+    {
+      continue;
+    }
+
+    if (node.isLeaf())
+    {
+      ui32 rayIndices[Size];
+      ui32 numRayIndices = 0;
+      for (ui32 bits = mask; bits != 0; bits &= bits - 1)
+      {
+        rayIndices[numRayIndices++] = firstRay + static_cast<ui32>(std::countr_zero(bits));
+      }
+      intersectLeaf(node.firstIndex, node.numPrimitives, rayIndices, numRayIndices, tMax);
+      for (ui32 i = 0; i < numRayIndices; i++)
+      {
+        packetTMax[rayIndices[i] - firstRay] = tMax[rayIndices[i]];
+      }
+      continue;
+    }
+
+    ui32           near       = node.firstIndex;
+    ui32           far        = node.firstIndex + 1;
+    const BvhNode& nearNode   = nodes[near];
+    const BvhNode& farNode    = nodes[far];
+    const f32v3    centerDiff = (farNode.lowerLeftBottom + farNode.upperRightTop) -
+                             (nearNode.lowerLeftBottom + nearNode.upperRightTop);
+    if (glm::dot(centerDiff, direction) < 0.0f)
+    {
+      std::swap(near, far);
+    }
+    stack[stackSize++] = {far, mask};
+    stack[stackSize++] = {near, mask};
+  }
+}
+} // namespace impl
+} // namespace gims
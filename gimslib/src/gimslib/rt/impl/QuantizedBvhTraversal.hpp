@@ -0,0 +1,71 @@
+#pragma once
+#include "Simd.hpp"
+#include "WideBvhTraversal.hpp"
+#include <bit>
+#include <gimslib/rt/QuantizedBvh.hpp>
+#include <gimslib/rt/Ray.hpp>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Slab test of the decoded bounds of all children of a quantized node. Writes the entry distances and returns
+//! a bit mask of the used children whose bounds are hit in [tMin, tMax].
+template <typename Quantized>
+ui32 intersectChildren(const QuantizedBvhNode<Quantized>& node, const WideRayBoxData<4>& ray, f32 tMin, f32 tMax,
+                       f32* tEntry)
+{
+  // NaNs from 0 * infinity are dropped by passing the running interval as the second operand of min and max.
+  f32x4 entry(tMin);
+  f32x4 exit(tMax);
+  for (ui32 axis = 0; axis < 3; axis++)
+  {
+    const f32x4 scale(node.getScale(axis));
+    const f32x4 origin(node.origin[axis]);
+    const f32x4 near = loadUnsigned(node.bounds[ray.nearRow[axis]]) * scale + origin;
+    const f32x4 far  = loadUnsigned(node.bounds[ray.farRow[axis]]) * scale + origin;
+    entry = max(near * ray.inverseDirection[axis] - ray.originTimesInverseDirection[axis], entry);
+    exit  = min(far * ray.inverseDirection[axis] - ray.originTimesInverseDirection[axis], exit);
+  }
+  entry.store(tEntry);
+  return lessEqualMask(entry, exit * f32x4(SLAB_EXIT_SCALE)) & node.usedChildren;
+}
+
+//! \brief Depth-first traversal of a quantized BVH, see traverseWideNodes().
+template <bool AnyHit, typename Quantized, typename LeafFunction>
+bool traverseQuantizedBvh(const QuantizedBvh<Quantized>& bvh, const Ray& ray, f32& tMax, LeafFunction&& intersectLeaf,
+                          TraversalCounters* counters = nullptr)
+{
+  const std::vector<QuantizedBvhNode<Quantized>>& nodes = bvh.getNodes();
+  if (nodes.empty())
+  {
+    return false;
+  }
+  const WideRayBoxData<4> rayBoxData(ray);
+  const auto              intersectNode = [&](ui32 nodeIdx, f32 tMaxNode, WideStackEntry hitChildren[4])
+  {
+    const QuantizedBvhNode<Quantized>& node = nodes[nodeIdx];
+    alignas(16) f32                    tEntry[4];
+    const ui32                         mask = intersectChildren(node, rayBoxData, ray.tMin, tMaxNode, tEntry);
+
+    // Inner children and the primitives of leaf children are stored in slot order.
+    ui32 numHitChildren = 0;
+    ui32 childIdx       = node.firstChild;
+    ui32 primitiveIdx   = node.firstPrimitive;
+    for (ui32 slot = 0; slot < 4; slot++)
+    {
+      const ui8  childType = node.childTypes[slot];
+      const bool isInner   = childType == QuantizedBvhNode<Quantized>::INNER_CHILD;
+      if (mask & (1 << slot))
+      {
+        hitChildren[numHitChildren++] = {isInner ? childIdx : primitiveIdx, isInner ? 0u : childType, tEntry[slot]};
+      }
+      childIdx += isInner ? 1 : 0;
+      primitiveIdx += isInner ? 0 : childType;
+    }
+    return numHitChildren;
+  };
+  return traverseWideNodes<AnyHit, 4>(ray.tMin, tMax, intersectNode, intersectLeaf, counters);
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <gimslib/types.hpp>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Stable parallel LSD radix sort of key/value pairs with 8 bit digits.
+//!
+//! Every pass counts the digits of each chunk in parallel, computes the scatter offsets of all chunks with one prefix
+//! sum, and scatters the chunks in parallel. Passes in which all keys share the same digit are skipped.
+//! \param[in,out]  keys The keys, sorted ascending on return.
+//! \param[in,out]  values The values, permuted like the keys.
+//! \param[in]  numKeyBits Only the lowest numKeyBits bits of the keys are sorted.
+//! \param[in]  threadPool Pool that executes the chunks.
+template <typename Key>
+void radixSort(std::vector<Key>& keys, std::vector<ui32>& values, ui32 numKeyBits, ThreadPool& threadPool)
+{
+  constexpr ui32 DIGIT_BITS = 8;
+  constexpr ui32 NUM_DIGITS = 1 << DIGIT_BITS;
+  constexpr ui32 GRAIN_SIZE = 16384;
+
+  const ui32 n         = static_cast<ui32>(keys.size());
+  const ui32 numChunks = std::max(1u, std::min((n + GRAIN_SIZE - 1) / GRAIN_SIZE, 4 * threadPool.getNumThreads()));
+  const ui32 chunkSize = (n + numChunks - 1) / numChunks;
+
+  std::vector<Key>                          keysOut(n);
+  std::vector<ui32>                         valuesOut(n);
+  std::vector<std::array<ui32, NUM_DIGITS>> offsets(numChunks);
+  for (ui32 shift = 0; shift < numKeyBits; shift += DIGIT_BITS)
+  {
+    threadPool.parallelFor(0, numChunks, 1,
+                           [&](ui32 chunkBegin, ui32 chunkEnd)
+                           {
+                             for (ui32 chunk = chunkBegin; chunk < chunkEnd; chunk++)
+                             {
+                               offsets[chunk].fill(0);
+                               const ui32 end = std::min(n, (chunk + 1) * chunkSize);
+                               for (ui32 i = chunk * chunkSize; i < end; i++)
+                               {
+                                 offsets[chunk][(keys[i] >> shift) & (NUM_DIGITS - 1)]++;
+                               }
+                             }
+                           });
+
+    // Exclusive prefix sum in digit-major order turns the counts into the first output position of every chunk.
+    ui32 sum        = 0;
+    bool isConstant = false;
+    for (ui32 digit = 0; digit < NUM_DIGITS; digit++)
+    {
+      const ui32 digitBegin = sum;
+      for (ui32 chunk = 0; chunk < numChunks; chunk++)
+      {
+        const ui32 count      = offsets[chunk][digit];
+        offsets[chunk][digit] = sum;
+        sum += count;
+      }
+      isConstant = isConstant || sum - digitBegin == n;
+    }
+    if (isConstant)
+    {
+      continue;
+    }
+
+    threadPool.parallelFor(0, numChunks, 1,
+                           [&](ui32 chunkBegin, ui32 chunkEnd)
+                           {
+                             for (ui32 chunk = chunkBegin; chunk < chunkEnd; chunk++)
+                             {
+                               const ui32 end = std::min(n, (chunk + 1) * chunkSize);
+                               for (ui32 i = chunk * chunkSize; i < end; i++)
+                               {
+                                 const ui32 position = offsets[chunk][(keys[i] >> shift) & (NUM_DIGITS - 1)]++;
+                                 keysOut[position]   = keys[i];
+                                 valuesOut[position] = values[i];
+                               }
+                             }
+                           });
+    keys.swap(keysOut);
+    values.swap(valuesOut);
+  }
+}
+} // namespace impl
+} // namespace gims
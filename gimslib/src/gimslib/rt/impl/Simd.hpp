@@ -0,0 +1,284 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <gimslib/types.hpp>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define GIMS_RT_SSE 1
+#include <immintrin.h>
+#endif
+#if defined(GIMS_RT_SSE) && defined(__AVX2__)
+#define GIMS_RT_AVX2 1
+#endif
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Four floats that are processed with SSE where available and with scalar code otherwise.
+struct alignas(16) f32x4
+{
+  static constexpr ui32 SIZE = 4;
+
+#ifdef GIMS_RT_SSE
+  __m128 v;
+
+  f32x4() = default;
+  explicit f32x4(__m128 value)
+      : v(value)
+  {
+  }
+  explicit f32x4(f32 value)
+      : v(_mm_set1_ps(value))
+  {
+  }
+  f32x4(f32 x, f32 y, f32 z, f32 w)
+      : v(_mm_setr_ps(x, y, z, w))
+  {
+  }
+  f32 operator[](ui32 i) const
+  {
+    alignas(16) f32 values[4];
+    _mm_store_ps(values, v);
+    return values[i];
+  }
+  //! \brief Loads four floats from a 16 byte aligned address.
+  static f32x4 load(const f32* values)
+  {
+    return f32x4(_mm_load_ps(values));
+  }
+  //! \brief Loads four floats from any address.
+  static f32x4 loadUnaligned(const f32* values)
+  {
+    return f32x4(_mm_loadu_ps(values));
+  }
+  //! \brief Stores four floats to a 16 byte aligned address.
+  void store(f32* values) const
+  {
+    _mm_store_ps(values, v);
+  }
+#else
+  f32 v[4];
+
+  f32x4() = default;
+  explicit f32x4(f32 value)
+      : v{value, value, value, value}
+  {
+  }
+  f32x4(f32 x, f32 y, f32 z, f32 w)
+      : v{x, y, z, w}
+  {
+  }
+  f32 operator[](ui32 i) const
+  {
+    return v[i];
+  }
+  static f32x4 load(const f32* values)
+  {
+    return f32x4(values[0], values[1], values[2], values[3]);
+  }
+  static f32x4 loadUnaligned(const f32* values)
+  {
+    return load(values);
+  }
+  void store(f32* values) const
+  {
+    std::copy(v, v + 4, values);
+  }
+#endif
+};
+
+#ifdef GIMS_RT_SSE
+inline f32x4 operator+(const f32x4& a, const f32x4& b)
+{
+  return f32x4(_mm_add_ps(a.v, b.v));
+}
+inline f32x4 operator-(const f32x4& a, const f32x4& b)
+{
+  return f32x4(_mm_sub_ps(a.v, b.v));
+}
+inline f32x4 operator*(const f32x4& a, const f32x4& b)
+{
+  return f32x4(_mm_mul_ps(a.v, b.v));
+}
+inline f32x4 operator/(const f32x4& a, const f32x4& b)
+{
+  return f32x4(_mm_div_ps(a.v, b.v));
+}
+inline f32x4 min(const f32x4& a, const f32x4& b)
+{
+  return f32x4(_mm_min_ps(a.v, b.v));
+}
+inline f32x4 max(const f32x4& a, const f32x4& b)
+{
+  return f32x4(_mm_max_ps(a.v, b.v));
+}
+//! \brief Converts to integers by truncation.
+inline void truncate(const f32x4& a, i32 result[4])
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm_cvttps_epi32(a.v));
+}
+//! \brief Returns a bit mask with bit i set, if a[i] <= b[i].
+inline ui32 lessEqualMask(const f32x4& a, const f32x4& b)
+{
+  return static_cast<ui32>(_mm_movemask_ps(_mm_cmple_ps(a.v, b.v)));
+}
+//! \brief Loads four unsigned 8 bit integers and converts them to floats.
+inline f32x4 loadUnsigned(const ui8* values)
+{
+  i32 packed;
+  std::memcpy(&packed, values, sizeof(packed));
+  const __m128i zero  = _mm_setzero_si128();
+  const __m128i bytes = _mm_cvtsi32_si128(packed);
+  return f32x4(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero)));
+}
+//! \brief Loads four unsigned 16 bit integers and converts them to floats.
+inline f32x4 loadUnsigned(const ui16* values)
+{
+  const __m128i shorts = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(values));
+  return f32x4(_mm_cvtepi32_ps(_mm_unpacklo_epi16(shorts, _mm_setzero_si128())));
+}
+//! \brief Returns b[i] where all bits of mask[i] are set and a[i] where none are set.
+inline f32x4 select(const f32x4& mask, const f32x4& a, const f32x4& b)
+{
+  return f32x4(_mm_or_ps(_mm_and_ps(mask.v, b.v), _mm_andnot_ps(mask.v, a.v)));
+}
+#else
+inline f32x4 operator+(const f32x4& a, const f32x4& b)
+{
+  return f32x4(a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]);
+}
+inline f32x4 operator-(const f32x4& a, const f32x4& b)
+{
+  return f32x4(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]);
+}
+inline f32x4 operator*(const f32x4& a, const f32x4& b)
+{
+  return f32x4(a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]);
+}
+inline f32x4 operator/(const f32x4& a, const f32x4& b)
+{
+  return f32x4(a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]);
+}
+// Like SSE, min and max return the second operand if one of the operands is NaN.
+inline f32x4 min(const f32x4& a, const f32x4& b)
+{
+  return f32x4(a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1],
+               a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3]);
+}
+inline f32x4 max(const f32x4& a, const f32x4& b)
+{
+  return f32x4(a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1],
+               a.v[2] > b.v[2] ? a.v[2] : b.v[2], a.v[3] > b.v[3] ? a.v[3] : b.v[3]);
+}
+//! \brief Converts to integers by truncation.
+inline void truncate(const f32x4& a, i32 result[4])
+{
+  for (ui32 i = 0; i < 4; i++)
+  {
+    result[i] = static_cast<i32>(a.v[i]);
+  }
+}
+inline ui32 lessEqualMask(const f32x4& a, const f32x4& b)
+{
+  ui32 mask = 0;
+  for (ui32 i = 0; i < 4; i++)
+  {
+    mask |= a.v[i] <= b.v[i] ? 1u << i : 0u;
+  }
+  return mask;
+}
+template <typename Unsigned> f32x4 loadUnsigned(const Unsigned* values)
+{
+  return f32x4(static_cast<f32>(values[0]), static_cast<f32>(values[1]), static_cast<f32>(values[2]),
+               static_cast<f32>(values[3]));
+}
+inline f32x4 select(const f32x4& mask, const f32x4& a, const f32x4& b)
+{
+  f32x4 result;
+  for (ui32 i = 0; i < 4; i++)
+  {
+    result.v[i] = std::bit_cast<ui32>(mask.v[i]) != 0 ? b.v[i] : a.v[i];
+  }
+  return result;
+}
+#endif
+
+#ifdef GIMS_RT_AVX2
+//! \brief Eight floats that are processed with AVX. Only available when compiling with AVX2.
+struct alignas(32) f32x8
+{
+  static constexpr ui32 SIZE = 8;
+
+  __m256 v;
+
+  f32x8() = default;
+  explicit f32x8(__m256 value)
+      : v(value)
+  {
+  }
+  explicit f32x8(f32 value)
+      : v(_mm256_set1_ps(value))
+  {
+  }
+  //! \brief Loads eight floats from a 32 byte aligned address.
+  static f32x8 load(const f32* values)
+  {
+    return f32x8(_mm256_load_ps(values));
+  }
+  //! \brief Loads eight floats from any address.
+  static f32x8 loadUnaligned(const f32* values)
+  {
+    return f32x8(_mm256_loadu_ps(values));
+  }
+  //! \brief Stores eight floats to a 32 byte aligned address.
+  void store(f32* values) const
+  {
+    _mm256_store_ps(values, v);
+  }
+};
+
+inline f32x8 operator+(const f32x8& a, const f32x8& b)
+{
+  return f32x8(_mm256_add_ps(a.v, b.v));
+}
+inline f32x8 operator-(const f32x8& a, const f32x8& b)
+{
+  return f32x8(_mm256_sub_ps(a.v, b.v));
+}
+inline f32x8 operator*(const f32x8& a, const f32x8& b)
+{
+  return f32x8(_mm256_mul_ps(a.v, b.v));
+}
+inline f32x8 operator/(const f32x8& a, const f32x8& b)
+{
+  return f32x8(_mm256_div_ps(a.v, b.v));
+}
+inline f32x8 min(const f32x8& a, const f32x8& b)
+{
+  return f32x8(_mm256_min_ps(a.v, b.v));
+}
+inline f32x8 max(const f32x8& a, const f32x8& b)
+{
+  return f32x8(_mm256_max_ps(a.v, b.v));
+}
+//! \brief Returns a bit mask with bit i set, if a[i] <= b[i].
+inline ui32 lessEqualMask(const f32x8& a, const f32x8& b)
+{
+  return static_cast<ui32>(_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)));
+}
+//! \brief Loads eight unsigned 16 bit integers from any address and converts them to floats.
+inline f32x8 loadUnsigned8(const ui16* values)
+{
+  const __m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+  return f32x8(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(shorts)));
+}
+//! \brief Returns b[i] where all bits of mask[i] are set and a[i] where none are set.
+inline f32x8 select(const f32x8& mask, const f32x8& a, const f32x8& b)
+{
+  return f32x8(_mm256_blendv_ps(a.v, b.v, mask.v));
+}
+#endif
+} // namespace impl
+} // namespace gims
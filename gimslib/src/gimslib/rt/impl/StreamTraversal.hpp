@@ -0,0 +1,94 @@
+#pragma once
+#include "BvhTraversal.hpp"
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/Ray.hpp>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Breadth-first traversal of a BVH with a stream of incoherent rays.
+//!
+//! Every node filters the rays that reach it and hit its bounds, and both children are traversed with the filtered
+//! rays, near child first, as seen by the majority of them. The filtered ray indices are appended to a single buffer,
+//! which is truncated to the range of a node when it is popped: the ranges of the stack entries grow monotonically,
+//! so everything behind it belongs to finished subtrees. See traversePacket() for intersectLeaf.
+//! \param[in]  rays All rays of the batch.
+//! \param[in,out]  tMax End of the interval of every ray of the batch.
+template <typename LeafFunction>
+void traverseStream(const Bvh& bvh, const Ray* rays, f32* tMax, ui32 numRays, LeafFunction&& intersectLeaf)
+{
+  const std::vector<BvhNode>& nodes = bvh.getNodes();
+  if (nodes.empty() || numRays == 0)
+  {
+    return;
+  }
+  std::vector<RayBoxData> rayBoxData;
+  rayBoxData.reserve(numRays);
+  for (ui32 i = 0; i < numRays; i++)
+  {
+    rayBoxData.emplace_back(rays[i]);
+  }
+  std::vector<ui32> rayIndices(numRays);
+  std::iota(rayIndices.begin(), rayIndices.end(), 0);
+
+  struct StackEntry
+  {
+    ui32 nodeIdx;
+    ui32 begin; //! First index into rayIndices of the rays that hit the parent.
+    ui32 end;   //! End of the range.
+  };
+  StackEntry stack[Bvh::MAX_DEPTH + 1];
+  ui32       stackSize = 0;
+  stack[stackSize++]   = {0, 0, numRays};
+  while (stackSize > 0)
+  {
+    const StackEntry entry = stack[--stackSize];
+    const BvhNode&   node  = nodes[entry.nodeIdx];
+    rayIndices.resize(entry.end);
+    for (ui32 i = entry.begin; i < entry.end; i++)
+    {
+      const ui32 rayIdx = rayIndices[i];
+      if (intersectBox(node, rayBoxData[rayIdx], rays[rayIdx].tMin, tMax[rayIdx]) !=
+          std::numeric_limits<f32>::infinity())
+      {
+        rayIndices.push_back(rayIdx);
+      }
+    }
+    const ui32 begin = entry.end;
+    const ui32 end   = static_cast<ui32>(rayIndices.size());
+    if (begin == end)
+    {
+      continue;
+    }
+
+    if (node.isLeaf())
+    {
+      intersectLeaf(node.firstIndex, node.numPrimitives, rayIndices.data() + begin, end - begin, tMax);
+      continue;
+    }
+
+    ui32           near       = node.firstIndex;
+    ui32           far        = node.firstIndex + 1;
+    const BvhNode& nearNode   = nodes[near];
+    const BvhNode& farNode    = nodes[far];
+    const f32v3    centerDiff = (farNode.lowerLeftBottom + farNode.upperRightTop) -
+                             (nearNode.lowerLeftBottom + nearNode.upperRightTop);
+    i32            votes      = 0;
+    for (ui32 i = begin; i < end; i++)
+    {
+      votes += glm::dot(centerDiff, rays[rayIndices[i]].direction) < 0.0f ? 1 : -1;
+    }
+    if (votes > 0)
+    {
+      std::swap(near, far);
+    }
+    stack[stackSize++] = {far, begin, end};
+    stack[stackSize++] = {near, begin, end};
+  }
+}
+} // namespace impl
+} // namespace gims
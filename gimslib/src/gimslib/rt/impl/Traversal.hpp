@@ -0,0 +1,84 @@
+#pragma once
+#include "BvhTraversal.hpp"
+#include "PacketTraversal.hpp"
+#include "QuantizedBvhTraversal.hpp"
+#include "StreamTraversal.hpp"
+#include "WideBvhTraversal.hpp"
+#include <algorithm>
+#include <gimslib/rt/Ray.hpp>
+#include <gimslib/rt/TraversalBvh.hpp>
+#include <span>
+#include <vector>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief Traverses the traversal layout of a TraversalBvh. The indices passed to intersectLeaf refer to
+//! TraversalBvh::getPrimitiveIndices(), see traverseBvh() for the other parameters.
+template <bool AnyHit, typename LeafFunction>
+bool traverse(const TraversalBvh& bvh, const Ray& ray, f32& tMax, LeafFunction&& intersectLeaf,
+              TraversalCounters* counters = nullptr)
+{
+  if (!bvh.getQuantizedBvh8().isEmpty())
+  {
+    return traverseQuantizedBvh<AnyHit>(bvh.getQuantizedBvh8(), ray, tMax, intersectLeaf, counters);
+  }
+  if (!bvh.getQuantizedBvh16().isEmpty())
+  {
+    return traverseQuantizedBvh<AnyHit>(bvh.getQuantizedBvh16(), ray, tMax, intersectLeaf, counters);
+  }
+  if (!bvh.getBvh8().isEmpty())
+  {
+    return traverseWideBvh<AnyHit>(bvh.getBvh8(), ray, tMax, intersectLeaf, counters);
+  }
+  if (!bvh.getBvh4().isEmpty())
+  {
+    return traverseWideBvh<AnyHit>(bvh.getBvh4(), ray, tMax, intersectLeaf, counters);
+  }
+  return traverseBvh<AnyHit>(bvh.getBvh(), ray, tMax, intersectLeaf, counters);
+}
+
+//! \brief Traverses the binary BVH with a batch of rays, in packets or as a stream. The closest hit of a ray is
+//! searched in [ray.tMin, min(ray.tMax, hit.t)], see traversePacket() for intersectLeaf.
+template <typename LeafFunction>
+void traverseBatch(const Bvh& bvh, RayBatchTraversal traversal, std::span<const Ray> rays,
+                   std::span<const RayHit> hits, LeafFunction&& intersectLeaf)
+{
+  // Batches of a single packet, e.g., the rays that reach an instance, do without allocations.
+  constexpr ui32   MAX_PACKET_SIZE = 16;
+  f32              packetTMax[MAX_PACKET_SIZE];
+  std::vector<f32> batchTMax;
+  f32*             tMax    = packetTMax;
+  const ui32       numRays = static_cast<ui32>(rays.size());
+  if (numRays > MAX_PACKET_SIZE)
+  {
+    batchTMax.resize(numRays);
+    tMax = batchTMax.data();
+  }
+  for (ui32 i = 0; i < numRays; i++)
+  {
+    tMax[i] = std::min(rays[i].tMax, hits[i].t);
+  }
+
+  switch (traversal)
+  {
+  case RayBatchTraversal::Packet8:
+    for (ui32 i = 0; i < numRays; i += 8)
+    {
+      traversePacket<8>(bvh, rays.data(), tMax, i, std::min(8u, numRays - i), intersectLeaf);
+    }
+    break;
+  case RayBatchTraversal::Packet16:
+    for (ui32 i = 0; i < numRays; i += 16)
+    {
+      traversePacket<16>(bvh, rays.data(), tMax, i, std::min(16u, numRays - i), intersectLeaf);
+    }
+    break;
+  case RayBatchTraversal::Stream:
+    traverseStream(bvh, rays.data(), tMax, numRays, intersectLeaf);
+    break;
+  }
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,269 @@
+#pragma once
+#include "Simd.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <gimslib/rt/Ray.hpp>
+#include <utility>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief SIMD type of the batched triangle tests: eight triangles per call if AVX2 is available, four otherwise.
+#ifdef GIMS_RT_AVX2
+using TriangleLanes = f32x8;
+#else
+using TriangleLanes = f32x4;
+#endif
+
+//! \brief Per-ray constants of the watertight ray/triangle test of Woop, Benthin and Wald, "Watertight Ray/Triangle
+//! Intersection", JCGT 2013.
+//!
+//! The test translates the vertices to the ray origin and shears them such that the ray points along +z. The edge
+//! functions of a triangle are then 2D cross products of the sheared vertices. Triangles that share an edge compute
+//! the same edge function from the same two vertices, so a ray that hits the edge hits at least one of them.
+struct WatertightRay
+{
+  f32v3 origin; //! Ray origin.
+  ui32  kx;     //! Axis that becomes x after the shear.
+  ui32  ky;     //! Axis that becomes y after the shear.
+  ui32  kz;     //! Axis along the largest component of the direction, becomes z.
+  f32   sx;     //! Shear of x, -direction[kx] / direction[kz] is subtracted per unit of z.
+  f32   sy;     //! Shear of y.
+  f32   sz;     //! Scale of z, 1 / direction[kz].
+  f32   tMin;   //! Start of the ray interval.
+
+  explicit WatertightRay(const Ray& ray)
+      : origin(ray.origin)
+      , tMin(ray.tMin)
+  {
+    const f32v3& d = ray.direction;
+    const f32v3  a(std::abs(d.x), std::abs(d.y), std::abs(d.z));
+    kz = a.x > a.y ? (a.x > a.z ? 0 : 2) : (a.y > a.z ? 1 : 2);
+    kx = (kz + 1) % 3;
+    ky = (kx + 1) % 3;
+    // Swapping x and y for negative directions keeps the winding, so front faces have positive edge functions.
+    if (d[kz] < 0.0f)
+    {
+      std::swap(kx, ky);
+    }
+    sx = d[kx] / d[kz];
+    sy = d[ky] / d[kz];
+    sz = 1.0f / d[kz];
+  }
+};
+
+//! \brief Watertight ray/triangle test. Returns true for hits in [ray.tMin, tMax], both sides count.
+//! \param[in]  ray Constants of the ray.
+//! \param[in]  p0 First vertex.
+//! \param[in]  p1 Second vertex.
+//! \param[in]  p2 Third vertex.
+//! \param[in]  tMax End of the ray interval.
+//! \param[out]  t Receives the distance of a hit.
+//! \param[out]  barycentrics Receives the weights of p1 and p2 of a hit, like DXR's barycentrics.
+inline bool intersectTriangle(const WatertightRay& ray, const f32v3& p0, const f32v3& p1, const f32v3& p2, f32 tMax,
+                              f32& t, f32v2& barycentrics)
+{
+  const f32v3 a  = p0 - ray.origin;
+  const f32v3 b  = p1 - ray.origin;
+  const f32v3 c  = p2 - ray.origin;
+  const f32   ax = a[ray.kx] - ray.sx * a[ray.kz];
+  const f32   ay = a[ray.ky] - ray.sy * a[ray.kz];
+  const f32   bx = b[ray.kx] - ray.sx * b[ray.kz];
+  const f32   by = b[ray.ky] - ray.sy * b[ray.kz];
+  const f32   cx = c[ray.kx] - ray.sx * c[ray.kz];
+  const f32   cy = c[ray.ky] - ray.sy * c[ray.kz];
+
+  f32 u = cx * by - cy * bx;
+  f32 v = ax * cy - ay * cx;
+  f32 w = bx * ay - by * ax;
+  // An edge function of exactly zero may be a rounding artifact, which double precision resolves.
+  if (u == 0.0f || v == 0.0f || w == 0.0f)
+  {
+    u = static_cast<f32>(static_cast<f64>(cx) * by - static_cast<f64>(cy) * bx);
+    v = static_cast<f32>(static_cast<f64>(ax) * cy - static_cast<f64>(ay) * cx);
+    w = static_cast<f32>(static_cast<f64>(bx) * ay - static_cast<f64>(by) * ax);
+  }
+  if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f))
+  {
+    return false;
+  }
+  const f32 det = u + v + w;
+  if (det == 0.0f)
+  {
+    return false;
+  }
+  const f32 tScaled = u * (ray.sz * a[ray.kz]) + v * (ray.sz * b[ray.kz]) + w * (ray.sz * c[ray.kz]);
+  const f32 tHit    = tScaled / det;
+  if (!(tHit >= ray.tMin && tHit <= tMax))
+  {
+    return false;
+  }
+  t            = tHit;
+  barycentrics = f32v2(v / det, w / det);
+  return true;
+}
+
+//! \brief Loads Lanes::SIZE coordinates of a plane of LeafTriangles from any address.
+template <typename Lanes> Lanes loadCoordinates(const f32* values)
+{
+  return Lanes::loadUnaligned(values);
+}
+//! \brief Loads Lanes::SIZE 16 bit coordinates of a plane of LeafTriangles from any address, converted to floats.
+template <typename Lanes> Lanes loadCoordinates(const ui16* values);
+template <> inline f32x4 loadCoordinates<f32x4>(const ui16* values)
+{
+  return loadUnsigned(values);
+}
+#ifdef GIMS_RT_AVX2
+template <> inline f32x8 loadCoordinates<f32x8>(const ui16* values)
+{
+  return loadUnsigned8(values);
+}
+#endif
+
+//! \brief Watertight test of up to Lanes::SIZE consecutive triangles in the SoA layout of LeafTriangles against a ray.
+//! Lanes compute the same values as intersectTriangle(), which tests the rare triangles that need the double precision
+//! fallback.
+//! \param[in]  ray Constants of the ray in the space of the coordinates, see LeafTriangles::transformRay().
+//! \param[in]  coordinates The nine coordinate planes, f32 or ui16, see LeafTriangles::getCoordinates().
+//! \param[in]  stride Coordinates per plane, see LeafTriangles::getStride().
+//! \param[in]  first Index of the first triangle in leaf order.
+//! \param[in]  numTriangles Number of triangles to test, 1 to Lanes::SIZE.
+//! \param[in]  tMax End of the ray interval.
+//! \param[out]  t Receives the distances of the hits, Lanes::SIZE floats.
+//! \param[out]  barycentrics1 Receives the weights of the second vertices of the hits, Lanes::SIZE floats.
+//! \param[out]  barycentrics2 Receives the weights of the third vertices of the hits, Lanes::SIZE floats.
+//! \return Bit mask with bit i set, if triangle first + i is hit in [ray.tMin, tMax].
+template <typename Lanes, typename Coordinate>
+ui32 intersectTriangles(const WatertightRay& ray, const Coordinate* coordinates, size_t stride, ui32 first,
+                        ui32 numTriangles, f32 tMax, f32* t, f32* barycentrics1, f32* barycentrics2)
+{
+  const auto loadPlane = [&](ui32 vertex, ui32 axis)
+  { return loadCoordinates<Lanes>(coordinates + (3 * vertex + axis) * stride + first); };
+  const Lanes zero(0.0f);
+  const Lanes originX(ray.origin[ray.kx]);
+  const Lanes originY(ray.origin[ray.ky]);
+  const Lanes originZ(ray.origin[ray.kz]);
+  const Lanes sx(ray.sx);
+  const Lanes sy(ray.sy);
+  const Lanes sz(ray.sz);
+
+  const Lanes az = loadPlane(0, ray.kz) - originZ;
+  const Lanes bz = loadPlane(1, ray.kz) - originZ;
+  const Lanes cz = loadPlane(2, ray.kz) - originZ;
+  const Lanes ax = (loadPlane(0, ray.kx) - originX) - sx * az;
+  const Lanes ay = (loadPlane(0, ray.ky) - originY) - sy * az;
+  const Lanes bx = (loadPlane(1, ray.kx) - originX) - sx * bz;
+  const Lanes by = (loadPlane(1, ray.ky) - originY) - sy * bz;
+  const Lanes cx = (loadPlane(2, ray.kx) - originX) - sx * cz;
+  const Lanes cy = (loadPlane(2, ray.ky) - originY) - sy * cz;
+
+  const Lanes u = cx * by - cy * bx;
+  const Lanes v = ax * cy - ay * cx;
+  const Lanes w = bx * ay - by * ax;
+
+  const auto  isZero      = [&](const Lanes& x) { return lessEqualMask(x, zero) & lessEqualMask(zero, x); };
+  const ui32  validMask   = (1u << numTriangles) - 1;
+  const ui32  nonNegative = lessEqualMask(zero, u) & lessEqualMask(zero, v) & lessEqualMask(zero, w);
+  const ui32  nonPositive = lessEqualMask(u, zero) & lessEqualMask(v, zero) & lessEqualMask(w, zero);
+  const Lanes det         = u + v + w;
+  const Lanes tHit        = (u * (sz * az) + v * (sz * bz) + w * (sz * cz)) / det;
+  const ui32  inInterval  = lessEqualMask(Lanes(ray.tMin), tHit) & lessEqualMask(tHit, Lanes(tMax));
+  ui32        mask        = (nonNegative | nonPositive) & ~isZero(det) & inInterval & validMask;
+  tHit.store(t);
+  (v / det).store(barycentrics1);
+  (w / det).store(barycentrics2);
+
+  // Triangles with a zero edge function are retested with the double precision fallback.
+  ui32 fallback = (isZero(u) | isZero(v) | isZero(w)) & validMask;
+  mask &= ~fallback;
+  while (fallback != 0)
+  {
+    const ui32 lane = static_cast<ui32>(std::countr_zero(fallback));
+    fallback &= fallback - 1;
+    const auto loadVertex = [&](ui32 vertex)
+    {
+      const Coordinate* plane = coordinates + 3 * vertex * stride + first + lane;
+      return f32v3(static_cast<f32>(plane[0]), static_cast<f32>(plane[stride]), static_cast<f32>(plane[2 * stride]));
+    };
+    f32v2 barycentrics;
+    if (intersectTriangle(ray, loadVertex(0), loadVertex(1), loadVertex(2), tMax, t[lane], barycentrics))
+    {
+      barycentrics1[lane] = barycentrics.x;
+      barycentrics2[lane] = barycentrics.y;
+      mask |= 1u << lane;
+    }
+  }
+  return mask;
+}
+
+//! \brief Finds the closest hit among the triangles of a leaf in the SoA layout of LeafTriangles.
+//!
+//! Triangles that share an edge or a vertex may be hit at the same distance. Such ties go to the lower mesh triangle
+//! index, so the closest hit does not depend on the order in which leaves and triangles are visited, i.e., on the BVH
+//! layout.
+//! \param[in]  ray Constants of the ray in the space of the coordinates, see LeafTriangles::transformRay().
+//! \param[in]  coordinates The nine coordinate planes, see intersectTriangles().
+//! \param[in]  stride Coordinates per plane, see LeafTriangles::getStride().
+//! \param[in]  triangleIndices Mesh triangle of every triangle in leaf order, see LeafTriangles::getTriangleIndices().
+//! \param[in]  first Index of the first triangle of the leaf in leaf order.
+//! \param[in]  numTriangles Number of triangles of the leaf.
+//! \param[in,out]  tMax End of the ray interval, receives the distance of a hit.
+//! \param[out]  barycentrics Receives the barycentrics of a hit, see intersectTriangle().
+//! \param[in,out]  triangleIdx Mesh triangle of the closest hit so far, RayHit::INVALID without one. Receives the mesh
+//! triangle of a hit.
+//! \return True, if a triangle is hit in [ray.tMin, tMax].
+template <typename Coordinate>
+bool intersectLeafTriangles(const WatertightRay& ray, const Coordinate* coordinates, size_t stride,
+                            const ui32* triangleIndices, ui32 first, ui32 numTriangles, f32& tMax,
+                            f32v2& barycentrics, ui32& triangleIdx)
+{
+  alignas(32) f32 t[TriangleLanes::SIZE];
+  alignas(32) f32 barycentrics1[TriangleLanes::SIZE];
+  alignas(32) f32 barycentrics2[TriangleLanes::SIZE];
+  bool            leafHit = false;
+  for (ui32 i = first; i < first + numTriangles; i += TriangleLanes::SIZE)
+  {
+    ui32 mask = intersectTriangles<TriangleLanes>(ray, coordinates, stride, i,
+                                                  std::min(TriangleLanes::SIZE, first + numTriangles - i), tMax, t,
+                                                  barycentrics1, barycentrics2);
+    while (mask != 0)
+    {
+      const ui32 lane = static_cast<ui32>(std::countr_zero(mask));
+      mask &= mask - 1;
+      if (t[lane] < tMax || (t[lane] == tMax && triangleIndices[i + lane] < triangleIdx))
+      {
+        tMax         = t[lane];
+        barycentrics = f32v2(barycentrics1[lane], barycentrics2[lane]);
+        triangleIdx  = triangleIndices[i + lane];
+        leafHit      = true;
+      }
+    }
+  }
+  return leafHit;
+}
+
+//! \brief Returns true, if any triangle of a leaf in the SoA layout of LeafTriangles is hit in [ray.tMin, tMax]. See
+//! intersectLeafTriangles() for the parameters.
+template <typename Coordinate>
+bool occludeLeafTriangles(const WatertightRay& ray, const Coordinate* coordinates, size_t stride, ui32 first,
+                          ui32 numTriangles, f32 tMax)
+{
+  alignas(32) f32 t[TriangleLanes::SIZE];
+  alignas(32) f32 barycentrics1[TriangleLanes::SIZE];
+  alignas(32) f32 barycentrics2[TriangleLanes::SIZE];
+  for (ui32 i = first; i < first + numTriangles; i += TriangleLanes::SIZE)
+  {
+    if (intersectTriangles<TriangleLanes>(ray, coordinates, stride, i,
+                                          std::min(TriangleLanes::SIZE, first + numTriangles - i), tMax, t,
+                                          barycentrics1, barycentrics2) != 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace impl
+} // namespace gims
@@ -0,0 +1,187 @@
+#pragma once
+#include "BvhTraversal.hpp"
+#include "Simd.hpp"
+#include <bit>
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/Ray.hpp>
+#include <gimslib/rt/WideBvh.hpp>
+#include <limits>
+#include <type_traits>
+
+namespace gims
+{
+namespace impl
+{
+//! \brief SIMD type for the slab tests of a node with Width children: one AVX register for eight children if
+//! available, SSE registers otherwise.
+#ifdef GIMS_RT_AVX2
+template <ui32 Width> using WideBvhLanes = std::conditional_t<Width == 8, f32x8, f32x4>;
+#else
+template <ui32 Width> using WideBvhLanes = f32x4;
+#endif
+
+//! \brief Per-ray constants of the wide slab test. The rows of the near and far planes depend on the direction signs,
+//! so no min/max per axis is needed and the empty bounds of unused child slots are never hit.
+template <ui32 Width> struct WideRayBoxData
+{
+  using Lanes = WideBvhLanes<Width>;
+
+  Lanes inverseDirection[3];
+  Lanes originTimesInverseDirection[3];
+  ui32  nearRow[3];
+  ui32  farRow[3];
+
+  explicit WideRayBoxData(const Ray& ray)
+  {
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      const f32 inverse                 = 1.0f / ray.direction[axis];
+      inverseDirection[axis]            = Lanes(inverse);
+      originTimesInverseDirection[axis] = Lanes(ray.origin[axis] * inverse);
+      nearRow[axis]                     = 2 * axis + (inverse < 0.0f ? 1 : 0);
+      farRow[axis]                      = 2 * axis + (inverse < 0.0f ? 0 : 1);
+    }
+  }
+};
+
+//! \brief Slab test of all children of a node. Writes the entry distances and returns a bit mask of the children
+//! whose bounds are hit in [tMin, tMax].
+template <ui32 Width>
+ui32 intersectChildren(const WideBvhNode<Width>& node, const WideRayBoxData<Width>& ray, f32 tMin, f32 tMax,
+                       f32* tEntry)
+{
+  using Lanes = WideBvhLanes<Width>;
+  ui32 mask   = 0;
+  for (ui32 i = 0; i < Width; i += Lanes::SIZE)
+  {
+    // NaNs from 0 * infinity are dropped by passing the running interval as the second operand of min and max.
+    Lanes entry(tMin);
+    Lanes exit(tMax);
+    for (ui32 axis = 0; axis < 3; axis++)
+    {
+      const Lanes tNear = Lanes::load(&node.bounds[ray.nearRow[axis]][i]) * ray.inverseDirection[axis] -
+                          ray.originTimesInverseDirection[axis];
+      const Lanes tFar = Lanes::load(&node.bounds[ray.farRow[axis]][i]) * ray.inverseDirection[axis] -
+                         ray.originTimesInverseDirection[axis];
+      entry = max(tNear, entry);
+      exit  = min(tFar, exit);
+    }
+    entry.store(tEntry + i);
+    mask |= lessEqualMask(entry, exit * Lanes(SLAB_EXIT_SCALE)) << i;
+  }
+  return mask;
+}
+
+//! \brief Reference to a child of a wide node together with its entry distance.
+struct WideStackEntry
+{
+  ui32 index;         //! Inner child: node index. Leaf: index of the first primitive index.
+  ui32 numPrimitives; //! Number of primitives of a leaf, 0 for inner nodes.
+  f32  tEntry;        //! Entry distance of the child bounds.
+};
+
+//! \brief Depth-first traversal of wide nodes, independent of their format. The hit children of a node are visited in
+//! the order of their entry distances, or in slot order with AnyHit.
+//!
+//! intersectNode(nodeIdx, tMax, hitChildren) writes the children of a node whose bounds are hit in [tMin, tMax] in any
+//! order and returns their number. intersectLeaf(firstIndex, numPrimitives, tMax) intersects the primitives of a
+//! leaf, shortens tMax to the closest hit and returns true, if it found a hit. With AnyHit, traversal stops at the
+//! first hit. If counters is not null, the visited nodes and leaves are added to it.
+//! \return True, if any leaf reported a hit.
+template <bool AnyHit, ui32 Width, typename NodeFunction, typename LeafFunction>
+bool traverseWideNodes(f32 tMin, f32& tMax, NodeFunction&& intersectNode, LeafFunction&& intersectLeaf,
+                       TraversalCounters* counters)
+{
+  // Every level pushes at most Width - 1 children.
+  WideStackEntry stack[(Width - 1) * Bvh::MAX_DEPTH + 1];
+  ui32           stackSize = 0;
+  bool           hit       = false;
+  WideStackEntry current   = {0, 0, tMin};
+  while (true)
+  {
+    if (counters)
+    {
+      counters->numNodesVisited++;
+    }
+    if (current.numPrimitives > 0)
+    {
+      if (intersectLeaf(current.index, current.numPrimitives, tMax))
+      {
+        hit = true;
+        if constexpr (AnyHit)
+        {
+          return true;
+        }
+      }
+    }
+    else
+    {
+      WideStackEntry hitChildren[Width];
+      const ui32     numHitChildren = intersectNode(current.index, tMax, hitChildren);
+      if (numHitChildren > 0)
+      {
+        // Sort the hit children by decreasing entry distance, push all but the nearest, and continue with it. Any
+        // hit ends the traversal, so occlusion queries skip the sort and keep the slot order.
+        if constexpr (!AnyHit)
+        {
+          for (ui32 i = 1; i < numHitChildren; i++)
+          {
+            const WideStackEntry child = hitChildren[i];
+            ui32                 j     = i;
+            for (; j > 0 && hitChildren[j - 1].tEntry < child.tEntry; j--)
+            {
+              hitChildren[j] = hitChildren[j - 1];
+            }
+            hitChildren[j] = child;
+          }
+        }
+        for (ui32 i = 0; i + 1 < numHitChildren; i++)
+        {
+          stack[stackSize++] = hitChildren[i];
+        }
+        current = hitChildren[numHitChildren - 1];
+        continue;
+      }
+    }
+
+    // Pop the next node, skipping nodes that lie behind the closest hit found in the meantime. The entry distance is
+    // rounded like the one of the slab test, so the same margin applies.
+    do
+    {
+      if (stackSize == 0)
+      {
+        return hit;
+      }
+      stackSize--;
+    } while (stack[stackSize].tEntry > tMax * SLAB_EXIT_SCALE);
+    current = stack[stackSize];
+  }
+}
+
+//! \brief Depth-first traversal of a wide BVH, see traverseWideNodes().
+template <bool AnyHit, ui32 Width, typename LeafFunction>
+bool traverseWideBvh(const WideBvh<Width>& bvh, const Ray& ray, f32& tMax, LeafFunction&& intersectLeaf,
+                     TraversalCounters* counters = nullptr)
+{
+  const std::vector<WideBvhNode<Width>>& nodes = bvh.getNodes();
+  if (nodes.empty())
+  {
+    return false;
+  }
+  const WideRayBoxData<Width> rayBoxData(ray);
+  const auto intersectNode = [&](ui32 nodeIdx, f32 tMaxNode, WideStackEntry hitChildren[Width])
+  {
+    const WideBvhNode<Width>& node = nodes[nodeIdx];
+    alignas(32) f32           tEntry[Width];
+    ui32                      numHitChildren = 0;
+    for (ui32 mask = intersectChildren(node, rayBoxData, ray.tMin, tMaxNode, tEntry); mask != 0; mask &= mask - 1)
+    {
+      const ui32 slot               = static_cast<ui32>(std::countr_zero(mask));
+      hitChildren[numHitChildren++] = {node.children[slot], node.numPrimitives[slot], tEntry[slot]};
+    }
+    return numHitChildren;
+  };
+  return traverseWideNodes<AnyHit, Width>(ray.tMin, tMax, intersectNode, intersectLeaf, counters);
+}
+} // namespace impl
+} // namespace gims
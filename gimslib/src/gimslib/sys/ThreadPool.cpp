@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <gimslib/sys/ThreadPool.hpp>
+#include <utility>
+
+namespace gims
+{
+ThreadPool::TaskGroup::TaskGroup(ThreadPool& threadPool)
+    : m_threadPool(threadPool)
+    , m_numPendingTasks(0)
+{
+}
+
+ThreadPool::TaskGroup::~TaskGroup()
+{
+  try
+  {
+    wait();
+  }
+  catch (...)
+  {
+  }
+}
+
+void ThreadPool::TaskGroup::run(std::function<void()> task)
+{
+  m_numPendingTasks++;
+  {
+    std::lock_guard<std::mutex> lock(m_threadPool.m_mutex);
+    m_threadPool.m_tasks.push_back({std::move(task), this});
+  }
+  m_threadPool.m_condition.notify_one();
+}
+
+void ThreadPool::TaskGroup::wait()
+{
+  while (m_numPendingTasks > 0)
+  {
+    if (!m_threadPool.runQueuedTask())
+    {
+      std::this_thread::yield();
+    }
+  }
+  std::exception_ptr exception;
+  {
+    std::lock_guard<std::mutex> lock(m_exceptionMutex);
+    exception = std::exchange(m_exception, nullptr);
+  }
+  if (exception)
+  {
+    std::rethrow_exception(exception);
+  }
+}
+
+ThreadPool::ThreadPool(ui32 numThreads)
+    : m_stop(false)
+{
+  if (numThreads == 0)
+  {
+    numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  for (ui32 i = 1; i < numThreads; i++)
+  {
+    m_workers.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  for (auto& worker : m_workers)
+  {
+    worker.join();
+  }
+}
+
+ui32 ThreadPool::getNumThreads() const
+{
+  return static_cast<ui32>(m_workers.size()) + 1;
+}
+
+void ThreadPool::parallelFor(ui32 begin, ui32 end, ui32 grainSize, const std::function<void(ui32, ui32)>& function)
+{
+  grainSize = std::max(grainSize, 1u);
+  if (end - begin <= grainSize || m_workers.empty())
+  {
+    if (begin < end)
+    {
+      function(begin, end);
+    }
+    return;
+  }
+  TaskGroup taskGroup(*this);
+  for (ui32 chunkBegin = begin + grainSize; chunkBegin < end;)
+  {
+    const ui32 chunkEnd = chunkBegin + std::min(grainSize, end - chunkBegin);
+    taskGroup.run([&function, chunkBegin, chunkEnd]() { function(chunkBegin, chunkEnd); });
+    chunkBegin = chunkEnd;
+  }
+  function(begin, begin + grainSize);
+  taskGroup.wait();
+}
+
+ThreadPool& ThreadPool::getGlobal()
+{
+  static ThreadPool threadPool;
+  return threadPool;
+}
+
+bool ThreadPool::runQueuedTask()
+{
+  Task task;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_tasks.empty())
+    {
+      return false;
+    }
+    task = std::move(m_tasks.front());
+    m_tasks.pop_front();
+  }
+  runTask(task);
+  return true;
+}
+
+void ThreadPool::runTask(Task& task)
+{
+  try
+  {
+    task.function();
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> lock(task.taskGroup->m_exceptionMutex);
+    if (!task.taskGroup->m_exception)
+    {
+      task.taskGroup->m_exception = std::current_exception();
+    }
+  }
+  task.taskGroup->m_numPendingTasks--;
+}
+
+void ThreadPool::work()
+{
+  while (true)
+  {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+      if (m_stop)
+      {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    runTask(task);
+  }
+}
+} // namespace gims
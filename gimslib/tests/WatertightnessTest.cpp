@@ -0,0 +1,168 @@
+#include <gimslib/rt/BottomLevelAS.hpp>
+#include <gimslib/rt/Bvh.hpp>
+#include <gimslib/rt/Ray.hpp>
+#include <gimslib/types.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Rays aimed exactly at the vertices and edges that the triangles of a closed surface share must hit it. Misses
+// there let shadow rays leak through closed meshes. Every BVH layout has to report the same closest hits, since they
+// all test the same triangles with the same watertight ray/triangle test.
+
+namespace
+{
+using namespace gims;
+
+/// <summary>
+/// Grid of gridSize x gridSize quads with two triangles each. The vertices are jittered, so that the triangles are
+/// neither axis aligned nor coplanar.
+/// </summary>
+struct JitteredGrid
+{
+  static constexpr ui32 gridSize = 64;
+
+  std::vector<f32v3> positions;
+  std::vector<ui32>  indices;
+
+  JitteredGrid()
+  {
+    std::mt19937                        random(1);
+    std::uniform_real_distribution<f32> uniform(-0.5f, 0.5f);
+    for (ui32 y = 0; y <= gridSize; y++)
+    {
+      for (ui32 x = 0; x <= gridSize; x++)
+      {
+        positions.emplace_back(static_cast<f32>(x) + 0.3f * uniform(random),
+                               static_cast<f32>(y) + 0.3f * uniform(random), 0.1f + 0.2f * uniform(random));
+      }
+    }
+    for (ui32 y = 0; y < gridSize; y++)
+    {
+      for (ui32 x = 0; x < gridSize; x++)
+      {
+        const ui32 v = y * (gridSize + 1) + x;
+        indices.insert(indices.end(), {v, v + 1, v + gridSize + 2, v, v + gridSize + 2, v + gridSize + 1});
+      }
+    }
+  }
+};
+
+/// <summary>
+/// Rays from random origins above the grid towards every inner vertex and the midpoints of its three edges to the
+/// right, to the top and along the quad diagonal.
+/// </summary>
+/// <param name="positions">The vertex positions that the BottomLevelAS actually intersects.</param>
+/// <returns>Four rays per inner vertex.</returns>
+std::vector<Ray> createSharedEdgeRays(const std::vector<f32v3>& positions)
+{
+  constexpr ui32                      gridSize = JitteredGrid::gridSize;
+  std::mt19937                        random(2);
+  std::uniform_real_distribution<f32> uniform(-0.5f, 0.5f);
+
+  std::vector<Ray> rays;
+  for (ui32 y = 1; y < gridSize; y++)
+  {
+    for (ui32 x = 1; x < gridSize; x++)
+    {
+      const ui32  v          = y * (gridSize + 1) + x;
+      const f32v3 targets[4] = {positions[v], 0.5f * (positions[v] + positions[v + 1]),
+                                0.5f * (positions[v] + positions[v + gridSize + 1]),
+                                0.5f * (positions[v] + positions[v + gridSize + 2])};
+      for (const auto& target : targets)
+      {
+        Ray ray;
+        ray.origin =
+            target + f32v3(10.0f * uniform(random), 10.0f * uniform(random), 10.0f + 5.0f * uniform(random));
+        ray.direction = target - ray.origin;
+        ray.tMin      = 0.0f;
+        ray.tMax      = 2.0f;
+        rays.push_back(ray);
+      }
+    }
+  }
+  return rays;
+}
+
+/// <summary>
+/// BVH layout under test.
+/// </summary>
+struct Layout
+{
+  std::string name;
+  ui32        branchingFactor;
+  ui32        quantizationBits;
+};
+
+/// <summary>
+/// Checks that no ray misses and that all layouts report the hits of the binary BVH.
+/// </summary>
+/// <param name="leafPositionBits">0 for float, 16 for quantized leaf triangles.</param>
+/// <returns>The number of failed checks.</returns>
+ui32 testLeafPositionBits(ui32 leafPositionBits)
+{
+  const JitteredGrid  grid;
+  const Layout        layouts[] = {{"binary", 2, 0},
+                                   {"BVH4", 4, 0},
+                                   {"BVH8", 8, 0},
+                                   {"quantized 8 bit", 4, 8},
+                                   {"quantized 16 bit", 4, 16}};
+  std::vector<Ray>    rays;
+  std::vector<RayHit> referenceHits;
+
+  ui32 numFailures = 0;
+  for (const auto& layout : layouts)
+  {
+    BvhBuildSettings settings;
+    settings.branchingFactor  = layout.branchingFactor;
+    settings.quantizationBits = layout.quantizationBits;
+    settings.leafPositionBits = leafPositionBits;
+    const BottomLevelAS blas(grid.positions, grid.indices, settings);
+
+    // All layouts snap the positions to the same grid, so the rays are the same, too.
+    if (rays.empty())
+    {
+      rays = createSharedEdgeRays(blas.getPositions());
+    }
+
+    ui32 numMisses          = 0;
+    ui32 numOcclusionMisses = 0;
+    ui32 numDifferentHits   = 0;
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+      RayHit hit;
+      if (!blas.intersect(rays[i], hit))
+      {
+        numMisses++;
+      }
+      if (!blas.occluded(rays[i]))
+      {
+        numOcclusionMisses++;
+      }
+      if (referenceHits.size() < rays.size())
+      {
+        referenceHits.push_back(hit);
+      }
+      else if (hit.t != referenceHits[i].t || hit.triangleIdx != referenceHits[i].triangleIdx ||
+               hit.barycentrics != referenceHits[i].barycentrics)
+      {
+        numDifferentHits++;
+      }
+    }
+
+    std::cout << layout.name << ", " << leafPositionBits << " leaf position bits: " << rays.size() << " rays, "
+              << numMisses << " misses, " << numOcclusionMisses << " occlusion misses, " << numDifferentHits
+              << " hits that differ from the binary BVH" << std::endl;
+    numFailures += numMisses + numOcclusionMisses + numDifferentHits;
+  }
+  return numFailures;
+}
+} // namespace
+
+int main()
+{
+  const ui32 numFailures = testLeafPositionBits(0) + testLeafPositionBits(16);
+  return numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}